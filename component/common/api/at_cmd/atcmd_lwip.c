@@ -2251,24 +2251,11 @@ node *tryget_node(int n)
 	return &node_pool[n];
 }
 
-int atcmd_lwip_receive_data(node *curnode, u8 *buffer, u16 buffer_size, int *recv_size, 
+/* Read the data of a node that is ready. On error the socket of the node is closed. */
+static int atcmd_lwip_read_data(node *curnode, u8 *buffer, u16 buffer_size, int *recv_size, 
 	u8_t *udp_clientaddr, u16_t *udp_clientport){
-		
-	struct timeval tv;
-	fd_set readfds;
-	int error_no = 0, ret = 0, size = 0;
 
-	FD_ZERO(&readfds);
-	FD_SET(curnode->sockfd, &readfds);
-	tv.tv_sec = RECV_SELECT_TIMEOUT_SEC;
-	tv.tv_usec = RECV_SELECT_TIMEOUT_USEC;
-	ret = select(curnode->sockfd + 1, &readfds, NULL, NULL, &tv);
-	if(!((ret > 0)&&(FD_ISSET(curnode->sockfd, &readfds))))
-	{
-		//AT_DBG_MSG(AT_FLAG_LWIP, AT_DBG_ALWAYS, 
-		//	"[ATPR] No receive event for con_id %d", curnode->con_id);
-		goto exit;
-	}
+	int error_no = 0, size = 0;
 
 	if(curnode->protocol == NODE_MODE_UDP) //udp server receive from client
 	{
@@ -2351,7 +2338,7 @@ int atcmd_lwip_receive_data(node *curnode, u8 *buffer, u16 buffer_size, int *rec
 			error_no = 8;
 		}
 	}
-exit:
+
 	if(error_no == 0)
 		*recv_size = size;
 	else{
@@ -2371,88 +2358,191 @@ exit:
 	return error_no;
 }
 
+int atcmd_lwip_receive_data(node *curnode, u8 *buffer, u16 buffer_size, int *recv_size, 
+	u8_t *udp_clientaddr, u16_t *udp_clientport){
+
+	struct timeval tv;
+	fd_set readfds;
+	int ret = 0;
+
+	FD_ZERO(&readfds);
+	FD_SET(curnode->sockfd, &readfds);
+	tv.tv_sec = RECV_SELECT_TIMEOUT_SEC;
+	tv.tv_usec = RECV_SELECT_TIMEOUT_USEC;
+	ret = select(curnode->sockfd + 1, &readfds, NULL, NULL, &tv);
+	if(!((ret > 0)&&(FD_ISSET(curnode->sockfd, &readfds))))
+	{
+		//AT_DBG_MSG(AT_FLAG_LWIP, AT_DBG_ALWAYS, 
+		//	"[ATPR] No receive event for con_id %d", curnode->con_id);
+		*recv_size = 0;
+		return 0;
+	}
+
+	return atcmd_lwip_read_data(curnode, buffer, buffer_size, recv_size, udp_clientaddr, udp_clientport);
+}
+
+/* The socket the auto receive task reads for node n, INVALID_SOCKET_ID if none */
+static int atcmd_lwip_autorecv_fd(int n)
+{
+	node* curnode = tryget_node(n);
+
+	if(curnode == NULL)
+		return INVALID_SOCKET_ID;
+	if((curnode->protocol == NODE_MODE_TCP 
+#if (ATCMD_VER == ATVER_2) && ATCMD_SUPPORT_SSL
+		||curnode->protocol == NODE_MODE_SSL
+#endif
+		)
+		&& curnode->role == NODE_ROLE_SERVER){
+		//TCP Server must receive data from the seed
+		return INVALID_SOCKET_ID;
+	}
+	return curnode->sockfd;
+}
+
+/* Print the data of a node in auto receive mode, ready: the node is known to be readable */
+static void atcmd_lwip_autorecv_node(node *curnode, int ready)
+{
+	int error_no = 0;
+	int recv_size = 0;
+	u8_t udp_clientaddr[16] = {0};
+	u16_t udp_clientport = 0;
+	int packet_size = ETH_MAX_MTU;
+
+	if(ready)
+		error_no = atcmd_lwip_read_data(curnode, rx_buffer, packet_size, &recv_size, udp_clientaddr, &udp_clientport);
+	else
+		error_no = atcmd_lwip_receive_data(curnode, rx_buffer, packet_size, &recv_size, udp_clientaddr, &udp_clientport);
+
+	if(atcmd_lwip_is_tt_mode()){
+		if((error_no == 0) && recv_size){
+			rx_buffer[recv_size] = '\0';
+			AT_DBG_MSG(AT_FLAG_LWIP, AT_DBG_ALWAYS,"Recv[%d]:%s", recv_size, rx_buffer);
+			at_print_data(rx_buffer, recv_size);
+			rtw_msleep_os(20);
+		}
+		return;
+	}
+
+	if(error_no == 0){
+		if(recv_size){
+			rx_buffer[recv_size] = '\0';
+			#if CONFIG_LOG_SERVICE_LOCK
+			log_service_lock();
+			#endif
+			if(curnode->protocol == NODE_MODE_UDP && curnode->role == NODE_ROLE_SERVER){
+				AT_DBG_MSG(AT_FLAG_LWIP, AT_DBG_ALWAYS,
+						"\r\n[ATPR] OK,%d,%d,%s,%d:%s", recv_size, curnode->con_id, udp_clientaddr, udp_clientport, rx_buffer);
+				at_printf("\r\n[ATPR] OK,%d,%d,%s,%d:", recv_size, curnode->con_id, udp_clientaddr, udp_clientport);
+			}
+			else{
+				AT_DBG_MSG(AT_FLAG_LWIP, AT_DBG_ALWAYS,
+						"\r\n[ATPR] OK,%d,%d:%s", 
+						recv_size, 
+						curnode->con_id, rx_buffer);
+				at_printf("\r\n[ATPR] OK,%d,%d:", recv_size, curnode->con_id);
+			}
+			at_print_data(rx_buffer, recv_size);
+			at_printf(STR_END_OF_ATCMD_RET);
+			#if CONFIG_LOG_SERVICE_LOCK
+			log_service_unlock();
+			#endif
+		}
+	}
+	else{
+		#if CONFIG_LOG_SERVICE_LOCK
+		log_service_lock();
+		#endif
+		at_printf("\r\n[ATPR] ERROR:%d,%d", error_no, curnode->con_id);				
+		at_printf(STR_END_OF_ATCMD_RET);
+		#if CONFIG_LOG_SERVICE_LOCK
+		log_service_unlock();
+		#endif
+	}
+}
+
+#if LWIP_SOCKET_EPOLL
+/* Auto receive with an interest list of the node sockets: a pass only reads
+   the nodes that are ready, instead of a select per node */
+static void atcmd_lwip_receive_epoll(int epfd)
+{
+	static int watched[NUM_NS];
+	static struct lwip_epoll_event ready[NUM_NS];
+	struct lwip_epoll_event ev;
+	node* curnode;
+	int i, k, n, fd, nready;
+
+	for (i = 0; i < NUM_NS; ++i)
+		watched[i] = INVALID_SOCKET_ID;
+
+	while(atcmd_lwip_is_autorecv_mode())
+	{
+		// follow the nodes opened and closed by the other commands
+		for (i = 0; i < NUM_NS; ++i) {
+			fd = atcmd_lwip_autorecv_fd(i);
+			if((watched[i] != INVALID_SOCKET_ID) && (fd != watched[i])){
+				lwip_epoll_ctl(epfd, LWIP_EPOLL_CTL_DEL, watched[i], NULL);
+				watched[i] = INVALID_SOCKET_ID;
+			}
+		}
+		for (i = 0; i < NUM_NS; ++i) {
+			fd = atcmd_lwip_autorecv_fd(i);
+			if((fd == INVALID_SOCKET_ID) || (fd == watched[i]))
+				continue;
+			// a socket number reused: the old socket was closed and left the list
+			for (k = 0; k < NUM_NS; ++k) {
+				if(watched[k] == fd)
+					watched[k] = INVALID_SOCKET_ID;
+			}
+			ev.events = LWIP_EPOLLIN;
+			ev.data.u32 = i;
+			if(lwip_epoll_ctl(epfd, LWIP_EPOLL_CTL_ADD, fd, &ev) == 0)
+				watched[i] = fd;
+		}
+
+		nready = lwip_epoll_wait(epfd, ready, NUM_NS, 
+			RECV_SELECT_TIMEOUT_SEC * 1000 + RECV_SELECT_TIMEOUT_USEC / 1000);
+		for (n = 0; n < nready; ++n) {
+			i = (int)ready[n].data.u32;
+			curnode = tryget_node(i);
+			if((curnode != NULL) && (curnode->sockfd == watched[i]))
+				atcmd_lwip_autorecv_node(curnode, 1);
+		}
+	}
+}
+#endif
+
 static void atcmd_lwip_receive_task(void *param)
 {
 
 	int i;
-	int packet_size = ETH_MAX_MTU;
+#if LWIP_SOCKET_EPOLL
+	int epfd;
+#endif
 
 	AT_DBG_MSG(AT_FLAG_LWIP, AT_DBG_ALWAYS, 
 			"Enter auto receive mode");
-	
+
+#if LWIP_SOCKET_EPOLL
+	epfd = lwip_epoll_create();
+	if(epfd >= 0){
+		atcmd_lwip_receive_epoll(epfd);
+		lwip_epoll_close(epfd);
+	}
+	else
+#endif
 	while(atcmd_lwip_is_autorecv_mode())
 	{
 		for (i = 0; i < NUM_NS; ++i) {
-			node* curnode = NULL;
-			int error_no = 0;
-			int recv_size = 0;	
-			u8_t udp_clientaddr[16] = {0};
-			u16_t udp_clientport = 0;			
-			curnode = tryget_node(i);
-			if(curnode == NULL)
-				continue;
-			if((curnode->protocol == NODE_MODE_TCP 
-#if (ATCMD_VER == ATVER_2) && ATCMD_SUPPORT_SSL
-				||curnode->protocol == NODE_MODE_SSL
-#endif
-				)
-				&& curnode->role == NODE_ROLE_SERVER){
-				//TCP Server must receive data from the seed
-				continue;
-			}
-			error_no = atcmd_lwip_receive_data(curnode, rx_buffer, packet_size, &recv_size, udp_clientaddr, &udp_clientport);
-
-			if(atcmd_lwip_is_tt_mode()){
-				if((error_no == 0) && recv_size){
-					rx_buffer[recv_size] = '\0';
-					AT_DBG_MSG(AT_FLAG_LWIP, AT_DBG_ALWAYS,"Recv[%d]:%s", recv_size, rx_buffer);
-					at_print_data(rx_buffer, recv_size);
-					rtw_msleep_os(20);
-				}
+			if(atcmd_lwip_autorecv_fd(i) == INVALID_SOCKET_ID)
 				continue;
-			}
-			
-			if(error_no == 0){
-				if(recv_size){
-					rx_buffer[recv_size] = '\0';
-					#if CONFIG_LOG_SERVICE_LOCK
-					log_service_lock();
-					#endif
-					if(curnode->protocol == NODE_MODE_UDP && curnode->role == NODE_ROLE_SERVER){
-						AT_DBG_MSG(AT_FLAG_LWIP, AT_DBG_ALWAYS,
-								"\r\n[ATPR] OK,%d,%d,%s,%d:%s", recv_size, curnode->con_id, udp_clientaddr, udp_clientport, rx_buffer);
-						at_printf("\r\n[ATPR] OK,%d,%d,%s,%d:", recv_size, curnode->con_id, udp_clientaddr, udp_clientport);
-					}
-					else{
-						AT_DBG_MSG(AT_FLAG_LWIP, AT_DBG_ALWAYS,
-								"\r\n[ATPR] OK,%d,%d:%s", 
-								recv_size, 
-								curnode->con_id, rx_buffer);
-						at_printf("\r\n[ATPR] OK,%d,%d:", recv_size, curnode->con_id);
-					}
-					at_print_data(rx_buffer, recv_size);
-					at_printf(STR_END_OF_ATCMD_RET);
-					#if CONFIG_LOG_SERVICE_LOCK
-					log_service_unlock();
-					#endif
-				}
-			}
-			else{
-				#if CONFIG_LOG_SERVICE_LOCK
-				log_service_lock();
-				#endif
-				at_printf("\r\n[ATPR] ERROR:%d,%d", error_no, curnode->con_id);				
-				at_printf(STR_END_OF_ATCMD_RET);
-				#if CONFIG_LOG_SERVICE_LOCK
-				log_service_unlock();
-				#endif
-			}
+			atcmd_lwip_autorecv_node(tryget_node(i), 0);
 		}
 	}
 
 	AT_DBG_MSG(AT_FLAG_LWIP, AT_DBG_ALWAYS, 
 			"Leave auto receive mode");
-	
+
 	vTaskDelete(NULL);
 }
 
@@ -5265,24 +5355,11 @@ node *tryget_node(int n)
 	return &node_pool[n];
 }
 
-int atcmd_lwip_receive_data(node *curnode, u8 *buffer, u16 buffer_size, int *recv_size, 
+/* Read the data of a node that is ready. On error the socket of the node is closed. */
+static int atcmd_lwip_read_data(node *curnode, u8 *buffer, u16 buffer_size, int *recv_size, 
 	u8_t *udp_clientaddr, u16_t *udp_clientport){
 
-	struct timeval tv;
-	fd_set readfds;
-	int error_no = 0, ret = 0, size = 0;
-
-	FD_ZERO(&readfds);
-	FD_SET(curnode->sockfd, &readfds);
-	tv.tv_sec = RECV_SELECT_TIMEOUT_SEC;
-	tv.tv_usec = RECV_SELECT_TIMEOUT_USEC;
-	ret = select(curnode->sockfd + 1, &readfds, NULL, NULL, &tv);
-	if(!((ret > 0)&&(FD_ISSET(curnode->sockfd, &readfds))))
-	{
-		//AT_DBG_MSG(AT_FLAG_LWIP, AT_DBG_ALWAYS, 
-		//	"[ATPR] No receive event for con_id %d", curnode->con_id);
-		goto exit;
-	}
+	int error_no = 0, size = 0;
 
 	if(curnode->protocol == NODE_MODE_UDP) //udp server receive from client
 	{
@@ -5365,7 +5442,7 @@ int atcmd_lwip_receive_data(node *curnode, u8 *buffer, u16 buffer_size, int *rec
 			error_no = 8;
 		}
 	}
-exit:
+
 	if(error_no == 0)
 		*recv_size = size;
 	else{
@@ -5387,82 +5464,185 @@ exit:
 	return error_no;
 }
 
+int atcmd_lwip_receive_data(node *curnode, u8 *buffer, u16 buffer_size, int *recv_size, 
+	u8_t *udp_clientaddr, u16_t *udp_clientport){
+
+	struct timeval tv;
+	fd_set readfds;
+	int ret = 0;
+
+	FD_ZERO(&readfds);
+	FD_SET(curnode->sockfd, &readfds);
+	tv.tv_sec = RECV_SELECT_TIMEOUT_SEC;
+	tv.tv_usec = RECV_SELECT_TIMEOUT_USEC;
+	ret = select(curnode->sockfd + 1, &readfds, NULL, NULL, &tv);
+	if(!((ret > 0)&&(FD_ISSET(curnode->sockfd, &readfds))))
+	{
+		//AT_DBG_MSG(AT_FLAG_LWIP, AT_DBG_ALWAYS, 
+		//	"[ATPR] No receive event for con_id %d", curnode->con_id);
+		*recv_size = 0;
+		return 0;
+	}
+
+	return atcmd_lwip_read_data(curnode, buffer, buffer_size, recv_size, udp_clientaddr, udp_clientport);
+}
+
+/* The socket the auto receive task reads for node n, INVALID_SOCKET_ID if none */
+static int atcmd_lwip_autorecv_fd(int n)
+{
+	node* curnode = tryget_node(n);
+
+	if(curnode == NULL)
+		return INVALID_SOCKET_ID;
+	if((curnode->protocol == NODE_MODE_TCP 
+#if (ATCMD_VER == ATVER_2) && ATCMD_SUPPORT_SSL
+		||curnode->protocol == NODE_MODE_SSL
+#endif
+		)
+		&& curnode->role == NODE_ROLE_SERVER){
+		//TCP Server must receive data from the seed
+		return INVALID_SOCKET_ID;
+	}
+	return curnode->sockfd;
+}
+
+/* Print the data of a node in auto receive mode, ready: the node is known to be readable */
+static void atcmd_lwip_autorecv_node(node *curnode, int ready)
+{
+	int error_no = 0;
+	int recv_size = 0;
+	u8_t udp_clientaddr[16] = {0};
+	u16_t udp_clientport = 0;
+	int packet_size = ETH_MAX_MTU;
+
+	if(ready)
+		error_no = atcmd_lwip_read_data(curnode, rx_buffer, packet_size, &recv_size, udp_clientaddr, &udp_clientport);
+	else
+		error_no = atcmd_lwip_receive_data(curnode, rx_buffer, packet_size, &recv_size, udp_clientaddr, &udp_clientport);
+
+	if(atcmd_lwip_is_tt_mode()){
+		if((error_no == 0) && recv_size){
+			rx_buffer[recv_size] = '\0';
+			AT_DBG_MSG(AT_FLAG_LWIP, AT_DBG_ALWAYS,"Recv[%d]:%s", recv_size, rx_buffer);
+			at_print_data(rx_buffer, recv_size);
+			rtw_msleep_os(20);
+		}
+		return;
+	}
+
+	if(error_no == 0){
+		if(recv_size){
+			rx_buffer[recv_size] = '\0';
+			#if CONFIG_LOG_SERVICE_LOCK
+			log_service_lock();
+			#endif
+			if(curnode->protocol == NODE_MODE_UDP && curnode->role == NODE_ROLE_SERVER){
+				AT_DBG_MSG(AT_FLAG_LWIP, AT_DBG_ALWAYS,
+						"\r\n[ATPR] OK,%d,%d,%s,%d:%s", recv_size, curnode->con_id, udp_clientaddr, udp_clientport, rx_buffer);
+				at_printf("\r\n[ATPR] OK,%d,%d,%s,%d:", recv_size, curnode->con_id, udp_clientaddr, udp_clientport);
+			}
+			else{
+				AT_DBG_MSG(AT_FLAG_LWIP, AT_DBG_ALWAYS,
+						"\r\n[ATPR] OK,%d,%d:%s", 
+						recv_size, 
+						curnode->con_id, rx_buffer);
+				at_printf("\r\n[ATPR] OK,%d,%d:", recv_size, curnode->con_id);
+			}
+			at_print_data(rx_buffer, recv_size);
+			at_printf(STR_END_OF_ATCMD_RET);
+			#if CONFIG_LOG_SERVICE_LOCK
+			log_service_unlock();
+			#endif
+		}
+	}
+	else{
+		#if CONFIG_LOG_SERVICE_LOCK
+		log_service_lock();
+		#endif
+		at_printf("\r\n[ATPR] ERROR:%d,%d", error_no, curnode->con_id);				
+		at_printf(STR_END_OF_ATCMD_RET);
+		#if CONFIG_LOG_SERVICE_LOCK
+		log_service_unlock();
+		#endif
+	}
+}
+
+#if LWIP_SOCKET_EPOLL
+/* Auto receive with an interest list of the node sockets: a pass only reads
+   the nodes that are ready, instead of a select per node */
+static void atcmd_lwip_receive_epoll(int epfd)
+{
+	static int watched[NUM_NS];
+	static struct lwip_epoll_event ready[NUM_NS];
+	struct lwip_epoll_event ev;
+	node* curnode;
+	int i, k, n, fd, nready;
+
+	for (i = 0; i < NUM_NS; ++i)
+		watched[i] = INVALID_SOCKET_ID;
+
+	while(atcmd_lwip_is_autorecv_mode())
+	{
+		// follow the nodes opened and closed by the other commands
+		for (i = 0; i < NUM_NS; ++i) {
+			fd = atcmd_lwip_autorecv_fd(i);
+			if((watched[i] != INVALID_SOCKET_ID) && (fd != watched[i])){
+				lwip_epoll_ctl(epfd, LWIP_EPOLL_CTL_DEL, watched[i], NULL);
+				watched[i] = INVALID_SOCKET_ID;
+			}
+		}
+		for (i = 0; i < NUM_NS; ++i) {
+			fd = atcmd_lwip_autorecv_fd(i);
+			if((fd == INVALID_SOCKET_ID) || (fd == watched[i]))
+				continue;
+			// a socket number reused: the old socket was closed and left the list
+			for (k = 0; k < NUM_NS; ++k) {
+				if(watched[k] == fd)
+					watched[k] = INVALID_SOCKET_ID;
+			}
+			ev.events = LWIP_EPOLLIN;
+			ev.data.u32 = i;
+			if(lwip_epoll_ctl(epfd, LWIP_EPOLL_CTL_ADD, fd, &ev) == 0)
+				watched[i] = fd;
+		}
+
+		nready = lwip_epoll_wait(epfd, ready, NUM_NS, 
+			RECV_SELECT_TIMEOUT_SEC * 1000 + RECV_SELECT_TIMEOUT_USEC / 1000);
+		for (n = 0; n < nready; ++n) {
+			i = (int)ready[n].data.u32;
+			curnode = tryget_node(i);
+			if((curnode != NULL) && (curnode->sockfd == watched[i]))
+				atcmd_lwip_autorecv_node(curnode, 1);
+		}
+	}
+}
+#endif
+
 static void atcmd_lwip_receive_task(void *param)
 {
 
 	int i;
-	int packet_size = ETH_MAX_MTU;
+#if LWIP_SOCKET_EPOLL
+	int epfd;
+#endif
 
 	AT_DBG_MSG(AT_FLAG_LWIP, AT_DBG_ALWAYS, 
 			"Enter auto receive mode");
-	
+
+#if LWIP_SOCKET_EPOLL
+	epfd = lwip_epoll_create();
+	if(epfd >= 0){
+		atcmd_lwip_receive_epoll(epfd);
+		lwip_epoll_close(epfd);
+	}
+	else
+#endif
 	while(atcmd_lwip_is_autorecv_mode())
 	{
 		for (i = 0; i < NUM_NS; ++i) {
-			node* curnode = NULL;
-			int error_no = 0;
-			int recv_size = 0;	
-			u8_t udp_clientaddr[16] = {0};
-			u16_t udp_clientport = 0;			
-			curnode = tryget_node(i);
-			if(curnode == NULL)
-				continue;
-			if((curnode->protocol == NODE_MODE_TCP 
-#if (ATCMD_VER == ATVER_2) && ATCMD_SUPPORT_SSL
-				||curnode->protocol == NODE_MODE_SSL
-#endif
-				)
-				&& curnode->role == NODE_ROLE_SERVER){
-				//TCP Server must receive data from the seed
-				continue;
-			}
-			error_no = atcmd_lwip_receive_data(curnode, rx_buffer, packet_size, &recv_size, udp_clientaddr, &udp_clientport);
-
-			if(atcmd_lwip_is_tt_mode()){
-				if((error_no == 0) && recv_size){
-					rx_buffer[recv_size] = '\0';
-					AT_DBG_MSG(AT_FLAG_LWIP, AT_DBG_ALWAYS,"Recv[%d]:%s", recv_size, rx_buffer);
-					at_print_data(rx_buffer, recv_size);
-					rtw_msleep_os(20);
-				}
+			if(atcmd_lwip_autorecv_fd(i) == INVALID_SOCKET_ID)
 				continue;
-			}
-			
-			if(error_no == 0){
-				if(recv_size){
-					rx_buffer[recv_size] = '\0';
-					#if CONFIG_LOG_SERVICE_LOCK
-					log_service_lock();
-					#endif
-					if(curnode->protocol == NODE_MODE_UDP && curnode->role == NODE_ROLE_SERVER){
-						AT_DBG_MSG(AT_FLAG_LWIP, AT_DBG_ALWAYS,
-								"\r\n[ATPR] OK,%d,%d,%s,%d:%s", recv_size, curnode->con_id, udp_clientaddr, udp_clientport, rx_buffer);
-						at_printf("\r\n[ATPR] OK,%d,%d,%s,%d:", recv_size, curnode->con_id, udp_clientaddr, udp_clientport);
-					}
-					else{
-						AT_DBG_MSG(AT_FLAG_LWIP, AT_DBG_ALWAYS,
-								"\r\n[ATPR] OK,%d,%d:%s", 
-								recv_size, 
-								curnode->con_id, rx_buffer);
-						at_printf("\r\n[ATPR] OK,%d,%d:", recv_size, curnode->con_id);
-					}
-					at_print_data(rx_buffer, recv_size);
-					at_printf(STR_END_OF_ATCMD_RET);
-					#if CONFIG_LOG_SERVICE_LOCK
-					log_service_unlock();
-					#endif
-				}
-			}
-			else{
-				#if CONFIG_LOG_SERVICE_LOCK
-				log_service_lock();
-				#endif
-				at_printf("\r\n[ATPR] ERROR:%d,%d", error_no, curnode->con_id);				
-				at_printf(STR_END_OF_ATCMD_RET);
-				#if CONFIG_LOG_SERVICE_LOCK
-				log_service_unlock();
-				#endif
-			}
+			atcmd_lwip_autorecv_node(tryget_node(i), 0);
 		}
 	}
 
@@ -22,6 +22,9 @@
 #if defined(configUSE_WAKELOCK_PMU) && (configUSE_WAKELOCK_PMU == 1)
 #include "freertos_pmu.h"
 #endif
+#if defined(configHEAP_PROFILING) && (configHEAP_PROFILING == 1)
+#include "freertos_heap_prof.h"
+#endif
 
 #if !defined(CONFIG_PLATFORM_8195BHP) && !defined(CONFIG_PLATFORM_8710C)
 extern u32 ConfigDebugErr;
@@ -2799,6 +2802,73 @@ exit:
 }
 #endif
 
+#if defined(configHEAP_PROFILING) && (configHEAP_PROFILING == 1)
+void fATSH(void *arg)
+{
+	int argc = 0;
+	char *argv[MAX_ARGC] = {0};
+	int top = 8;
+
+	AT_DBG_MSG(AT_FLAG_OS, AT_DBG_ALWAYS, "[ATSH]: _AT_SYS_HEAP_PROFILE_");
+
+	if (arg)
+		argc = parse_param(arg, argv);
+
+	if (argc < 2) {
+		heap_prof_dump(top);
+	} else {
+		switch(argv[1][0]) {
+			case 's': // call sites, largest live bytes first
+				if (argc == 3)
+					top = atoi(argv[2]);
+				heap_prof_dump(top);
+				break;
+
+			case 'b': // binary blob as hex, for host side analysis
+			{
+				int i, len, retry;
+				uint8_t *blob = NULL;
+
+				// this malloc may be a new call site itself, allocate room for a few more and retry
+				for (retry = 0; retry < 3; retry++) {
+					len = heap_prof_get_blob(NULL, 0) + 4 * 20;
+					blob = (uint8_t *)pvPortMalloc(len);
+					if (blob == NULL)
+						break;
+					len = heap_prof_get_blob(blob, len);
+					if (len > 0)
+						break;
+					vPortFree(blob);
+					blob = NULL;
+				}
+				if (blob == NULL)
+					break;
+				for (i = 0; i < len; i++) {
+					printf("%02x", blob[i]);
+					if ((i & 31) == 31)
+						printf("\n\r");
+				}
+				printf("\n\r");
+				vPortFree(blob);
+				break;
+			}
+
+			case 'c': // restart peaks and counters
+				heap_prof_clear();
+				break;
+
+			default:
+				AT_DBG_MSG(AT_FLAG_OS, AT_DBG_ALWAYS, "[ATSH] Usage ATSH=[s/b/c][top]");
+				break;
+		}
+	}
+
+#if ATCMD_VER == ATVER_2
+	at_printf("\r\n[ATSH] OK");
+#endif
+}
+#endif
+
 log_item_t at_sys_items[] = {
 #ifndef CONFIG_INIC_NO_FLASH
 #if ATCMD_VER == ATVER_1
@@ -2868,6 +2938,9 @@ log_item_t at_sys_items[] = {
 #if defined(configUSE_WAKELOCK_PMU) && (configUSE_WAKELOCK_PMU == 1)
 	{"ATSL", fATSL,{NULL,NULL}},	 // wakelock test
 #endif
+#if defined(configHEAP_PROFILING) && (configHEAP_PROFILING == 1)
+	{"ATSH", fATSH,{NULL,NULL}},	 // heap profile
+#endif
 #endif
 };
 
@@ -3,6 +3,7 @@
 #include "atcmd_wifi.h"
 #include <lwip_netconf.h>
 #include "tcpip.h"
+#include "lwip/stats.h"
 #include <dhcp/dhcps.h>
 #if CONFIG_WLAN
 #include <wlan/wlan_test_inc.h>
@@ -51,6 +52,7 @@
 #define _AT_WLAN_SSL_CLIENT_        "ATWL"
 #define _AT_WLAN_PROMISC_           "ATWM"
 #define _AT_WLAN_P2P_INFO_          "ATWN"
+#define _AT_WLAN_NETSTATS_          "ATWn"
 #define _AT_WLAN_OTA_UPDATE_        "ATWO"
 #define	_AT_WLAN_POWER_             "ATWP"
 #define	_AT_WLAN_SIMPLE_CONFIG_     "ATWQ"
@@ -3424,6 +3426,34 @@ void fATWU(void *arg)
 //move to atcmd_lwip.c
 #endif
 #endif
+
+#if CONFIG_LWIP_LAYER && LWIP_NETSTATS
+// ATWn: show the lwIP network counters, ATWn=0: clear them
+void fATWn(void *arg)
+{
+	struct stats_net stats;
+
+	if(arg && (strcmp((char *)arg, "0") == 0)){
+		netstats_reset();
+		at_printf("\r\n[ATWn] counters cleared");
+	}
+	else{
+		netstats_get(&stats);
+		at_printf("\r\n[ATWn] rx frames %u, rx drops %u, tx frames %u, tx errors %u",
+			stats.rx_frames, stats.rx_drops, stats.tx_frames, stats.tx_errors);
+		at_printf("\r\n[ATWn] pbuf alloc fail %u, mbox full %u",
+			stats.pbuf_alloc_fail, stats.mbox_full);
+		at_printf("\r\n[ATWn] tcp rexmit %u, tcp ooseq drop %u, chksum err %u, reass timeout %u",
+			stats.tcp_rexmit, stats.tcp_ooseq_drop, stats.chksum_err, stats.reass_timeout);
+		at_printf("\r\n[ATWn] dns hits %u, neg hits %u, misses %u, prefetch %u",
+			stats.dns_hits, stats.dns_neg_hits, stats.dns_misses, stats.dns_prefetch);
+	}
+#if ATCMD_VER == ATVER_2
+	at_printf("\r\n[ATWn] OK");
+#endif
+}
+#endif
+
 log_item_t at_wifi_items[ ] = {
 #if ATCMD_VER == ATVER_1
 #if CONFIG_LWIP_LAYER
@@ -3431,6 +3461,9 @@ log_item_t at_wifi_items[ ] = {
 	{"ATWI", fATWI,{NULL,NULL}}, 
 	{"ATWT", fATWT,{NULL,NULL}},
 	{"ATWU", fATWU,{NULL,NULL}},
+#if LWIP_NETSTATS
+	{"ATWn", fATWn,{NULL,NULL}},
+#endif
 #endif
 #if WIFI_LOGO_CERTIFICATION_CONFIG
 	{"ATPE", fATPE,}, // set static IP for STA
@@ -3529,6 +3562,9 @@ log_item_t at_wifi_items[ ] = {
 	{"ATWQ", fATWQ,},
 #endif // #if (CONFIG_INCLUDE_SIMPLE_CONFIG)
 #endif // #if CONFIG_WLAN
+#if CONFIG_LWIP_LAYER && LWIP_NETSTATS
+	{"ATWn", fATWn,},
+#endif
 #endif // end of #if ATCMD_VER == ATVER_1
 };
 
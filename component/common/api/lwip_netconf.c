@@ -19,6 +19,13 @@
 #include "wlan_fast_connect/example_wlan_fast_connect.h"
 #endif
 
+/* Input function of the netifs, see ETHERNETIF_RX_BATCH in lwipopts.h */
+#if LWIP_VERSION_MAJOR >= 2 && ETHERNETIF_RX_BATCH
+#define NETIF_INPUT_FN	tcpip_input_batched
+#else
+#define NETIF_INPUT_FN	tcpip_input
+#endif
+
 #if LWIP_VERSION_MAJOR >= 2 && LWIP_VERSION_MINOR >= 1
 #if LWIP_IPV6
 #include "lwip/dhcp6.h"
@@ -189,11 +196,11 @@ void LwIP_Init(void)
 #if LWIP_VERSION_MAJOR >= 2
 #if CONFIG_ETHERNET
 		if(idx == NET_IF_NUM - 1)
-			netif_add(&xnetif[idx], ip_2_ip4(&ipaddr), ip_2_ip4(&netmask),ip_2_ip4(&gw), NULL, &ethernetif_mii_init, &tcpip_input);
+			netif_add(&xnetif[idx], ip_2_ip4(&ipaddr), ip_2_ip4(&netmask),ip_2_ip4(&gw), NULL, &ethernetif_mii_init, &NETIF_INPUT_FN);
 		else
-			netif_add(&xnetif[idx], ip_2_ip4(&ipaddr), ip_2_ip4(&netmask),ip_2_ip4(&gw), NULL, &ethernetif_init, &tcpip_input);
+			netif_add(&xnetif[idx], ip_2_ip4(&ipaddr), ip_2_ip4(&netmask),ip_2_ip4(&gw), NULL, &ethernetif_init, &NETIF_INPUT_FN);
 #else
-		netif_add(&xnetif[idx], ip_2_ip4(&ipaddr), ip_2_ip4(&netmask),ip_2_ip4(&gw), NULL, &ethernetif_init, &tcpip_input);
+		netif_add(&xnetif[idx], ip_2_ip4(&ipaddr), ip_2_ip4(&netmask),ip_2_ip4(&gw), NULL, &ethernetif_init, &NETIF_INPUT_FN);
 #endif
 #else	
 		
@@ -22,8 +22,14 @@
 #define SYS_LIGHTWEIGHT_PROT    1
 
 /* Define LWIP_COMPAT_MUTEX if the port has no mutexes and binary semaphores
- should be used instead */
+ should be used instead. sys_arch.c implements sys_mutex_t with FreeRTOS
+ mutexes, whose priority inheritance LWIP_TCPIP_CORE_LOCKING relies on, so
+ they are used when core locking is enabled on the command line. */
+#if defined(LWIP_TCPIP_CORE_LOCKING) && LWIP_TCPIP_CORE_LOCKING
+#define LWIP_COMPAT_MUTEX       0
+#else
 #define LWIP_COMPAT_MUTEX       1
+#endif
 
 #define ETHARP_TRUST_IP_MAC     0
 #define IP_REASSEMBLY           1
@@ -44,7 +50,9 @@
 /* MEM_ALIGNMENT: should be set to the alignment of the CPU for which
    lwIP is compiled. 4 byte alignment -> define MEM_ALIGNMENT to 4, 2
    byte alignment -> define MEM_ALIGNMENT to 2. */
+#ifndef MEM_ALIGNMENT
 #define MEM_ALIGNMENT           4
+#endif
 
 /* MEM_SIZE: the size of the heap memory. If the application will send
 a lot of data that needs to be copied, this should be set high. */
@@ -112,6 +120,30 @@ a lot of data that needs to be copied, this should be set high. */
 /* PBUF_POOL_BUFSIZE: the size of each pbuf in the pbuf pool. */
 #define PBUF_POOL_BUFSIZE       500
 
+/* ETHERNETIF_RX_ZERO_COPY==1: ethernetif_recv() passes the wlan rx skb data to
+   lwIP in a PBUF_REF custom pbuf instead of copying it into the pbuf pool. The
+   skb goes back to the driver when the pbuf is freed. At most
+   ETHERNETIF_RX_ZERO_COPY_NUM skbs are held, further frames are copied. They
+   come from the skb data pool of the driver (MAX_SKB_BUF_NUM in
+   rtw_opt_skbuf.c), which is shared with tx, so keep it well below that. */
+#ifndef ETHERNETIF_RX_ZERO_COPY
+#define ETHERNETIF_RX_ZERO_COPY         0
+#endif
+#define ETHERNETIF_RX_ZERO_COPY_NUM     4
+#if ETHERNETIF_RX_ZERO_COPY
+#define LWIP_SUPPORT_CUSTOM_PBUF        1
+#endif
+
+/* ETHERNETIF_RX_BATCH==1: the netif input is tcpip_input_batched() of
+   sys_arch.c instead of tcpip_input(). Received frames wait in a queue of
+   ETHERNETIF_RX_BATCH_SIZE frames and one mbox message has the TCP_IP thread
+   process all that came in before it ran, instead of one message and one
+   wakeup per frame. */
+#ifndef ETHERNETIF_RX_BATCH
+#define ETHERNETIF_RX_BATCH             1
+#endif
+#define ETHERNETIF_RX_BATCH_SIZE        16
+
 
 /* ---------- TCP options ---------- */
 #define LWIP_TCP                1
@@ -150,6 +182,20 @@ a lot of data that needs to be copied, this should be set high. */
     #define TCP_WND                 (2*TCP_MSS)
 #endif
 
+/* Out-of-order data kept per connection: at most one window, and half of
+   the pbuf pool so that one lossy connection cannot starve the others. */
+#define TCP_OOSEQ_MAX_BYTES     TCP_WND
+#define TCP_OOSEQ_MAX_PBUFS     (PBUF_POOL_SIZE / 2)
+
+/* Selective acknowledgments (RFC 2018): report the out-of-order data to the
+   peer and retransmit only the holes the peer reports. */
+#ifndef LWIP_TCP_SACK_OUT
+#define LWIP_TCP_SACK_OUT       1
+#endif
+#ifndef LWIP_TCP_SACK_IN
+#define LWIP_TCP_SACK_IN        1
+#endif
+
 /* ---------- ICMP options ---------- */
 #define LWIP_ICMP                       1
 
@@ -168,6 +214,18 @@ a lot of data that needs to be copied, this should be set high. */
 #define UDP_TTL                 255
 /* ---------- DNS options ---------- */
 #define LWIP_DNS                        1
+/* OTA, MQTT, SNTP and the cloud agents resolve the same few names over and
+   over: keep more answers, remember failed names for a while and refresh the
+   names in use before their TTL runs out */
+#ifndef DNS_TABLE_SIZE
+#define DNS_TABLE_SIZE                  8
+#endif
+#ifndef DNS_NEG_TTL
+#define DNS_NEG_TTL                     30
+#endif
+#ifndef DNS_PREFETCH
+#define DNS_PREFETCH                    1
+#endif
 
 /* ---------- UPNP options --------- */
 #define LWIP_UPNP		0
@@ -266,6 +324,11 @@ extern unsigned int sys_now(void);
 /* ---------- Statistics options ---------- */
 #define LWIP_STATS 0
 #define LWIP_PROVIDE_ERRNO 1
+/* LWIP_NETSTATS==1: the few always-on counters of lwip_netstats, read with
+   netstats_get() or the ATWn command */
+#ifndef LWIP_NETSTATS
+#define LWIP_NETSTATS 1
+#endif
 
 
 /*
@@ -311,6 +374,21 @@ Certain platform allows computing and verifying the IP, UDP, TCP and ICMP checks
   #define CHECKSUM_CHECK_TCP              1
 #endif
 
+/* LWIP_PORT_CHKSUM==1: use the word-at-a-time checksum of
+   port/realtek/freertos/chksum.c as LWIP_CHKSUM, and let tcp_write() sum
+   the data while it copies it (LWIP_CHECKSUM_ON_COPY), so tcp_output() does
+   not read the payload a second time. */
+#ifndef LWIP_PORT_CHKSUM
+#define LWIP_PORT_CHKSUM                1
+#endif
+#if LWIP_PORT_CHKSUM
+extern unsigned short lwip_port_chksum(const void *dataptr, int len);
+extern unsigned short lwip_port_chksum_copy(void *dst, const void *src, unsigned short len);
+#define LWIP_CHKSUM                     lwip_port_chksum
+#define LWIP_CHECKSUM_ON_COPY           1
+#define LWIP_CHKSUM_COPY(dst, src, len) lwip_port_chksum_copy(dst, src, len)
+#endif
+
 
 /*
    ----------------------------------------------
@@ -365,7 +443,29 @@ Certain platform allows computing and verifying the IP, UDP, TCP and ICMP checks
 /* Added by Realtek end */
 
 /* Extra options for lwip_v2.0.2 which should not affect lwip_v1.4.1 */
+/* LWIP_TCPIP_CORE_LOCKING==1: the socket and netconn API run the stack in the
+   calling task with the core mutex held instead of posting an api_msg to the
+   TCP_IP thread and waiting for it, which saves two context switches per
+   call. The calling task then runs tcp_output() down to the wlan driver, so
+   give socket tasks at least 512 words of stack. Received frames and
+   tcpip_callback() still go through the TCP_IP thread.
+   Off by default until validated on target with the stack sizes of the
+   shipped examples and prebuilt libraries, opt in with
+   -DLWIP_TCPIP_CORE_LOCKING=1. */
+#ifndef LWIP_TCPIP_CORE_LOCKING
 #define LWIP_TCPIP_CORE_LOCKING         0
+#endif
+/* LWIP_TIMERS_WHEEL==1: sys_timeout() files the timeouts in a timer wheel
+   instead of a sorted list, and the TCP_IP thread only wakes up for real
+   deadlines. The PMU reads the next one with pmu_get_lwip_sleep_time(). */
+#ifndef LWIP_TIMERS_WHEEL
+#define LWIP_TIMERS_WHEEL               1
+#endif
+/* LWIP_SOCKET_EPOLL==1: lwip_epoll_*() interest lists, used by the AT
+   command auto receive task instead of a select() per connection */
+#ifndef LWIP_SOCKET_EPOLL
+#define LWIP_SOCKET_EPOLL               1
+#endif
 #define LWIP_TCPIP_TIMEOUT              1
 #define LWIP_SO_RCVTIMEO                1
 #define LWIP_SOCKET_SET_ERRNO           0
@@ -12,6 +12,8 @@
 #define WIFI_MANAGER_STACKSIZE	1300
 #define WIFI_MANAGER_PRIORITY		(0) //Actual priority is 4 since calling rtw_create_task
 #define WIFI_MANAGER_Q_SZ	8
+#define WIFI_MANAGER_BUF_SZ	128	// event copies up to this size come from a pool instead of the heap
+#define WIFI_MANAGER_BUF_NUM	WIFI_MANAGER_Q_SZ
 
 #define WIFI_EVENT_MAX_ROW	3
 /******************************************************
@@ -21,6 +23,7 @@
 static event_list_elem_t     event_callback_list[WIFI_EVENT_MAX][WIFI_EVENT_MAX_ROW];
 #if CONFIG_WIFI_IND_USE_THREAD
 static rtw_worker_thread_t          wifi_worker_thread;
+static rtw_mempool_t               *wifi_event_pool = NULL;
 #endif
 
 //----------------------------------------------------------------------------//
@@ -42,7 +45,11 @@ static rtw_result_t rtw_send_event_to_worker(int event_cmd, char *buf, int buf_l
 		message.function = (event_handler_t)event_callback_list[event_cmd][i].handler;
 		message.buf_len = buf_len;
 		if(buf_len){
-			local_buf = (char*)pvPortMalloc(buf_len);
+			local_buf = NULL;
+			if(wifi_event_pool && (buf_len <= WIFI_MANAGER_BUF_SZ))
+				local_buf = (char*)rtw_mempool_alloc(wifi_event_pool);
+			if(local_buf == NULL)
+				local_buf = (char*)pvPortMalloc(buf_len);
 			if(local_buf == NULL)
 				return RTW_NOMEM;
 			memcpy(local_buf, buf, buf_len);
@@ -56,7 +63,8 @@ static rtw_result_t rtw_send_event_to_worker(int event_cmd, char *buf, int buf_l
 		if(ret != RTW_SUCCESS){
 			if(local_buf){
 				printf("\r\nrtw_send_event_to_worker: enqueue cmd %d failed and free %p(%d)\n", event_cmd, local_buf, buf_len);
-				vPortFree(local_buf);
+				if(!rtw_mempool_release(local_buf))
+					vPortFree(local_buf);
 			}
 			break;
 		}
@@ -260,6 +268,8 @@ void init_event_callback_list(void){
 int wifi_manager_init(void)
 {
 #if CONFIG_WIFI_IND_USE_THREAD
+	if(wifi_event_pool == NULL)
+		wifi_event_pool = rtw_mempool_create(WIFI_MANAGER_BUF_SZ, WIFI_MANAGER_BUF_NUM);
 	rtw_create_worker_thread(&wifi_worker_thread, 
 							WIFI_MANAGER_PRIORITY, 
 							WIFI_MANAGER_STACKSIZE, 
@@ -272,6 +282,9 @@ void rtw_wifi_manager_deinit(void)
 {
 #if CONFIG_WIFI_IND_USE_THREAD
 	rtw_delete_worker_thread(&wifi_worker_thread);
+	// events still queued keep their blocks, the pool is then reused by wifi_manager_init()
+	if(rtw_mempool_delete(wifi_event_pool) == _SUCCESS)
+		wifi_event_pool = NULL;
 #endif
 }
 
@@ -17,6 +17,7 @@
 
 #include "MQTTFreertos.h"
 #include "netdb.h"
+#include "ssl_session_store.h"
 
 #ifdef LWIP_IPV6
 #undef LWIP_IPV6
@@ -545,6 +546,11 @@ int FreeRTOS_write(Network* n, unsigned char* buffer, int len, int timeout_ms)
 void FreeRTOS_disconnect(Network* n)
 {
 	if (n->my_socket >= 0){
+#if (MQTT_OVER_SSL)
+		/* without close_notify servers drop the session from their cache */
+		if (n->use_ssl && n->ssl)
+			mbedtls_ssl_close_notify(n->ssl);
+#endif
 		shutdown(n->my_socket, SHUT_RDWR);
 		close(n->my_socket);
 		n->my_socket = -1;
@@ -787,6 +793,8 @@ int NetworkConnect(Network* n, char* addr, int port)
 
 			mbedtls_ssl_conf_own_cert(n->conf, client_crt, client_rsa);
 		}
+
+		ssl_session_store_set(n->ssl, addr, port);
 	
 		retVal = mbedtls_ssl_handshake(n->ssl);
 		if (retVal < 0) {
@@ -794,6 +802,7 @@ int NetworkConnect(Network* n, char* addr, int port)
 			goto err;
 		} else {
 			mqtt_printf(MQTT_DEBUG, "ssl handshake success");
+			ssl_session_store_get(n->ssl, addr, port);
 		}
 	}
 
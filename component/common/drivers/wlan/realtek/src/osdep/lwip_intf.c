@@ -148,6 +148,46 @@ void rltk_wlan_recv(int idx, struct eth_drv_sg *sg_list, int sg_len)
 #endif
 }
 
+/**
+ *      rltk_wlan_recv_skb - take the pending rx skb without copying it. Called by ethernetif_recv()
+ *      in place of rltk_wlan_recv() when ETHERNETIF_RX_ZERO_COPY is enabled.
+ *      @idx: netif index
+ *
+ *      Return Value: a clone of the rx skb sharing its data buffer, which stays valid after the
+ *      driver frees the rx skb until the clone is released with rltk_wlan_free_skb(). NULL if no
+ *      skb is available.
+ */     
+struct sk_buff * rltk_wlan_recv_skb(int idx)
+{
+#if (CONFIG_LWIP_LAYER == 1)
+	struct sk_buff *skb;
+	
+	DBG_TRACE("%s is called", __FUNCTION__);
+	if(idx == -1){
+		DBG_ERR("skb is NULL");
+		return NULL;
+	}
+	skb = rltk_wlan_get_recv_skb(idx);
+	if(skb == NULL)
+		return NULL;
+
+	return skb_clone(skb, 0);
+#else
+	return NULL;
+#endif
+}
+
+/**
+ *      rltk_wlan_free_skb - release a skb returned by rltk_wlan_recv_skb().
+ *      @skb: the skb
+ *
+ *      Return Value: None
+ */     
+void rltk_wlan_free_skb(struct sk_buff *skb)
+{
+	kfree_skb(skb);
+}
+
 int netif_is_valid_IP(int idx, unsigned char *ip_dest)
 {
 #if defined(CONFIG_MBED_ENABLED)
@@ -51,6 +51,8 @@ void rltk_wlan_set_netif_info(int idx_wlan, void * dev, unsigned char * dev_addr
 void rltk_wlan_send_skb(int idx, struct sk_buff *skb);	//struct sk_buff as defined above comment line
 int rltk_wlan_send(int idx, struct eth_drv_sg *sg_list, int sg_len, int total_len);
 void rltk_wlan_recv(int idx, struct eth_drv_sg *sg_list, int sg_len);
+struct sk_buff * rltk_wlan_recv_skb(int idx);
+void rltk_wlan_free_skb(struct sk_buff *skb);
 unsigned char rltk_wlan_running(unsigned char idx);		// interface is up. 0: interface is down
 
 #if defined(CONFIG_MBED_ENABLED)
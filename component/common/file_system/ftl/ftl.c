@@ -42,7 +42,13 @@
 //#define SAVE_TO_STORAGE_RECONFIRM_EN 1
 
 #define FTL_USE_MAPPING_TABLE			1
+#define FTL_MAX_RECORD_WORDS			32 // max words covered by one key, 128 bytes
 #define FTL_ONLY_GC_IN_IDLE				0
+#define FTL_GC_STEP_CELLS				32 // default cells scanned by one incremental gc step
+#define FTL_CHECKPOINT_MAGIC			0x4B435446 // "FTCK"
+#define FTL_WRITE_CACHE_WORDS			16 // default words held by the write-back cache
+#define FTL_WRITE_CACHE_MAX_WORDS		64
+#define FTL_RESET_FLUSH_WAIT_MS			100 // ftl_flush_before_reset() waits this long for ftl_sem
 #define FTL_APP_LOGICAL_ADDR_BASE		0
 
 
@@ -50,6 +56,17 @@
 #define RAVEN_DEBUG 1
 #endif
 
+// FTL_SIMULATION is set by the host build in sim/, which measures gc with these hooks
+#if defined(FTL_SIMULATION) && (FTL_SIMULATION == 1)
+extern void ftl_sim_gc_begin(void);
+extern void ftl_sim_gc_end(uint16_t recycle_num);
+#define FTL_SIM_GC_BEGIN()              ftl_sim_gc_begin()
+#define FTL_SIM_GC_END(recycle_num)     ftl_sim_gc_end(recycle_num)
+#else
+#define FTL_SIM_GC_BEGIN()
+#define FTL_SIM_GC_END(recycle_num)
+#endif
+
 /////////////////////////////////////////////////////////////////
 #define LOGIC_ADDR_MAP_BIT_NUM 12
 
@@ -83,6 +100,9 @@ uint32_t g_WriteCnt;
 #define MAX_logical_address_size (((PAGE_element_data*(g_PAGE_num-1))-1)<<2)
 
 #define MAPPING_TABLE_SIZE   (MAX_logical_address_size / 4 * LOGIC_ADDR_MAP_BIT_NUM / 8)
+#define MAPPING_TABLE_PACKED_MAX_PAGE_NUM   (8)     // 12 bit of 8 bytes aligned cell offset
+#define MAPPING_TABLE_HASH_MAX_PAGE_NUM     (33)    // 16 bit logical address, MAX_logical_address_size <= 0xffff
+#define MAPPING_HASH_SIZE    (ftl_mapping_hash_size * sizeof(struct Mapping_Hash_T))
 
 #define BIT_VALID           BIT31
 
@@ -92,6 +112,17 @@ uint32_t g_WriteCnt;
 #define INFO_end_index (1)
 #define INFO_size      (2)
 
+// erase count is kept inverted in bit 16..30 of INFO_end_index, so a page of old format reads 0
+#define ERASE_CNT_MAX           0x7fff
+#define ERASE_CNT_SHIFT         16
+
+// one record is [data 0 .. data n-1][pad if n is even][key], key always at odd index
+#define FTL_RECORD_CELLS(length)    (((length) + 2) & ~1)
+
+// bit 24..30 of the key hold ~length, a key torn while programmed can not pass as complete
+#define FTL_KEY_CHECK_SHIFT         24
+#define FTL_KEY_CHECK_MASK          0x7f
+
 #define FTL_ASSERT(x)   //PLATFORM_ASSERT(x)
 
 // 2K bytes / per page
@@ -100,17 +131,74 @@ struct Page_T
     uint32_t Data[PAGE_element];
 };
 
+// entry of the hash mapping table, addr 0 is free
+struct Mapping_Hash_T
+{
+    uint16_t addr;      // logical_addr / 4 + 1
+    uint16_t phy;       // cell index / 2
+};
+
+// head of the checkpoint, followed by the mapping table snapshot and crc32 of both
+struct Checkpoint_T
+{
+    uint32_t magic;
+    uint8_t  cur_pageID;        // position of the snapshot, newer records are replayed at mount
+    uint8_t  page_num;
+    uint16_t free_cell_index;
+    uint8_t  mapping_type;
+    uint8_t  seq;               // newest slot is used first
+    uint16_t hash_size;
+    uint32_t table_size;
+    uint16_t page_seq[MAPPING_TABLE_HASH_MAX_PAGE_NUM];    // 0xffff for page not valid
+};
+
+// entry of the write-back cache, addr 0 is free
+struct Write_Cache_T
+{
+    uint16_t addr;      // logical_addr / 4 + 1
+    uint8_t  dirty;
+    uint32_t data;
+};
+
 
 QueueHandle_t ftl_sem = NULL;
 uint8_t *ftl_mapping_table = NULL;
+uint8_t ftl_mapping_type = FTL_MAPPING_TABLE_PACKED;
+uint16_t ftl_mapping_hash_size = 0;   // entries, power of 2
+uint16_t ftl_mapping_hash_count = 0;
 bool do_gc_in_idle = FALSE;
 uint8_t idle_gc_page_thres = 1;
 uint16_t idle_gc_cell_thres = PAGE_element / 2;
 
+#define GC_PAGE_NONE    0xff
+bool gc_incremental = FALSE;
+uint16_t gc_step_cells = FTL_GC_STEP_CELLS;
+uint8_t gc_reserve_page = 1;
+uint8_t g_gc_pageID = GC_PAGE_NONE;    // victim page of the incremental gc in progress
+uint16_t g_gc_key_index;               // next key to migrate in victim page
+
+uint32_t ftl_checkpoint_addr = 0;      // 0 is no checkpoint
+uint8_t ftl_checkpoint_sector_num = 0;
+uint8_t ftl_checkpoint_interval = 1;
+uint8_t ftl_checkpoint_gc_count = 0;
+uint8_t ftl_checkpoint_slot = 0;       // slot of last checkpoint, slots are written in turn
+uint8_t ftl_checkpoint_seq = 0;
+
+struct Write_Cache_T *ftl_write_cache = NULL;   // NULL is no cache
+uint8_t ftl_write_cache_num = 0;
+uint8_t ftl_write_cache_dirty = 0;
+uint32_t ftl_write_cache_delay_ms = 0;          // idle flush once the oldest dirty word is this old
+uint32_t ftl_write_cache_dirty_time;
+
 extern uint32_t ftl_write(uint16_t logical_addr, uint32_t w_data);
+uint32_t ftl_write_record(uint16_t logical_addr, const uint32_t *w_data, uint8_t length);
 extern bool ftl_page_erase(struct Page_T *p);
 void ftl_mapping_table_init(void);
 uint16_t read_mapping_table(uint16_t logical_addr);
+void ftl_checkpoint_save(void);
+void ftl_checkpoint_invalidate(void);
+uint32_t ftl_read(uint16_t logical_addr, uint32_t *value);
+uint32_t ftl_write_cache_flush(void);
 
 uint32_t ftl_page_read(struct Page_T *p, uint32_t index)
 {
@@ -142,6 +230,15 @@ void ftl_flash_write(uint32_t start_addr, uint32_t data)
 	device_mutex_unlock(RT_DEV_LOCK_FLASH);
 }
 
+void ftl_flash_write_burst(uint32_t start_addr, const uint32_t *data, uint32_t word_num)
+{
+	flash_t flash;
+
+	device_mutex_lock(RT_DEV_LOCK_FLASH);
+	flash_burst_write(&flash, start_addr, word_num << 2, (uint8_t *)data);
+	device_mutex_unlock(RT_DEV_LOCK_FLASH);
+}
+
 bool ftl_flash_erase_sector(uint32_t addr)
 {
 	flash_t flash;
@@ -181,6 +278,33 @@ uint32_t ftl_page_write(struct Page_T *p, uint32_t index, uint32_t data)
 
 }
 
+uint32_t ftl_page_write_burst(struct Page_T *p, uint32_t index, const uint32_t *data, uint32_t word_num)
+{
+	flash_t flash;
+    uint32_t i;
+
+    if (index + word_num <= PAGE_element)
+    {
+        ftl_flash_write_burst((uint32_t)&p->Data[index], data, word_num);
+        for (i = 0; i < word_num; i++)
+        {
+            uint32_t rdata = 0;
+            flash_read_word(&flash, (uint32_t)&p->Data[index + i], &rdata);
+            if (data[i] != rdata)
+            {
+                FTL_PRINTF(FTL_LEVEL_ERROR, "[ftl](ftl_page_write_burst) P: %x, idx: %d, D: 0x%08x, read back: %x \n",
+                                   p, index + i, data[i], rdata);
+                return FTL_WRITE_ERROR_READ_BACK;
+            }
+        }
+        return FTL_WRITE_SUCCESS;
+    }
+    else
+    {
+        return FTL_WRITE_ERROR_OUT_OF_SPACE;
+    }
+}
+
 uint8_t ftl_get_page_seq(struct Page_T *p)
 {
     uint32_t tmp = ftl_page_read(p, INFO_beg_index);
@@ -206,9 +330,10 @@ uint8_t ftl_key_get_length(uint32_t key)
     }
 }
 
+// key before commit, BIT_VALID is cleared once the data is written
 uint32_t ftl_key_init(uint16_t logical_addr, uint8_t length)
 {
-    FTL_ASSERT(length == 1); // todo
+    FTL_ASSERT(length >= 1 && length <= FTL_MAX_RECORD_WORDS);
 
     uint32_t result;
 
@@ -216,11 +341,66 @@ uint32_t ftl_key_init(uint16_t logical_addr, uint8_t length)
     result <<= 16;
 
     result |= logical_addr;
-    result |= 0xff000000;
+    result |= BIT_VALID;
+    result |= ((~length & FTL_KEY_CHECK_MASK) << FTL_KEY_CHECK_SHIFT);
 
     return result;
 }
 
+// length of a key programmed completely but not committed, 0 if the key program was torn
+// program only clears bits, so a torn key has more length bits and fewer check bits
+uint8_t ftl_key_get_pending_length(uint32_t key)
+{
+    uint8_t length = (key >> 16);
+
+    if (flash_get_bit(key, BIT_VALID) ||
+        (((key >> FTL_KEY_CHECK_SHIFT) & FTL_KEY_CHECK_MASK) != (~length & FTL_KEY_CHECK_MASK)))
+    {
+        return 0;
+    }
+
+    return length;
+}
+
+// cells of the record ending at key_index, 0 if the key can not be parsed
+// a key torn by power loss may hold any length and address, such a record is dead
+uint16_t ftl_key_get_record_cells(uint32_t key, uint16_t key_index)
+{
+    uint16_t addr = key & 0xffff;
+    uint8_t length = ftl_key_get_length(key);
+
+    if ((length == 0) || (length > FTL_MAX_RECORD_WORDS))
+    {
+        return 0;
+    }
+
+    if ((key_index >= PAGE_element) || (FTL_RECORD_CELLS(length) > key_index - 1))
+    {
+        return 0;
+    }
+
+    if ((addr & 0x3) || (addr + (length << 2) > MAX_logical_address_size))
+    {
+        return 0;
+    }
+
+    return FTL_RECORD_CELLS(length);
+}
+
+// index of the word holding logical_addr in the record ending at key_index, 0 if not inside
+uint16_t ftl_key_get_data_index(uint32_t key, uint16_t key_index, uint16_t logical_addr)
+{
+    uint16_t addr = key & 0xffff;
+    uint8_t length = ftl_key_get_length(key);
+
+    if ((logical_addr < addr) || (logical_addr >= addr + (length << 2)))
+    {
+        return 0;
+    }
+
+    return key_index - FTL_RECORD_CELLS(length) + 1 + ((logical_addr - addr) >> 2);
+}
+
 // logical_addr is 4 bytes alignment addr
 uint32_t ftl_check_logical_addr(uint16_t logical_addr)
 {
@@ -378,16 +558,16 @@ L_retry:
 
         if (EndPageID != pageID)
         {
-            for (; key_index >= 3; key_index -= 2)
+            uint16_t cells;
+            for (; key_index >= 3; key_index -= cells)
             {
                 uint32_t key = ftl_page_read(g_pPage + pageID, key_index);
 
-                uint32_t length = ftl_key_get_length(key);
+                cells = ftl_key_get_record_cells(key, key_index);
 
-                if (length == 1)
+                if (cells)
                 {
-                    uint16_t addr = key & 0xffff;
-                    if (addr == logical_addr)
+                    if (ftl_key_get_data_index(key, key_index, logical_addr))
                     {
                         found = 1;
                         //r_data = ftl_page_read( g_pPage+pageID,key_index-1 );
@@ -396,7 +576,8 @@ L_retry:
                 }
                 else
                 {
-                    FTL_PRINTF(FTL_LEVEL_ERROR, "[ftl] length != 1! func: %s, line: %d", __FUNCTION__, __LINE__);
+                    cells = 2;
+                    FTL_PRINTF(FTL_LEVEL_ERROR, "[ftl] invalid length! func: %s, line: %d", __FUNCTION__, __LINE__);
                 }
             }
 
@@ -473,6 +654,64 @@ uint8_t ftl_page_get_oldest(void)
 
 
 
+// copy live words of the record ending at key_index to current page, return dropped word count
+// with pLaterNum, words which do not fit in current page are not written but counted there
+uint16_t ftl_page_migrate_record(uint8_t pageID, uint16_t key_index, uint32_t key, uint16_t *pLaterNum)
+{
+    uint16_t addr = key & 0xffff;
+    uint8_t length = ftl_key_get_length(key);
+    uint16_t data_index;
+
+    uint32_t run[FTL_MAX_RECORD_WORDS];
+    uint16_t run_addr = addr;
+    uint8_t run_len = 0;
+    uint16_t drop_num = 0;
+    uint8_t i;
+
+    if (ftl_key_get_record_cells(key, key_index) == 0)
+    {
+        // dead record, nothing to copy
+        return 1;
+    }
+    data_index = key_index - FTL_RECORD_CELLS(length) + 1;
+
+    for (i = 0; i <= length; ++i, addr += 4)
+    {
+        if ((i < length) && !ftl_page_can_addr_drop(addr, pageID))
+        {
+            // copy it, consecutive live words go to one record
+            if (run_len == 0)
+            {
+                run_addr = addr;
+            }
+            run[run_len++] = ftl_page_read(g_pPage + pageID, data_index + i);
+            continue;
+        }
+
+        if (i < length)
+        {
+            // drop / recycle
+            ++drop_num;
+        }
+
+        if (run_len)
+        {
+            // write to another place
+            if ((pLaterNum == NULL) || (g_free_cell_index + FTL_RECORD_CELLS(run_len) <= PAGE_element))
+            {
+                ftl_write_record(run_addr, run, run_len);
+            }
+            else
+            {
+                *pLaterNum += run_len;
+            }
+            run_len = 0;
+        }
+    }
+
+    return drop_num;
+}
+
 uint16_t   ftl_page_garbage_collect_Imp(void)
 {
     uint16_t RecycleNum = 0;
@@ -508,38 +747,22 @@ L_retry:
     }
 
     // drop or copy it
-    for (; key_index >= 3; key_index -= 2)
+    uint16_t cells;
+    for (; key_index >= 3; key_index -= cells)
     {
         uint32_t key = ftl_page_read(g_pPage + Recycle_page, key_index);
 
-        uint32_t length = ftl_key_get_length(key);
-        if (length == 1)
+        cells = ftl_key_get_record_cells(key, key_index);
+        if (cells)
         {
-            uint16_t addr = key & 0xffff;
-
-            if (ftl_page_can_addr_drop(addr, Recycle_page))
-            {
-                // drop / recycle
-                //DPRINTF("drop [%d] addr: 0x%08x \n", candidate_key_index, candidate_addr);
-
-                ++RecycleNum;
-            }
-            else
-            {
-                // copy it
-                //DPRINTF("copy [%d] addr: 0x%08x \n", candidate_key_index, candidate_addr);
-
-                uint32_t rdata = ftl_page_read(g_pPage + Recycle_page, key_index - 1);
-
-                // write to another place
-                ftl_write(addr, rdata);
-            }
+            RecycleNum += ftl_page_migrate_record(Recycle_page, key_index, key, NULL);
         }
         else
         {
-            FTL_PRINTF(FTL_LEVEL_ERROR, "ftl_page_garbage_collect_Imp:length != 1!recycle page:%x, retry_count:%x, index:%x, read value:%x",
+            FTL_PRINTF(FTL_LEVEL_ERROR, "ftl_page_garbage_collect_Imp:invalid length!recycle page:%x, retry_count:%x, index:%x, read value:%x",
                                Recycle_page, retry_count, key_index, key);
 
+            cells = 2;
             ++RecycleNum;
         }
     }
@@ -552,6 +775,12 @@ L_retry:
         return RecycleNum;
     }
 
+    if (Recycle_page == g_gc_pageID)
+    {
+        // incremental gc of this page is done as well
+        g_gc_pageID = GC_PAGE_NONE;
+    }
+
 
     FTL_PRINTF(FTL_LEVEL_INFO, "[ftl] ftl_page_garbage_collect_Imp: Recycle_page:%d, RecycleNum:%d, retry_count:%d",
                       Recycle_page, RecycleNum, retry_count);
@@ -573,6 +802,7 @@ L_retry:
     //DPRINTF("----ftl_page_garbage_collect_Imp, RecycleNum:%d \n", RecycleNum);
 
     g_free_page_count = ftl_get_free_page_count();
+    ftl_checkpoint_save();
     return RecycleNum;
 }
 
@@ -595,7 +825,10 @@ uint8_t ftl_page_garbage_collect(uint32_t page_thresh, uint32_t cell_thresh)
             {
                 FTL_PRINTF(FTL_LEVEL_INFO, "[ftl] doGarbageCollection: page thres %d, cell thres %d", page_thresh,
                                   cell_thresh);
-                ftl_page_garbage_collect_Imp();
+                FTL_SIM_GC_BEGIN();
+                uint16_t recycle_num = ftl_page_garbage_collect_Imp();
+                FTL_SIM_GC_END(recycle_num);
+                (void)recycle_num;
                 result = 1;
             }
         }
@@ -611,13 +844,104 @@ uint8_t ftl_page_garbage_collect(uint32_t page_thresh, uint32_t cell_thresh)
     return result;
 }
 
+// one step of incremental gc: migrate records of the oldest page scanning at most max_cells cells,
+// or erase it once all records are migrated if allow_erase, so the time of one call is bounded.
+// gc starts when free pages <= gc_reserve_page. When the last free page is in use the rest is
+// done at once, which is the only case a step is not bounded.
+// return TRUE while gc is still pending
+bool ftl_page_garbage_collect_step(uint16_t max_cells, bool allow_erase)
+{
+    bool pending;
+
+    if (g_pPage == NULL)
+    {
+        return FALSE;
+    }
+
+    if (NULL != ftl_sem)
+    {
+		xSemaphoreTakeRecursive(ftl_sem, portMAX_DELAY);
+    }
+
+    if (g_doingGarbageCollection == 0)
+    {
+        g_doingGarbageCollection = 1;
+
+        if ((g_gc_pageID == GC_PAGE_NONE) && (g_free_page_count <= gc_reserve_page) &&
+            (g_PAGE_num - ftl_get_free_page_count() >= 2))
+        {
+            g_gc_pageID = ftl_page_get_oldest();
+            if (ftl_get_page_end_position(g_pPage + g_gc_pageID, &g_gc_key_index))
+            {
+                g_gc_key_index = PAGE_element - 1;
+            }
+        }
+
+        if (g_gc_pageID != GC_PAGE_NONE)
+        {
+            uint16_t scanned = 0;
+
+            FTL_SIM_GC_BEGIN();
+
+            while ((g_gc_key_index >= 3) && ((scanned < max_cells) || (g_free_page_count == 0)))
+            {
+                uint32_t key = ftl_page_read(g_pPage + g_gc_pageID, g_gc_key_index);
+                uint16_t cells = ftl_key_get_record_cells(key, g_gc_key_index);
+
+                if (cells)
+                {
+                    ftl_page_migrate_record(g_gc_pageID, g_gc_key_index, key, NULL);
+                }
+                else
+                {
+                    cells = 2;
+                }
+
+                g_gc_key_index -= cells;
+                scanned += cells;
+            }
+
+            if ((g_gc_key_index < 3) &&
+                ((allow_erase && (scanned == 0)) || (g_free_page_count == 0)))
+            {
+                ftl_page_erase(g_pPage + g_gc_pageID);
+                g_gc_pageID = GC_PAGE_NONE;
+                g_free_page_count = ftl_get_free_page_count();
+                ftl_checkpoint_save();
+            }
+
+            FTL_SIM_GC_END(scanned);
+        }
+
+        g_doingGarbageCollection = 0;
+    }
+
+    pending = (g_gc_pageID != GC_PAGE_NONE);
+
+    if (NULL != ftl_sem)
+    {
+		xSemaphoreGiveRecursive(ftl_sem);
+    }
+
+    return pending;
+}
+
 void ftl_garbage_collect_in_idle(void)
 {
     if (g_pPage == NULL)
     {
         return ;
     }
-    if (do_gc_in_idle)
+    if (ftl_write_cache_dirty &&
+        ((uint32_t)rtw_get_passing_time_ms(ftl_write_cache_dirty_time) >= ftl_write_cache_delay_ms))
+    {
+        ftl_write_cache_flush();
+    }
+    if (do_gc_in_idle && gc_incremental)
+    {
+        ftl_page_garbage_collect_step(gc_step_cells, TRUE);
+    }
+    else if (do_gc_in_idle)
     {
         if (g_free_page_count <= idle_gc_page_thres)
         {
@@ -631,8 +955,9 @@ void ftl_garbage_collect_in_idle(void)
 
 void ftl_set_page_end_position(struct Page_T *p, uint16_t Endpos)
 {
-    uint32_t data = Endpos;
-    data |= 0xffff0000;
+    // keep erase count in upper half
+    uint32_t data = ftl_page_read(p, INFO_end_index);
+    data &= (0xffff0000 | Endpos);
 
     //ftl_page_write(p, INFO_end_index,  data);
 
@@ -642,6 +967,33 @@ void ftl_set_page_end_position(struct Page_T *p, uint16_t Endpos)
     ftl_page_write(p, INFO_end_index,  data);
 }
 
+uint16_t ftl_page_get_erase_cnt(struct Page_T *p)
+{
+    uint32_t info = ftl_page_read(p, INFO_end_index);
+
+    return (~(info >> ERASE_CNT_SHIFT)) & ERASE_CNT_MAX;
+}
+
+// page to restart the ring at when no page is valid, so restarts do not always wear page 0
+uint8_t ftl_page_get_least_worn(void)
+{
+    uint8_t pageID = 0;
+    uint16_t min_cnt = ERASE_CNT_MAX;
+    uint8_t i;
+
+    for (i = 0; i < g_PAGE_num; ++i)
+    {
+        uint16_t erase_cnt = ftl_page_get_erase_cnt(g_pPage + i);
+        if (erase_cnt < min_cnt)
+        {
+            min_cnt = erase_cnt;
+            pageID = i;
+        }
+    }
+
+    return pageID;
+}
+
 bool ftl_page_erase(struct Page_T *p)
 {
     uint32_t info = ftl_page_read(p, INFO_beg_index);
@@ -653,8 +1005,17 @@ bool ftl_page_erase(struct Page_T *p)
         return TRUE;
     }
 
+    // erase clears the count, read it first. A power loss before it is written back restarts it from 0
+    uint16_t erase_cnt = ftl_page_get_erase_cnt(p);
+    if (erase_cnt < ERASE_CNT_MAX)
+    {
+        ++erase_cnt;
+    }
+
     if (ftl_flash_erase_sector((uint32_t)p))// 2: EraseSector
     {
+        ftl_page_write(p, INFO_end_index, 0x0000ffff | BIT_VALID | ((uint32_t)(~erase_cnt & ERASE_CNT_MAX) << ERASE_CNT_SHIFT));
+
         if (FTL_WRITE_SUCCESS == ftl_page_write(p, INFO_beg_index, data))
         {
             return TRUE;
@@ -733,53 +1094,24 @@ void ftl_recover_from_power_lost(void)
     }
 
     // drop or copy it
-    for (; key_index >= 3; key_index -= 2)
+    uint16_t cells;
+    for (; key_index >= 3; key_index -= cells)
     {
         uint32_t key = ftl_page_read(g_pPage + Recycle_page, key_index);
 
-        uint32_t length = ftl_key_get_length(key);
+        cells = ftl_key_get_record_cells(key, key_index);
 
-        if (length == 1)
+        if (cells)
         {
-            uint16_t addr = key & 0xffff;
-
-            if (ftl_page_can_addr_drop(addr, Recycle_page))
-            {
-                // drop / recycle
-                //DBG_PRINT_INFO_2("key_index:%d, addr: 0x%08x - drop\n", key_index, addr);
-
-                ++RecycleNum;
-            }
-            else
-            {
-                // copy it
-                //DBG_PRINT_INFO_2("key_index:%d, addr: 0x%08x - copy\n", key_index, addr);
-
-                uint32_t rdata = ftl_page_read(g_pPage + Recycle_page, key_index - 1);
-
-                // write to another place
-                if ((g_free_cell_index + length) < PAGE_element)
-                {
-                    --RecycleNum;
-
-                    //FTL_ASSERT(length == 1);
-
-
-
-                    ftl_write(addr, rdata);
-                }
-                else
-                {
-                    ++later_to_write_item_num;
-                    // need more safe?? use another eflash page ?? or ram ??
-                }
-            }
-
+            // words which do not fit in current page are counted in later_to_write_item_num
+            // need more safe?? use another eflash page ?? or ram ??
+            RecycleNum += ftl_page_migrate_record(Recycle_page, key_index, key, &later_to_write_item_num);
         }
         else
         {
             //DBG_PRINT_INFO_1("length is not 1 (%d)", length);
-            FTL_PRINTF(FTL_LEVEL_ERROR, "[ftl] length != 1! func: %s, line: %d", __FUNCTION__, __LINE__);
+            FTL_PRINTF(FTL_LEVEL_ERROR, "[ftl] invalid length! func: %s, line: %d", __FUNCTION__, __LINE__);
+            cells = 2;
             ++RecycleNum;
         }
     }
@@ -806,21 +1138,112 @@ void ftl_recover_from_power_lost(void)
 
 }
 
-uint16_t read_mapping_table(uint16_t logical_addr)
+uint32_t ftl_mapping_table_size(void)
+{
+    if (ftl_mapping_type == FTL_MAPPING_TABLE_HASH)
+    {
+        return MAPPING_HASH_SIZE;
+    }
+
+    return MAPPING_TABLE_SIZE;
+}
+
+// slot of logical_addr, or the free slot to insert it
+struct Mapping_Hash_T *ftl_mapping_hash_lookup(uint16_t logical_addr)
+{
+    struct Mapping_Hash_T *table = (struct Mapping_Hash_T *)ftl_mapping_table;
+    uint16_t addr = (logical_addr >> 2) + 1;
+    uint16_t mask = ftl_mapping_hash_size - 1;
+    uint16_t i = (uint16_t)((addr * 2654435761u) >> 16) & mask;
+    uint16_t probe;
+
+    // linear probing, entries are never removed except by FTL_IOCTL_CLEAR_ALL
+    for (probe = 0; probe < ftl_mapping_hash_size; ++probe)
+    {
+        if ((table[i].addr == addr) || (table[i].addr == 0))
+        {
+            return &table[i];
+        }
+        i = (i + 1) & mask;
+    }
+
+    return NULL;
+}
+
+// return TRUE if the mapping table can hold the words from logical_addr
+bool ftl_mapping_table_can_add(uint16_t logical_addr, uint8_t length)
+{
+    uint16_t new_count = 0;
+    uint8_t i;
+
+    if (ftl_mapping_type != FTL_MAPPING_TABLE_HASH)
+    {
+        return TRUE;
+    }
+
+    for (i = 0; i < length; ++i, logical_addr += 4)
+    {
+        struct Mapping_Hash_T *entry = ftl_mapping_hash_lookup(logical_addr);
+        if ((entry == NULL) || (entry->addr == 0))
+        {
+            ++new_count;
+        }
+    }
+
+    return (ftl_mapping_hash_count + new_count <= ftl_mapping_hash_size) ? TRUE : FALSE;
+}
+
+// cell index of logical_addr in a packed table, 0 if not mapped
+uint16_t ftl_mapping_packed_get(const uint8_t *table, uint16_t logical_addr)
 {
     uint32_t bit_index = logical_addr / 4 * LOGIC_ADDR_MAP_BIT_NUM;
     uint32_t byte_index = bit_index / 8;
     uint32_t byte_offset = bit_index % 8;
 
-    uint16_t phy_addr = ftl_mapping_table[byte_index] + (ftl_mapping_table[byte_index + 1] << 8);
+    uint16_t phy_addr = table[byte_index] + (table[byte_index + 1] << 8);
     phy_addr = (phy_addr & (0xfff << byte_offset)) >> byte_offset;
     phy_addr *= 2;
 
     return phy_addr;
 }
 
+uint16_t read_mapping_table(uint16_t logical_addr)
+{
+    if (ftl_mapping_type == FTL_MAPPING_TABLE_HASH)
+    {
+        struct Mapping_Hash_T *entry = ftl_mapping_hash_lookup(logical_addr);
+
+        if ((entry == NULL) || (entry->addr == 0))
+        {
+            return 0;
+        }
+        return entry->phy * 2;
+    }
+
+    return ftl_mapping_packed_get(ftl_mapping_table, logical_addr);
+}
+
 void write_mapping_table(uint16_t logical_addr, uint8_t pageID, uint16_t cell_index)
 {
+    if (ftl_mapping_type == FTL_MAPPING_TABLE_HASH)
+    {
+        struct Mapping_Hash_T *entry = ftl_mapping_hash_lookup(logical_addr);
+
+        if (entry == NULL)
+        {
+            FTL_PRINTF(FTL_LEVEL_ERROR, "[ftl] mapping hash full! addr: 0x%x\n", logical_addr);
+            return;
+        }
+
+        if (entry->addr == 0)
+        {
+            entry->addr = (logical_addr >> 2) + 1;
+            ++ftl_mapping_hash_count;
+        }
+        entry->phy = (pageID * PAGE_element + cell_index) / 2;
+        return;
+    }
+
     uint32_t bit_index = (logical_addr / 4) *
                          LOGIC_ADDR_MAP_BIT_NUM;//use 12 bit to represent one logical address
     uint32_t byte_index = bit_index / 8;
@@ -852,15 +1275,283 @@ void write_mapping_table(uint16_t logical_addr, uint8_t pageID, uint16_t cell_in
     }
 }
 
-// logical_addr is 4 bytes alignment addr
-uint32_t ftl_read(uint16_t logical_addr, uint32_t *value)
+// add entries of a table snapshot for the logical addresses not mapped yet
+void ftl_mapping_table_merge(const uint8_t *snapshot)
 {
-    uint32_t ret = FTL_READ_SUCCESS;
+    if (ftl_mapping_type == FTL_MAPPING_TABLE_HASH)
+    {
+        const struct Mapping_Hash_T *entry = (const struct Mapping_Hash_T *)snapshot;
+        uint16_t i;
 
+        for (i = 0; i < ftl_mapping_hash_size; ++i)
+        {
+            uint16_t logical_addr = (entry[i].addr - 1) << 2;
 
-    if (ftl_check_logical_addr(logical_addr))
-    {
-        //PLATFORM_ASSERT(0);
+            if ((entry[i].addr != 0) && !read_mapping_table(logical_addr))
+            {
+                write_mapping_table(logical_addr, 0, entry[i].phy * 2);
+            }
+        }
+        return;
+    }
+
+    uint32_t logical_addr;
+    for (logical_addr = 0; logical_addr < MAX_logical_address_size; logical_addr += 4)
+    {
+        uint16_t cell_index = ftl_mapping_packed_get(snapshot, logical_addr);
+
+        if (cell_index && !read_mapping_table(logical_addr))
+        {
+            write_mapping_table(logical_addr, 0, cell_index);
+        }
+    }
+}
+
+uint32_t ftl_crc32(uint32_t crc, const uint8_t *buf, uint32_t len)
+{
+    static const uint32_t crc_tbl[16] =
+    {
+        0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+        0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C
+    };
+
+    crc = ~crc;
+    while (len--)
+    {
+        crc ^= *buf++;
+        crc = (crc >> 4) ^ crc_tbl[crc & 0xf];
+        crc = (crc >> 4) ^ crc_tbl[crc & 0xf];
+    }
+    return ~crc;
+}
+
+uint32_t ftl_checkpoint_size(void)
+{
+    return sizeof(struct Checkpoint_T) + ((ftl_mapping_table_size() + 3) & ~3) + 4;
+}
+
+// a slot is the checkpoint rounded up to whole sectors, extra reserved sectors give more slots
+uint32_t ftl_checkpoint_slot_size(void)
+{
+    return (ftl_checkpoint_size() + FMC_PAGE_SIZE - 1) & ~(FMC_PAGE_SIZE - 1);
+}
+
+uint8_t ftl_checkpoint_slot_num(void)
+{
+    return (ftl_checkpoint_sector_num * FMC_PAGE_SIZE) / ftl_checkpoint_slot_size();
+}
+
+void ftl_checkpoint_invalidate(void)
+{
+    uint8_t i;
+
+    if (ftl_checkpoint_addr)
+    {
+        for (i = 0; i < ftl_checkpoint_slot_num(); ++i)
+        {
+            ftl_flash_erase_sector(ftl_checkpoint_addr + i * ftl_checkpoint_slot_size());
+        }
+        ftl_checkpoint_gc_count = 0;
+    }
+}
+
+// snapshot the mapping table after gc erased a page, every entry points to a valid page then.
+// crc is written last, a torn checkpoint is not used
+void ftl_checkpoint_save(void)
+{
+    struct Checkpoint_T head;
+    uint32_t table_size = ftl_mapping_table_size();
+    uint32_t size = ftl_checkpoint_size();
+    uint32_t base;
+    uint32_t addr;
+    uint32_t crc;
+    uint8_t i;
+
+    if ((ftl_checkpoint_addr == 0) || (ftl_mapping_table == NULL))
+    {
+        return;
+    }
+
+    if (++ftl_checkpoint_gc_count < ftl_checkpoint_interval)
+    {
+        return;
+    }
+    ftl_checkpoint_gc_count = 0;
+
+    if (ftl_checkpoint_slot_num() == 0)
+    {
+        FTL_PRINTF(FTL_LEVEL_WARN, "[ftl] checkpoint %d bytes exceed reserved sectors\n", size);
+        return;
+    }
+
+    // write the slots in turn, spreads the erases and keeps the previous checkpoint if this one is torn
+    ftl_checkpoint_slot = (ftl_checkpoint_slot + 1) % ftl_checkpoint_slot_num();
+    base = ftl_checkpoint_addr + ftl_checkpoint_slot * ftl_checkpoint_slot_size();
+
+    memset(&head, 0xff, sizeof(head));
+    head.magic = FTL_CHECKPOINT_MAGIC;
+    head.seq = ++ftl_checkpoint_seq;
+    head.cur_pageID = g_cur_pageID;
+    head.page_num = g_PAGE_num;
+    head.free_cell_index = g_free_cell_index;
+    head.mapping_type = ftl_mapping_type;
+    head.hash_size = ftl_mapping_hash_size;
+    head.table_size = table_size;
+    for (i = 0; i < g_PAGE_num; ++i)
+    {
+        if (0 == ftl_page_is_valid(g_pPage + i))
+        {
+            head.page_seq[i] = ftl_get_page_seq(g_pPage + i);
+        }
+    }
+
+    for (addr = 0; addr < size; addr += FMC_PAGE_SIZE)
+    {
+        ftl_flash_erase_sector(base + addr);
+    }
+
+    addr = base;
+    ftl_flash_write_burst(addr, (uint32_t *)&head, sizeof(head) / 4);
+    addr += sizeof(head);
+
+    // table is word aligned, only a packed table may end with a partial word
+    if (table_size / 4)
+    {
+        ftl_flash_write_burst(addr, (uint32_t *)ftl_mapping_table, table_size / 4);
+        addr += table_size & ~3;
+    }
+    if (table_size & 3)
+    {
+        uint32_t tail = 0;
+        memcpy(&tail, ftl_mapping_table + (table_size & ~3), table_size & 3);
+        ftl_flash_write(addr, tail);
+        addr += 4;
+    }
+
+    crc = ftl_crc32(0, (uint8_t *)&head, sizeof(head));
+    crc = ftl_crc32(crc, ftl_mapping_table, table_size);
+    ftl_flash_write(addr, crc);
+}
+
+// return the table snapshot of the checkpoint in slot and the position it was taken at, NULL if
+// there is none, it is corrupted, or a page it refers to was recycled since
+uint8_t *ftl_checkpoint_load_slot(uint8_t slot, uint8_t *pPageID, uint16_t *pCellIndex)
+{
+    struct Checkpoint_T head;
+    uint8_t *snapshot;
+    uint32_t crc = 0;
+    uint32_t table_size = ftl_mapping_table_size();
+    uint32_t base = ftl_checkpoint_addr + slot * ftl_checkpoint_slot_size();
+    flash_t flash;
+    uint8_t i;
+
+    device_mutex_lock(RT_DEV_LOCK_FLASH);
+    flash_stream_read(&flash, base, sizeof(head), (uint8_t *)&head);
+    device_mutex_unlock(RT_DEV_LOCK_FLASH);
+
+    if ((head.magic != FTL_CHECKPOINT_MAGIC) || (head.page_num != g_PAGE_num) ||
+        (head.mapping_type != ftl_mapping_type) || (head.hash_size != ftl_mapping_hash_size) ||
+        (head.table_size != table_size) || (head.cur_pageID >= g_PAGE_num))
+    {
+        return NULL;
+    }
+
+    for (i = 0; i < g_PAGE_num; ++i)
+    {
+        if ((head.page_seq[i] != 0xffff) &&
+            ((0 != ftl_page_is_valid(g_pPage + i)) || (head.page_seq[i] != ftl_get_page_seq(g_pPage + i))))
+        {
+            FTL_PRINTF(FTL_LEVEL_INFO, "[ftl] checkpoint is stale, page %d\n", i);
+            return NULL;
+        }
+    }
+
+    snapshot = rtw_malloc((table_size + 3) & ~3);
+    if (snapshot == NULL)
+    {
+        return NULL;
+    }
+
+    device_mutex_lock(RT_DEV_LOCK_FLASH);
+    flash_stream_read(&flash, base + sizeof(head), table_size, snapshot);
+    flash_stream_read(&flash, base + sizeof(head) + ((table_size + 3) & ~3), 4, (uint8_t *)&crc);
+    device_mutex_unlock(RT_DEV_LOCK_FLASH);
+
+    if (crc != ftl_crc32(ftl_crc32(0, (uint8_t *)&head, sizeof(head)), snapshot, table_size))
+    {
+        FTL_PRINTF(FTL_LEVEL_WARN, "[ftl] checkpoint crc error, full scan\n");
+        rtw_mfree(snapshot, 0);
+        return NULL;
+    }
+
+    *pPageID = head.cur_pageID;
+    *pCellIndex = head.free_cell_index;
+    return snapshot;
+}
+
+// newest usable checkpoint of all slots
+uint8_t *ftl_checkpoint_load(uint8_t *pPageID, uint16_t *pCellIndex)
+{
+    struct Checkpoint_T head;
+    uint8_t *snapshot = NULL;
+    uint8_t slot_num = ftl_checkpoint_slot_num();
+    uint8_t newest = 0;
+    uint8_t found = 0;
+    flash_t flash;
+    uint8_t i;
+
+    if ((ftl_checkpoint_addr == 0) || (slot_num == 0))
+    {
+        return NULL;
+    }
+
+    for (i = 0; i < slot_num; ++i)
+    {
+        // magic and seq only
+        device_mutex_lock(RT_DEV_LOCK_FLASH);
+        flash_stream_read(&flash, ftl_checkpoint_addr + i * ftl_checkpoint_slot_size(), 12, (uint8_t *)&head);
+        device_mutex_unlock(RT_DEV_LOCK_FLASH);
+
+        if ((head.magic == FTL_CHECKPOINT_MAGIC) && (!found || ((int8_t)(head.seq - ftl_checkpoint_seq) > 0)))
+        {
+            found = 1;
+            newest = i;
+            ftl_checkpoint_seq = head.seq;
+        }
+    }
+
+    if (!found)
+    {
+        return NULL;
+    }
+    ftl_checkpoint_slot = newest;
+
+    // newest first, then back in write order
+    for (i = 0; (i < slot_num) && (snapshot == NULL); ++i)
+    {
+        snapshot = ftl_checkpoint_load_slot((newest + slot_num - i) % slot_num, pPageID, pCellIndex);
+    }
+
+    return snapshot;
+}
+
+void ftl_checkpoint_config(uint32_t u32CheckpointAddr, uint8_t sector_num, uint8_t gc_interval)
+{
+    ftl_checkpoint_addr = sector_num ? u32CheckpointAddr : 0;
+    ftl_checkpoint_sector_num = sector_num;
+    ftl_checkpoint_interval = gc_interval ? gc_interval : 1;
+    ftl_checkpoint_gc_count = 0;
+}
+
+// logical_addr is 4 bytes alignment addr
+uint32_t ftl_read(uint16_t logical_addr, uint32_t *value)
+{
+    uint32_t ret = FTL_READ_SUCCESS;
+
+
+    if (ftl_check_logical_addr(logical_addr))
+    {
+        //PLATFORM_ASSERT(0);
         return FTL_READ_ERROR_INVALID_LOGICAL_ADDR;
     }
     else
@@ -873,34 +1564,27 @@ uint32_t ftl_read(uint16_t logical_addr, uint32_t *value)
 
 L_retry:
 
-            // todo, length is 1
             //PRINTF("pageID,key_index: %d, %d \r\n", pageID, key_index);
 
-            for (; key_index >= 3; key_index -= 2)
+            uint16_t cells;
+            for (; key_index >= 3; key_index -= cells)
             {
                 uint32_t key = ftl_page_read(g_pPage + pageID, key_index);
 
-                uint32_t length = ftl_key_get_length(key);
+                cells = ftl_key_get_record_cells(key, key_index);
 
-                if (length == 0)
+                if (cells)
                 {
-                    continue;
-                }
-
-                //PLATFORM_ASSERT( length == 1);
-
-                if (length == 1)
-                {
-                    uint16_t addr = key & 0xffff;
-                    if (addr == logical_addr)
+                    uint16_t data_index = ftl_key_get_data_index(key, key_index, logical_addr);
+                    if (data_index)
                     {
                         found = 1;
-                        *value = ftl_page_read(g_pPage + pageID, key_index - 1);
+                        *value = ftl_page_read(g_pPage + pageID, data_index);
                         ret = 0;
 
 #if defined(FEATURE_WRITE_RECYCLE) && (FEATURE_WRITE_RECYCLE == 1)
                         g_read_pageID = pageID;
-                        g_read_data_index = key_index - 1;
+                        g_read_data_index = data_index;
 #endif
 
                         break;
@@ -908,7 +1592,11 @@ L_retry:
                 }
                 else
                 {
-                    FTL_PRINTF(FTL_LEVEL_ERROR, "[ftl] length != 1!  line: %d", __LINE__);
+                    cells = 2;
+                    if (ftl_key_get_length(key) != 0)
+                    {
+                        FTL_PRINTF(FTL_LEVEL_ERROR, "[ftl] invalid length!  line: %d", __LINE__);
+                    }
                 }
 
             }
@@ -953,21 +1641,18 @@ L_retry:
                 return FTL_READ_ERROR_READ_NOT_FOUND;
             }
 
+            // mapping table points to the cell before the key of the record
             uint8_t pageID = phy_addr / PAGE_element;
-            uint16_t key_index = phy_addr % PAGE_element;
+            uint16_t key_index = phy_addr % PAGE_element + 1;
 
-            uint32_t key = ftl_page_read(g_pPage + pageID, key_index + 1);
+            uint32_t key = ftl_page_read(g_pPage + pageID, key_index);
 
-            uint32_t length = ftl_key_get_length(key);
-
-            //PLATFORM_ASSERT( length == 1);
-
-            if (length == 1)
+            if (ftl_key_get_record_cells(key, key_index))
             {
-                uint16_t addr = key & 0xffff;
-                if (addr == logical_addr)
+                uint16_t data_index = ftl_key_get_data_index(key, key_index, logical_addr);
+                if (data_index)
                 {
-                    *value = ftl_page_read(g_pPage + pageID, key_index);
+                    *value = ftl_page_read(g_pPage + pageID, data_index);
                     ret = 0;
                 }
                 else
@@ -979,7 +1664,7 @@ L_retry:
             else
             {
                 ret = FTL_READ_ERROR_PARSE_ERROR;
-                FTL_PRINTF(FTL_LEVEL_ERROR, "[ftl] length != 1! func: %s, line: %d", __FUNCTION__, __LINE__);
+                FTL_PRINTF(FTL_LEVEL_ERROR, "[ftl] invalid length! func: %s, line: %d", __FUNCTION__, __LINE__);
             }
         }
     }
@@ -991,6 +1676,234 @@ L_retry:
 
 // return 0 success
 // return !0 fail
+struct Write_Cache_T *ftl_write_cache_lookup(uint16_t logical_addr)
+{
+    uint16_t addr = (logical_addr >> 2) + 1;
+    uint8_t i;
+
+    for (i = 0; i < ftl_write_cache_num; ++i)
+    {
+        if (ftl_write_cache[i].addr == addr)
+        {
+            return &ftl_write_cache[i];
+        }
+    }
+
+    return NULL;
+}
+
+// write dirty words back, runs of consecutive addresses go to one record
+uint32_t ftl_write_cache_flush(void)
+{
+    uint32_t ret = FTL_WRITE_SUCCESS;
+    uint32_t data32[FTL_MAX_RECORD_WORDS];
+
+    if (ftl_write_cache == NULL)
+    {
+        return FTL_WRITE_SUCCESS;
+    }
+
+    if (NULL != ftl_sem)
+    {
+		xSemaphoreTakeRecursive(ftl_sem, portMAX_DELAY);
+    }
+
+    while (ftl_write_cache_dirty && (ret == FTL_WRITE_SUCCESS))
+    {
+        struct Write_Cache_T *entry = NULL;
+        uint8_t length = 0;
+        uint8_t i;
+
+        // lowest dirty address starts the run
+        for (i = 0; i < ftl_write_cache_num; ++i)
+        {
+            if (ftl_write_cache[i].dirty && ((entry == NULL) || (ftl_write_cache[i].addr < entry->addr)))
+            {
+                entry = &ftl_write_cache[i];
+            }
+        }
+        if (entry == NULL)
+        {
+            ftl_write_cache_dirty = 0;
+            break;
+        }
+
+        uint16_t logical_addr = (entry->addr - 1) << 2;
+        while ((entry != NULL) && entry->dirty && (length < FTL_MAX_RECORD_WORDS))
+        {
+            data32[length++] = entry->data;
+            entry = ftl_write_cache_lookup(logical_addr + (length << 2));
+        }
+
+        ret = ftl_write_record(logical_addr, data32, length);
+        if (ret == FTL_WRITE_SUCCESS)
+        {
+            for (i = 0; i < length; ++i)
+            {
+                ftl_write_cache_lookup(logical_addr + (i << 2))->dirty = 0;
+            }
+            ftl_write_cache_dirty -= length;
+        }
+    }
+
+    if (NULL != ftl_sem)
+    {
+		xSemaphoreGiveRecursive(ftl_sem);
+    }
+
+    return ret;
+}
+
+// return TRUE if the hash mapping table can hold the words cached so far plus size bytes from offset
+bool ftl_write_cache_can_add(uint16_t offset, uint16_t size)
+{
+    uint16_t new_count = 0;
+    uint8_t i;
+
+    if (ftl_mapping_type != FTL_MAPPING_TABLE_HASH)
+    {
+        return TRUE;
+    }
+
+    for (i = 0; i < ftl_write_cache_num; ++i)
+    {
+        if (ftl_write_cache[i].dirty && !read_mapping_table((ftl_write_cache[i].addr - 1) << 2))
+        {
+            ++new_count;
+        }
+    }
+
+    for (; size > 0; size -= 4, offset += 4)
+    {
+        if (!read_mapping_table(offset) && (ftl_write_cache_lookup(offset) == NULL))
+        {
+            ++new_count;
+        }
+    }
+
+    return (ftl_mapping_hash_count + new_count <= ftl_mapping_hash_size) ? TRUE : FALSE;
+}
+
+// save through the cache, a word equal to the stored value is dropped
+uint32_t ftl_write_cache_save(uint8_t *pdata8, uint16_t offset, uint16_t size)
+{
+    uint32_t ret = FTL_WRITE_SUCCESS;
+
+    if (ftl_check_logical_addr(offset) || ftl_check_logical_addr(offset + size - 4))
+    {
+        return FTL_WRITE_ERROR_INVALID_ADDR;
+    }
+
+    if (NULL != ftl_sem)
+    {
+		xSemaphoreTakeRecursive(ftl_sem, portMAX_DELAY);
+    }
+
+    // fail before anything is cached, as a write would
+    if (!ftl_write_cache_can_add(offset, size))
+    {
+        FTL_PRINTF(FTL_LEVEL_ERROR, "[ftl] mapping hash full! addr: 0x%x\n", offset);
+        size = 0;
+        ret = FTL_WRITE_ERROR_OUT_OF_SPACE;
+    }
+
+    for (; size > 0; size -= 4, offset += 4, pdata8 += 4)
+    {
+        uint32_t data32 = (uint32_t)(pdata8[0] |
+                                     (pdata8[1] << 8) |
+                                     (pdata8[2] << 16) |
+                                     (pdata8[3] << 24));
+        struct Write_Cache_T *entry = ftl_write_cache_lookup(offset);
+
+        if (entry == NULL)
+        {
+            uint32_t old;
+            uint8_t i;
+
+            if ((ftl_read(offset, &old) == FTL_READ_SUCCESS) && (old == data32))
+            {
+                continue;
+            }
+
+            // free or clean entry, else write back all
+            for (i = 0; (i < ftl_write_cache_num) && (entry == NULL); ++i)
+            {
+                if (!ftl_write_cache[i].dirty)
+                {
+                    entry = &ftl_write_cache[i];
+                }
+            }
+            if (entry == NULL)
+            {
+                ret = ftl_write_cache_flush();
+                if (ret)
+                {
+                    break;
+                }
+                entry = &ftl_write_cache[0];
+            }
+
+            entry->addr = (offset >> 2) + 1;
+            entry->dirty = 0;
+        }
+        else if (entry->data == data32)
+        {
+            continue;
+        }
+
+        entry->data = data32;
+        if (!entry->dirty)
+        {
+            if (ftl_write_cache_dirty == 0)
+            {
+                ftl_write_cache_dirty_time = rtw_get_current_time();
+            }
+            entry->dirty = 1;
+            ++ftl_write_cache_dirty;
+        }
+    }
+
+    if (NULL != ftl_sem)
+    {
+		xSemaphoreGiveRecursive(ftl_sem);
+    }
+
+    return ret;
+}
+
+// a reset from interrupt, with the scheduler stopped or from inside an ftl call can not wait for
+// ftl_sem, nor can one behind a stuck owner: cached words are then lost as on power loss
+void ftl_flush_before_reset(void)
+{
+    if ((g_pPage == NULL) || (ftl_write_cache == NULL) || (0 != __get_IPSR()) ||
+        (xTaskGetSchedulerState() != taskSCHEDULER_RUNNING))
+    {
+        return;
+    }
+
+    if (NULL != ftl_sem)
+    {
+        if (xSemaphoreGetMutexHolder(ftl_sem) == xTaskGetCurrentTaskHandle())
+        {
+            return;
+        }
+
+        if (xSemaphoreTakeRecursive(ftl_sem, FTL_RESET_FLUSH_WAIT_MS / portTICK_PERIOD_MS) != pdTRUE)
+        {
+            FTL_PRINTF(FTL_LEVEL_WARN, "[ftl] ftl busy, %d cached words not flushed before reset\n",
+                       ftl_write_cache_dirty);
+            return;
+        }
+    }
+
+    ftl_write_cache_flush();
+
+    if (NULL != ftl_sem)
+    {
+		xSemaphoreGiveRecursive(ftl_sem);
+    }
+}
+
 uint32_t ftl_save_to_storage_i(void *pdata_tmp, uint16_t offset, uint16_t size)
 {
     uint8_t *pdata8 = (uint8_t *)pdata_tmp;
@@ -1005,6 +1918,15 @@ uint32_t ftl_save_to_storage_i(void *pdata_tmp, uint16_t offset, uint16_t size)
         return FTL_WRITE_ERROR_INVALID_PARAMETER;
     }
 
+    if (ftl_write_cache != NULL)
+    {
+        if (0 != __get_IPSR())
+        {
+            return FTL_WRITE_ERROR_IN_INTR;
+        }
+        return ftl_write_cache_save(pdata8, offset, size);
+    }
+
 #if defined(SAVE_TO_STORAGE_RECONFIRM_EN) && (SAVE_TO_STORAGE_RECONFIRM_EN == 1)
     uint16_t bak_offset = offset;
     uint16_t bak_size = size;
@@ -1012,15 +1934,24 @@ uint32_t ftl_save_to_storage_i(void *pdata_tmp, uint16_t offset, uint16_t size)
 
 
     uint32_t ret = 0;
+    uint32_t data32[FTL_MAX_RECORD_WORDS];
 
+    // one key for up to FTL_MAX_RECORD_WORDS words
     while (size > 0)
     {
-        uint32_t data32 = (uint32_t)(pdata8[0] |
-                                     (pdata8[1] << 8) |
-                                     (pdata8[2] << 16) |
-                                     (pdata8[3] << 24));
+        uint8_t length = 0;
+
+        while ((size > 0) && (length < FTL_MAX_RECORD_WORDS))
+        {
+            data32[length++] = (uint32_t)(pdata8[0] |
+                                          (pdata8[1] << 8) |
+                                          (pdata8[2] << 16) |
+                                          (pdata8[3] << 24));
+            size -= 4;
+            pdata8 += 4;
+        }
 
-        ret = ftl_write(offset, data32);
+        ret = ftl_write_record(offset, data32, length);
         FTL_ASSERT(result == 0);
 
         if (ret)
@@ -1028,9 +1959,13 @@ uint32_t ftl_save_to_storage_i(void *pdata_tmp, uint16_t offset, uint16_t size)
             break;
         }
 
-        offset += 4;
-        size -= 4;
-        pdata8 += 4;
+        offset += (length << 2);
+    }
+
+    // every save moves pending incremental gc one step forward, erase is left to idle
+    if (gc_incremental && (g_gc_pageID != GC_PAGE_NONE))
+    {
+        ftl_page_garbage_collect_step(gc_step_cells, FALSE);
     }
 
 
@@ -1099,13 +2034,40 @@ uint32_t ftl_load_from_storage_i(void *pdata_tmp, uint16_t offset, uint16_t size
 
     uint8_t *pdata8 = (uint8_t *)pdata_tmp;
     uint32_t ret = 0, data32;
+    uint8_t sem_flag = FALSE;
+
+    // a save or flush may change or evict the cache entries while they are read
+    if (ftl_write_cache != NULL)
+    {
+        if (0 != __get_IPSR())
+        {
+            return FTL_READ_ERROR_IN_INTR;
+        }
+
+        if (NULL != ftl_sem)
+        {
+            if (xSemaphoreTakeRecursive(ftl_sem, portMAX_DELAY) == TRUE)
+            {
+                sem_flag = TRUE;
+            }
+        }
+    }
 
     while (size > 0)
     {
-        ret = ftl_read(offset, &data32);
-        if (ret != 0)
+        struct Write_Cache_T *entry = (ftl_write_cache != NULL) ? ftl_write_cache_lookup(offset) : NULL;
+
+        if (entry != NULL)
         {
-            break;
+            data32 = entry->data;
+        }
+        else
+        {
+            ret = ftl_read(offset, &data32);
+            if (ret != 0)
+            {
+                break;
+            }
         }
 
         pdata8[0] = (data32 & 0xFF);
@@ -1118,15 +2080,31 @@ uint32_t ftl_load_from_storage_i(void *pdata_tmp, uint16_t offset, uint16_t size
         pdata8 += 4;
     }
 
+    if (sem_flag)
+    {
+		xSemaphoreGiveRecursive(ftl_sem);
+    }
+
     return ret;
 }
 
 uint32_t ftl_write(uint16_t logical_addr, uint32_t w_data)
+{
+    return ftl_write_record(logical_addr, &w_data, 1);
+}
+
+// write length words from logical_addr with one key, data is programmed in one burst
+uint32_t ftl_write_record(uint16_t logical_addr, const uint32_t *w_data, uint8_t length)
 {
     uint32_t ret = FTL_WRITE_SUCCESS;
 
     uint8_t sem_flag = FALSE;
 
+    if ((length == 0) || (length > FTL_MAX_RECORD_WORDS))
+    {
+        return FTL_WRITE_ERROR_INVALID_PARAMETER;
+    }
+
     if (0 != __get_IPSR())
     {
         FTL_PRINTF(FTL_LEVEL_WARN, "[ftl] FTL_write should not be called in interrupt handler!\n");
@@ -1141,42 +2119,56 @@ uint32_t ftl_write(uint16_t logical_addr, uint32_t w_data)
         }
     }
 
-    if (ftl_check_logical_addr(logical_addr))
+    if (ftl_check_logical_addr(logical_addr) ||
+        ftl_check_logical_addr(logical_addr + ((length - 1) << 2)))
     {
         FTL_ASSERT(0);
         ret = FTL_WRITE_ERROR_INVALID_ADDR;
     }
+    else if (!ftl_mapping_table_can_add(logical_addr, length))
+    {
+        FTL_PRINTF(FTL_LEVEL_ERROR, "[ftl] mapping hash full! addr: 0x%x\n", logical_addr);
+        ret = FTL_WRITE_ERROR_OUT_OF_SPACE;
+    }
     else
     {
 
         // todo, try to find old cell, check data is the same or not
         // or use the same cell if all bits match non "0->1" patterns
 
-        uint8_t length = 1; // 1*4 bytes , todo
+        uint16_t cells = FTL_RECORD_CELLS(length);
 
 L_retry:
 
-        if ((g_free_cell_index + length) < PAGE_element)
+        if ((g_free_cell_index + cells) <= PAGE_element)
         {
+            uint16_t key_index = g_free_cell_index + cells - 1;
+
             FTL_ASSERT(WRITABLE_32BIT == ftl_page_read(g_pPage + g_cur_pageID, g_free_cell_index));
-            FTL_ASSERT(WRITABLE_32BIT == ftl_page_read(g_pPage + g_cur_pageID,
-                                                       g_free_cell_index + length));
+            FTL_ASSERT(WRITABLE_32BIT == ftl_page_read(g_pPage + g_cur_pageID, key_index));
 
             uint32_t key = ftl_key_init(logical_addr, length);
 
-            //ftl_page_write(g_pPage + g_cur_pageID, g_free_cell_index + 1, key);
-            ftl_page_write(g_pPage + g_cur_pageID, g_free_cell_index, w_data);
+            // key first, then data, BIT_VALID of the key is the commit of the record
+            // ftl_init() clears a record whose key is not committed
+            ftl_page_write(g_pPage + g_cur_pageID, key_index, key);
+
+            ftl_page_write_burst(g_pPage + g_cur_pageID, g_free_cell_index, w_data, length);
 
             flash_set_bit(&key, BIT_VALID);
 
-            ftl_page_write(g_pPage + g_cur_pageID, g_free_cell_index + 1, key);
+            ftl_page_write(g_pPage + g_cur_pageID, key_index, key);
 
             if (FTL_USE_MAPPING_TABLE == 1) //mapping table otp
             {
-                write_mapping_table(logical_addr, g_cur_pageID, g_free_cell_index);
+                uint8_t i;
+                for (i = 0; i < length; ++i)
+                {
+                    write_mapping_table(logical_addr + (i << 2), g_cur_pageID, key_index - 1);
+                }
             }
 
-            g_free_cell_index += (length + 1);
+            g_free_cell_index += cells;
 
             ret = FTL_WRITE_SUCCESS;
         }
@@ -1218,6 +2210,11 @@ L_retry:
                     {
                         ret = FTL_WRITE_ERROR_NEED_GC;
                     }
+                    else if (gc_incremental)
+                    {
+                        // start gc in reserve, finish it at once only without any free page
+                        ftl_page_garbage_collect_step(gc_step_cells, FALSE);
+                    }
                     else
                     {
                         ftl_page_garbage_collect(0, PAGE_element / 2);
@@ -1240,7 +2237,7 @@ L_retry:
         xSemaphoreGiveRecursive(ftl_sem);
     }
 
-    FTL_PRINTF(FTL_LEVEL_WARN, "[ftl] w 0x%08x: 0x%08x (%d)\r\n", logical_addr, w_data, ret);
+    FTL_PRINTF(FTL_LEVEL_WARN, "[ftl] w 0x%08x: 0x%08x len %d (%d)\r\n", logical_addr, w_data[0], length, ret);
 
     return ret;
 }
@@ -1297,11 +2294,19 @@ uint32_t ftl_ioctl(uint32_t cmd, uint32_t p1, uint32_t p2)
             }
 
             //clear ftl_mapping_table
-            memset(ftl_mapping_table, 0, MAPPING_TABLE_SIZE);
+            memset(ftl_mapping_table, 0, ftl_mapping_table_size());
+            ftl_mapping_hash_count = 0;
 
             // updata current page info
-            g_cur_pageID = 0;
+            g_cur_pageID = ftl_page_get_least_worn();
             g_free_cell_index = INFO_size;
+            g_gc_pageID = GC_PAGE_NONE;
+            ftl_checkpoint_invalidate();
+            if (ftl_write_cache != NULL)
+            {
+                memset(ftl_write_cache, 0, ftl_write_cache_num * sizeof(struct Write_Cache_T));
+                ftl_write_cache_dirty = 0;
+            }
 
             //fix after FTL_IOCTL_CLEAR_ALL may not do gc bug
             g_free_page_count = ftl_get_free_page_count();
@@ -1362,6 +2367,66 @@ uint32_t ftl_ioctl(uint32_t cmd, uint32_t p1, uint32_t p2)
             result = 0;
         }
         break;
+    case FTL_IOCTL_ENABLE_INCREMENTAL_GC:
+        {
+            gc_incremental = TRUE;
+            gc_step_cells = p1 ? p1 : FTL_GC_STEP_CELLS;
+            gc_reserve_page = p2 ? p2 : 1;
+            result = 0;
+        }
+        break;
+    case FTL_IOCTL_DISABLE_INCREMENTAL_GC:
+        {
+            gc_incremental = FALSE;
+            // finish the page in progress
+            while ((g_gc_pageID != GC_PAGE_NONE) && ftl_page_garbage_collect_step(PAGE_element, TRUE));
+            result = 0;
+        }
+        break;
+    case FTL_IOCTL_DO_GC_STEP:
+        {
+            result = ftl_page_garbage_collect_step(p1 ? p1 : gc_step_cells, TRUE) ? 1 : 0;
+        }
+        break;
+    case FTL_IOCTL_GET_ERASE_CNT:
+        {
+            result = (p1 < g_PAGE_num) ? ftl_page_get_erase_cnt(g_pPage + p1) : 0xffffffff;
+        }
+        break;
+    case FTL_IOCTL_ENABLE_WRITE_CACHE:
+        {
+            uint8_t num = p1 ? ((p1 < FTL_WRITE_CACHE_MAX_WORDS) ? p1 : FTL_WRITE_CACHE_MAX_WORDS) : FTL_WRITE_CACHE_WORDS;
+
+            result = ftl_write_cache_flush();
+            if (result == 0)
+            {
+                if (ftl_write_cache != NULL)
+                {
+                    rtw_mfree((u8 *)ftl_write_cache, 0);
+                    ftl_write_cache = NULL;
+                }
+                ftl_write_cache_num = num;
+                ftl_write_cache_delay_ms = p2;
+                ftl_write_cache = (struct Write_Cache_T *)rtw_zmalloc(num * sizeof(struct Write_Cache_T));
+                result = (ftl_write_cache != NULL) ? 0 : 1;
+            }
+        }
+        break;
+    case FTL_IOCTL_DISABLE_WRITE_CACHE:
+        {
+            result = ftl_write_cache_flush();
+            if ((result == 0) && (ftl_write_cache != NULL))
+            {
+                rtw_mfree((u8 *)ftl_write_cache, 0);
+                ftl_write_cache = NULL;
+            }
+        }
+        break;
+    case FTL_IOCTL_FLUSH_WRITE_CACHE:
+        {
+            result = ftl_write_cache_flush();
+        }
+        break;
     default:
         break;
     }
@@ -1383,11 +2448,57 @@ uint32_t ftl_save(void *pdata, uint16_t offset, uint16_t size)
 #endif
 
 uint32_t ftl_init(uint32_t u32PageStartAddr, uint8_t pagenum)
+{
+    return ftl_init_ext(u32PageStartAddr, pagenum, FTL_MAPPING_TABLE_PACKED, 0);
+}
+
+uint32_t ftl_init_ext(uint32_t u32PageStartAddr, uint8_t pagenum, uint8_t mapping_type, uint16_t hash_size)
 {
     if (pagenum < 3)
     {
         pagenum = 3;
     }
+
+    if ((mapping_type == FTL_MAPPING_TABLE_PACKED) && (pagenum > MAPPING_TABLE_PACKED_MAX_PAGE_NUM))
+    {
+        FTL_PRINTF(FTL_LEVEL_WARN, "[ftl] %d pages exceed packed mapping table, use hash\n", pagenum);
+        mapping_type = FTL_MAPPING_TABLE_HASH;
+    }
+
+    if (mapping_type == FTL_MAPPING_TABLE_HASH)
+    {
+        uint16_t size = 16;
+
+        if (pagenum > MAPPING_TABLE_HASH_MAX_PAGE_NUM)
+        {
+            FTL_PRINTF(FTL_LEVEL_ERROR, "[ftl] %d pages exceed 16 bit logical address, max %d\n",
+                       pagenum, MAPPING_TABLE_HASH_MAX_PAGE_NUM);
+            return FTL_ERROR_OUT_OF_SPACE;
+        }
+
+        if (hash_size == 0)
+        {
+            // one entry for each word of the logical space, entries are only removed by
+            // FTL_IOCTL_CLEAR_ALL so a smaller table fills up with words saved once
+            hash_size = PAGE_element_data * (pagenum - 1);
+        }
+
+        // round up to power of 2
+        while ((size < hash_size) && (size < 0x8000))
+        {
+            size <<= 1;
+        }
+
+        if ((ftl_mapping_table != NULL) && (ftl_mapping_hash_size != size))
+        {
+            rtw_mfree(ftl_mapping_table, 0);
+            ftl_mapping_table = NULL;
+        }
+        ftl_mapping_hash_size = size;
+    }
+
+    ftl_mapping_type = mapping_type;
+    ftl_mapping_hash_count = 0;
     g_PAGE_num = pagenum;
 
     if (ftl_sem == NULL)
@@ -1454,8 +2565,9 @@ uint32_t ftl_init(uint32_t u32PageStartAddr, uint8_t pagenum)
     {
         // not any valid, first time to init
 
-        cur_pageID = 0;
+        cur_pageID = ftl_page_get_least_worn();
         cur_sequence = 0;
+        ftl_checkpoint_invalidate();
 
         if (!ftl_page_format(g_pPage + cur_pageID, cur_sequence))
         {
@@ -1469,9 +2581,39 @@ uint32_t ftl_init(uint32_t u32PageStartAddr, uint8_t pagenum)
     uint16_t free_cell_index = INFO_size;
     for (i = PAGE_element - 1 ; i >= INFO_size ; --i)
     {
-        if (WRITABLE_32BIT != ftl_page_read(g_pPage + cur_pageID, i))
+        uint32_t key = ftl_page_read(g_pPage + cur_pageID, i);
+
+        if (WRITABLE_32BIT != key)
         {
-            free_cell_index = i + 1;
+            // records always end at odd index, skip a torn record without key
+            free_cell_index = (i + 2) & ~1;
+
+            // the key is programmed first and committed last, a key not committed is the last
+            // cell of a torn record: clear its cells from the bottom so no data word passes as key
+            if ((i & 1) && !flash_get_bit(key, BIT_VALID))
+            {
+                uint16_t j = i;
+                uint8_t length = ftl_key_get_pending_length(key);
+
+                if (length)
+                {
+                    flash_set_bit(&key, BIT_VALID);
+                    if (ftl_key_get_record_cells(key, i))
+                    {
+                        j = i - FTL_RECORD_CELLS(length) + 1;
+                    }
+                }
+
+                FTL_PRINTF(FTL_LEVEL_WARN, "[ftl] torn record at %d..%d cleared\n", j, i);
+
+                for (; j <= i; j++)
+                {
+                    if (ftl_page_read(g_pPage + cur_pageID, j) != 0)
+                    {
+                        ftl_page_write(g_pPage + cur_pageID, j, 0);
+                    }
+                }
+            }
             break;
         }
     }
@@ -1486,6 +2628,7 @@ uint32_t ftl_init(uint32_t u32PageStartAddr, uint8_t pagenum)
 
     g_cur_pageID = cur_pageID;
     g_free_cell_index = free_cell_index;
+    g_gc_pageID = GC_PAGE_NONE;
 
 #if defined(WIN32) && (WIN32 == 1)
 #if defined(EXTRA_DEBUG) && (EXTRA_DEBUG == 1)
@@ -1536,47 +2679,71 @@ void ftl_mapping_table_init(void)
         //ftl_mapping_table = os_mem_zalloc((RAM_TYPE)ftl_config.ftl_mapping_table_ram_type,
         //                                  MAPPING_TABLE_SIZE);//table is initialised as 0
 
-		ftl_mapping_table = rtw_zmalloc(MAPPING_TABLE_SIZE);
+		ftl_mapping_table = rtw_zmalloc(ftl_mapping_table_size());
+    }
+    else
+    {
+        memset(ftl_mapping_table, 0, ftl_mapping_table_size());
     }
+    ftl_mapping_hash_count = 0;
 
     uint8_t pageID = g_cur_pageID;
     int32_t key_index = g_free_cell_index - 1;
 
+    // with a valid checkpoint only the records written after it are scanned
+    uint8_t stop_pageID = g_PAGE_num;
+    uint16_t stop_index = 0;
+    uint8_t *snapshot = ftl_checkpoint_load(&stop_pageID, &stop_index);
+
 L_retry:
 
-    // todo, length is 1
     //PRINTF("pageID,key_index: %d, %d \r\n", pageID, key_index);
 
-    for (; key_index >= 3; key_index -= 2)
+    uint16_t cells;
+    for (; key_index >= 3; key_index -= cells)
     {
-        uint32_t key = ftl_page_read(g_pPage + pageID, key_index);
-
-        uint32_t length = ftl_key_get_length(key);
-
-        if (length == 0)
+        if ((pageID == stop_pageID) && (key_index < stop_index))
         {
-            continue;
+            break;
         }
 
-        //PLATFORM_ASSERT( length == 1);
+        uint32_t key = ftl_page_read(g_pPage + pageID, key_index);
+
+        cells = ftl_key_get_record_cells(key, key_index);
 
-        if (length == 1)
+        if (cells)
         {
             uint16_t addr = key & 0xffff;
-            if (!read_mapping_table(addr))
+            uint8_t length = ftl_key_get_length(key);
+            uint8_t i;
+
+            for (i = 0; i < length; ++i, addr += 4)
             {
-                write_mapping_table(addr, pageID, key_index - 1);
+                if (ftl_check_logical_addr(addr))
+                {
+                    break;
+                }
+
+                // newest first, older records of the same addr are skipped
+                if (!read_mapping_table(addr))
+                {
+                    write_mapping_table(addr, pageID, key_index - 1);
+                }
             }
         }
         else
         {
-            FTL_PRINTF(FTL_LEVEL_ERROR, "[ftl] length != 1! func: %s, line: %d", __FUNCTION__, __LINE__);
+            cells = 2;
+            if (ftl_key_get_length(key) != 0)
+            {
+                FTL_PRINTF(FTL_LEVEL_ERROR, "[ftl] invalid length! func: %s, line: %d", __FUNCTION__, __LINE__);
+            }
         }
 
     }
 
     uint8_t prePageID;
-    if (0 == ftl_get_prev_page(pageID, &prePageID))
+    if ((pageID != stop_pageID) && (0 == ftl_get_prev_page(pageID, &prePageID)))
     {
         uint16_t EndPos;
 
@@ -1598,6 +2765,12 @@ L_retry:
             goto L_retry;
         }
     }
+
+    if (snapshot != NULL)
+    {
+        ftl_mapping_table_merge(snapshot);
+        rtw_mfree(snapshot, 0);
+    }
 }
 
 #if 0//WIN32
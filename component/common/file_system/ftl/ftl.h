@@ -47,6 +47,7 @@ extern  "C" {
 #define FTL_READ_ERROR_PARSE_ERROR          (0x03)
 #define FTL_READ_ERROR_INVALID_PARAMETER    (0x04)
 #define FTL_READ_ERROR_NOT_INIT             (0x05)
+#define FTL_READ_ERROR_IN_INTR              (0x06)
 
 #define FTL_INIT_ERROR_ERASE_FAIL     (0x01)
 /** End of FTL_Exported_Macros
@@ -76,6 +77,13 @@ typedef enum
     FTL_IOCTL_ENABLE_GC_IN_IDLE = 4,  /**< IO code to enable garbage collection in idle task*/
     FTL_IOCTL_DISABLE_GC_IN_IDLE = 5,  /**< IO code to disable garbage collection in idle task*/
     FTL_IOCTL_DO_GC_IN_APP = 6,  /**< IO code to do garbage collection in app*/
+    FTL_IOCTL_ENABLE_INCREMENTAL_GC = 7,  /**< IO code to do garbage collection in steps of at most p1 cells, started when free pages <= p2*/
+    FTL_IOCTL_DISABLE_INCREMENTAL_GC = 8,  /**< IO code to finish incremental garbage collection and go back to whole page gc*/
+    FTL_IOCTL_DO_GC_STEP = 9,  /**< IO code to do one incremental gc step of at most p1 cells, return 1 while gc is pending*/
+    FTL_IOCTL_GET_ERASE_CNT = 10,  /**< IO code to get erase count of page p1, 0xffffffff if p1 is not a ftl page*/
+    FTL_IOCTL_ENABLE_WRITE_CACHE = 11,  /**< IO code to cache up to p1 saved words in RAM, written back by idle once p2 ms old, no save or load from interrupt then*/
+    FTL_IOCTL_DISABLE_WRITE_CACHE = 12,  /**< IO code to write back and free the write cache*/
+    FTL_IOCTL_FLUSH_WRITE_CACHE = 13,  /**< IO code to write back the write cache*/
 } T_FTL_IOCTL_CODE;
 
 /** End of FTL_Exported_Types
@@ -134,6 +142,16 @@ typedef enum
     */
 uint32_t ftl_ioctl(uint32_t cmd, uint32_t p1, uint32_t p2);
 
+/**
+    * @brief    Write back words held by the write cache, called by sys_reset()
+    * @return   void
+    * @note     With FTL_IOCTL_ENABLE_WRITE_CACHE, saved words reach flash only at flush, idle or
+    *           when the cache is full, and are lost by a power loss before that.
+    *           Nothing is written back when called from interrupt, with the scheduler not running,
+    *           by a task inside an ftl call, or when ftl_sem is not free within 100 ms.
+    */
+void ftl_flush_before_reset(void);
+
 /** @} */ /* End of group FTL_Exported_Functions */
 
 static inline void flash_set_bit(uint32_t *addr, uint32_t bit)
@@ -41,11 +41,47 @@ extern  "C" {
 /*============================================================================*
   *                                   Types
   *============================================================================*/
+typedef enum
+{
+    FTL_MAPPING_TABLE_PACKED = 0,  /**< 12 bit entry for each logical word, up to 8 pages */
+    FTL_MAPPING_TABLE_HASH = 1,    /**< hash of live logical words only, up to 33 pages */
+} T_FTL_MAPPING_TYPE;
 
 /*============================================================================*
   *                                Functions
   *============================================================================*/
 uint32_t ftl_init(uint32_t u32PageStartAddr, uint8_t pagenum);
+
+/**
+    * @brief    Init ftl with selected mapping table
+    * @param    u32PageStartAddr  flash address of first ftl page
+    * @param    pagenum    number of ftl pages, at most 33 (16 bit logical address), more than 8 use FTL_MAPPING_TABLE_HASH
+    * @param    mapping_type  @ref T_FTL_MAPPING_TYPE
+    * @param    hash_size  max live logical words for FTL_MAPPING_TABLE_HASH, rounded up to power of 2,
+    *                      0 for the whole logical space ((pagenum - 1) pages worth of words).
+    *                      RAM cost is 4 bytes per entry, a save which needs one more entry than
+    *                      hash_size fails.
+    * @return   status
+    * @retval   0  status successful
+    * @retval   otherwise fail
+    * @note     ftl_init() uses FTL_MAPPING_TABLE_PACKED, which costs 1.5 bytes for every word of
+    *           the logical space whether used or not. The hash only saves RAM with a hash_size
+    *           below the logical space, for applications which use part of it.
+    */
+uint32_t ftl_init_ext(uint32_t u32PageStartAddr, uint8_t pagenum, uint8_t mapping_type, uint16_t hash_size);
+
+/**
+    * @brief    Keep a checkpoint of the mapping table in flash so mount only scans newer records
+    * @param    u32CheckpointAddr  flash address of sectors reserved for the checkpoint, outside the ftl pages
+    * @param    sector_num  number of reserved sectors, 0 disables the checkpoint
+    * @param    gc_interval  write the checkpoint every gc_interval pages recycled by gc, 0 for 1
+    * @return   void
+    * @note     Call before ftl_init(). The checkpoint is the mapping table plus about 150 bytes, one
+    *           sector for the default tables of 3 pages. Each checkpoint costs one sector erase, so a
+    *           larger gc_interval trades mount time for wear. A checkpoint with crc error or taken
+    *           before a page was recycled is ignored and mount falls back to the full scan.
+    */
+void ftl_checkpoint_config(uint32_t u32CheckpointAddr, uint8_t sector_num, uint8_t gc_interval);
 /**
     * @brief    Save specified value to specified ftl offset
     * @param    pdata  specify data buffer
@@ -0,0 +1,777 @@
+/////////////////////////////////////////////////
+//
+// ftl_bench, host benchmark driver of the ftl
+//
+// Replays ftl_save/ftl_load workloads against ftl.c running on the NOR flash
+// model (nor_flash_sim.c) and reports throughput, erases per logical write,
+// worst case garbage collection time and the wear of every sector.
+//
+/////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <getopt.h>
+
+#include "platform_stdlib.h"
+#include "ftl_int.h"
+#include "nor_flash_sim.h"
+
+#define SIM_FLASH_BASE			0x00100000
+#define SIM_MAX_PAGE_NUM		33
+#define SIM_CHECKPOINT_SECTORS	2	/* enough for any packed table */
+#define SIM_MAX_RECORD_SIZE		256
+
+/* ftl.c internals reset on a simulated reboot */
+extern struct Page_T *g_pPage;
+extern uint8_t *ftl_mapping_table;
+extern uint8_t  g_doingGarbageCollection;
+extern uint32_t ftl_mapping_table_size(void);
+extern uint16_t ftl_mapping_hash_count;
+extern uint8_t  ftl_mapping_type;
+extern void    *ftl_write_cache;
+extern uint8_t  ftl_write_cache_dirty;
+
+int ftl_sim_sem_depth;
+
+enum {
+	WORKLOAD_UNIFORM = 0,	/* random offsets over the whole logical space */
+	WORKLOAD_HOT,			/* 90% of the saves hit 10% of the offsets */
+	WORKLOAD_BOND,			/* BLE bonding like: a few fixed records rewritten in turn */
+	WORKLOAD_TRACE,			/* replay of a trace file */
+};
+
+struct bench_cfg {
+	uint8_t     page_num;
+	uint32_t    ops;
+	int         workload;
+	const char *trace_path;
+	const char *image_path;
+	uint16_t    record_size;	/* 0 means random 4..64 bytes */
+	uint32_t    space;			/* logical bytes used by the workload */
+	uint32_t    read_pct;
+	uint32_t    power_loss;		/* mean flash ops between power losses, 0 off */
+	uint32_t    seed;
+	int         show_wear;
+	uint8_t     mapping_type;
+	uint16_t    hash_size;
+	uint16_t    gc_step_cells;	/* incremental gc, 0 off */
+	uint8_t     gc_reserve_page;
+	uint32_t    idle_steps;		/* gc steps run as idle after every operation */
+	uint8_t     checkpoint_interval;	/* 0 no checkpoint */
+	uint8_t     cache_words;	/* write-back cache, 0 off */
+	uint32_t    cache_delay_ms;
+	uint32_t    same_pct;		/* saves that rewrite the stored value */
+	uint32_t    torn_rounds;	/* torn record check instead of a workload, 0 off */
+};
+
+struct bench_result {
+	uint64_t saves;
+	uint64_t save_words;
+	uint64_t save_fail;
+	uint64_t loads;
+	uint64_t load_fail;
+	uint64_t save_wall_ns;
+	uint64_t load_wall_ns;
+	uint64_t worst_save_busy_ns;
+
+	uint64_t gc_count;
+	uint64_t gc_recycled;
+	uint64_t gc_busy_ns;
+	uint64_t gc_worst_busy_ns;
+	uint64_t gc_worst_wall_ns;
+
+	uint64_t power_loss;
+	uint64_t mismatch_words;
+
+	uint64_t mount_count;
+	uint64_t mount_reads;
+	uint64_t mount_worst_reads;
+	uint64_t mount_wall_ns;
+};
+
+static struct bench_result result;
+
+/* shadow copy of what the ftl should return */
+static uint8_t  *shadow;
+static uint8_t  *shadow_valid;	/* one flag per 4 bytes */
+static uint32_t  shadow_size;
+
+static uint64_t gc_begin_wall;
+static uint64_t gc_begin_busy;
+
+static uint64_t now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+void ftl_sim_gc_begin(void)
+{
+	gc_begin_wall = now_ns();
+	gc_begin_busy = nor_sim_busy_ns();
+}
+
+void ftl_sim_gc_end(uint16_t recycle_num)
+{
+	uint64_t wall = now_ns() - gc_begin_wall;
+	uint64_t busy = nor_sim_busy_ns() - gc_begin_busy;
+
+	result.gc_count++;
+	result.gc_recycled += recycle_num;
+	result.gc_busy_ns += busy;
+
+	if (busy > result.gc_worst_busy_ns) {
+		result.gc_worst_busy_ns = busy;
+	}
+	if (wall > result.gc_worst_wall_ns) {
+		result.gc_worst_wall_ns = wall;
+	}
+}
+
+static uint8_t  sim_mapping_type;
+static uint16_t sim_hash_size;
+static uint16_t sim_gc_step_cells;
+static uint8_t  sim_gc_reserve_page;
+static uint8_t  sim_checkpoint_interval;
+static uint8_t  sim_cache_words;
+static uint32_t sim_cache_delay_ms;
+
+/* one operation per ms */
+unsigned int ftl_sim_now_ms;
+
+/* drop everything ftl.c keeps in RAM, as a reset of the chip would */
+static void sim_reboot(uint32_t page_num)
+{
+	free(ftl_mapping_table);
+	ftl_mapping_table = NULL;
+	g_pPage = NULL;
+	g_doingGarbageCollection = 0;
+	ftl_sim_sem_depth = 0;
+	free(ftl_write_cache);
+	ftl_write_cache = NULL;
+	ftl_write_cache_dirty = 0;
+
+	if (sim_checkpoint_interval) {
+		ftl_checkpoint_config(SIM_FLASH_BASE + page_num * NOR_SIM_SECTOR_SIZE,
+							  SIM_CHECKPOINT_SECTORS, sim_checkpoint_interval);
+	}
+
+	struct nor_sim_stats before, after;
+	uint64_t wall = now_ns();
+
+	nor_sim_get_stats(&before);
+	if (ftl_init_ext(SIM_FLASH_BASE, page_num, sim_mapping_type, sim_hash_size) != 0) {
+		fprintf(stderr, "ftl_init failed\n");
+		exit(1);
+	}
+	nor_sim_get_stats(&after);
+
+	result.mount_count++;
+	result.mount_wall_ns += now_ns() - wall;
+	result.mount_reads += after.read_words - before.read_words;
+	if (after.read_words - before.read_words > result.mount_worst_reads) {
+		result.mount_worst_reads = after.read_words - before.read_words;
+	}
+
+	if (sim_gc_step_cells) {
+		ftl_ioctl(FTL_IOCTL_ENABLE_INCREMENTAL_GC, sim_gc_step_cells, sim_gc_reserve_page);
+	}
+	if (sim_cache_words) {
+		ftl_ioctl(FTL_IOCTL_ENABLE_WRITE_CACHE, sim_cache_words, sim_cache_delay_ms);
+	}
+}
+
+static void sim_arm_power_loss(const struct bench_cfg *cfg)
+{
+	if (cfg->power_loss) {
+		nor_sim_arm_power_loss(1 + (uint32_t)rand() % (2 * cfg->power_loss));
+	}
+}
+
+/* compare one 4 byte word with the shadow, accept the flash content if it is pending */
+static void verify_word(uint16_t offset, int pending)
+{
+	uint8_t buf[4];
+	uint32_t ret = ftl_load_from_storage(buf, offset, 4);
+	uint32_t idx = offset / 4;
+
+	if (pending) {
+		if (ret == 0) {
+			memcpy(shadow + offset, buf, 4);
+			shadow_valid[idx] = 1;
+		}
+		return;
+	}
+
+	if (!shadow_valid[idx]) {
+		return;
+	}
+
+	if (ret != 0 || memcmp(buf, shadow + offset, 4) != 0) {
+		result.mismatch_words++;
+		if (ret == 0) {
+			memcpy(shadow + offset, buf, 4);
+		} else {
+			shadow_valid[idx] = 0;
+		}
+	}
+}
+
+static void verify_all(uint16_t pending_offset, uint16_t pending_size)
+{
+	uint32_t offset;
+
+	for (offset = 0; offset < shadow_size; offset += 4) {
+		int pending = (offset >= pending_offset && offset < (uint32_t)pending_offset + pending_size);
+		verify_word(offset, pending);
+	}
+}
+
+static void fill_record(uint8_t *buf, uint16_t size)
+{
+	uint16_t i;
+
+	for (i = 0; i < size; i++) {
+		buf[i] = (uint8_t)rand();
+	}
+}
+
+static void do_save(const struct bench_cfg *cfg, uint16_t offset, uint16_t size)
+{
+	uint8_t buf[SIM_MAX_RECORD_SIZE];
+
+	fill_record(buf, size);
+	if ((uint32_t)(rand() % 100) < cfg->same_pct) {
+		memcpy(buf, shadow + offset, size);
+	}
+
+	if (setjmp(nor_sim_power_env) != 0) {
+		result.power_loss++;
+		sim_reboot(cfg->page_num);
+		verify_all(offset, size);
+		sim_arm_power_loss(cfg);
+		return;
+	}
+
+	uint64_t busy = nor_sim_busy_ns();
+	uint64_t start = now_ns();
+	uint32_t ret = ftl_save_to_storage(buf, offset, size);
+	result.save_wall_ns += now_ns() - start;
+	busy = nor_sim_busy_ns() - busy;
+
+	if (busy > result.worst_save_busy_ns) {
+		result.worst_save_busy_ns = busy;
+	}
+
+	result.saves++;
+	result.save_words += size / 4;
+
+	if (ret != 0) {
+		result.save_fail++;
+		return;
+	}
+
+	memcpy(shadow + offset, buf, size);
+	memset(shadow_valid + offset / 4, 1, size / 4);
+}
+
+static void do_load(const struct bench_cfg *cfg, uint16_t offset, uint16_t size)
+{
+	uint8_t buf[SIM_MAX_RECORD_SIZE];
+	uint32_t i;
+
+	(void)cfg;
+
+	for (i = 0; i < size / 4; i++) {
+		if (!shadow_valid[offset / 4 + i]) {
+			return;
+		}
+	}
+
+	uint64_t start = now_ns();
+	uint32_t ret = ftl_load_from_storage(buf, offset, size);
+	result.load_wall_ns += now_ns() - start;
+	result.loads++;
+
+	if (ret != 0) {
+		result.load_fail++;
+	} else if (memcmp(buf, shadow + offset, size) != 0) {
+		result.mismatch_words += size / 4;
+		memcpy(shadow + offset, buf, size);
+	}
+}
+
+static uint16_t pick_size(const struct bench_cfg *cfg)
+{
+	uint16_t size = cfg->record_size;
+
+	if (size == 0) {
+		size = 4 * (1 + rand() % 16);
+	}
+	if (size > cfg->space) {
+		size = cfg->space;
+	}
+	return size;
+}
+
+static uint16_t pick_offset(const struct bench_cfg *cfg, uint16_t size, uint32_t op)
+{
+	uint32_t slots = (cfg->space - size) / 4 + 1;
+	uint32_t slot;
+
+	switch (cfg->workload) {
+	case WORKLOAD_HOT:
+		if (rand() % 10) {
+			slot = rand() % ((slots + 9) / 10);
+		} else {
+			slot = rand() % slots;
+		}
+		break;
+	case WORKLOAD_BOND:
+		/* 8 records of the same size rewritten round robin */
+		slot = (op % 8) * (size / 4);
+		if (slot >= slots) {
+			slot %= slots;
+		}
+		break;
+	default:
+		slot = rand() % slots;
+		break;
+	}
+
+	return slot * 4;
+}
+
+static void do_idle(const struct bench_cfg *cfg)
+{
+	uint32_t i;
+
+	if (setjmp(nor_sim_power_env) != 0) {
+		result.power_loss++;
+		sim_reboot(cfg->page_num);
+		verify_all(0, 0);
+		sim_arm_power_loss(cfg);
+		return;
+	}
+
+	ftl_sim_now_ms++;
+
+	/* the idle hook writes back the cache once it is old enough */
+	if (cfg->cache_words) {
+		ftl_garbage_collect_in_idle();
+	}
+
+	for (i = 0; i < cfg->idle_steps; i++) {
+		if (ftl_ioctl(FTL_IOCTL_DO_GC_STEP, 0, 0) == 0) {
+			break;
+		}
+	}
+}
+
+static void run_synthetic(const struct bench_cfg *cfg)
+{
+	uint32_t op;
+
+	for (op = 0; op < cfg->ops; op++) {
+		uint16_t size = pick_size(cfg);
+		uint16_t offset = pick_offset(cfg, size, op);
+
+		if ((uint32_t)(rand() % 100) < cfg->read_pct) {
+			do_load(cfg, offset, size);
+		} else {
+			do_save(cfg, offset, size);
+		}
+		do_idle(cfg);
+	}
+}
+
+/* trace line: "s <offset> <size>" or "l <offset> <size>", '#' starts a comment */
+static void run_trace(const struct bench_cfg *cfg)
+{
+	FILE *fp = fopen(cfg->trace_path, "r");
+	char line[128];
+	uint32_t lineno = 0;
+
+	if (fp == NULL) {
+		perror(cfg->trace_path);
+		exit(1);
+	}
+
+	while (fgets(line, sizeof(line), fp)) {
+		char op;
+		unsigned int offset, size;
+
+		lineno++;
+		if (line[0] == '#' || line[0] == '\n') {
+			continue;
+		}
+		if (sscanf(line, " %c %i %i", &op, &offset, &size) != 3 ||
+			(offset & 3) || (size & 3) || size == 0 || size > SIM_MAX_RECORD_SIZE ||
+			offset + size > shadow_size) {
+			fprintf(stderr, "%s:%u: bad trace line\n", cfg->trace_path, lineno);
+			continue;
+		}
+
+		if (op == 's' || op == 'S') {
+			do_save(cfg, offset, size);
+		} else {
+			do_load(cfg, offset, size);
+		}
+		do_idle(cfg);
+	}
+
+	fclose(fp);
+}
+
+/*
+ * Save a record of 1..4 words over an old one and cut the power at every flash
+ * operation of the save in turn, <rounds> times each with other torn bits. After
+ * the re-mount the record must read all old or all new and the word saved before
+ * must be intact. The last new word reads as a key of the word at 0x10.
+ */
+static int run_torn_check(const struct bench_cfg *cfg)
+{
+	static const uint32_t old_rec[4] = { 0x01010101, 0x02020202, 0x03030303, 0x04040404 };
+	static const uint32_t new_rec[4] = { 0xdeadbeef, 0xcafebabe, 0x12345678, 0x00020010 };
+	static const uint32_t neighbour = 0x11111111;
+	static volatile uint32_t words, cut, round, done, cuts, bad;
+	uint32_t rec[4], word;
+
+	cuts = 0;
+	bad = 0;
+	for (words = 1; words <= 4; words++) {
+		for (cut = 1, done = 0; !done; cut++) {
+			for (round = 0; round < cfg->torn_rounds && !done; round++) {
+				ftl_ioctl(FTL_IOCTL_CLEAR_ALL, 0, 0);
+				ftl_save_to_storage((void *)&neighbour, 0x10, 4);
+				ftl_save_to_storage((void *)old_rec, 0x20, words * 4);
+
+				if (setjmp(nor_sim_power_env) == 0) {
+					nor_sim_arm_power_loss(cut);
+					ftl_save_to_storage((void *)new_rec, 0x20, words * 4);
+					nor_sim_arm_power_loss(0);
+					done = 1;
+					break;
+				}
+
+				result.power_loss++;
+				cuts++;
+				sim_reboot(cfg->page_num);
+
+				if (ftl_load_from_storage(&word, 0x10, 4) != 0 || word != neighbour ||
+					ftl_load_from_storage(rec, 0x20, words * 4) != 0 ||
+					(memcmp(rec, old_rec, words * 4) != 0 && memcmp(rec, new_rec, words * 4) != 0)) {
+					printf("  torn save of %u words at flash op %u: 0x10 reads 0x%08x\n",
+						   words, cut, word);
+					bad++;
+				}
+			}
+		}
+	}
+
+	printf("torn records   : %u power losses inside a save, %u corrupted\n", cuts, bad);
+
+	return bad ? 1 : 0;
+}
+
+static void report_wear(const struct bench_cfg *cfg)
+{
+	uint32_t i, min = UINT32_MAX, max = 0;
+	uint32_t ftl_min = UINT32_MAX, ftl_max = 0;
+	uint64_t sum = 0;
+
+	for (i = 0; i < cfg->page_num; i++) {
+		uint32_t cnt = nor_sim_sector_erase_count(i);
+		/* count persisted by the ftl in the page header, survives reboots and images */
+		uint32_t ftl_cnt = ftl_ioctl(FTL_IOCTL_GET_ERASE_CNT, i, 0);
+		sum += cnt;
+		if (cnt < min) {
+			min = cnt;
+		}
+		if (cnt > max) {
+			max = cnt;
+		}
+		if (ftl_cnt < ftl_min) {
+			ftl_min = ftl_cnt;
+		}
+		if (ftl_cnt > ftl_max) {
+			ftl_max = ftl_cnt;
+		}
+		if (cfg->show_wear) {
+			printf("  sector %2u: %u erases, %u in page header\n", i, cnt, ftl_cnt);
+		}
+	}
+
+	printf("wear           : min %u, max %u, avg %.1f erases per sector, header count %u..%u\n",
+		   min, max, (double)sum / cfg->page_num, ftl_min, ftl_max);
+
+	if (cfg->checkpoint_interval) {
+		for (i = cfg->page_num; i < cfg->page_num + SIM_CHECKPOINT_SECTORS; i++) {
+			printf("  checkpoint sector %u: %u erases\n", i - cfg->page_num, nor_sim_sector_erase_count(i));
+		}
+	}
+}
+
+static void report(const struct bench_cfg *cfg)
+{
+	struct nor_sim_stats stats;
+	static const char *const name[] = { "uniform", "hot", "bond", "trace" };
+
+	nor_sim_get_stats(&stats);
+
+	printf("workload       : %s, %u pages, %u bytes logical space\n",
+		   name[cfg->workload], cfg->page_num, cfg->space);
+	printf("saves          : %llu (%llu words, %llu failed), %.0f ops/s\n",
+		   (unsigned long long)result.saves, (unsigned long long)result.save_words,
+		   (unsigned long long)result.save_fail,
+		   result.save_wall_ns ? result.saves * 1e9 / result.save_wall_ns : 0.0);
+	printf("modeled        : %.2f s flash busy, %.0f saves/s at flash speed\n",
+		   stats.busy_ns / 1e9, stats.busy_ns ? result.saves * 1e9 / stats.busy_ns : 0.0);
+	printf("loads          : %llu (%llu failed), %.0f ops/s\n",
+		   (unsigned long long)result.loads, (unsigned long long)result.load_fail,
+		   result.load_wall_ns ? result.loads * 1e9 / result.load_wall_ns : 0.0);
+	printf("flash          : %llu programmed words in %llu programs, %llu erases, %llu reads, %llu illegal programs\n",
+		   (unsigned long long)stats.program_words, (unsigned long long)stats.program_ops,
+		   (unsigned long long)stats.erase_count,
+		   (unsigned long long)stats.read_words, (unsigned long long)stats.illegal_program);
+	if (result.save_words) {
+		printf("amplification  : %.3f programmed words and %.3f programs per logical word, %.5f erases per logical word, %.5f erases per save\n",
+			   (double)stats.program_words / result.save_words,
+			   (double)stats.program_ops / result.save_words,
+			   (double)stats.erase_count / result.save_words,
+			   (double)stats.erase_count / result.saves);
+	}
+	printf("gc             : %llu runs, %llu recycled, avg %.2f ms, worst %.2f ms modeled / %.1f us host\n",
+		   (unsigned long long)result.gc_count, (unsigned long long)result.gc_recycled,
+		   result.gc_count ? result.gc_busy_ns / 1e6 / result.gc_count : 0.0,
+		   result.gc_worst_busy_ns / 1e6, result.gc_worst_wall_ns / 1e3);
+	printf("save latency   : worst %.2f ms modeled\n", result.worst_save_busy_ns / 1e6);
+	printf("mount          : %llu mounts, avg %.0f worst %llu words read, avg %.1f us host\n",
+		   (unsigned long long)result.mount_count,
+		   result.mount_count ? (double)result.mount_reads / result.mount_count : 0.0,
+		   (unsigned long long)result.mount_worst_reads,
+		   result.mount_count ? result.mount_wall_ns / 1e3 / result.mount_count : 0.0);
+	printf("mapping table  : %s, %u bytes RAM, %u live words\n",
+		   ftl_mapping_type == FTL_MAPPING_TABLE_HASH ? "hash" : "packed",
+		   ftl_mapping_table_size(), ftl_mapping_type == FTL_MAPPING_TABLE_HASH ?
+		   ftl_mapping_hash_count : (unsigned int)(cfg->space / 4));
+	report_wear(cfg);
+	if (cfg->power_loss) {
+		printf("power loss     : %llu injected, %llu words lost or corrupted\n",
+			   (unsigned long long)result.power_loss, (unsigned long long)result.mismatch_words);
+	} else {
+		printf("verify         : %llu words mismatched\n", (unsigned long long)result.mismatch_words);
+	}
+}
+
+static void usage(const char *prog)
+{
+	printf("usage: %s [options]\n"
+		   "  -p <pages>      ftl pages (default 3)\n"
+		   "  -n <ops>        operations for synthetic workloads (default 100000)\n"
+		   "  -w <workload>   uniform | hot | bond (default uniform)\n"
+		   "  -t <file>       replay trace file instead of a synthetic workload\n"
+		   "  -s <bytes>      record size, multiple of 4 (default random 4..64)\n"
+		   "  -k <bytes>      logical space used (default half of the ftl capacity)\n"
+		   "  -r <percent>    loads among the operations (default 30)\n"
+		   "  -l <ops>        inject a power loss every ~<ops> flash operations\n"
+		   "  -f <image>      mmap the flash image from a file instead of RAM\n"
+		   "  -g <cells>[,<reserve>]  incremental gc of <cells> per step, started at <reserve> free pages\n"
+		   "  -i <steps>      incremental gc steps run as idle after every operation (default 0)\n"
+		   "  -c <interval>   checkpoint of the mapping table every <interval> recycled pages\n"
+		   "  -C <words>[,<ms>]  write-back cache of <words>, written back by idle after <ms>\n"
+		   "  -u <percent>    saves that rewrite the value already stored (default 0)\n"
+		   "  -m <type>       mapping table: packed | hash[:<entries>] (default packed)\n"
+		   "  -S <seed>       random seed\n"
+		   "  -T <rounds>     torn record check: power loss at every flash op of a save, <rounds> times\n"
+		   "  -e <prog_ns>,<erase_ns>  modeled flash latencies\n"
+		   "  -v              print the erase count of every sector\n", prog);
+}
+
+int main(int argc, char **argv)
+{
+	struct bench_cfg cfg = {
+		.page_num = 3,
+		.ops = 100000,
+		.workload = WORKLOAD_UNIFORM,
+		.read_pct = 30,
+		.seed = 1,
+	};
+	int opt;
+
+	while ((opt = getopt(argc, argv, "p:n:w:t:s:k:r:l:f:g:i:c:C:u:m:S:T:e:vh")) != -1) {
+		switch (opt) {
+		case 'p':
+			cfg.page_num = atoi(optarg);
+			break;
+		case 'n':
+			cfg.ops = strtoul(optarg, NULL, 0);
+			break;
+		case 'w':
+			if (!strcmp(optarg, "hot")) {
+				cfg.workload = WORKLOAD_HOT;
+			} else if (!strcmp(optarg, "bond")) {
+				cfg.workload = WORKLOAD_BOND;
+			} else {
+				cfg.workload = WORKLOAD_UNIFORM;
+			}
+			break;
+		case 't':
+			cfg.workload = WORKLOAD_TRACE;
+			cfg.trace_path = optarg;
+			break;
+		case 's':
+			cfg.record_size = strtoul(optarg, NULL, 0) & ~3;
+			break;
+		case 'k':
+			cfg.space = strtoul(optarg, NULL, 0) & ~3;
+			break;
+		case 'r':
+			cfg.read_pct = strtoul(optarg, NULL, 0);
+			break;
+		case 'l':
+			cfg.power_loss = strtoul(optarg, NULL, 0);
+			break;
+		case 'f':
+			cfg.image_path = optarg;
+			break;
+		case 'g': {
+			unsigned int cells = 0, reserve = 1;
+			sscanf(optarg, "%u,%u", &cells, &reserve);
+			cfg.gc_step_cells = cells;
+			cfg.gc_reserve_page = reserve;
+			break;
+		}
+		case 'i':
+			cfg.idle_steps = strtoul(optarg, NULL, 0);
+			break;
+		case 'c':
+			cfg.checkpoint_interval = strtoul(optarg, NULL, 0);
+			break;
+		case 'C': {
+			unsigned int words = 0, delay = 0;
+			sscanf(optarg, "%u,%u", &words, &delay);
+			cfg.cache_words = words;
+			cfg.cache_delay_ms = delay;
+			break;
+		}
+		case 'u':
+			cfg.same_pct = strtoul(optarg, NULL, 0);
+			break;
+		case 'm':
+			if (!strncmp(optarg, "hash", 4)) {
+				cfg.mapping_type = FTL_MAPPING_TABLE_HASH;
+				if (optarg[4] == ':') {
+					cfg.hash_size = strtoul(optarg + 5, NULL, 0);
+				}
+			} else {
+				cfg.mapping_type = FTL_MAPPING_TABLE_PACKED;
+			}
+			break;
+		case 'S':
+			cfg.seed = strtoul(optarg, NULL, 0);
+			break;
+		case 'T':
+			cfg.torn_rounds = strtoul(optarg, NULL, 0);
+			break;
+		case 'e': {
+			unsigned long prog_ns = 0, erase_ns = 0;
+			sscanf(optarg, "%lu,%lu", &prog_ns, &erase_ns);
+			nor_sim_set_latency(prog_ns, erase_ns);
+			break;
+		}
+		case 'v':
+			cfg.show_wear = 1;
+			break;
+		default:
+			usage(argv[0]);
+			return opt == 'h' ? 0 : 1;
+		}
+	}
+
+	if (cfg.page_num < 3 || cfg.page_num > SIM_MAX_PAGE_NUM) {
+		fprintf(stderr, "pages must be 3..%d\n", SIM_MAX_PAGE_NUM);
+		return 1;
+	}
+	if (cfg.record_size > SIM_MAX_RECORD_SIZE) {
+		cfg.record_size = SIM_MAX_RECORD_SIZE;
+	}
+
+	/* same formula as MAX_logical_address_size in ftl.c */
+	uint32_t capacity = ((NOR_SIM_SECTOR_SIZE / 8 - 1) * (cfg.page_num - 1) - 1) * 4;
+	if (capacity > 0x10000) {
+		capacity = 0x10000;
+	}
+	if (cfg.space == 0 || cfg.space > capacity) {
+		cfg.space = (cfg.space == 0) ? capacity / 2 : capacity;
+		cfg.space &= ~3;
+	}
+
+	srand(cfg.seed);
+
+	sim_mapping_type = cfg.mapping_type;
+	sim_hash_size = cfg.hash_size;
+	sim_gc_step_cells = cfg.gc_step_cells;
+	sim_gc_reserve_page = cfg.gc_reserve_page;
+	sim_checkpoint_interval = cfg.checkpoint_interval;
+	sim_cache_words = cfg.cache_words;
+	sim_cache_delay_ms = cfg.cache_delay_ms;
+
+	if (nor_sim_init(SIM_FLASH_BASE, cfg.page_num + (cfg.checkpoint_interval ? SIM_CHECKPOINT_SECTORS : 0),
+					 cfg.image_path) != 0) {
+		fprintf(stderr, "nor_sim_init failed\n");
+		return 1;
+	}
+
+	shadow_size = (cfg.workload == WORKLOAD_TRACE) ? capacity : cfg.space;
+	shadow = calloc(1, shadow_size);
+	shadow_valid = calloc(1, shadow_size / 4);
+	if (shadow == NULL || shadow_valid == NULL) {
+		return 1;
+	}
+
+	sim_reboot(cfg.page_num);
+
+	/* a persistent image already holds data, take it as the reference */
+	if (cfg.image_path) {
+		verify_all(0, shadow_size);
+	}
+	nor_sim_reset_stats();
+
+	if (cfg.torn_rounds) {
+		int ret = run_torn_check(&cfg);
+
+		nor_sim_deinit();
+		free(shadow);
+		free(shadow_valid);
+		return ret;
+	}
+
+	sim_arm_power_loss(&cfg);
+
+	if (cfg.workload == WORKLOAD_TRACE) {
+		run_trace(&cfg);
+	} else {
+		run_synthetic(&cfg);
+	}
+
+	nor_sim_arm_power_loss(0);
+
+	/* final check, through a clean reboot so the mount path is covered too */
+	ftl_flush_before_reset();
+	sim_reboot(cfg.page_num);
+	verify_all(0, 0);
+
+	report(&cfg);
+
+	nor_sim_deinit();
+	free(shadow);
+	free(shadow_valid);
+
+	return 0;
+}
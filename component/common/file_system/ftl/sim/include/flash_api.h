@@ -0,0 +1,22 @@
+/*
+ * Host build replacement of flash_api.h for the FTL simulator.
+ * The functions are implemented by the NOR flash model in nor_flash_sim.c.
+ */
+#ifndef MBED_EXT_FLASH_API_EXT_H
+#define MBED_EXT_FLASH_API_EXT_H
+
+#include <stdint.h>
+
+struct flash_s {
+	uint32_t dummy;
+};
+typedef struct flash_s flash_t;
+
+void flash_erase_sector(flash_t *obj, uint32_t address);
+int flash_read_word(flash_t *obj, uint32_t address, uint32_t *data);
+int flash_write_word(flash_t *obj, uint32_t address, uint32_t data);
+int flash_stream_read(flash_t *obj, uint32_t address, uint32_t len, uint8_t *data);
+int flash_stream_write(flash_t *obj, uint32_t address, uint32_t len, uint8_t *data);
+int flash_burst_write(flash_t *obj, uint32_t address, uint32_t Length, uint8_t *data);
+
+#endif
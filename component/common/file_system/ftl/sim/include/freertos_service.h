@@ -0,0 +1,57 @@
+/*
+ * Host build replacement of freertos_service.h for the FTL simulator.
+ * Recursive mutexes are reduced to a nesting counter; the simulator is
+ * single threaded and may abandon a locked section on injected power loss.
+ */
+#ifndef _FREERTOS_SERVICE_H_
+#define _FREERTOS_SERVICE_H_
+
+#include <stdint.h>
+
+typedef void *QueueHandle_t;
+typedef void *TaskHandle_t;
+
+#define portMAX_DELAY	0xffffffffUL
+#define portTICK_PERIOD_MS	1
+#define pdTRUE	1
+#define taskSCHEDULER_RUNNING	2
+
+extern int ftl_sim_sem_depth;
+
+static inline QueueHandle_t xSemaphoreCreateRecursiveMutex(void)
+{
+	return (QueueHandle_t)&ftl_sim_sem_depth;
+}
+
+static inline int xSemaphoreTakeRecursive(QueueHandle_t sema, uint32_t timeout)
+{
+	(void)sema;
+	(void)timeout;
+	ftl_sim_sem_depth++;
+	return 1;
+}
+
+static inline int xSemaphoreGiveRecursive(QueueHandle_t sema)
+{
+	(void)sema;
+	ftl_sim_sem_depth--;
+	return 1;
+}
+
+static inline TaskHandle_t xTaskGetCurrentTaskHandle(void)
+{
+	return (TaskHandle_t)&ftl_sim_sem_depth;
+}
+
+static inline TaskHandle_t xSemaphoreGetMutexHolder(QueueHandle_t sema)
+{
+	(void)sema;
+	return ftl_sim_sem_depth ? xTaskGetCurrentTaskHandle() : NULL;
+}
+
+static inline int xTaskGetSchedulerState(void)
+{
+	return taskSCHEDULER_RUNNING;
+}
+
+#endif //_FREERTOS_SERVICE_H_
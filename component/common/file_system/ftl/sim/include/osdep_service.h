@@ -0,0 +1,19 @@
+/*
+ * Host build replacement of osdep_service.h for the FTL simulator.
+ */
+#ifndef __OSDEP_SERVICE_H_
+#define __OSDEP_SERVICE_H_
+
+#include <stdlib.h>
+
+#define rtw_malloc(sz)			((u8 *)malloc(sz))
+#define rtw_zmalloc(sz)			((u8 *)calloc(1, (sz)))
+#define rtw_mfree(pbuf, sz)		free(pbuf)
+#define rtw_free(buf)			free(buf)
+
+/* virtual clock in ms, advanced by the benchmark */
+extern unsigned int ftl_sim_now_ms;
+#define rtw_get_current_time()			(ftl_sim_now_ms)
+#define rtw_get_passing_time_ms(start)	((int)(ftl_sim_now_ms - (start)))
+
+#endif //__OSDEP_SERVICE_H_
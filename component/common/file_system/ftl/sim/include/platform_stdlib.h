@@ -0,0 +1,37 @@
+/*
+ * Host build replacement of platform_stdlib.h for the FTL simulator.
+ * Only what ftl.c needs from the target platform headers is provided here.
+ */
+#ifndef __PLATFORM_STDLIB_H__
+#define __PLATFORM_STDLIB_H__
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#ifndef TRUE
+#define TRUE	1
+#endif
+#ifndef FALSE
+#define FALSE	0
+#endif
+
+#define BIT31	0x80000000
+
+#ifndef __WEAK
+#define __WEAK	__attribute__((weak))
+#endif
+
+typedef uint8_t		u8;
+typedef uint16_t	u16;
+typedef uint32_t	u32;
+
+/* The simulator never runs in handler mode */
+static inline uint32_t __get_IPSR(void)
+{
+	return 0;
+}
+
+#endif //__PLATFORM_STDLIB_H__
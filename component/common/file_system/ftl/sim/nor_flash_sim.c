@@ -0,0 +1,261 @@
+/////////////////////////////////////////////////
+//
+// NOR flash model for the host build of the ftl
+//
+/////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include "flash_api.h"
+#include "nor_flash_sim.h"
+
+jmp_buf nor_sim_power_env;
+
+static uint8_t  *nor_image = NULL;
+static int       nor_image_fd = -1;
+static uint32_t  nor_base;
+static uint32_t  nor_size;
+static uint32_t *nor_erase_cnt = NULL;
+
+static uint32_t  nor_program_word_ns = NOR_SIM_PROGRAM_WORD_NS;
+static uint32_t  nor_erase_sector_ns = NOR_SIM_ERASE_SECTOR_NS;
+static int       nor_strict = 0;
+static uint64_t  nor_power_loss_countdown = 0;
+
+static struct nor_sim_stats nor_stats;
+
+int nor_sim_init(uint32_t base, uint32_t sector_num, const char *image_path)
+{
+	nor_base = base;
+	nor_size = sector_num * NOR_SIM_SECTOR_SIZE;
+
+	if (image_path) {
+		nor_image_fd = open(image_path, O_RDWR | O_CREAT, 0644);
+		if (nor_image_fd < 0) {
+			perror("nor_sim_init: open");
+			return -1;
+		}
+
+		off_t old_size = lseek(nor_image_fd, 0, SEEK_END);
+		if (ftruncate(nor_image_fd, nor_size) != 0) {
+			perror("nor_sim_init: ftruncate");
+			close(nor_image_fd);
+			return -1;
+		}
+
+		nor_image = mmap(NULL, nor_size, PROT_READ | PROT_WRITE, MAP_SHARED, nor_image_fd, 0);
+		if (nor_image == MAP_FAILED) {
+			perror("nor_sim_init: mmap");
+			nor_image = NULL;
+			close(nor_image_fd);
+			return -1;
+		}
+
+		/* a new (or grown) image is in erased state */
+		if (old_size < (off_t)nor_size) {
+			memset(nor_image + (old_size > 0 ? old_size : 0), 0xff, nor_size - (old_size > 0 ? old_size : 0));
+		}
+	} else {
+		nor_image = malloc(nor_size);
+		if (nor_image == NULL) {
+			return -1;
+		}
+		memset(nor_image, 0xff, nor_size);
+	}
+
+	nor_erase_cnt = calloc(sector_num, sizeof(uint32_t));
+	if (nor_erase_cnt == NULL) {
+		nor_sim_deinit();
+		return -1;
+	}
+
+	nor_sim_reset_stats();
+	return 0;
+}
+
+void nor_sim_deinit(void)
+{
+	if (nor_image_fd >= 0) {
+		if (nor_image) {
+			munmap(nor_image, nor_size);
+		}
+		close(nor_image_fd);
+		nor_image_fd = -1;
+	} else {
+		free(nor_image);
+	}
+	nor_image = NULL;
+
+	free(nor_erase_cnt);
+	nor_erase_cnt = NULL;
+}
+
+void nor_sim_set_latency(uint32_t program_word_ns, uint32_t erase_sector_ns)
+{
+	nor_program_word_ns = program_word_ns;
+	nor_erase_sector_ns = erase_sector_ns;
+}
+
+void nor_sim_set_strict(int strict)
+{
+	nor_strict = strict;
+}
+
+void nor_sim_get_stats(struct nor_sim_stats *stats)
+{
+	*stats = nor_stats;
+}
+
+void nor_sim_reset_stats(void)
+{
+	memset(&nor_stats, 0, sizeof(nor_stats));
+}
+
+uint32_t nor_sim_sector_erase_count(uint32_t sector)
+{
+	if (sector * NOR_SIM_SECTOR_SIZE >= nor_size) {
+		return 0;
+	}
+	return nor_erase_cnt[sector];
+}
+
+uint64_t nor_sim_busy_ns(void)
+{
+	return nor_stats.busy_ns;
+}
+
+void nor_sim_arm_power_loss(uint64_t op_countdown)
+{
+	nor_power_loss_countdown = op_countdown;
+}
+
+static uint32_t nor_sim_offset(uint32_t address, uint32_t len)
+{
+	if (address < nor_base || address - nor_base + len > nor_size) {
+		fprintf(stderr, "[nor_sim] access out of range: 0x%08x (+%u)\n", address, len);
+		abort();
+	}
+	return address - nor_base;
+}
+
+/* return 1 when this operation is the one interrupted by the power loss */
+static int nor_sim_power_loss_hit(void)
+{
+	if (nor_power_loss_countdown == 0) {
+		return 0;
+	}
+	return (--nor_power_loss_countdown == 0);
+}
+
+static void nor_sim_program(uint32_t offset, uint32_t len, const uint8_t *data)
+{
+	uint32_t i;
+	int torn = nor_sim_power_loss_hit();
+	/* a program runs through the bytes in order, a torn one stops at a random byte */
+	uint32_t cut = torn ? (uint32_t)rand() % (len + 1) : len;
+
+	for (i = 0; i < len && i <= cut; i++) {
+		uint8_t old = nor_image[offset + i];
+		uint8_t val = data[i];
+
+		if (~old & val) {
+			nor_stats.illegal_program++;
+			if (nor_strict) {
+				fprintf(stderr, "[nor_sim] program 0->1 at 0x%08x: 0x%02x -> 0x%02x\n",
+						nor_base + offset + i, old, val);
+				abort();
+			}
+		}
+
+		if (i == cut) {
+			/* only a random part of the bits to clear made it */
+			val |= (uint8_t)rand();
+		}
+
+		nor_image[offset + i] = old & val;
+	}
+
+	nor_stats.program_words += (len + 3) / 4;
+	nor_stats.program_ops++;
+	nor_stats.busy_ns += (uint64_t)nor_program_word_ns * ((len + 3) / 4);
+
+	if (torn) {
+		longjmp(nor_sim_power_env, 1);
+	}
+}
+
+void flash_erase_sector(flash_t *obj, uint32_t address)
+{
+	(void)obj;
+
+	address &= ~(NOR_SIM_SECTOR_SIZE - 1);
+	uint32_t offset = nor_sim_offset(address, NOR_SIM_SECTOR_SIZE);
+
+	if (nor_sim_power_loss_hit()) {
+		/* erase interrupted, only the beginning of the sector is cleared */
+		memset(nor_image + offset, 0xff, (uint32_t)rand() % NOR_SIM_SECTOR_SIZE);
+		longjmp(nor_sim_power_env, 1);
+	}
+
+	memset(nor_image + offset, 0xff, NOR_SIM_SECTOR_SIZE);
+
+	nor_erase_cnt[offset / NOR_SIM_SECTOR_SIZE]++;
+	nor_stats.erase_count++;
+	nor_stats.busy_ns += nor_erase_sector_ns;
+}
+
+int flash_read_word(flash_t *obj, uint32_t address, uint32_t *data)
+{
+	(void)obj;
+
+	uint32_t offset = nor_sim_offset(address, 4);
+
+	memcpy(data, nor_image + offset, 4);
+	nor_stats.read_words++;
+
+	return 1;
+}
+
+int flash_write_word(flash_t *obj, uint32_t address, uint32_t data)
+{
+	(void)obj;
+
+	uint32_t offset = nor_sim_offset(address, 4);
+
+	nor_sim_program(offset, 4, (const uint8_t *)&data);
+
+	return 1;
+}
+
+int flash_stream_read(flash_t *obj, uint32_t address, uint32_t len, uint8_t *data)
+{
+	(void)obj;
+
+	uint32_t offset = nor_sim_offset(address, len);
+
+	memcpy(data, nor_image + offset, len);
+	nor_stats.read_words += (len + 3) / 4;
+
+	return 1;
+}
+
+int flash_stream_write(flash_t *obj, uint32_t address, uint32_t len, uint8_t *data)
+{
+	(void)obj;
+
+	uint32_t offset = nor_sim_offset(address, len);
+
+	nor_sim_program(offset, len, data);
+
+	return 1;
+}
+
+int flash_burst_write(flash_t *obj, uint32_t address, uint32_t Length, uint8_t *data)
+{
+	return flash_stream_write(obj, address, Length, data);
+}
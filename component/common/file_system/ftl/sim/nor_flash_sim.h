@@ -0,0 +1,58 @@
+/**
+*****************************************************************************************
+*     Copyright(c) 2017, Realtek Semiconductor Corporation. All rights reserved.
+*****************************************************************************************
+   * @file      nor_flash_sim.h
+   * @brief     NOR flash model used by the host build of the ftl
+   * @details   Backs flash_read_word/flash_write_word/flash_erase_sector with a RAM or
+   *            mmap'd image that behaves like NOR flash: erase sets a sector to 0xFF,
+   *            program can only clear bits. Every sector keeps an erase counter and a
+   *            power loss can be injected after a given number of program/erase ops.
+   **************************************************************************************
+  */
+
+#ifndef _NOR_FLASH_SIM_H_
+#define _NOR_FLASH_SIM_H_
+
+#include <stdint.h>
+#include <setjmp.h>
+
+#define NOR_SIM_SECTOR_SIZE		0x1000
+
+/* default latencies, roughly the numbers of the SPI NOR on AmebaZ2 */
+#define NOR_SIM_PROGRAM_WORD_NS		(30 * 1000)
+#define NOR_SIM_ERASE_SECTOR_NS		(45 * 1000 * 1000)
+
+struct nor_sim_stats {
+	uint64_t read_words;
+	uint64_t program_words;
+	uint64_t program_ops;		/* program commands, a burst counts once */
+	uint64_t erase_count;
+	uint64_t illegal_program;	/* program tried to turn a 0 bit into 1 */
+	uint64_t busy_ns;			/* modeled time the flash was busy */
+};
+
+/* longjmp target used when an injected power loss fires */
+extern jmp_buf nor_sim_power_env;
+
+int nor_sim_init(uint32_t base, uint32_t sector_num, const char *image_path);
+void nor_sim_deinit(void);
+
+void nor_sim_set_latency(uint32_t program_word_ns, uint32_t erase_sector_ns);
+void nor_sim_set_strict(int strict);
+
+void nor_sim_get_stats(struct nor_sim_stats *stats);
+void nor_sim_reset_stats(void);
+uint32_t nor_sim_sector_erase_count(uint32_t sector);
+uint64_t nor_sim_busy_ns(void);
+
+/**
+    * @brief    Arm a power loss after the given number of program/erase operations
+    * @param    op_countdown  0 disarms the injection
+    * @note     The operation that hits zero is torn (a program stops at a random byte, which
+    *           gets only part of its bits, or only part of the sector is erased) and then
+    *           nor_sim_power_env is longjmp'd.
+    */
+void nor_sim_arm_power_loss(uint64_t op_countdown);
+
+#endif // _NOR_FLASH_SIM_H_
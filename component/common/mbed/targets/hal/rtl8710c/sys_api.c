@@ -272,12 +272,23 @@ void sys_disable_fast_boot(void){
 	hal_sys_set_fast_boot(NULL, 0);
 }
 
+/**
+  * @brief  Write back data cached by the ftl before reset.
+  * @param  none
+  * @retval  none
+  * @note  Provided by ftl.c, not linked when the ftl is not built.
+  */
+__weak void ftl_flush_before_reset(void);
+
 /**
   * @brief  system software reset.
   * @retval none
   */
 void sys_reset(void)
 {
+	if (ftl_flush_before_reset) {
+		ftl_flush_before_reset();
+	}
 	sys_disable_fast_boot();
 	hal_misc_rst_by_wdt();
 }
@@ -288,6 +299,9 @@ void sys_reset(void)
   */
 void software_reset(void)
 {
+	if (ftl_flush_before_reset) {
+		ftl_flush_before_reset();
+	}
 	sys_disable_fast_boot();
 	hci_tp_close();  
 	hal_wlan_pwr_off();
@@ -49,10 +49,12 @@ static int _verify_func(void *data, x509_crt *crt, int depth, int *flags)
 #include "mbedtls/platform.h"
 #include "mbedtls/net_sockets.h"
 #include "mbedtls/base64.h"
+#include "ssl_session_store.h"
 
 struct httpc_tls {
 	mbedtls_ssl_context ctx;         /*!< Context for mbedTLS */
 	mbedtls_ssl_config conf;         /*!< Configuration for mbedTLS */
+	int *sock;                       /*!< Socket, for the server port of the session store */
 	mbedtls_x509_crt ca;             /*!< CA certificates */
 	mbedtls_x509_crt cert;           /*!< Certificate */
 	mbedtls_pk_context key;          /*!< Private key */
@@ -246,6 +248,7 @@ exit:
 		}
 
 		mbedtls_ssl_set_bio(ssl, sock, mbedtls_net_send, mbedtls_net_recv, NULL);
+		tls->sock = sock;
 	}
 	else {
 		printf("\n[HTTPC] ERROR: malloc\n");
@@ -308,15 +311,24 @@ int httpc_tls_handshake(void *tls_in, char *host)
 	return ret;
 #elif (HTTPC_USE_TLS == HTTPC_TLS_MBEDTLS)
 	int ret = 0;
+	int port = 0;
+	struct sockaddr_in addr;
+	socklen_t addr_len = sizeof(addr);
 
 	mbedtls_ssl_set_hostname(&tls->ctx, host);
 
+	if(getpeername(*tls->sock, (struct sockaddr *) &addr, &addr_len) == 0)
+		port = ntohs(addr.sin_port);
+
+	ssl_session_store_set(&tls->ctx, host, port);
+
 	if((ret = mbedtls_ssl_handshake(&tls->ctx)) != 0) {
 		printf("\n[HTTPC] ERROR: mbedtls_ssl_handshake %d\n", ret);
 		ret = -1;
 	}
 	else {
 		printf("\n[HTTPC] Use ciphersuite %s\n", mbedtls_ssl_get_ciphersuite(&tls->ctx));
+		ssl_session_store_get(&tls->ctx, host, port);
 	}
 
 	return ret;
@@ -34,14 +34,45 @@ static int _verify_func(void *data, x509_crt *crt, int depth, int *flags)
 #include "mbedtls/platform.h"
 #include "mbedtls/net_sockets.h"
 #include "mbedtls/base64.h"
+#include "mbedtls/ssl_cache.h"
+#include "mbedtls/ssl_ticket.h"
+
+/* Sessions kept for abbreviated handshakes of reconnecting clients, 0 for none.
+ * Without MBEDTLS_HAVE_TIME the oldest session is replaced, none expires. */
+#ifndef HTTPD_TLS_CACHE_SIZE
+#define HTTPD_TLS_CACHE_SIZE     4
+#endif
+#if !defined(MBEDTLS_SSL_CACHE_C) || !defined(MBEDTLS_SSL_SRV_C)
+#undef HTTPD_TLS_CACHE_SIZE
+#define HTTPD_TLS_CACHE_SIZE     0
+#endif
+
+/* Session tickets keep the sessions at the clients, sealed with an AEAD key */
+#ifndef HTTPD_TLS_TICKETS
+#define HTTPD_TLS_TICKETS        1
+#endif
+#if !defined(MBEDTLS_SSL_TICKET_C) || !defined(MBEDTLS_SSL_SESSION_TICKETS) || !defined(MBEDTLS_SSL_SRV_C) || \
+	(!defined(MBEDTLS_GCM_C) && !defined(MBEDTLS_CCM_C))
+#undef HTTPD_TLS_TICKETS
+#define HTTPD_TLS_TICKETS        0
+#endif
 
 struct httpd_tls {
 	mbedtls_ssl_context ctx;         /*!< Context for mbedTLS */
-	mbedtls_ssl_config conf;         /*!< Configuration for mbedTLS */
 };
 
 static mbedtls_x509_crt httpd_certs; /*!< Certificates of server and CA */
 static mbedtls_pk_context httpd_key; /*!< Private key of server */
+static mbedtls_ssl_config httpd_conf[2]; /*!< Configurations shared by connections, without and with client verification */
+#if HTTPD_TLS_CACHE_SIZE || HTTPD_TLS_TICKETS
+static _mutex httpd_session_mutex;   /*!< Lock of the cache and tickets, connections may handshake in parallel */
+#endif
+#if HTTPD_TLS_CACHE_SIZE
+static mbedtls_ssl_cache_context httpd_cache[2]; /*!< Sessions of the clients, one cache per configuration */
+#endif
+#if HTTPD_TLS_TICKETS
+static mbedtls_ssl_ticket_context httpd_ticket[2]; /*!< Key of the session tickets, one per configuration */
+#endif
 
 static int _verify_func(void *data, mbedtls_x509_crt *crt, int depth, uint32_t *flags)
 {
@@ -73,6 +104,55 @@ static void* _calloc_func(size_t nmemb, size_t size)
 
 	return ptr;
 }
+
+#if HTTPD_TLS_CACHE_SIZE
+static int _cache_get(void *data, mbedtls_ssl_session *session)
+{
+	int ret;
+
+	rtw_mutex_get(&httpd_session_mutex);
+	ret = mbedtls_ssl_cache_get(data, session);
+	rtw_mutex_put(&httpd_session_mutex);
+
+	return ret;
+}
+
+static int _cache_set(void *data, const mbedtls_ssl_session *session)
+{
+	int ret;
+
+	rtw_mutex_get(&httpd_session_mutex);
+	ret = mbedtls_ssl_cache_set(data, session);
+	rtw_mutex_put(&httpd_session_mutex);
+
+	return ret;
+}
+#endif
+
+#if HTTPD_TLS_TICKETS
+static int _ticket_write(void *p_ticket, const mbedtls_ssl_session *session,
+	unsigned char *start, const unsigned char *end, size_t *tlen, uint32_t *lifetime)
+{
+	int ret;
+
+	rtw_mutex_get(&httpd_session_mutex);
+	ret = mbedtls_ssl_ticket_write(p_ticket, session, start, end, tlen, lifetime);
+	rtw_mutex_put(&httpd_session_mutex);
+
+	return ret;
+}
+
+static int _ticket_parse(void *p_ticket, mbedtls_ssl_session *session, unsigned char *buf, size_t len)
+{
+	int ret;
+
+	rtw_mutex_get(&httpd_session_mutex);
+	ret = mbedtls_ssl_ticket_parse(p_ticket, session, buf, len);
+	rtw_mutex_put(&httpd_session_mutex);
+
+	return ret;
+}
+#endif
 #endif /* HTTPC_USE_POLARSSL */
 
 static int _random_func(void *p_rng, unsigned char *output, size_t output_len)
@@ -84,6 +164,49 @@ static int _random_func(void *p_rng, unsigned char *output, size_t output_len)
 	return 0;
 }
 
+#if (HTTPD_USE_TLS == HTTPD_TLS_MBEDTLS)
+static int _conf_setup(mbedtls_ssl_config *conf, uint8_t verify)
+{
+	int ret = 0;
+
+	if((ret = mbedtls_ssl_config_defaults(conf,
+			MBEDTLS_SSL_IS_SERVER,
+			MBEDTLS_SSL_TRANSPORT_STREAM,
+			MBEDTLS_SSL_PRESET_DEFAULT)) != 0) {
+
+		printf("\n[HTTPD] ERROR: mbedtls_ssl_config_defaults %d\n", ret);
+		return -1;
+	}
+
+	mbedtls_ssl_conf_authmode(conf, MBEDTLS_SSL_VERIFY_NONE);
+	mbedtls_ssl_conf_rng(conf, _random_func, NULL);
+	mbedtls_ssl_conf_ca_chain(conf, httpd_certs.next, NULL);
+
+	if(verify) {
+		mbedtls_ssl_conf_authmode(conf, MBEDTLS_SSL_VERIFY_REQUIRED);
+		mbedtls_ssl_conf_verify(conf, _verify_func, NULL);
+	}
+
+	if((ret = mbedtls_ssl_conf_own_cert(conf, &httpd_certs, &httpd_key)) != 0) {
+		printf("\n[HTTPD] ERROR: mbedtls_ssl_conf_own_cert %d\n", ret);
+		return -1;
+	}
+
+#if HTTPD_TLS_CACHE_SIZE
+	// a session made without client verification must not resume with verification,
+	// mbedtls does not verify the client again on resumption
+	mbedtls_ssl_conf_session_cache(conf, &httpd_cache[verify ? 1 : 0], _cache_get, _cache_set);
+#endif
+#if HTTPD_TLS_TICKETS
+	mbedtls_ssl_conf_session_tickets_cb(conf, _ticket_write, _ticket_parse, &httpd_ticket[verify ? 1 : 0]);
+#endif
+
+	return 0;
+}
+#endif
+
+void httpd_tls_setup_free(void);
+
 int httpd_tls_setup_init(const char *server_cert, const char *server_key, const char *ca_certs)
 {
 #if (HTTPD_USE_TLS == HTTPD_TLS_POLARSSL)
@@ -124,6 +247,9 @@ exit:
 	return ret;
 #elif (HTTPD_USE_TLS == HTTPD_TLS_MBEDTLS)
 	int ret = 0;
+#if HTTPD_TLS_TICKETS
+	int i;
+#endif
 
 	mbedtls_platform_set_calloc_free(_calloc_func, vPortFree);
 	memset(&httpd_certs, 0, sizeof(mbedtls_x509_crt));
@@ -151,11 +277,42 @@ exit:
 		goto exit;
 	}
 
-exit:
-	if(ret) {
-		mbedtls_x509_crt_free(&httpd_certs);
-		mbedtls_pk_free(&httpd_key);
+	// the configurations are built once and only read by the connections
+#if HTTPD_TLS_CACHE_SIZE || HTTPD_TLS_TICKETS
+	rtw_mutex_init(&httpd_session_mutex);
+#endif
+#if HTTPD_TLS_CACHE_SIZE
+	mbedtls_ssl_cache_init(&httpd_cache[0]);
+	mbedtls_ssl_cache_init(&httpd_cache[1]);
+	mbedtls_ssl_cache_set_max_entries(&httpd_cache[0], HTTPD_TLS_CACHE_SIZE);
+	mbedtls_ssl_cache_set_max_entries(&httpd_cache[1], HTTPD_TLS_CACHE_SIZE);
+#endif
+#if HTTPD_TLS_TICKETS
+	mbedtls_ssl_ticket_init(&httpd_ticket[0]);
+	mbedtls_ssl_ticket_init(&httpd_ticket[1]);
+	for(i = 0; i < 2; i ++) {
+#if defined(MBEDTLS_GCM_C)
+		if((ret = mbedtls_ssl_ticket_setup(&httpd_ticket[i], _random_func, NULL, MBEDTLS_CIPHER_AES_128_GCM, MBEDTLS_SSL_DEFAULT_TICKET_LIFETIME)) != 0) {
+#else
+		if((ret = mbedtls_ssl_ticket_setup(&httpd_ticket[i], _random_func, NULL, MBEDTLS_CIPHER_AES_128_CCM, MBEDTLS_SSL_DEFAULT_TICKET_LIFETIME)) != 0) {
+#endif
+			printf("\n[HTTPD] ERROR: mbedtls_ssl_ticket_setup %d\n", ret);
+			ret = -1;
+			goto exit;
+		}
 	}
+#endif
+	mbedtls_ssl_config_init(&httpd_conf[0]);
+	mbedtls_ssl_config_init(&httpd_conf[1]);
+
+	if((_conf_setup(&httpd_conf[0], 0) != 0) || (_conf_setup(&httpd_conf[1], 1) != 0)) {
+		ret = -1;
+		goto exit;
+	}
+
+exit:
+	if(ret)
+		httpd_tls_setup_free();
 
 	return ret;
 #endif
@@ -167,6 +324,19 @@ void httpd_tls_setup_free(void)
 	x509_crt_free(&httpd_certs);
 	pk_free(&httpd_key);
 #elif (HTTPD_USE_TLS == HTTPD_TLS_MBEDTLS)
+	mbedtls_ssl_config_free(&httpd_conf[0]);
+	mbedtls_ssl_config_free(&httpd_conf[1]);
+#if HTTPD_TLS_CACHE_SIZE
+	mbedtls_ssl_cache_free(&httpd_cache[0]);
+	mbedtls_ssl_cache_free(&httpd_cache[1]);
+#endif
+#if HTTPD_TLS_TICKETS
+	mbedtls_ssl_ticket_free(&httpd_ticket[0]);
+	mbedtls_ssl_ticket_free(&httpd_ticket[1]);
+#endif
+#if HTTPD_TLS_CACHE_SIZE || HTTPD_TLS_TICKETS
+	rtw_mutex_free(&httpd_session_mutex);
+#endif
 	mbedtls_x509_crt_free(&httpd_certs);
 	mbedtls_pk_free(&httpd_key);
 #endif
@@ -235,40 +405,13 @@ exit:
 	int ret = 0;
 	struct httpd_tls *tls = NULL;
 	mbedtls_ssl_context *ssl;
-	mbedtls_ssl_config *conf;
+	mbedtls_ssl_config *conf = &httpd_conf[(secure == HTTPD_SECURE_TLS_VERIFY) ? 1 : 0];
 
 	if((tls = (struct httpd_tls *) malloc(sizeof(struct httpd_tls))) != NULL) {
 		memset(tls, 0, sizeof(struct httpd_tls));
 		ssl = &tls->ctx;
-		conf = &tls->conf;
 
 		mbedtls_ssl_init(ssl);
-		mbedtls_ssl_config_init(conf);
-
-		if((ret = mbedtls_ssl_config_defaults(conf,
-				MBEDTLS_SSL_IS_SERVER,
-				MBEDTLS_SSL_TRANSPORT_STREAM,
-				MBEDTLS_SSL_PRESET_DEFAULT)) != 0) {
-
-			printf("\n[HTTPD] ERROR: mbedtls_ssl_config_defaults %d\n", ret);
-			ret = -1;
-			goto exit;
-		}
-
-		mbedtls_ssl_conf_authmode(conf, MBEDTLS_SSL_VERIFY_NONE);
-		mbedtls_ssl_conf_rng(conf, _random_func, NULL);
-		mbedtls_ssl_conf_ca_chain(conf, httpd_certs.next, NULL);
-
-		if(secure == HTTPD_SECURE_TLS_VERIFY) {
-			mbedtls_ssl_conf_authmode(conf, MBEDTLS_SSL_VERIFY_REQUIRED);
-			mbedtls_ssl_conf_verify(conf, _verify_func, NULL);
-		}
-
-		if((ret = mbedtls_ssl_conf_own_cert(conf, &httpd_certs, &httpd_key)) != 0) {
-			printf("\n[HTTPD] ERROR: mbedtls_ssl_conf_own_cert %d\n", ret);
-			ret = -1;
-			goto exit;
-		}
 
 		if((ret = mbedtls_ssl_setup(ssl, conf)) != 0) {
 			printf("\n[HTTPD] ERROR: mbedtls_ssl_setup %d\n", ret);
@@ -298,7 +441,6 @@ exit:
 	if(ret && tls) {
 		mbedtls_ssl_close_notify(ssl);
 		mbedtls_ssl_free(ssl);
-		mbedtls_ssl_config_free(conf);
 		free(tls);
 		tls = NULL;
 	}
@@ -316,7 +458,6 @@ void httpd_tls_free(void *tls_in)
 	free(tls);
 #elif (HTTPD_USE_TLS == HTTPD_TLS_MBEDTLS)
 	mbedtls_ssl_free(&tls->ctx);
-	mbedtls_ssl_config_free(&tls->conf);
 	free(tls);
 #endif
 }
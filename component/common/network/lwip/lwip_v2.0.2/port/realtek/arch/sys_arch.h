@@ -63,5 +63,28 @@ typedef struct _sys_arch_state_t
 
 /* Message queue constants. */
 #define archMESG_QUEUE_LENGTH	( 6 )
+
+#if ETHERNETIF_RX_BATCH
+struct pbuf;
+struct netif;
+
+#define TCPIP_INPUT_BATCH_HIST	5
+
+struct tcpip_input_batch_stats {
+	u32_t wakeups;		// TCP_IP thread passes over the queue, one mbox message each
+	u32_t frames;		// frames passed to the stack
+	u32_t max_frames;	// most frames of one pass
+	u32_t drops;		// queue full, or the mbox full for a new pass
+	u32_t hist[TCPIP_INPUT_BATCH_HIST];	// passes of 1, 2-3, 4-7, 8-15 and 16+ frames
+};
+
+/* netif input function to pass to netif_add() in place of tcpip_input() */
+err_t tcpip_input_batched(struct pbuf *p, struct netif *inp);
+/* Queue count frames with at most one mbox message, returns how many were
+   taken, they may still be dropped when the mbox is full. The caller keeps
+   and frees the others p[ret..count-1]. */
+int tcpip_input_batch(struct pbuf **p, int count, struct netif *inp);
+void tcpip_input_batch_get_stats(struct tcpip_input_batch_stats *stats);
+#endif
 #endif /* __SYS_RTXC_H__ */
 
@@ -0,0 +1,254 @@
+/*
+ * Port checksum routines, selected by LWIP_PORT_CHKSUM in lwipopts.h
+ *
+ * lwip_port_chksum() replaces lwip_standard_chksum() as LWIP_CHKSUM and
+ * lwip_port_chksum_copy() replaces lwip_chksum_copy() as LWIP_CHKSUM_COPY,
+ * so that tcp_write() sums the data while it copies it into the segment
+ * instead of reading it again in tcp_output().
+ *
+ * Both sum 32-bit words, so they return the same host order (!) partial
+ * sum as LWIP_CHKSUM_ALGORITHM 2 and 3, for any alignment and length.
+ * Cortex-M33 (and M3/M4) builds with GCC sum 32 bytes per iteration with
+ * an adds/adcs carry chain, 64-bit hosts sum 64-bit words, other targets
+ * sum 32-bit words into a 64-bit accumulator.
+ *
+ * port/realtek/host has a micro-benchmark against the lwIP algorithms.
+ */
+#include <string.h>
+
+#include "lwip/opt.h"
+#include "lwip/def.h"
+#include "lwip/inet_chksum.h"
+
+/* Folds a 64-bit sum of 16-bit words to at most 18 bits */
+static u32_t chksum_fold64(unsigned long long acc)
+{
+	acc = (acc >> 32) + (acc & 0xffffffffULL);
+	acc = (acc >> 16) + (acc & 0xffffULL);
+	return (u32_t)acc;
+}
+
+#if defined(__GNUC__) && (defined(__ARM_ARCH_8M_MAIN__) || defined(__ARM_ARCH_7EM__) || defined(__ARM_ARCH_7M__))
+/* Sums len bytes at the 4 byte aligned pb, len is a multiple of 4 */
+static u32_t chksum_words(const u8_t *pb, int len)
+{
+	u32_t sum = 0, a, b, c, d;
+
+	while (len >= 32) {
+		/* ldrd does not touch the flags, so one carry chain covers 8 words */
+		__asm__ volatile (
+			"ldrd %[a], %[b], [%[p]], #8\n\t"
+			"ldrd %[c], %[d], [%[p]], #8\n\t"
+			"adds %[s], %[s], %[a]\n\t"
+			"adcs %[s], %[s], %[b]\n\t"
+			"adcs %[s], %[s], %[c]\n\t"
+			"adcs %[s], %[s], %[d]\n\t"
+			"ldrd %[a], %[b], [%[p]], #8\n\t"
+			"ldrd %[c], %[d], [%[p]], #8\n\t"
+			"adcs %[s], %[s], %[a]\n\t"
+			"adcs %[s], %[s], %[b]\n\t"
+			"adcs %[s], %[s], %[c]\n\t"
+			"adcs %[s], %[s], %[d]\n\t"
+			"adc %[s], %[s], #0\n\t"
+			: [s] "+r" (sum), [p] "+r" (pb), [a] "=&r" (a), [b] "=&r" (b), [c] "=&r" (c), [d] "=&r" (d)
+			:
+			: "cc", "memory");
+		len -= 32;
+	}
+
+	while (len >= 4) {
+		a = *(const u32_t *)(const void *)pb;
+		sum += a;
+		sum += (sum < a);
+		pb += 4;
+		len -= 4;
+	}
+
+	return FOLD_U32T(sum);
+}
+#elif defined(__LP64__) || defined(_WIN64)
+/* Sums len bytes at the 4 byte aligned pb, len is a multiple of 4 */
+static u32_t chksum_words(const u8_t *pb, int len)
+{
+	const unsigned long long *pq;
+	unsigned long long acc = 0, carry = 0, w;
+
+	if (((mem_ptr_t)pb & 4) && (len >= 4)) {
+		acc = *(const u32_t *)(const void *)pb;
+		pb += 4;
+		len -= 4;
+	}
+
+	/* the carries out of bit 63 are counted and added back at the end */
+	pq = (const unsigned long long *)(const void *)pb;
+	while (len >= 32) {
+		w = pq[0]; acc += w; carry += (acc < w);
+		w = pq[1]; acc += w; carry += (acc < w);
+		w = pq[2]; acc += w; carry += (acc < w);
+		w = pq[3]; acc += w; carry += (acc < w);
+		pq += 4;
+		len -= 32;
+	}
+	while (len >= 8) {
+		w = *pq++; acc += w; carry += (acc < w);
+		len -= 8;
+	}
+	if (len >= 4) {
+		w = *(const u32_t *)(const void *)pq; acc += w; carry += (acc < w);
+	}
+
+	return chksum_fold64((acc >> 32) + (acc & 0xffffffffULL) + carry);
+}
+#else
+/* Sums len bytes at the 4 byte aligned pb, len is a multiple of 4 */
+static u32_t chksum_words(const u8_t *pb, int len)
+{
+	const u32_t *pl = (const u32_t *)(const void *)pb;
+	unsigned long long acc = 0;
+
+	while (len >= 16) {
+		acc += pl[0];
+		acc += pl[1];
+		acc += pl[2];
+		acc += pl[3];
+		pl += 4;
+		len -= 16;
+	}
+	while (len >= 4) {
+		acc += *pl++;
+		len -= 4;
+	}
+
+	return chksum_fold64(acc);
+}
+#endif
+
+/**
+ * @param dataptr points to start of data to be summed at any boundary
+ * @param len length of data to be summed
+ * @return host order (!) lwip checksum (non-inverted Internet sum)
+ */
+u16_t lwip_port_chksum(const void *dataptr, int len)
+{
+	const u8_t *pb = (const u8_t *)dataptr;
+	u16_t t = 0;
+	u32_t sum = 0;
+	int odd = ((mem_ptr_t)pb & 1);
+
+	/* Get aligned to u16_t, the sum is swapped back at the end */
+	if (odd && (len > 0)) {
+		((u8_t *)&t)[1] = *pb++;
+		len--;
+	}
+
+	/* Get aligned to u32_t */
+	if (((mem_ptr_t)pb & 2) && (len > 1)) {
+		sum += *(const u16_t *)(const void *)pb;
+		pb += 2;
+		len -= 2;
+	}
+
+	if (len >= 4) {
+		sum += chksum_words(pb, len & ~3);
+		pb += len & ~3;
+		len &= 3;
+	}
+
+	if (len > 1) {
+		sum += *(const u16_t *)(const void *)pb;
+		pb += 2;
+		len -= 2;
+	}
+
+	/* Consume left-over byte, if any */
+	if (len > 0)
+		((u8_t *)&t)[0] = *pb;
+
+	sum += t;
+	sum = FOLD_U32T(sum);
+	sum = FOLD_U32T(sum);
+
+	if (odd)
+		sum = SWAP_BYTES_IN_WORD(sum);
+
+	return (u16_t)sum;
+}
+
+/**
+ * Copies len bytes from src to dst and returns the checksum of them, as
+ * lwip_chksum_copy() does, in a single pass. The stores are aligned to dst,
+ * src may have any alignment.
+ */
+u16_t lwip_port_chksum_copy(void *dst, const void *src, u16_t len)
+{
+	u8_t *pd = (u8_t *)dst;
+	const u8_t *ps = (const u8_t *)src;
+	unsigned long long acc = 0;
+	u32_t sum = 0, w0, w1, w2, w3;
+	u16_t t = 0, h;
+	int n = len;
+	int odd = ((mem_ptr_t)pd & 1);
+
+	if (odd && (n > 0)) {
+		((u8_t *)&t)[1] = *pd++ = *ps++;
+		n--;
+	}
+
+	if (((mem_ptr_t)pd & 2) && (n > 1)) {
+		memcpy(&h, ps, 2);
+		*(u16_t *)(void *)pd = h;
+		sum += h;
+		pd += 2;
+		ps += 2;
+		n -= 2;
+	}
+
+	/* memcpy of a word compiles to a single (unaligned) load */
+	while (n >= 16) {
+		memcpy(&w0, ps, 4);
+		memcpy(&w1, ps + 4, 4);
+		memcpy(&w2, ps + 8, 4);
+		memcpy(&w3, ps + 12, 4);
+		((u32_t *)(void *)pd)[0] = w0;
+		((u32_t *)(void *)pd)[1] = w1;
+		((u32_t *)(void *)pd)[2] = w2;
+		((u32_t *)(void *)pd)[3] = w3;
+		acc += w0;
+		acc += w1;
+		acc += w2;
+		acc += w3;
+		pd += 16;
+		ps += 16;
+		n -= 16;
+	}
+	while (n >= 4) {
+		memcpy(&w0, ps, 4);
+		*(u32_t *)(void *)pd = w0;
+		acc += w0;
+		pd += 4;
+		ps += 4;
+		n -= 4;
+	}
+	sum += chksum_fold64(acc);
+
+	if (n > 1) {
+		memcpy(&h, ps, 2);
+		*(u16_t *)(void *)pd = h;
+		sum += h;
+		pd += 2;
+		ps += 2;
+		n -= 2;
+	}
+
+	if (n > 0)
+		((u8_t *)&t)[0] = *pd = *ps;
+
+	sum += t;
+	sum = FOLD_U32T(sum);
+	sum = FOLD_U32T(sum);
+
+	if (odd)
+		sum = SWAP_BYTES_IN_WORD(sum);
+
+	return (u16_t)sum;
+}
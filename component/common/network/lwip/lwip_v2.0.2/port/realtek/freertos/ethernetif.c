@@ -47,6 +47,8 @@
 #include "lwip/def.h"
 #include "lwip/mem.h"
 #include "lwip/pbuf.h"
+#include "lwip/memp.h"
+#include "lwip/stats.h"
 #include "lwip/sys.h"
 #include "lwip/tcpip.h"
 #include "lwip/icmp.h"
@@ -157,9 +159,14 @@ static err_t low_level_output(struct netif *netif, struct pbuf *p)
 #else
                 if(1)
 #endif
+		{
+			NETSTATS_INC(tx_frames);
 			return ERR_OK;
-		else
+		}
+		else {
+			NETSTATS_INC(tx_errors);
 			return ERR_BUF;	// return a non-fatal error
+		}
 	}
 	return ERR_OK;
 }
@@ -175,10 +182,14 @@ static err_t low_level_output_mii(struct netif *netif, struct pbuf *p)
 		sg_list[sg_len++].len = q->len;
 	}
 	if (sg_len) {
-		 if(rltk_mii_send(sg_list, sg_len, p->tot_len) == 0)
+		 if(rltk_mii_send(sg_list, sg_len, p->tot_len) == 0) {
+			NETSTATS_INC(tx_frames);
 			return ERR_OK;
-		else
+		}
+		else {
+			NETSTATS_INC(tx_errors);
 			return ERR_BUF;	// return a non-fatal error
+		}
 	}
 	return ERR_OK;
 }
@@ -207,6 +218,48 @@ static err_t low_level_output_mii(struct netif *netif, struct pbuf *p)
 //void ethernetif_input( void * pvParameters )
 
 
+#if CONFIG_WLAN && ETHERNETIF_RX_ZERO_COPY
+/* Rx pbuf referencing the data of a wlan rx skb */
+struct ethernetif_rx_pbuf {
+	struct pbuf_custom p;
+	struct sk_buff *skb;
+};
+
+LWIP_MEMPOOL_DECLARE(RX_PBUF, ETHERNETIF_RX_ZERO_COPY_NUM, sizeof(struct ethernetif_rx_pbuf), "ethernetif rx pbuf");
+
+/* Called by pbuf_free() from any task when lwIP is done with the frame */
+static void ethernetif_rx_pbuf_free(struct pbuf *p)
+{
+	struct ethernetif_rx_pbuf *rx_pbuf = (struct ethernetif_rx_pbuf *) p;
+
+	rltk_wlan_free_skb(rx_pbuf->skb);
+	LWIP_MEMPOOL_FREE(RX_PBUF, rx_pbuf);
+}
+
+/* Wrap the pending rx skb in a pbuf, NULL if all rx pbufs are in use */
+static struct pbuf *ethernetif_recv_skb(struct netif *netif, int total_len)
+{
+	struct ethernetif_rx_pbuf *rx_pbuf;
+	struct sk_buff *skb;
+
+	rx_pbuf = (struct ethernetif_rx_pbuf *) LWIP_MEMPOOL_ALLOC(RX_PBUF);
+	if (rx_pbuf == NULL)
+		return NULL;
+
+	skb = rltk_wlan_recv_skb(netif_get_idx(netif));
+	if ((skb == NULL) || (skb->len < (unsigned int) total_len)) {
+		if (skb)
+			rltk_wlan_free_skb(skb);
+		LWIP_MEMPOOL_FREE(RX_PBUF, rx_pbuf);
+		return NULL;
+	}
+
+	rx_pbuf->skb = skb;
+	rx_pbuf->p.custom_free_function = ethernetif_rx_pbuf_free;
+	return pbuf_alloced_custom(PBUF_RAW, total_len, PBUF_REF, &rx_pbuf->p, skb->data, total_len);
+}
+#endif
+
 /* Refer to eCos eth_drv_recv to do similarly in ethernetif_input */
 void ethernetif_recv(struct netif *netif, int total_len)
 {
@@ -220,10 +273,25 @@ void ethernetif_recv(struct netif *netif, int total_len)
 	if ((total_len > MAX_ETH_MSG) || (total_len < 0))
 		total_len = MAX_ETH_MSG;
 
+#if CONFIG_WLAN && ETHERNETIF_RX_ZERO_COPY
+	// Pass the rx skb itself, it is copied below when all rx pbufs are held by lwIP
+	p = ethernetif_recv_skb(netif, total_len);
+	if (p != NULL) {
+		if (ERR_OK != netif->input(p, netif)) {
+			pbuf_free(p);
+			NETSTATS_INC_PROTECTED(rx_drops);
+		} else {
+			NETSTATS_INC_PROTECTED(rx_frames);
+		}
+		return;
+	}
+#endif
+
 	// Allocate buffer to store received packet
 	p = pbuf_alloc(PBUF_RAW, total_len, PBUF_POOL);
 	if (p == NULL) {
 		printf("\n\rCannot allocate pbuf to receive packet");
+		NETSTATS_INC_PROTECTED(rx_drops);
 		return;
 	}
 
@@ -241,8 +309,12 @@ void ethernetif_recv(struct netif *netif, int total_len)
 	rltk_inic_recv(sg_list, sg_len);
 #endif
 	// Pass received packet to the interface
-	if (ERR_OK != netif->input(p, netif))
+	if (ERR_OK != netif->input(p, netif)) {
 		pbuf_free(p);
+		NETSTATS_INC_PROTECTED(rx_drops);
+	} else {
+		NETSTATS_INC_PROTECTED(rx_frames);
+	}
 
 }
 
@@ -259,6 +331,7 @@ void ethernetif_mii_recv(struct netif *netif, int total_len)
 	p = pbuf_alloc(PBUF_RAW, total_len, PBUF_POOL);
 	if (p == NULL) {
 		printf("\n\rCannot allocate pbuf to receive packet");
+		NETSTATS_INC_PROTECTED(rx_drops);
 		return;
 	}
 
@@ -270,8 +343,12 @@ void ethernetif_mii_recv(struct netif *netif, int total_len)
 	rltk_mii_recv(sg_list, sg_len);
 
 	// Pass received packet to the interface
-	if (ERR_OK != netif->input(p, netif))
+	if (ERR_OK != netif->input(p, netif)) {
 		pbuf_free(p);
+		NETSTATS_INC_PROTECTED(rx_drops);
+	} else {
+		NETSTATS_INC_PROTECTED(rx_frames);
+	}
 
 }
 /**
@@ -288,6 +365,9 @@ void ethernetif_mii_recv(struct netif *netif, int total_len)
  */
 err_t ethernetif_init(struct netif *netif)
 {
+#if CONFIG_WLAN && ETHERNETIF_RX_ZERO_COPY
+	static int rx_pbuf_inited = 0;
+#endif
 	LWIP_ASSERT("netif != NULL", (netif != NULL));
 
 #if LWIP_NETIF_HOSTNAME
@@ -309,6 +389,14 @@ err_t ethernetif_init(struct netif *netif)
 
 	etharp_init();
 
+#if CONFIG_WLAN && ETHERNETIF_RX_ZERO_COPY
+	/* shared by the wlan interfaces, the pbufs may still be held by lwIP when a netif is added again */
+	if (!rx_pbuf_inited) {
+		LWIP_MEMPOOL_INIT(RX_PBUF);
+		rx_pbuf_inited = 1;
+	}
+#endif
+
 	return ERR_OK;
 }
 
@@ -40,6 +40,11 @@
 #include "task.h"
 #include "queue.h"
 #include "lwip/timeouts.h"
+#if ETHERNETIF_RX_BATCH
+#include "lwip/tcpip.h"
+#include "lwip/ip.h"
+#include "netif/ethernet.h"
+#endif
 #include "autoconf.h"
 #if defined(CONFIG_USE_TCM_HEAP) && CONFIG_USE_TCM_HEAP
 #include "tcm_heap.h"
@@ -130,7 +135,7 @@ err_t result;
 #if SYS_STATS
       lwip_stats.sys.mbox.err++;
 #endif /* SYS_STATS */
-			
+      NETSTATS_INC_PROTECTED(mbox_full);
    }
 
    return result;
@@ -390,7 +395,9 @@ struct timeoutlist *tl;
 /*-----------------------------------------------------------------------------------*/
 /*-----------------------------------------------------------------------------------*/
 #if LWIP_COMPAT_MUTEX == 0
-/* Create a new mutex*/
+/* Create a new mutex, FreeRTOS mutexes inherit the priority of the tasks
+   waiting for them, so a low priority task holding the core lock
+   (LWIP_TCPIP_CORE_LOCKING) does not stall the TCP_IP thread */
 err_t sys_mutex_new(sys_mutex_t *mutex) {
 
   *mutex = xSemaphoreCreateMutex();
@@ -424,7 +431,7 @@ void sys_mutex_free(sys_mutex_t *mutex)
 /* Lock a mutex*/
 void sys_mutex_lock(sys_mutex_t *mutex)
 {
-	sys_arch_sem_wait(*mutex, 0);
+	while (xSemaphoreTake(*mutex, portMAX_DELAY) != pdTRUE);
 }
 
 /*-----------------------------------------------------------------------------------*/
@@ -433,6 +440,18 @@ void sys_mutex_unlock(sys_mutex_t *mutex)
 {
 	xSemaphoreGive(*mutex);
 }
+
+/*-----------------------------------------------------------------------------------*/
+int sys_mutex_valid(sys_mutex_t *mutex)
+{
+	return (*mutex != NULL);
+}
+
+/*-----------------------------------------------------------------------------------*/
+void sys_mutex_set_invalid(sys_mutex_t *mutex)
+{
+	*mutex = NULL;
+}
 #endif /*LWIP_COMPAT_MUTEX*/
 
 /*-----------------------------------------------------------------------------------*/
@@ -632,3 +651,178 @@ u32_t sys_jiffies(void)
 {
 	return xTaskGetTickCount();
 }
+
+#if ETHERNETIF_RX_BATCH
+/*
+ * Batched frame delivery to the TCP_IP thread. The rx task of the driver
+ * queues the frames and posts one static callback message for the queue. The
+ * TCP_IP thread then takes all frames queued until it gets to them, so a burst
+ * of frames costs one mbox message and one wakeup instead of one per frame.
+ * The message is posted again only when the thread has emptied the queue.
+ */
+static struct {
+	struct pbuf *p[ETHERNETIF_RX_BATCH_SIZE];
+	struct netif *inp[ETHERNETIF_RX_BATCH_SIZE];
+	u16_t head;
+	u16_t count;
+	u8_t posted;		// the callback message is in the mbox or running
+	struct tcpip_callback_msg *msg;
+	struct tcpip_input_batch_stats stats;
+} tcpip_batch;
+
+static err_t tcpip_batch_input(struct pbuf *p, struct netif *inp)
+{
+#if LWIP_ETHERNET
+	if (inp->flags & (NETIF_FLAG_ETHARP | NETIF_FLAG_ETHERNET))
+		return ethernet_input(p, inp);
+#endif
+	return ip_input(p, inp);
+}
+
+static void tcpip_batch_account(u32_t frames)
+{
+	int hist;
+	SYS_ARCH_DECL_PROTECT(lev);
+
+	for (hist = 0; (hist < TCPIP_INPUT_BATCH_HIST - 1) && (frames >> (hist + 1)); hist++)
+		;
+	SYS_ARCH_PROTECT(lev);
+	tcpip_batch.stats.wakeups++;
+	tcpip_batch.stats.frames += frames;
+	if (frames > tcpip_batch.stats.max_frames)
+		tcpip_batch.stats.max_frames = frames;
+	tcpip_batch.stats.hist[hist]++;
+	SYS_ARCH_UNPROTECT(lev);
+}
+
+#if !LWIP_TCPIP_CORE_LOCKING_INPUT
+/* Runs in the TCP_IP thread */
+static void tcpip_batch_thread(void *ctx)
+{
+	struct pbuf *p;
+	struct netif *inp;
+	u32_t frames = 0;
+	SYS_ARCH_DECL_PROTECT(lev);
+	( void ) ctx;
+
+	for (;;) {
+		SYS_ARCH_PROTECT(lev);
+		if (tcpip_batch.count == 0) {
+			tcpip_batch.posted = 0;
+			SYS_ARCH_UNPROTECT(lev);
+			break;
+		}
+		SYS_ARCH_UNPROTECT(lev);
+		/* give the other messages a turn after each queue full of frames, the
+		   queue stays posted. Only the TCP_IP thread takes frames out. */
+		if (frames && ((frames % ETHERNETIF_RX_BATCH_SIZE) == 0) && (tcpip_trycallback(tcpip_batch.msg) == ERR_OK))
+			break;
+
+		SYS_ARCH_PROTECT(lev);
+		p = tcpip_batch.p[tcpip_batch.head];
+		inp = tcpip_batch.inp[tcpip_batch.head];
+		tcpip_batch.head = (tcpip_batch.head + 1) % ETHERNETIF_RX_BATCH_SIZE;
+		tcpip_batch.count--;
+		SYS_ARCH_UNPROTECT(lev);
+
+		if (tcpip_batch_input(p, inp) != ERR_OK)
+			pbuf_free(p);
+		frames++;
+	}
+
+	if (frames)
+		tcpip_batch_account(frames);
+}
+#endif
+
+int tcpip_input_batch(struct pbuf **p, int count, struct netif *inp)
+{
+#if LWIP_TCPIP_CORE_LOCKING_INPUT
+	int i;
+
+	if (count <= 0)
+		return 0;
+	LOCK_TCPIP_CORE();
+	for (i = 0; i < count; i++) {
+		if (tcpip_batch_input(p[i], inp) != ERR_OK)
+			pbuf_free(p[i]);
+	}
+	UNLOCK_TCPIP_CORE();
+	tcpip_batch_account(count);
+	return count;
+#else
+	struct tcpip_callback_msg *msg;
+	struct pbuf *drop[ETHERNETIF_RX_BATCH_SIZE];
+	int i, queued, ndrop, post = 0;
+	SYS_ARCH_DECL_PROTECT(lev);
+
+	if (count <= 0)
+		return 0;
+
+	if (tcpip_batch.msg == NULL) {
+		msg = tcpip_callbackmsg_new(tcpip_batch_thread, NULL);
+		if (msg == NULL)
+			return 0;
+		SYS_ARCH_PROTECT(lev);
+		if (tcpip_batch.msg == NULL) {
+			tcpip_batch.msg = msg;
+			msg = NULL;
+		}
+		SYS_ARCH_UNPROTECT(lev);
+		if (msg)
+			tcpip_callbackmsg_delete(msg);
+	}
+
+	SYS_ARCH_PROTECT(lev);
+	for (queued = 0; (queued < count) && (tcpip_batch.count < ETHERNETIF_RX_BATCH_SIZE); queued++) {
+		i = (tcpip_batch.head + tcpip_batch.count) % ETHERNETIF_RX_BATCH_SIZE;
+		tcpip_batch.p[i] = p[queued];
+		tcpip_batch.inp[i] = inp;
+		tcpip_batch.count++;
+	}
+	tcpip_batch.stats.drops += count - queued;
+	if (queued && !tcpip_batch.posted) {
+		tcpip_batch.posted = 1;
+		post = 1;
+	}
+	SYS_ARCH_UNPROTECT(lev);
+
+	if (post && (tcpip_trycallback(tcpip_batch.msg) != ERR_OK)) {
+		/* mbox full: drop the queue like tcpip_input() drops the frame. It
+		   may hold frames of other callers since the queue was marked posted. */
+		SYS_ARCH_PROTECT(lev);
+		tcpip_batch.posted = 0;
+		ndrop = tcpip_batch.count;
+		for (i = 0; i < ndrop; i++)
+			drop[i] = tcpip_batch.p[(tcpip_batch.head + i) % ETHERNETIF_RX_BATCH_SIZE];
+		tcpip_batch.head = 0;
+		tcpip_batch.count = 0;
+		tcpip_batch.stats.drops += ndrop;
+#if LWIP_NETSTATS
+		/* the netif counted them in rx_frames when they were queued */
+		lwip_netstats.rx_frames -= ndrop;
+		lwip_netstats.rx_drops += ndrop;
+#endif
+		SYS_ARCH_UNPROTECT(lev);
+		for (i = 0; i < ndrop; i++)
+			pbuf_free(drop[i]);
+	}
+
+	return queued;
+#endif
+}
+
+err_t tcpip_input_batched(struct pbuf *p, struct netif *inp)
+{
+	return (tcpip_input_batch(&p, 1, inp) == 1) ? ERR_OK : ERR_MEM;
+}
+
+void tcpip_input_batch_get_stats(struct tcpip_input_batch_stats *stats)
+{
+	SYS_ARCH_DECL_PROTECT(lev);
+
+	SYS_ARCH_PROTECT(lev);
+	*stats = tcpip_batch.stats;
+	SYS_ARCH_UNPROTECT(lev);
+}
+#endif
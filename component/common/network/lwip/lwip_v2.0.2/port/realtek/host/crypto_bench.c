@@ -0,0 +1,327 @@
+/*
+ * TLS record cipher micro-benchmark, see README
+ *
+ * Checks the crypto engine path of gcm.c (SUPPORT_HW_SSL_AES_GCM) against a
+ * NIST vector and the software GCM for all key sizes and lengths up to a
+ * record, with the engine emulated by the software AES through
+ * rom_ssl_ram_map. Then times the record protection of the AES-GCM and the
+ * AES-CBC + HMAC ciphersuites in software and counts the engine calls a
+ * record takes on the target.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "mbedtls/config.h"
+#include "mbedtls/aes.h"
+#include "mbedtls/gcm.h"
+#include "mbedtls/md.h"
+
+#define BENCH_MAX_LEN		16384
+#define BENCH_BYTES			(16 * 1024 * 1024)	// per measurement
+#define BENCH_AAD_LEN		13					// TLS sequence number and record header
+
+static unsigned char src_buf[BENCH_MAX_LEN + 64], dst_buf[BENCH_MAX_LEN + 64], chk_buf[BENCH_MAX_LEN + 64];
+static unsigned char bench_key[32], bench_iv[16], bench_aad[BENCH_AAD_LEN];
+
+/* NIST GCM test case 4 (gcm.c self test 3) */
+static const unsigned char nist_key[16] = {
+	0xfe, 0xff, 0xe9, 0x92, 0x86, 0x65, 0x73, 0x1c, 0x6d, 0x6a, 0x8f, 0x94, 0x67, 0x30, 0x83, 0x08
+};
+static const unsigned char nist_iv[12] = {
+	0xca, 0xfe, 0xba, 0xbe, 0xfa, 0xce, 0xdb, 0xad, 0xde, 0xca, 0xf8, 0x88
+};
+static const unsigned char nist_aad[20] = {
+	0xfe, 0xed, 0xfa, 0xce, 0xde, 0xad, 0xbe, 0xef, 0xfe, 0xed, 0xfa, 0xce, 0xde, 0xad, 0xbe, 0xef,
+	0xab, 0xad, 0xda, 0xd2
+};
+static const unsigned char nist_pt[60] = {
+	0xd9, 0x31, 0x32, 0x25, 0xf8, 0x84, 0x06, 0xe5, 0xa5, 0x59, 0x09, 0xc5, 0xaf, 0xf5, 0x26, 0x9a,
+	0x86, 0xa7, 0xa9, 0x53, 0x15, 0x34, 0xf7, 0xda, 0x2e, 0x4c, 0x30, 0x3d, 0x8a, 0x31, 0x8a, 0x72,
+	0x1c, 0x3c, 0x0c, 0x95, 0x95, 0x68, 0x09, 0x53, 0x2f, 0xcf, 0x0e, 0x24, 0x49, 0xa6, 0xb5, 0x25,
+	0xb1, 0x6a, 0xed, 0xf5, 0xaa, 0x0d, 0xe6, 0x57, 0xba, 0x63, 0x7b, 0x39
+};
+static const unsigned char nist_ct[60] = {
+	0x42, 0x83, 0x1e, 0xc2, 0x21, 0x77, 0x74, 0x24, 0x4b, 0x72, 0x21, 0xb7, 0x84, 0xd0, 0xd4, 0x9c,
+	0xe3, 0xaa, 0x21, 0x2f, 0x2c, 0x02, 0xa4, 0xe0, 0x35, 0xc1, 0x7e, 0x23, 0x29, 0xac, 0xa1, 0x2e,
+	0x21, 0xd5, 0x14, 0xb2, 0x54, 0x66, 0x93, 0x1c, 0x7d, 0x8f, 0x6a, 0x5a, 0xac, 0x84, 0xaa, 0x05,
+	0x1b, 0xa3, 0x0b, 0x39, 0x6a, 0x0a, 0xac, 0x97, 0x3d, 0x58, 0xe0, 0x91
+};
+static const unsigned char nist_tag[16] = {
+	0x5b, 0xc9, 0x4f, 0xbc, 0x32, 0x21, 0xa5, 0xdb, 0x94, 0xfa, 0xe9, 0x5a, 0xe7, 0x12, 0x1a, 0x47
+};
+
+/*
+ * Crypto engine emulation: the AES engine functions of rom_ssl_ram_map on
+ * the software AES, counting the key setups the RAM code asks for
+ */
+static unsigned char emu_key[32];
+static u32 emu_keylen;
+static unsigned long emu_inits;
+
+static int emu_aes_init(const u8 *key, const u32 keylen)
+{
+	memcpy(emu_key, key, keylen);
+	emu_keylen = keylen;
+	emu_inits++;
+	return 0;
+}
+
+static int emu_aes_crypt(int mode, int cbc, const u8 *message, u32 msglen, const u8 *iv, u8 *result)
+{
+	mbedtls_aes_context aes;
+	unsigned char iv_buf[16];
+	u32 off;
+
+	rom_ssl_ram_map.use_hw_crypto_func = 0;
+	mbedtls_aes_init(&aes);
+	if (mode == MBEDTLS_AES_ENCRYPT)
+		mbedtls_aes_setkey_enc(&aes, emu_key, emu_keylen * 8);
+	else
+		mbedtls_aes_setkey_dec(&aes, emu_key, emu_keylen * 8);
+	if (cbc) {
+		memcpy(iv_buf, iv, 16);
+		mbedtls_aes_crypt_cbc(&aes, mode, msglen, iv_buf, message, result);
+	} else {
+		for (off = 0; off + 16 <= msglen; off += 16)
+			mbedtls_aes_crypt_ecb(&aes, mode, message + off, result + off);
+	}
+	mbedtls_aes_free(&aes);
+	rom_ssl_ram_map.use_hw_crypto_func = 1;
+
+	return 0;
+}
+
+static int emu_ecb_encrypt(const u8 *message, const u32 msglen, const u8 *iv, const u32 ivlen, u8 *result)
+{
+	return emu_aes_crypt(MBEDTLS_AES_ENCRYPT, 0, message, msglen, iv, result);
+}
+
+static int emu_ecb_decrypt(const u8 *message, const u32 msglen, const u8 *iv, const u32 ivlen, u8 *result)
+{
+	return emu_aes_crypt(MBEDTLS_AES_DECRYPT, 0, message, msglen, iv, result);
+}
+
+static int emu_cbc_encrypt(const u8 *message, const u32 msglen, const u8 *iv, const u32 ivlen, u8 *result)
+{
+	return emu_aes_crypt(MBEDTLS_AES_ENCRYPT, 1, message, msglen, iv, result);
+}
+
+static int emu_cbc_decrypt(const u8 *message, const u32 msglen, const u8 *iv, const u32 ivlen, u8 *result)
+{
+	return emu_aes_crypt(MBEDTLS_AES_DECRYPT, 1, message, msglen, iv, result);
+}
+
+static void emu_engine(int on)
+{
+	rom_ssl_ram_map.hw_crypto_aes_ecb_init = emu_aes_init;
+	rom_ssl_ram_map.hw_crypto_aes_ecb_encrypt = emu_ecb_encrypt;
+	rom_ssl_ram_map.hw_crypto_aes_ecb_decrypt = emu_ecb_decrypt;
+	rom_ssl_ram_map.hw_crypto_aes_cbc_init = emu_aes_init;
+	rom_ssl_ram_map.hw_crypto_aes_cbc_encrypt = emu_cbc_encrypt;
+	rom_ssl_ram_map.hw_crypto_aes_cbc_decrypt = emu_cbc_decrypt;
+	rom_ssl_ram_map.use_hw_crypto_func = on;
+}
+
+/* engine: 0 software, 1 emulated engine; split: first update length, multiple of 16 */
+static int gcm_encrypt(int engine, unsigned int keybits, const unsigned char *key, const unsigned char *iv, size_t iv_len,
+	const unsigned char *aad, size_t aad_len, const unsigned char *input, size_t len, size_t split,
+	unsigned char *output, unsigned char tag[16])
+{
+	mbedtls_gcm_context gcm;
+	int ret;
+
+	emu_engine(engine);
+	mbedtls_gcm_init(&gcm);
+	if ((ret = mbedtls_gcm_setkey(&gcm, MBEDTLS_CIPHER_ID_AES, key, keybits)) == 0 &&
+		(ret = mbedtls_gcm_starts(&gcm, MBEDTLS_GCM_ENCRYPT, iv, iv_len, aad, aad_len)) == 0 &&
+		(ret = mbedtls_gcm_update(&gcm, split, input, output)) == 0 &&
+		(ret = mbedtls_gcm_update(&gcm, len - split, input + split, output + split)) == 0)
+		ret = mbedtls_gcm_finish(&gcm, tag, 16);
+	mbedtls_gcm_free(&gcm);
+	emu_engine(0);
+
+	return ret;
+}
+
+static int bench_verify(void)
+{
+	static const unsigned int keybits[] = {128, 192, 256};
+	mbedtls_gcm_context gcm;
+	unsigned char tag[16], chk_tag[16];
+	size_t len, split;
+	int k, ret;
+
+	if (gcm_encrypt(1, 128, nist_key, nist_iv, sizeof(nist_iv), nist_aad, sizeof(nist_aad), nist_pt,
+			sizeof(nist_pt), 0, dst_buf, tag) != 0 ||
+		memcmp(dst_buf, nist_ct, sizeof(nist_ct)) || memcmp(tag, nist_tag, sizeof(nist_tag))) {
+		printf("engine GCM: NIST test case 4 failed\n");
+		return -1;
+	}
+
+	for (k = 0; k < (int)(sizeof(keybits) / sizeof(keybits[0])); k++) {
+		for (len = 0; len <= BENCH_MAX_LEN; len += (len < 300) ? 1 : 997) {
+			split = (len / 2) & ~(size_t)15;
+			gcm_encrypt(0, keybits[k], bench_key, bench_iv, 12, bench_aad, BENCH_AAD_LEN, src_buf, len, 0,
+				chk_buf, chk_tag);
+			gcm_encrypt(1, keybits[k], bench_key, bench_iv, 12, bench_aad, BENCH_AAD_LEN, src_buf, len, split,
+				dst_buf, tag);
+			if (memcmp(dst_buf, chk_buf, len) || memcmp(tag, chk_tag, 16)) {
+				printf("engine GCM: AES-%u len %u split %u differs from the software GCM\n",
+					keybits[k], (unsigned int)len, (unsigned int)split);
+				return -1;
+			}
+
+			/* in place, as the TLS record layer decrypts */
+			emu_engine(1);
+			mbedtls_gcm_init(&gcm);
+			mbedtls_gcm_setkey(&gcm, MBEDTLS_CIPHER_ID_AES, bench_key, keybits[k]);
+			ret = mbedtls_gcm_auth_decrypt(&gcm, len, bench_iv, 12, bench_aad, BENCH_AAD_LEN, tag, 16,
+				dst_buf, dst_buf);
+			mbedtls_gcm_free(&gcm);
+			emu_engine(0);
+			if (ret != 0 || memcmp(dst_buf, src_buf, len)) {
+				printf("engine GCM: AES-%u len %u in place decryption failed (%d)\n",
+					keybits[k], (unsigned int)len, ret);
+				return -1;
+			}
+		}
+	}
+
+	return 0;
+}
+
+static double bench_now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+/* record protection of a TLS 1.2 record as ssl_encrypt_buf(), MB/s */
+static double bench_gcm(unsigned int keybits, int len)
+{
+	mbedtls_gcm_context gcm;
+	unsigned char tag[16];
+	int i, count = BENCH_BYTES / len;
+	double start;
+
+	mbedtls_gcm_init(&gcm);
+	mbedtls_gcm_setkey(&gcm, MBEDTLS_CIPHER_ID_AES, bench_key, keybits);
+
+	start = bench_now();
+	for (i = 0; i < count; i++) {
+		bench_iv[11] = (unsigned char)i;
+		mbedtls_gcm_crypt_and_tag(&gcm, MBEDTLS_GCM_ENCRYPT, len, bench_iv, 12, bench_aad, BENCH_AAD_LEN,
+			src_buf, dst_buf, 16, tag);
+	}
+	start = bench_now() - start;
+	mbedtls_gcm_free(&gcm);
+
+	return (double)count * len / start / 1e6;
+}
+
+/* MAC then encrypt: HMAC of header and data, then AES-CBC of data, MAC and padding */
+static double bench_cbc(unsigned int keybits, mbedtls_md_type_t md_type, int len)
+{
+	mbedtls_aes_context aes;
+	mbedtls_md_context_t md;
+	unsigned char iv[16];
+	int i, pad, count = BENCH_BYTES / len;
+	size_t mac_len;
+	double start;
+
+	mbedtls_aes_init(&aes);
+	mbedtls_aes_setkey_enc(&aes, bench_key, keybits);
+	mbedtls_md_init(&md);
+	mbedtls_md_setup(&md, mbedtls_md_info_from_type(md_type), 1);
+	mbedtls_md_hmac_starts(&md, bench_key, 32);
+	mac_len = mbedtls_md_get_size(mbedtls_md_info_from_type(md_type));
+	pad = 16 - (len + mac_len) % 16;
+
+	start = bench_now();
+	for (i = 0; i < count; i++) {
+		memcpy(iv, bench_iv, 16);
+		mbedtls_md_hmac_reset(&md);
+		mbedtls_md_hmac_update(&md, bench_aad, BENCH_AAD_LEN);
+		mbedtls_md_hmac_update(&md, src_buf, len);
+		mbedtls_md_hmac_finish(&md, src_buf + len);
+		memset(src_buf + len + mac_len, pad - 1, pad);
+		mbedtls_aes_crypt_cbc(&aes, MBEDTLS_AES_ENCRYPT, len + mac_len + pad, iv, src_buf, dst_buf);
+	}
+	start = bench_now() - start;
+	mbedtls_md_free(&md);
+	mbedtls_aes_free(&aes);
+
+	return (double)count * len / start / 1e6;
+}
+
+/* engine key setups for one record with the emulated engine: 0 GCM, 1 CBC */
+static unsigned long bench_engine_calls(int cbc, int len)
+{
+	mbedtls_gcm_context gcm;
+	mbedtls_aes_context aes;
+	unsigned char tag[16], iv[16];
+	unsigned long calls;
+
+	emu_engine(1);
+	if (cbc) {
+		mbedtls_aes_init(&aes);
+		mbedtls_aes_setkey_enc(&aes, bench_key, 128);
+		memcpy(iv, bench_iv, 16);
+		emu_inits = 0;
+		mbedtls_aes_crypt_cbc(&aes, MBEDTLS_AES_ENCRYPT, (len + 32 + 16) & ~15, iv, src_buf, dst_buf);
+		mbedtls_aes_free(&aes);
+	} else {
+		mbedtls_gcm_init(&gcm);
+		mbedtls_gcm_setkey(&gcm, MBEDTLS_CIPHER_ID_AES, bench_key, 128);
+		emu_inits = 0;
+		mbedtls_gcm_crypt_and_tag(&gcm, MBEDTLS_GCM_ENCRYPT, len, bench_iv, 12, bench_aad, BENCH_AAD_LEN,
+			src_buf, dst_buf, 16, tag);
+		mbedtls_gcm_free(&gcm);
+	}
+	calls = emu_inits;
+	emu_engine(0);
+
+	return calls;
+}
+
+int main(void)
+{
+	static const int lens[] = {64, 1024, 16384};
+	int i;
+
+	srand(1);
+	for (i = 0; i < (int)sizeof(src_buf); i++)
+		src_buf[i] = (unsigned char)rand();
+	for (i = 0; i < (int)sizeof(bench_key); i++)
+		bench_key[i] = (unsigned char)rand();
+	for (i = 0; i < (int)sizeof(bench_iv); i++)
+		bench_iv[i] = (unsigned char)rand();
+	for (i = 0; i < (int)sizeof(bench_aad); i++)
+		bench_aad[i] = (unsigned char)rand();
+
+	if (bench_verify() != 0)
+		return 1;
+	printf("engine GCM matches the software GCM\n");
+
+	printf("software record protection, MB/s\n");
+	printf("  len  AES128-GCM  AES256-GCM  AES128-CBC-SHA  AES128-CBC-SHA256  AES256-CBC-SHA256\n");
+	for (i = 0; i < (int)(sizeof(lens) / sizeof(lens[0])); i++) {
+		printf("%5d  %10.1f  %10.1f  %14.1f  %17.1f  %17.1f\n", lens[i],
+			bench_gcm(128, lens[i]), bench_gcm(256, lens[i]),
+			bench_cbc(128, MBEDTLS_MD_SHA1, lens[i]), bench_cbc(128, MBEDTLS_MD_SHA256, lens[i]),
+			bench_cbc(256, MBEDTLS_MD_SHA256, lens[i]));
+	}
+
+	printf("crypto engine calls per record\n");
+	printf("  len  GCM per block  GCM engine CTR  CBC\n");
+	for (i = 0; i < (int)(sizeof(lens) / sizeof(lens[0])); i++) {
+		printf("%5d  %13d  %14lu  %3lu\n", lens[i], (lens[i] + 15) / 16 + 1,
+			bench_engine_calls(0, lens[i]), bench_engine_calls(1, lens[i]));
+	}
+
+	return 0;
+}
@@ -0,0 +1,631 @@
+/*
+ * FreeRTOS API on pthreads for the lwIP host port, see include/FreeRTOS.h
+ *
+ * Tasks are detached pthreads, queues and semaphores are a ring buffer under
+ * a mutex with two condition variables, like a FreeRTOS queue with item size
+ * 0 for semaphores. Threads that were not created by xTaskCreate (main, the
+ * netif rx thread) get a task handle on first use, so they can block on
+ * queues and call the lwIP API like any task.
+ */
+#define _GNU_SOURCE
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <sched.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "queue.h"
+#include "semphr.h"
+
+struct tskTaskControlBlock {
+	pthread_t thread;
+	TaskFunction_t code;
+	void *param;
+	UBaseType_t priority;
+	char name[configMAX_TASK_NAME_LEN];
+};
+
+struct QueueDefinition {
+	pthread_mutex_t lock;
+	pthread_cond_t not_empty;
+	pthread_cond_t not_full;
+	uint8_t *storage;
+	UBaseType_t length;
+	UBaseType_t item_size;
+	UBaseType_t waiting;
+	UBaseType_t head;
+	uint8_t type;
+	TaskHandle_t holder;		// mutexes only
+	UBaseType_t recursion;
+};
+
+static pthread_mutex_t critical_lock;
+static pthread_once_t posix_once = PTHREAD_ONCE_INIT;
+static struct timespec start_time;
+static __thread TaskHandle_t current_task = NULL;
+static __thread UBaseType_t critical_nesting = 0;
+
+static pthread_mutex_t heap_lock = PTHREAD_MUTEX_INITIALIZER;
+static size_t heap_used = 0;
+static size_t heap_peak = 0;
+
+static void posix_init(void)
+{
+	pthread_mutexattr_t attr;
+
+	pthread_mutexattr_init(&attr);
+	pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+	pthread_mutex_init(&critical_lock, &attr);
+	pthread_mutexattr_destroy(&attr);
+
+	clock_gettime(CLOCK_MONOTONIC, &start_time);
+}
+
+/*-----------------------------------------------------------------------------------*/
+/* Critical sections and heap */
+
+void vPortEnterCritical( void )
+{
+	pthread_once(&posix_once, posix_init);
+	pthread_mutex_lock(&critical_lock);
+	critical_nesting++;
+}
+
+void vPortExitCritical( void )
+{
+	configASSERT(critical_nesting > 0);
+	critical_nesting--;
+	pthread_mutex_unlock(&critical_lock);
+}
+
+void vPortYield( void )
+{
+	sched_yield();
+}
+
+void vTaskSuspendAll( void )
+{
+	vPortEnterCritical();
+}
+
+BaseType_t xTaskResumeAll( void )
+{
+	vPortExitCritical();
+	return pdFALSE;
+}
+
+void vAssertCalled( const char *pcFile, unsigned long ulLine )
+{
+	printf("FreeRTOS assert at %s:%lu\n", pcFile, ulLine);
+	abort();
+}
+
+/* Usage is accounted against configTOTAL_HEAP_SIZE, so allocation failures
+ * happen at the same load as on the target */
+void *pvPortMalloc( size_t xSize )
+{
+	size_t *block;
+
+	if (xSize == 0)
+		return NULL;
+
+	pthread_mutex_lock(&heap_lock);
+	if (heap_used + xSize > configTOTAL_HEAP_SIZE) {
+		pthread_mutex_unlock(&heap_lock);
+		return NULL;
+	}
+	heap_used += xSize;
+	if (heap_used > heap_peak)
+		heap_peak = heap_used;
+	pthread_mutex_unlock(&heap_lock);
+
+	block = malloc(sizeof(size_t) * 2 + xSize);
+	if (block == NULL) {
+		pthread_mutex_lock(&heap_lock);
+		heap_used -= xSize;
+		pthread_mutex_unlock(&heap_lock);
+		return NULL;
+	}
+	block[0] = xSize;
+
+	return &block[2];
+}
+
+void vPortFree( void *pv )
+{
+	size_t *block = pv;
+
+	if (block == NULL)
+		return;
+
+	block -= 2;
+	pthread_mutex_lock(&heap_lock);
+	heap_used -= block[0];
+	pthread_mutex_unlock(&heap_lock);
+	free(block);
+}
+
+void *pvPortReAlloc( void *pv, size_t xSize )
+{
+	void *pvNew;
+	size_t old_size;
+
+	if (pv == NULL)
+		return pvPortMalloc(xSize);
+	if (xSize == 0) {
+		vPortFree(pv);
+		return NULL;
+	}
+
+	pvNew = pvPortMalloc(xSize);
+	if (pvNew) {
+		old_size = ((size_t *)pv)[-2];
+		memcpy(pvNew, pv, (old_size < xSize) ? old_size : xSize);
+		vPortFree(pv);
+	}
+
+	return pvNew;
+}
+
+size_t xPortGetFreeHeapSize( void )
+{
+	return configTOTAL_HEAP_SIZE - heap_used;
+}
+
+size_t xPortGetMinimumEverFreeHeapSize( void )
+{
+	return configTOTAL_HEAP_SIZE - heap_peak;
+}
+
+/*-----------------------------------------------------------------------------------*/
+/* Tasks */
+
+static void *task_start(void *arg)
+{
+	TaskHandle_t task = arg;
+
+	current_task = task;
+	task->code(task->param);
+
+	/* a FreeRTOS task must not return */
+	vTaskDelete(NULL);
+	return NULL;
+}
+
+BaseType_t xTaskCreate( TaskFunction_t pxTaskCode, const char * const pcName, const uint16_t usStackDepth,
+						void * const pvParameters, UBaseType_t uxPriority, TaskHandle_t * const pxCreatedTask )
+{
+	TaskHandle_t task;
+	pthread_attr_t attr;
+	int ret;
+
+	( void ) usStackDepth;	// stack words, host threads keep the default stack
+
+	pthread_once(&posix_once, posix_init);
+
+	task = calloc(1, sizeof(struct tskTaskControlBlock));
+	if (task == NULL)
+		return errCOULD_NOT_ALLOCATE_REQUIRED_MEMORY;
+
+	task->code = pxTaskCode;
+	task->param = pvParameters;
+	task->priority = uxPriority;
+	if (pcName)
+		strncpy(task->name, pcName, configMAX_TASK_NAME_LEN - 1);
+
+	/* the handle is visible before the task runs, as with the FreeRTOS scheduler */
+	if (pxCreatedTask)
+		*pxCreatedTask = task;
+
+	pthread_attr_init(&attr);
+	pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+	ret = pthread_create(&task->thread, &attr, task_start, task);
+	pthread_attr_destroy(&attr);
+
+	if (ret != 0) {
+		if (pxCreatedTask)
+			*pxCreatedTask = NULL;
+		free(task);
+		return errCOULD_NOT_ALLOCATE_REQUIRED_MEMORY;
+	}
+
+	return pdPASS;
+}
+
+void vTaskDelete( TaskHandle_t xTaskToDelete )
+{
+	TaskHandle_t self = xTaskGetCurrentTaskHandle();
+
+	if ((xTaskToDelete == NULL) || (xTaskToDelete == self)) {
+		/* drop the critical sections held by the task, sys_thread_delete() deletes itself inside one */
+		while (critical_nesting)
+			vPortExitCritical();
+		current_task = NULL;
+		free(self);
+		pthread_exit(NULL);
+	}
+
+	/* Another task is only deleted at its next cancellation point (blocking call) */
+	pthread_cancel(xTaskToDelete->thread);
+}
+
+TickType_t xTaskGetTickCount( void )
+{
+	struct timespec now;
+
+	pthread_once(&posix_once, posix_init);
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	return (TickType_t)((now.tv_sec - start_time.tv_sec) * configTICK_RATE_HZ +
+		(now.tv_nsec - start_time.tv_nsec) / (1000000000L / configTICK_RATE_HZ));
+}
+
+TickType_t xTaskGetTickCountFromISR( void )
+{
+	return xTaskGetTickCount();
+}
+
+void vTaskDelay( const TickType_t xTicksToDelay )
+{
+	struct timespec ts;
+
+	if (xTicksToDelay == 0) {
+		sched_yield();
+		return;
+	}
+
+	ts.tv_sec = xTicksToDelay / configTICK_RATE_HZ;
+	ts.tv_nsec = (xTicksToDelay % configTICK_RATE_HZ) * (1000000000L / configTICK_RATE_HZ);
+	while (nanosleep(&ts, &ts) == -1 && errno == EINTR)
+		;
+}
+
+void vTaskDelayUntil( TickType_t * const pxPreviousWakeTime, const TickType_t xTimeIncrement )
+{
+	TickType_t wake = *pxPreviousWakeTime + xTimeIncrement;
+	TickType_t now = xTaskGetTickCount();
+
+	if ((int32_t)(wake - now) > 0)
+		vTaskDelay(wake - now);
+	*pxPreviousWakeTime = wake;
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle( void )
+{
+	if (current_task == NULL) {
+		current_task = calloc(1, sizeof(struct tskTaskControlBlock));
+		configASSERT(current_task != NULL);
+		current_task->thread = pthread_self();
+		strncpy(current_task->name, "host", configMAX_TASK_NAME_LEN - 1);
+	}
+
+	return current_task;
+}
+
+void *vTaskGetCurrentTCB( void )
+{
+	return xTaskGetCurrentTaskHandle();
+}
+
+char *pcTaskGetName( TaskHandle_t xTaskToQuery )
+{
+	if (xTaskToQuery == NULL)
+		xTaskToQuery = xTaskGetCurrentTaskHandle();
+
+	return xTaskToQuery->name;
+}
+
+void vTaskSetTimeOutState( TimeOut_t * const pxTimeOut )
+{
+	pxTimeOut->xOverflowCount = 0;
+	pxTimeOut->xTimeOnEntering = xTaskGetTickCount();
+}
+
+/* pdTRUE once *pxTicksToWait have passed since pxTimeOut, otherwise the ticks left are returned in *pxTicksToWait */
+BaseType_t xTaskCheckForTimeOut( TimeOut_t * const pxTimeOut, TickType_t * const pxTicksToWait )
+{
+	TickType_t elapsed;
+
+	if (*pxTicksToWait == portMAX_DELAY)
+		return pdFALSE;
+
+	elapsed = xTaskGetTickCount() - pxTimeOut->xTimeOnEntering;
+	if (elapsed >= *pxTicksToWait) {
+		*pxTicksToWait = 0;
+		return pdTRUE;
+	}
+
+	*pxTicksToWait -= elapsed;
+	vTaskSetTimeOutState(pxTimeOut);
+	return pdFALSE;
+}
+
+UBaseType_t uxTaskGetStackHighWaterMark( TaskHandle_t xTask )
+{
+	( void ) xTask;
+	return 0;
+}
+
+UBaseType_t uxTaskPriorityGet( TaskHandle_t xTask )
+{
+	if (xTask == NULL)
+		xTask = xTaskGetCurrentTaskHandle();
+
+	return xTask->priority;
+}
+
+void vTaskPrioritySet( TaskHandle_t xTask, UBaseType_t uxNewPriority )
+{
+	if (xTask == NULL)
+		xTask = xTaskGetCurrentTaskHandle();
+
+	xTask->priority = uxNewPriority;
+}
+
+/* Tasks run as soon as they are created, the caller keeps running as a task */
+void vTaskStartScheduler( void )
+{
+	for (;;)
+		vTaskDelay(portMAX_DELAY);
+}
+
+/*-----------------------------------------------------------------------------------*/
+/* Queues, semaphores and mutexes */
+
+static void queue_deadline(struct timespec *ts, TickType_t ticks)
+{
+	clock_gettime(CLOCK_MONOTONIC, ts);
+	ts->tv_sec += ticks / configTICK_RATE_HZ;
+	ts->tv_nsec += (ticks % configTICK_RATE_HZ) * (1000000000L / configTICK_RATE_HZ);
+	if (ts->tv_nsec >= 1000000000L) {
+		ts->tv_sec++;
+		ts->tv_nsec -= 1000000000L;
+	}
+}
+
+/* Wait on cond with queue->lock held, 0 on timeout */
+static int queue_wait(QueueHandle_t queue, pthread_cond_t *cond, TickType_t ticks, const struct timespec *deadline)
+{
+	if (ticks == 0)
+		return 0;
+
+	if (ticks == portMAX_DELAY) {
+		pthread_cond_wait(cond, &queue->lock);
+		return 1;
+	}
+
+	return (pthread_cond_timedwait(cond, &queue->lock, deadline) != ETIMEDOUT);
+}
+
+QueueHandle_t xQueueGenericCreate( const UBaseType_t uxQueueLength, const UBaseType_t uxItemSize, const uint8_t ucQueueType )
+{
+	QueueHandle_t queue;
+	pthread_condattr_t attr;
+
+	if (uxQueueLength == 0)
+		return NULL;
+
+	queue = calloc(1, sizeof(struct QueueDefinition) + uxQueueLength * uxItemSize);
+	if (queue == NULL)
+		return NULL;
+
+	queue->storage = (uint8_t *)(queue + 1);
+	queue->length = uxQueueLength;
+	queue->item_size = uxItemSize;
+	queue->type = ucQueueType;
+
+	pthread_mutex_init(&queue->lock, NULL);
+	pthread_condattr_init(&attr);
+	pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+	pthread_cond_init(&queue->not_empty, &attr);
+	pthread_cond_init(&queue->not_full, &attr);
+	pthread_condattr_destroy(&attr);
+
+	return queue;
+}
+
+QueueHandle_t xQueueCreateMutex( const uint8_t ucQueueType )
+{
+	QueueHandle_t queue = xQueueGenericCreate(1, 0, ucQueueType);
+
+	if (queue)
+		queue->waiting = 1;
+
+	return queue;
+}
+
+QueueHandle_t xQueueCreateCountingSemaphore( const UBaseType_t uxMaxCount, const UBaseType_t uxInitialCount )
+{
+	QueueHandle_t queue;
+
+	if (uxInitialCount > uxMaxCount)
+		return NULL;
+
+	queue = xQueueGenericCreate(uxMaxCount, 0, queueQUEUE_TYPE_COUNTING_SEMAPHORE);
+	if (queue)
+		queue->waiting = uxInitialCount;
+
+	return queue;
+}
+
+void vQueueDelete( QueueHandle_t xQueue )
+{
+	if (xQueue == NULL)
+		return;
+
+	pthread_cond_destroy(&xQueue->not_empty);
+	pthread_cond_destroy(&xQueue->not_full);
+	pthread_mutex_destroy(&xQueue->lock);
+	free(xQueue);
+}
+
+BaseType_t xQueueGenericSend( QueueHandle_t xQueue, const void * const pvItemToQueue, TickType_t xTicksToWait, const BaseType_t xCopyPosition )
+{
+	struct timespec deadline;
+	UBaseType_t pos;
+
+	configASSERT(xQueue != NULL);
+	if ((xTicksToWait != 0) && (xTicksToWait != portMAX_DELAY))
+		queue_deadline(&deadline, xTicksToWait);
+
+	pthread_mutex_lock(&xQueue->lock);
+
+	if (xQueue->type == queueQUEUE_TYPE_MUTEX) {
+		/* giving a mutex that is not held fails, as in FreeRTOS */
+		if (xQueue->waiting) {
+			pthread_mutex_unlock(&xQueue->lock);
+			return errQUEUE_FULL;
+		}
+		xQueue->holder = NULL;
+	}
+
+	while ((xQueue->waiting == xQueue->length) && (xCopyPosition != queueOVERWRITE)) {
+		if (!queue_wait(xQueue, &xQueue->not_full, xTicksToWait, &deadline)) {
+			pthread_mutex_unlock(&xQueue->lock);
+			return errQUEUE_FULL;
+		}
+	}
+
+	if (xQueue->item_size) {
+		if (xCopyPosition == queueOVERWRITE) {
+			xQueue->waiting = 0;
+			pos = xQueue->head;
+		} else if (xCopyPosition == queueSEND_TO_FRONT) {
+			xQueue->head = (xQueue->head + xQueue->length - 1) % xQueue->length;
+			pos = xQueue->head;
+		} else {
+			pos = (xQueue->head + xQueue->waiting) % xQueue->length;
+		}
+		memcpy(xQueue->storage + pos * xQueue->item_size, pvItemToQueue, xQueue->item_size);
+	}
+	xQueue->waiting++;
+
+	pthread_cond_signal(&xQueue->not_empty);
+	pthread_mutex_unlock(&xQueue->lock);
+
+	return pdPASS;
+}
+
+static BaseType_t queue_receive( QueueHandle_t xQueue, void * const pvBuffer, TickType_t xTicksToWait, int peek )
+{
+	struct timespec deadline;
+
+	configASSERT(xQueue != NULL);
+	if ((xTicksToWait != 0) && (xTicksToWait != portMAX_DELAY))
+		queue_deadline(&deadline, xTicksToWait);
+
+	pthread_mutex_lock(&xQueue->lock);
+
+	while (xQueue->waiting == 0) {
+		if (!queue_wait(xQueue, &xQueue->not_empty, xTicksToWait, &deadline)) {
+			pthread_mutex_unlock(&xQueue->lock);
+			return errQUEUE_EMPTY;
+		}
+	}
+
+	if (xQueue->item_size && pvBuffer)
+		memcpy(pvBuffer, xQueue->storage + xQueue->head * xQueue->item_size, xQueue->item_size);
+
+	if (peek) {
+		/* let the other readers see the item too */
+		pthread_cond_signal(&xQueue->not_empty);
+	} else {
+		xQueue->head = (xQueue->head + 1) % xQueue->length;
+		xQueue->waiting--;
+		if (xQueue->type == queueQUEUE_TYPE_MUTEX)
+			xQueue->holder = xTaskGetCurrentTaskHandle();
+		pthread_cond_signal(&xQueue->not_full);
+	}
+
+	pthread_mutex_unlock(&xQueue->lock);
+
+	return pdPASS;
+}
+
+BaseType_t xQueueReceive( QueueHandle_t xQueue, void * const pvBuffer, TickType_t xTicksToWait )
+{
+	return queue_receive(xQueue, pvBuffer, xTicksToWait, 0);
+}
+
+BaseType_t xQueuePeek( QueueHandle_t xQueue, void * const pvBuffer, TickType_t xTicksToWait )
+{
+	return queue_receive(xQueue, pvBuffer, xTicksToWait, 1);
+}
+
+BaseType_t xQueueSemaphoreTake( QueueHandle_t xQueue, TickType_t xTicksToWait )
+{
+	return queue_receive(xQueue, NULL, xTicksToWait, 0);
+}
+
+BaseType_t xQueueTakeMutexRecursive( QueueHandle_t xMutex, TickType_t xTicksToWait )
+{
+	TaskHandle_t self = xTaskGetCurrentTaskHandle();
+
+	/* only the holder changes holder and recursion from self to another value */
+	if (xMutex->holder == self) {
+		xMutex->recursion++;
+		return pdPASS;
+	}
+
+	if (queue_receive(xMutex, NULL, xTicksToWait, 0) != pdPASS)
+		return pdFAIL;
+
+	xMutex->holder = self;
+	xMutex->recursion = 1;
+
+	return pdPASS;
+}
+
+BaseType_t xQueueGiveMutexRecursive( QueueHandle_t xMutex )
+{
+	if (xMutex->holder != xTaskGetCurrentTaskHandle())
+		return pdFAIL;
+
+	if (--xMutex->recursion == 0) {
+		xMutex->holder = NULL;
+		pthread_mutex_lock(&xMutex->lock);
+		xMutex->waiting = 1;
+		pthread_cond_signal(&xMutex->not_empty);
+		pthread_mutex_unlock(&xMutex->lock);
+	}
+
+	return pdPASS;
+}
+
+TaskHandle_t xQueueGetMutexHolder( QueueHandle_t xSemaphore )
+{
+	return xSemaphore->holder;
+}
+
+BaseType_t xQueueGenericReset( QueueHandle_t xQueue, BaseType_t xNewQueue )
+{
+	( void ) xNewQueue;
+
+	pthread_mutex_lock(&xQueue->lock);
+	xQueue->waiting = 0;
+	xQueue->head = 0;
+	pthread_cond_broadcast(&xQueue->not_full);
+	pthread_mutex_unlock(&xQueue->lock);
+
+	return pdPASS;
+}
+
+UBaseType_t uxQueueMessagesWaiting( const QueueHandle_t xQueue )
+{
+	UBaseType_t waiting;
+
+	pthread_mutex_lock(&xQueue->lock);
+	waiting = xQueue->waiting;
+	pthread_mutex_unlock(&xQueue->lock);
+
+	return waiting;
+}
+
+UBaseType_t uxQueueSpacesAvailable( const QueueHandle_t xQueue )
+{
+	return xQueue->length - uxQueueMessagesWaiting(xQueue);
+}
@@ -0,0 +1,467 @@
+/*
+ * Ethernet netif of the lwIP host port on a TAP device and pcap files, see hostif.h
+ */
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/ioctl.h>
+#include <net/if.h>
+#include <linux/if_tun.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "lwip/opt.h"
+#include "lwip/def.h"
+#include "lwip/pbuf.h"
+#include "lwip/memp.h"
+#include "lwip/stats.h"
+#include "lwip/tcpip.h"
+#include "netif/etharp.h"
+#include "hostif.h"
+
+#define HOSTIF_MAX_FRAME		1540	// MAX_ETH_MSG of ethernetif.h
+#define HOSTIF_RX_STACK_SIZE	512
+#define HOSTIF_RX_PRIORITY		(tskIDLE_PRIORITY + 5 + PRIORITIE_OFFSET)
+
+#define HOSTIF_LOSS_SEED		1
+
+#define PCAP_MAGIC				0xa1b2c3d4
+#define PCAP_MAGIC_NSEC			0xa1b23c4d
+#define PCAP_LINKTYPE_ETHERNET	1
+
+struct pcap_hdr {
+	u32_t magic;
+	u16_t version_major;
+	u16_t version_minor;
+	s32_t thiszone;
+	u32_t sigfigs;
+	u32_t snaplen;
+	u32_t network;
+};
+
+struct pcap_rec_hdr {
+	u32_t ts_sec;
+	u32_t ts_frac;		// usec, or nsec for PCAP_MAGIC_NSEC
+	u32_t incl_len;
+	u32_t orig_len;
+};
+
+static struct {
+	int tap_fd;
+	FILE *replay;
+	int replay_swapped;
+	int replay_nsec;
+	int replay_paced;
+	volatile int replay_done;
+	FILE *capture;
+	pthread_mutex_t capture_lock;
+	u8_t hwaddr[ETHARP_HWADDR_LEN];
+	int loss;				// permille
+	unsigned int rx_seed;	// rx is the tap thread, tx the TCP_IP thread
+	unsigned int tx_seed;
+	struct hostif_stats stats;
+} hostif = {
+	.tap_fd = -1,
+	.capture_lock = PTHREAD_MUTEX_INITIALIZER,
+	.hwaddr = {0x00, 0xe0, 0x4c, 0x87, 0x00, 0x01},
+};
+
+static u32_t pcap_swap32(u32_t val)
+{
+	return ((val & 0xff) << 24) | ((val & 0xff00) << 8) | ((val >> 8) & 0xff00) | (val >> 24);
+}
+
+static void capture_frame(const u8_t *frame, u32_t len)
+{
+	struct pcap_rec_hdr rec;
+	struct timeval tv;
+
+	if (hostif.capture == NULL)
+		return;
+
+	gettimeofday(&tv, NULL);
+	rec.ts_sec = (u32_t)tv.tv_sec;
+	rec.ts_frac = (u32_t)tv.tv_usec;
+	rec.incl_len = len;
+	rec.orig_len = len;
+
+	pthread_mutex_lock(&hostif.capture_lock);
+	fwrite(&rec, sizeof(rec), 1, hostif.capture);
+	fwrite(frame, 1, len, hostif.capture);
+	fflush(hostif.capture);
+	pthread_mutex_unlock(&hostif.capture_lock);
+}
+
+int hostif_open_tap(const char *name)
+{
+	struct ifreq ifr;
+	int fd;
+
+	fd = open("/dev/net/tun", O_RDWR);
+	if (fd < 0) {
+		printf("hostif: open /dev/net/tun failed: %s\n", strerror(errno));
+		return -1;
+	}
+
+	memset(&ifr, 0, sizeof(ifr));
+	ifr.ifr_flags = IFF_TAP | IFF_NO_PI;
+	strncpy(ifr.ifr_name, name, IFNAMSIZ - 1);
+	if (ioctl(fd, TUNSETIFF, &ifr) < 0) {
+		printf("hostif: TUNSETIFF %s failed: %s\n", name, strerror(errno));
+		close(fd);
+		return -1;
+	}
+
+	hostif.tap_fd = fd;
+	return 0;
+}
+
+int hostif_open_replay(const char *path, int paced)
+{
+	struct pcap_hdr hdr;
+	FILE *fp;
+
+	fp = (strcmp(path, "-") == 0) ? stdin : fopen(path, "rb");
+	if (fp == NULL) {
+		printf("hostif: open %s failed: %s\n", path, strerror(errno));
+		return -1;
+	}
+
+	if (fread(&hdr, sizeof(hdr), 1, fp) != 1)
+		goto bad_file;
+
+	hostif.replay_swapped = 0;
+	if ((hdr.magic == pcap_swap32(PCAP_MAGIC)) || (hdr.magic == pcap_swap32(PCAP_MAGIC_NSEC))) {
+		hostif.replay_swapped = 1;
+		hdr.magic = pcap_swap32(hdr.magic);
+		hdr.network = pcap_swap32(hdr.network);
+	}
+	if (((hdr.magic != PCAP_MAGIC) && (hdr.magic != PCAP_MAGIC_NSEC)) || (hdr.network != PCAP_LINKTYPE_ETHERNET))
+		goto bad_file;
+
+	hostif.replay_nsec = (hdr.magic == PCAP_MAGIC_NSEC);
+	hostif.replay_paced = paced;
+	hostif.replay = fp;
+	return 0;
+
+bad_file:
+	printf("hostif: %s is not an Ethernet pcap file\n", path);
+	if (fp != stdin)
+		fclose(fp);
+	return -1;
+}
+
+int hostif_open_capture(const char *path)
+{
+	struct pcap_hdr hdr;
+
+	hostif.capture = fopen(path, "wb");
+	if (hostif.capture == NULL) {
+		printf("hostif: open %s failed: %s\n", path, strerror(errno));
+		return -1;
+	}
+
+	hdr.magic = PCAP_MAGIC;
+	hdr.version_major = 2;
+	hdr.version_minor = 4;
+	hdr.thiszone = 0;
+	hdr.sigfigs = 0;
+	hdr.snaplen = 65535;
+	hdr.network = PCAP_LINKTYPE_ETHERNET;
+	fwrite(&hdr, sizeof(hdr), 1, hostif.capture);
+
+	return 0;
+}
+
+void hostif_set_hwaddr(const u8_t *hwaddr)
+{
+	memcpy(hostif.hwaddr, hwaddr, ETHARP_HWADDR_LEN);
+}
+
+void hostif_set_loss(int permille)
+{
+	hostif.loss = permille;
+	hostif.rx_seed = HOSTIF_LOSS_SEED;
+	hostif.tx_seed = HOSTIF_LOSS_SEED + 1;
+}
+
+/* ARP is never dropped, so a loss only delays the IP traffic it hits */
+static int hostif_lost(const u8_t *frame, unsigned int *seed)
+{
+	const struct eth_hdr *ethhdr = (const struct eth_hdr *)frame;
+
+	if ((hostif.loss <= 0) || (ethhdr->type != PP_HTONS(ETHTYPE_IP)))
+		return 0;
+
+	return (rand_r(seed) % 1000) < hostif.loss;
+}
+
+int hostif_replay_done(void)
+{
+	return hostif.replay_done;
+}
+
+void hostif_get_stats(struct hostif_stats *stats)
+{
+	SYS_ARCH_DECL_PROTECT(lev);
+
+	SYS_ARCH_PROTECT(lev);
+	*stats = hostif.stats;
+	SYS_ARCH_UNPROTECT(lev);
+}
+
+void hostif_close(void)
+{
+	int fd = hostif.tap_fd;
+
+	/* the tap thread checks tap_fd when its read fails */
+	hostif.tap_fd = -1;
+	if (fd >= 0)
+		close(fd);
+
+	pthread_mutex_lock(&hostif.capture_lock);
+	if (hostif.capture)
+		fclose(hostif.capture);
+	hostif.capture = NULL;
+	pthread_mutex_unlock(&hostif.capture_lock);
+}
+
+#if ETHERNETIF_RX_ZERO_COPY
+/* Stands for a wlan rx skb: lwIP gets the frame as a PBUF_REF pbuf and frees the buffer */
+struct hostif_rx_pbuf {
+	struct pbuf_custom p;
+	u8_t frame[HOSTIF_MAX_FRAME];
+};
+
+LWIP_MEMPOOL_DECLARE(HOSTIF_RX_PBUF, ETHERNETIF_RX_ZERO_COPY_NUM, sizeof(struct hostif_rx_pbuf), "hostif rx pbuf");
+
+static void hostif_rx_pbuf_free(struct pbuf *p)
+{
+	LWIP_MEMPOOL_FREE(HOSTIF_RX_PBUF, p);
+}
+
+/* Same as ethernetif_recv_skb(), the copy here is the DMA of the wlan driver */
+static struct pbuf *hostif_recv_skb(const u8_t *frame, u32_t len)
+{
+	struct hostif_rx_pbuf *rx_pbuf;
+
+	rx_pbuf = (struct hostif_rx_pbuf *)LWIP_MEMPOOL_ALLOC(HOSTIF_RX_PBUF);
+	if (rx_pbuf == NULL)
+		return NULL;
+
+	memcpy(rx_pbuf->frame, frame, len);
+	rx_pbuf->p.custom_free_function = hostif_rx_pbuf_free;
+	return pbuf_alloced_custom(PBUF_RAW, len, PBUF_REF, &rx_pbuf->p, rx_pbuf->frame, len);
+}
+#endif
+
+/*
+ * Same as ethernetif_recv(): copy the frame into a pool pbuf, or reference it
+ * with ETHERNETIF_RX_ZERO_COPY, and pass it to the interface
+ */
+static err_t hostif_input(struct netif *netif, const u8_t *frame, u32_t len, int wait)
+{
+	struct pbuf *p;
+	SYS_ARCH_DECL_PROTECT(lev);
+
+	capture_frame(frame, len);
+
+	for (;;) {
+#if ETHERNETIF_RX_ZERO_COPY
+		p = hostif_recv_skb(frame, len);
+		if (p == NULL)
+#endif
+		{
+			p = pbuf_alloc(PBUF_RAW, len, PBUF_POOL);
+			if (p)
+				pbuf_take(p, frame, len);
+		}
+		if (p) {
+			if (netif->input(p, netif) == ERR_OK)
+				break;
+			pbuf_free(p);
+		}
+		/* a replay is not lossy: wait for the tcpip thread to catch up */
+		if (!wait) {
+			SYS_ARCH_PROTECT(lev);
+			hostif.stats.rx_drops++;
+			SYS_ARCH_UNPROTECT(lev);
+			NETSTATS_INC_PROTECTED(rx_drops);
+			return ERR_MEM;
+		}
+		vTaskDelay(1);
+	}
+
+	SYS_ARCH_PROTECT(lev);
+	hostif.stats.rx_frames++;
+	hostif.stats.rx_bytes += len;
+	SYS_ARCH_UNPROTECT(lev);
+	NETSTATS_INC_PROTECTED(rx_frames);
+
+	return ERR_OK;
+}
+
+static void hostif_tap_thread(void *param)
+{
+	struct netif *netif = param;
+	u8_t frame[HOSTIF_MAX_FRAME];
+	ssize_t len;
+	SYS_ARCH_DECL_PROTECT(lev);
+
+	for (;;) {
+		len = read(hostif.tap_fd, frame, sizeof(frame));
+		if (len < 0) {
+			if (errno == EINTR)
+				continue;
+			if (hostif.tap_fd < 0)	// hostif_close()
+				break;
+			printf("hostif: tap read failed: %s\n", strerror(errno));
+			break;
+		}
+		if (len < SIZEOF_ETH_HDR)
+			continue;
+		if (hostif_lost(frame, &hostif.rx_seed)) {
+			SYS_ARCH_PROTECT(lev);
+			hostif.stats.rx_lost++;
+			SYS_ARCH_UNPROTECT(lev);
+			continue;
+		}
+		hostif_input(netif, frame, (u32_t)len, 0);
+	}
+
+	vTaskDelete(NULL);
+}
+
+static void hostif_replay_thread(void *param)
+{
+	struct netif *netif = param;
+	struct pcap_rec_hdr rec;
+	u8_t frame[HOSTIF_MAX_FRAME];
+	u32_t len, first_ms = 0, rec_ms;
+	TickType_t start = xTaskGetTickCount();
+	int first = 1;
+
+	while (fread(&rec, sizeof(rec), 1, hostif.replay) == 1) {
+		if (hostif.replay_swapped) {
+			rec.ts_sec = pcap_swap32(rec.ts_sec);
+			rec.ts_frac = pcap_swap32(rec.ts_frac);
+			rec.incl_len = pcap_swap32(rec.incl_len);
+		}
+
+		/* frames larger than the driver buffer are truncated as on the target */
+		len = LWIP_MIN(rec.incl_len, sizeof(frame));
+		if (fread(frame, 1, len, hostif.replay) != len)
+			break;
+		if ((rec.incl_len > len) && (fseek(hostif.replay, rec.incl_len - len, SEEK_CUR) != 0))
+			break;
+
+		if (hostif.replay_paced) {
+			rec_ms = rec.ts_sec * 1000 + rec.ts_frac / (hostif.replay_nsec ? 1000000 : 1000);
+			if (first)
+				first_ms = rec_ms;
+			first = 0;
+			vTaskDelayUntil(&start, rec_ms - first_ms);
+			first_ms = rec_ms;
+		}
+
+		if (len >= SIZEOF_ETH_HDR)
+			hostif_input(netif, frame, len, 1);
+	}
+
+	if (hostif.replay != stdin)
+		fclose(hostif.replay);
+	hostif.replay = NULL;
+	hostif.replay_done = 1;
+
+	vTaskDelete(NULL);
+}
+
+static err_t hostif_linkoutput(struct netif *netif, struct pbuf *p)
+{
+	u8_t frame[HOSTIF_MAX_FRAME];
+	u16_t len;
+	SYS_ARCH_DECL_PROTECT(lev);
+
+	LWIP_UNUSED_ARG(netif);
+
+	len = pbuf_copy_partial(p, frame, sizeof(frame), 0);
+	if (hostif_lost(frame, &hostif.tx_seed)) {
+		SYS_ARCH_PROTECT(lev);
+		hostif.stats.tx_lost++;
+		SYS_ARCH_UNPROTECT(lev);
+		return ERR_OK;
+	}
+	capture_frame(frame, len);
+
+	if ((hostif.tap_fd >= 0) && (write(hostif.tap_fd, frame, len) != len)) {
+		SYS_ARCH_PROTECT(lev);
+		hostif.stats.tx_errors++;
+		SYS_ARCH_UNPROTECT(lev);
+		NETSTATS_INC(tx_errors);
+		return ERR_IF;
+	}
+
+	SYS_ARCH_PROTECT(lev);
+	hostif.stats.tx_frames++;
+	hostif.stats.tx_bytes += len;
+	SYS_ARCH_UNPROTECT(lev);
+	NETSTATS_INC(tx_frames);
+
+	return ERR_OK;
+}
+
+/**
+ * Netif init callback for netif_add(), in place of ethernetif_init().
+ */
+err_t hostif_init(struct netif *netif)
+{
+	LWIP_ASSERT("netif != NULL", (netif != NULL));
+
+#if LWIP_NETIF_HOSTNAME
+	netif->hostname = "lwip0";
+#endif
+	netif->name[0] = 'r';
+	netif->name[1] = '0';
+	netif->output = etharp_output;
+#if LWIP_IPV6
+	netif->output_ip6 = ethip6_output;
+#endif
+	netif->linkoutput = hostif_linkoutput;
+
+	netif->hwaddr_len = ETHARP_HWADDR_LEN;
+	memcpy(netif->hwaddr, hostif.hwaddr, ETHARP_HWADDR_LEN);
+	netif->mtu = 1500;
+	netif->flags = NETIF_FLAG_BROADCAST | NETIF_FLAG_ETHARP | NETIF_FLAG_LINK_UP;
+#if LWIP_IGMP
+	netif->flags |= NETIF_FLAG_IGMP;
+#endif
+
+#if ETHERNETIF_RX_ZERO_COPY
+	LWIP_MEMPOOL_INIT(HOSTIF_RX_PBUF);
+#endif
+
+	return ERR_OK;
+}
+
+/**
+ * Start receiving from the opened tap device and replay file, once the
+ * netif is up.
+ */
+err_t hostif_start(struct netif *netif)
+{
+	if ((hostif.tap_fd >= 0) &&
+		(xTaskCreate(hostif_tap_thread, "hostif_rx", HOSTIF_RX_STACK_SIZE, netif, HOSTIF_RX_PRIORITY, NULL) != pdPASS))
+		return ERR_MEM;
+
+	if (hostif.replay &&
+		(xTaskCreate(hostif_replay_thread, "hostif_rp", HOSTIF_RX_STACK_SIZE, netif, HOSTIF_RX_PRIORITY, NULL) != pdPASS))
+		return ERR_MEM;
+
+	return ERR_OK;
+}
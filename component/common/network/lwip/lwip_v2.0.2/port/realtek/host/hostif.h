@@ -0,0 +1,43 @@
+#ifndef __HOSTIF_H__
+#define __HOSTIF_H__
+
+#include "lwip/err.h"
+#include "lwip/netif.h"
+
+/*
+ * Host replacement of ethernetif.c: the netif exchanges Ethernet frames with
+ * a Linux TAP device and/or a pcap file instead of the wlan driver.
+ *
+ *   tap      frames are read from and written to /dev/net/tun (IFF_TAP)
+ *   replay   frames of a pcap file are injected as received frames
+ *   capture  received and sent frames are appended to a pcap file
+ *   loss     IPv4 frames of the tap device are dropped at random in both
+ *            directions to emulate a lossy link, lost frames are not captured
+ */
+struct hostif_stats {
+	u32_t rx_frames;
+	u32_t rx_bytes;
+	u32_t rx_drops;		// no pbuf or tcpip mbox full
+	u32_t tx_frames;
+	u32_t tx_bytes;
+	u32_t tx_errors;
+	u32_t rx_lost;		// dropped by the loss emulation
+	u32_t tx_lost;
+};
+
+int hostif_open_tap(const char *name);
+int hostif_open_replay(const char *path, int paced);
+int hostif_open_capture(const char *path);
+void hostif_set_hwaddr(const u8_t *hwaddr);
+/* Drops <permille> of the IPv4 frames in each direction, with a fixed seed */
+void hostif_set_loss(int permille);
+
+err_t hostif_init(struct netif *netif);
+err_t hostif_start(struct netif *netif);
+
+/* 1 once the replay file has been fed completely */
+int hostif_replay_done(void);
+void hostif_get_stats(struct hostif_stats *stats);
+void hostif_close(void);
+
+#endif
@@ -0,0 +1,93 @@
+/*
+ * Host build replacement of FreeRTOS.h for the lwIP host port.
+ *
+ * Only the part of the FreeRTOS v10.0.1 API used by sys_arch.c and the
+ * network applications is provided, implemented on pthreads in
+ * freertos_posix.c. Every task is a pthread, priorities are ignored and
+ * critical sections are one recursive process wide mutex.
+ */
+#ifndef INC_FREERTOS_H
+#define INC_FREERTOS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef long BaseType_t;
+typedef unsigned long UBaseType_t;
+typedef uint32_t TickType_t;
+
+#define pdFALSE						( ( BaseType_t ) 0 )
+#define pdTRUE						( ( BaseType_t ) 1 )
+#define pdPASS						( pdTRUE )
+#define pdFAIL						( pdFALSE )
+#define errQUEUE_EMPTY				( ( BaseType_t ) 0 )
+#define errQUEUE_FULL				( ( BaseType_t ) 0 )
+#define errCOULD_NOT_ALLOCATE_REQUIRED_MEMORY	( -1 )
+
+#define portMAX_DELAY				( TickType_t ) 0xffffffffUL
+#define portCHAR					char
+#define portSHORT					short
+#define portLONG					long
+#define portBASE_TYPE				long
+#define portSTACK_TYPE				uint32_t
+#define portBYTE_ALIGNMENT			8
+#define portNOP()
+#define portYIELD()					vPortYield()
+#define portEND_SWITCHING_ISR( x )	( void ) ( x )
+#define portYIELD_FROM_ISR( x )		( void ) ( x )
+#define PRIVILEGED_FUNCTION
+#define PRIVILEGED_DATA
+
+/* Same values as the AmebaZ2 FreeRTOSConfig.h */
+#define configTICK_RATE_HZ			( ( TickType_t ) 1000 )
+#define configMAX_PRIORITIES		( 11 )
+#define configMINIMAL_STACK_SIZE	( ( unsigned short ) 70 )
+#define configMAX_TASK_NAME_LEN		( 10 )
+#define configTOTAL_HEAP_SIZE		( ( size_t ) ( 160 * 1024 ) )
+#define PRIORITIE_OFFSET			( 4 )
+#define configUSE_MUTEXES			1
+#define configUSE_RECURSIVE_MUTEXES	1
+#define configUSE_COUNTING_SEMAPHORES	1
+#define configSUPPORT_DYNAMIC_ALLOCATION	1
+#define INCLUDE_vTaskDelete			1
+#define INCLUDE_vTaskDelay			1
+#define INCLUDE_xTaskGetCurrentTaskHandle	1
+#define INCLUDE_uxTaskGetStackHighWaterMark	0
+
+#define portTICK_PERIOD_MS			( ( TickType_t ) 1000 / configTICK_RATE_HZ )
+#define portTICK_RATE_MS			portTICK_PERIOD_MS
+
+#define configASSERT( x )			do { if( ( x ) == 0 ) vAssertCalled( __FILE__, __LINE__ ); } while( 0 )
+
+/* Critical sections nest per thread, the scheduler lock is the same lock */
+void vPortEnterCritical( void );
+void vPortExitCritical( void );
+void vPortYield( void );
+#define portENTER_CRITICAL()		vPortEnterCritical()
+#define portEXIT_CRITICAL()			vPortExitCritical()
+#define portDISABLE_INTERRUPTS()	vPortEnterCritical()
+#define portENABLE_INTERRUPTS()		vPortExitCritical()
+#define portSET_INTERRUPT_MASK_FROM_ISR()		( vPortEnterCritical(), 0 )
+#define portCLEAR_INTERRUPT_MASK_FROM_ISR( x )	( ( void ) ( x ), vPortExitCritical() )
+
+void *pvPortMalloc( size_t xSize );
+void vPortFree( void *pv );
+void *pvPortReAlloc( void *pv, size_t xSize );
+size_t xPortGetFreeHeapSize( void );
+size_t xPortGetMinimumEverFreeHeapSize( void );
+
+void vAssertCalled( const char *pcFile, unsigned long ulLine );
+
+/* Names from before v8, still used by the SDK */
+#define xTaskHandle					TaskHandle_t
+#define xQueueHandle				QueueHandle_t
+#define xSemaphoreHandle			SemaphoreHandle_t
+#define portTickType				TickType_t
+#define pdTASK_CODE					TaskFunction_t
+
+typedef void ( *TaskFunction_t )( void * );
+typedef struct tskTaskControlBlock *TaskHandle_t;
+typedef struct QueueDefinition *QueueHandle_t;
+typedef QueueHandle_t SemaphoreHandle_t;
+
+#endif /* INC_FREERTOS_H */
@@ -0,0 +1,30 @@
+/*
+ * Host build replacement of port/realtek/arch/cc.h.
+ *
+ * The target cc.h defines s32_t as long and mem_ptr_t as u32_t, which are
+ * wrong on a 64-bit host (TCP sequence compares, pointer alignment), so the
+ * lwIP types come from stdint.h here. The other arch/ headers are shared
+ * with the target.
+ */
+#ifndef __CC_H__
+#define __CC_H__
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+#include "arch/cpu.h"
+
+typedef int sys_prot_t;
+
+#define PACK_STRUCT_BEGIN
+#define PACK_STRUCT_STRUCT __attribute__ ((__packed__))
+#define PACK_STRUCT_END
+#define PACK_STRUCT_FIELD(x) x
+
+/* lwIP asserts are fatal on the host, so that fuzzing catches them */
+#define LWIP_PLATFORM_DIAG(x)	do { printf x; } while(0)
+#define LWIP_PLATFORM_ASSERT(x)	do { printf("lwip assert \"%s\" at %s:%d\n", x, __FILE__, __LINE__); abort(); } while(0)
+
+#define LWIP_TIMEVAL_PRIVATE 0
+
+#endif /* __CC_H__ */
@@ -0,0 +1,11 @@
+/*
+ * Host build replacement of autoconf.h for the lwIP host port.
+ */
+#ifndef WLANCONFIG_H
+#define WLANCONFIG_H
+
+#define CONFIG_LWIP_LAYER		1
+#define CONFIG_WLAN				0
+#define CONFIG_USE_TCM_HEAP		0
+
+#endif /* WLANCONFIG_H */
@@ -0,0 +1,17 @@
+/*
+ * Host build replacement of basic_types.h for the lwIP host port.
+ * Only the fixed width types used by rom_ssl_ram_map.h are needed.
+ */
+#ifndef __BASIC_TYPES_H__
+#define __BASIC_TYPES_H__
+
+#include <platform/platform_stdlib.h>
+
+#ifndef IN
+#define IN
+#endif
+#ifndef OUT
+#define OUT
+#endif
+
+#endif /* __BASIC_TYPES_H__ */
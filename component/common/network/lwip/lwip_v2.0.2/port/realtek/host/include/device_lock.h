@@ -0,0 +1,22 @@
+/*
+ * Host build replacement of device_lock.h for the lwIP host port.
+ * There is no crypto engine or flash to share, so the device locks are no-ops.
+ */
+#ifndef _DEVICE_LOCK_H_
+#define _DEVICE_LOCK_H_
+
+enum _RT_DEV_LOCK_E
+{
+	RT_DEV_LOCK_EFUSE = 0,
+	RT_DEV_LOCK_FLASH = 1,
+	RT_DEV_LOCK_CRYPTO = 2,
+	RT_DEV_LOCK_PTA = 3,
+	RT_DEV_LOCK_WLAN = 4,
+	RT_DEV_LOCK_MAX = 5
+};
+typedef uint32_t RT_DEV_LOCK_E;
+
+#define device_mutex_lock(device)	do { (void)(device); } while (0)
+#define device_mutex_unlock(device)	do { (void)(device); } while (0)
+
+#endif //_DEVICE_LOCK_H_
@@ -0,0 +1,9 @@
+/*
+ * Host build replacement of hal_crypto.h for the lwIP host port.
+ * There is no crypto engine: rom_ssl_ram_map.use_hw_crypto_func stays 0 and
+ * mbedtls takes its software paths.
+ */
+#ifndef _HAL_CRYPTO_H_
+#define _HAL_CRYPTO_H_
+
+#endif /* _HAL_CRYPTO_H_ */
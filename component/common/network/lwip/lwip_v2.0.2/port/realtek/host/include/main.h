@@ -0,0 +1,9 @@
+/*
+ * Host build replacement of the project main.h for the lwIP host port.
+ */
+#ifndef MAIN_H
+#define MAIN_H
+
+#include <autoconf.h>
+
+#endif /* MAIN_H */
@@ -0,0 +1,43 @@
+/*
+ * Host build replacement of mbedtls/config.h for the lwIP host port.
+ * It uses the shipped config_rsa.h profile with the software fallbacks of the
+ * crypto engine paths (SUPPORT_HW_SW_CRYPTO, as in the ROM build), see
+ * ssl_ram_map.c.
+ */
+#ifndef MBEDTLS_CONFIG_HOST_H
+#define MBEDTLS_CONFIG_HOST_H
+
+#include "rom_ssl_ram_map.h"
+#define RTL_HW_CRYPTO
+#define SUPPORT_HW_SW_CRYPTO
+#define RTL_CRYPTO_FRAGMENT               15360
+
+#include <platform/platform_stdlib.h>
+#include "mbedtls/config_rsa.h"
+
+#undef MBEDTLS_PLATFORM_NO_STD_FUNCTIONS
+
+/* the "https" command: TLS server as the httpd and websocket server examples
+   enable it, with the mbedtls test certificate */
+#define MBEDTLS_SSL_SRV_C
+#define MBEDTLS_CERTS_C
+
+/* pk_bench: the handshake algorithms which config_rsa.h leaves to the ROM */
+#if defined(HOST_PK_BENCH)
+#define CONFIG_SSL_BENCH
+#define MBEDTLS_ECP_C
+#define MBEDTLS_ECDSA_C
+#define MBEDTLS_ECDH_C
+#define MBEDTLS_DHM_C
+#define MBEDTLS_ASN1_WRITE_C
+#define MBEDTLS_ECP_WINDOW_SIZE 5
+#define MBEDTLS_ECP_FIXED_POINT_CACHE
+#endif
+
+/* the amd64 multiply-accumulate of bn_mul.h, config_rsa.h leaves the assembly off
+   for the target, whose bignum runs from ROM; pk_bench_c uses the generic C */
+#if !defined(HOST_BN_MUL_C)
+#define MBEDTLS_HAVE_ASM
+#endif
+
+#endif /* MBEDTLS_CONFIG_HOST_H */
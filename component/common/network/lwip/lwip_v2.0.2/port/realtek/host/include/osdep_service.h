@@ -0,0 +1,66 @@
+/*
+ * Host build replacement of osdep_service.h for the lwIP host port.
+ * Only what the network applications use is provided.
+ */
+#ifndef __OSDEP_SERVICE_H_
+#define __OSDEP_SERVICE_H_
+
+#include <stdlib.h>
+#include <sys/random.h>
+#include "FreeRTOS.h"
+#include "task.h"
+#include "semphr.h"
+
+#define SUCCESS	0
+#define FAIL	(-1)
+
+#define rtw_malloc(sz)			((u8 *)pvPortMalloc(sz))
+#define rtw_zmalloc(sz)			((u8 *)rtw_host_zmalloc(sz))
+#define rtw_mfree(pbuf, sz)		vPortFree(pbuf)
+#define rtw_free(buf)			vPortFree(buf)
+
+#define rtw_get_current_time()			xTaskGetTickCount()
+#define rtw_systime_to_ms(systime)		(systime)
+#define rtw_get_passing_time_ms(start)	(xTaskGetTickCount() - (start))
+#define rtw_msleep_os(ms)				vTaskDelay(ms)
+#define rtw_mdelay_os(ms)				vTaskDelay(ms)
+
+typedef void *_mutex;
+
+static inline void rtw_mutex_init(_mutex *pmutex)
+{
+	*pmutex = xSemaphoreCreateMutex();
+}
+
+static inline void rtw_mutex_free(_mutex *pmutex)
+{
+	if (*pmutex != NULL)
+		vSemaphoreDelete(*pmutex);
+	*pmutex = NULL;
+}
+
+static inline void rtw_mutex_get(_mutex *pmutex)
+{
+	xSemaphoreTake(*pmutex, portMAX_DELAY);
+}
+
+static inline void rtw_mutex_put(_mutex *pmutex)
+{
+	xSemaphoreGive(*pmutex);
+}
+
+static inline void *rtw_host_zmalloc(size_t sz)
+{
+	void *pbuf = pvPortMalloc(sz);
+
+	if (pbuf)
+		memset(pbuf, 0, sz);
+	return pbuf;
+}
+
+static inline int rtw_get_random_bytes(void *dst, size_t size)
+{
+	return (getrandom(dst, size, 0) == (ssize_t)size) ? 0 : -1;
+}
+
+#endif //__OSDEP_SERVICE_H_
@@ -0,0 +1,37 @@
+/*
+ * Host build replacement of platform_stdlib.h for the lwIP host port.
+ * It is included by lwipopts.h, so it must not pull in the host socket
+ * headers: the lwIP socket API is used under the BSD names.
+ */
+#ifndef __PLATFORM_STDLIB_H__
+#define __PLATFORM_STDLIB_H__
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdarg.h>
+#include <string.h>
+#include <ctype.h>
+
+#ifndef TRUE
+#define TRUE	1
+#endif
+#ifndef FALSE
+#define FALSE	0
+#endif
+
+typedef uint8_t		u8;
+typedef uint16_t	u16;
+typedef uint32_t	u32;
+typedef int8_t		s8;
+typedef int16_t		s16;
+typedef int32_t		s32;
+
+#define rtl_printf		printf
+#define rtl_sprintf		sprintf
+#define rtl_snprintf	snprintf
+#define rtl_strlen		strlen
+#define rtl_memcpy		memcpy
+#define rtl_memset		memset
+
+#endif /* __PLATFORM_STDLIB_H__ */
@@ -0,0 +1,14 @@
+/*
+ * Host build replacement of platform_opts.h for the lwIP host port.
+ * lwipopts.h profiles are selected with the same CONFIG_ macros as on the
+ * target, e.g. make PROFILE=-DCONFIG_HIGH_TP_TEST=1, see README.
+ */
+#ifndef __PLATFORM_OPTS_H__
+#define __PLATFORM_OPTS_H__
+
+#define CONFIG_BSD_TCP			1
+#define CONFIG_ETHERNET			0
+#define CONFIG_USE_POLARSSL		0
+#define CONFIG_USE_MBEDTLS		1
+
+#endif /* __PLATFORM_OPTS_H__ */
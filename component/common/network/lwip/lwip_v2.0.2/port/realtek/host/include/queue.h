@@ -0,0 +1,42 @@
+/*
+ * Host build replacement of queue.h, see FreeRTOS.h
+ */
+#ifndef QUEUE_H
+#define QUEUE_H
+
+#include "FreeRTOS.h"
+
+#define queueSEND_TO_BACK						( ( BaseType_t ) 0 )
+#define queueSEND_TO_FRONT						( ( BaseType_t ) 1 )
+#define queueOVERWRITE							( ( BaseType_t ) 2 )
+
+#define queueQUEUE_TYPE_BASE					( ( uint8_t ) 0U )
+#define queueQUEUE_TYPE_MUTEX					( ( uint8_t ) 1U )
+#define queueQUEUE_TYPE_COUNTING_SEMAPHORE		( ( uint8_t ) 2U )
+#define queueQUEUE_TYPE_BINARY_SEMAPHORE		( ( uint8_t ) 3U )
+#define queueQUEUE_TYPE_RECURSIVE_MUTEX			( ( uint8_t ) 4U )
+
+QueueHandle_t xQueueGenericCreate( const UBaseType_t uxQueueLength, const UBaseType_t uxItemSize, const uint8_t ucQueueType );
+BaseType_t xQueueGenericSend( QueueHandle_t xQueue, const void * const pvItemToQueue, TickType_t xTicksToWait, const BaseType_t xCopyPosition );
+BaseType_t xQueueReceive( QueueHandle_t xQueue, void * const pvBuffer, TickType_t xTicksToWait );
+BaseType_t xQueuePeek( QueueHandle_t xQueue, void * const pvBuffer, TickType_t xTicksToWait );
+BaseType_t xQueueSemaphoreTake( QueueHandle_t xQueue, TickType_t xTicksToWait );
+BaseType_t xQueueGenericReset( QueueHandle_t xQueue, BaseType_t xNewQueue );
+UBaseType_t uxQueueMessagesWaiting( const QueueHandle_t xQueue );
+UBaseType_t uxQueueSpacesAvailable( const QueueHandle_t xQueue );
+void vQueueDelete( QueueHandle_t xQueue );
+
+#define xQueueCreate( uxQueueLength, uxItemSize )	xQueueGenericCreate( ( uxQueueLength ), ( uxItemSize ), queueQUEUE_TYPE_BASE )
+#define xQueueSend( xQueue, pvItemToQueue, xTicksToWait )			xQueueGenericSend( ( xQueue ), ( pvItemToQueue ), ( xTicksToWait ), queueSEND_TO_BACK )
+#define xQueueSendToBack( xQueue, pvItemToQueue, xTicksToWait )		xQueueGenericSend( ( xQueue ), ( pvItemToQueue ), ( xTicksToWait ), queueSEND_TO_BACK )
+#define xQueueSendToFront( xQueue, pvItemToQueue, xTicksToWait )	xQueueGenericSend( ( xQueue ), ( pvItemToQueue ), ( xTicksToWait ), queueSEND_TO_FRONT )
+#define xQueueOverwrite( xQueue, pvItemToQueue )					xQueueGenericSend( ( xQueue ), ( pvItemToQueue ), 0, queueOVERWRITE )
+#define xQueueReset( xQueue )										xQueueGenericReset( ( xQueue ), pdFALSE )
+
+/* There are no interrupts on the host, the ISR variants never block */
+#define xQueueSendFromISR( xQueue, pvItemToQueue, pxHigherPriorityTaskWoken )			( ( void ) ( pxHigherPriorityTaskWoken ), xQueueGenericSend( ( xQueue ), ( pvItemToQueue ), 0, queueSEND_TO_BACK ) )
+#define xQueueSendToBackFromISR( xQueue, pvItemToQueue, pxHigherPriorityTaskWoken )	xQueueSendFromISR( ( xQueue ), ( pvItemToQueue ), ( pxHigherPriorityTaskWoken ) )
+#define xQueueReceiveFromISR( xQueue, pvBuffer, pxHigherPriorityTaskWoken )			( ( void ) ( pxHigherPriorityTaskWoken ), xQueueReceive( ( xQueue ), ( pvBuffer ), 0 ) )
+#define uxQueueMessagesWaitingFromISR( xQueue )										uxQueueMessagesWaiting( xQueue )
+
+#endif /* QUEUE_H */
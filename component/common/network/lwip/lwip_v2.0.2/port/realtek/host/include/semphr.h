@@ -0,0 +1,37 @@
+/*
+ * Host build replacement of semphr.h, see FreeRTOS.h
+ */
+#ifndef SEMAPHORE_H
+#define SEMAPHORE_H
+
+#include "queue.h"
+
+QueueHandle_t xQueueCreateMutex( const uint8_t ucQueueType );
+QueueHandle_t xQueueCreateCountingSemaphore( const UBaseType_t uxMaxCount, const UBaseType_t uxInitialCount );
+BaseType_t xQueueTakeMutexRecursive( QueueHandle_t xMutex, TickType_t xTicksToWait );
+BaseType_t xQueueGiveMutexRecursive( QueueHandle_t xMutex );
+TaskHandle_t xQueueGetMutexHolder( QueueHandle_t xSemaphore );
+
+#define xSemaphoreCreateBinary()					xQueueGenericCreate( ( UBaseType_t ) 1, 0, queueQUEUE_TYPE_BINARY_SEMAPHORE )
+#define vSemaphoreCreateBinary( xSemaphore )		\
+	{												\
+		( xSemaphore ) = xSemaphoreCreateBinary();	\
+		if( ( xSemaphore ) != NULL )				\
+		{											\
+			( void ) xSemaphoreGive( ( xSemaphore ) );	\
+		}											\
+	}
+#define xSemaphoreCreateMutex()						xQueueCreateMutex( queueQUEUE_TYPE_MUTEX )
+#define xSemaphoreCreateRecursiveMutex()			xQueueCreateMutex( queueQUEUE_TYPE_RECURSIVE_MUTEX )
+#define xSemaphoreCreateCounting( uxMaxCount, uxInitialCount )	xQueueCreateCountingSemaphore( ( uxMaxCount ), ( uxInitialCount ) )
+#define xSemaphoreTake( xSemaphore, xBlockTime )	xQueueSemaphoreTake( ( xSemaphore ), ( xBlockTime ) )
+#define xSemaphoreGive( xSemaphore )				xQueueGenericSend( ( QueueHandle_t ) ( xSemaphore ), NULL, 0, queueSEND_TO_BACK )
+#define xSemaphoreTakeRecursive( xMutex, xBlockTime )	xQueueTakeMutexRecursive( ( xMutex ), ( xBlockTime ) )
+#define xSemaphoreGiveRecursive( xMutex )			xQueueGiveMutexRecursive( ( xMutex ) )
+#define xSemaphoreGiveFromISR( xSemaphore, pxHigherPriorityTaskWoken )	( ( void ) ( pxHigherPriorityTaskWoken ), xSemaphoreGive( xSemaphore ) )
+#define xSemaphoreTakeFromISR( xSemaphore, pxHigherPriorityTaskWoken )	( ( void ) ( pxHigherPriorityTaskWoken ), xSemaphoreTake( ( xSemaphore ), 0 ) )
+#define xSemaphoreGetMutexHolder( xSemaphore )		xQueueGetMutexHolder( ( xSemaphore ) )
+#define uxSemaphoreGetCount( xSemaphore )			uxQueueMessagesWaiting( ( QueueHandle_t ) ( xSemaphore ) )
+#define vSemaphoreDelete( xSemaphore )				vQueueDelete( ( QueueHandle_t ) ( xSemaphore ) )
+
+#endif /* SEMAPHORE_H */
@@ -0,0 +1,455 @@
+/*
+ * Host build of the FreeRTOS + lwIP stack, see README
+ *
+ * Brings up one netif on a TAP device or a pcap replay, then runs the
+ * commands given on the command line and on stdin, e.g. the ATWT/ATWU
+ * iperf commands of tcptest.c.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "semphr.h"
+
+#include "lwip/opt.h"
+#include "lwip/tcpip.h"
+#include "lwip/netif.h"
+#include "lwip/dhcp.h"
+#include "lwip/dns.h"
+#include "lwip/netdb.h"
+#include "lwip/sockets.h"
+#include "lwip/stats.h"
+#include "lwip/ip4_addr.h"
+#include "netif/etharp.h"
+#include "hostif.h"
+#include "MQTTClient.h"
+#include "httpd.h"
+#include "ssl_session_store.h"
+#include "mbedtls/certs.h"
+
+#define HOST_MAX_ARGC		32
+#define HOST_DHCP_TIMEOUT	10		// seconds
+#define HOST_START_DELAY	500		// ms, the tcptest.c tasks wait 100 ms before they start
+#define HOST_MQTT_BUF_SIZE	1024
+#define HOST_MQTT_TIMEOUT	30000	// ms
+
+extern void cmd_tcp(int argc, char **argv);
+extern void cmd_udp(int argc, char **argv);
+extern int httpd_tls_setup_init(const char *server_cert, const char *server_key, const char *ca_certs);
+extern void httpd_tls_setup_free(void);
+extern void *httpd_tls_new_handshake(int *sock, uint8_t secure);
+extern void httpd_tls_free(void *tls_in);
+extern void httpd_tls_close(void *tls_in);
+extern int httpd_tls_read(void *tls_in, uint8_t *buf, size_t buf_len);
+extern int httpd_tls_write(void *tls_in, uint8_t *buf, size_t buf_len);
+
+struct netif xnetif[1];
+
+static ip4_addr_t host_ip, host_mask, host_gw;
+static int host_dhcp = 0;
+static SemaphoreHandle_t host_init_sema;
+
+static void host_tcpip_init_done(void *arg)
+{
+	( void ) arg;
+
+#if ETHERNETIF_RX_BATCH
+	netif_add(&xnetif[0], &host_ip, &host_mask, &host_gw, NULL, &hostif_init, &tcpip_input_batched);
+#else
+	netif_add(&xnetif[0], &host_ip, &host_mask, &host_gw, NULL, &hostif_init, &tcpip_input);
+#endif
+	netif_set_default(&xnetif[0]);
+	netif_set_up(&xnetif[0]);
+#if LWIP_DNS
+	/* the gateway answers DNS unless DHCP tells another server */
+	dns_setserver(0, (const ip_addr_t *)&host_gw);
+#endif
+#if LWIP_DHCP
+	if (host_dhcp)
+		dhcp_start(&xnetif[0]);
+#endif
+
+	xSemaphoreGive(host_init_sema);
+}
+
+static void host_print_stats(void)
+{
+	struct hostif_stats stats;
+#if ETHERNETIF_RX_BATCH
+	struct tcpip_input_batch_stats batch;
+#endif
+#if LWIP_NETSTATS
+	struct stats_net net;
+#endif
+
+	hostif_get_stats(&stats);
+	printf("rx %u frames %u bytes %u drops, tx %u frames %u bytes %u errors\n",
+		stats.rx_frames, stats.rx_bytes, stats.rx_drops, stats.tx_frames, stats.tx_bytes, stats.tx_errors);
+	if (stats.rx_lost || stats.tx_lost)
+		printf("loss emulation: %u rx frames, %u tx frames lost\n", stats.rx_lost, stats.tx_lost);
+#if ETHERNETIF_RX_BATCH
+	tcpip_input_batch_get_stats(&batch);
+	printf("rx batch: %u frames in %u wakeups, max %u, %u drops, 1/2-3/4-7/8-15/16+ %u/%u/%u/%u/%u\n",
+		batch.frames, batch.wakeups, batch.max_frames, batch.drops,
+		batch.hist[0], batch.hist[1], batch.hist[2], batch.hist[3], batch.hist[4]);
+#endif
+#if LWIP_NETSTATS
+	netstats_get(&net);
+	printf("netstats: rx %u frames %u drops, tx %u frames %u errors, pbuf alloc fail %u, mbox full %u, "
+		"tcp rexmit %u ooseq drop %u, chksum err %u, reass timeout %u, "
+		"dns hits %u neg hits %u misses %u prefetch %u\n",
+		net.rx_frames, net.rx_drops, net.tx_frames, net.tx_errors, net.pbuf_alloc_fail, net.mbox_full,
+		net.tcp_rexmit, net.tcp_ooseq_drop, net.chksum_err, net.reass_timeout,
+		net.dns_hits, net.dns_neg_hits, net.dns_misses, net.dns_prefetch);
+#endif
+	printf("heap free %u, min free %u\n",
+		(unsigned int)xPortGetFreeHeapSize(), (unsigned int)xPortGetMinimumEverFreeHeapSize());
+}
+
+/* mqtt=<host>,<port>,<count>[,<size>[,ssl]]: publish <count> QoS 0 messages of <size> bytes */
+static void host_mqtt(int argc, char **argv)
+{
+	static unsigned char sendbuf[HOST_MQTT_BUF_SIZE], readbuf[HOST_MQTT_BUF_SIZE];
+	static char payload[HOST_MQTT_BUF_SIZE - 64];
+	MQTTPacket_connectData data = MQTTPacket_connectData_initializer;
+	MQTTMessage message;
+	MQTTClient client;
+	Network network;
+	TickType_t start;
+	int i, count, size = 64, rc = 0;
+
+	if (argc < 4) {
+		printf("usage: mqtt=<host>,<port>,<count>[,<size>[,ssl]]\n");
+		return;
+	}
+	count = atoi(argv[3]);
+	if (argc > 4)
+		size = atoi(argv[4]);
+	if ((size < 0) || (size > (int)sizeof(payload)))
+		size = sizeof(payload);
+	memset(payload, 'a', size);
+
+	NetworkInit(&network);
+	network.use_ssl = (argc > 5) && (strcmp(argv[5], "ssl") == 0);
+	start = xTaskGetTickCount();
+	if (NetworkConnect(&network, argv[1], atoi(argv[2])) != 0) {
+		printf("mqtt connect to %s:%s failed\n", argv[1], argv[2]);
+		return;
+	}
+	MQTTClientInit(&client, &network, HOST_MQTT_TIMEOUT, sendbuf, sizeof(sendbuf), readbuf, sizeof(readbuf));
+	data.MQTTVersion = 3;
+	data.clientID.cstring = "lwip_host";
+	if ((rc = MQTTConnect(&client, &data)) != 0) {
+		printf("mqtt connect failed %d\n", rc);
+		network.disconnect(&network);
+		return;
+	}
+	printf("mqtt connected in %u ms\n", (unsigned int)(xTaskGetTickCount() - start));
+
+	memset(&message, 0, sizeof(message));
+	message.qos = QOS0;
+	message.payload = payload;
+	message.payloadlen = size;
+	start = xTaskGetTickCount();
+	for (i = 0; (i < count) && (rc == 0); i++)
+		rc = MQTTPublish(&client, "lwip_host/bench", &message);
+	printf("mqtt published %d messages of %d bytes in %u ms, rc %d\n",
+		i, size, (unsigned int)(xTaskGetTickCount() - start), rc);
+
+	MQTTDisconnect(&client);
+	network.disconnect(&network);
+}
+
+/* Same argument format as the AT commands: NAME=arg1,arg2,... */
+static int host_parse_param(char *buf, char **argv)
+{
+	int argc = 1;
+
+	while ((argc < HOST_MAX_ARGC) && buf && *buf) {
+		argv[argc++] = buf;
+		buf = strchr(buf, ',');
+		if (buf)
+			*buf++ = '\0';
+	}
+
+	return argc;
+}
+
+/* https=<port>,<count>: answer <count> HTTPS requests with httpd_tls.c and the mbedtls test certificate */
+static void host_https(int argc, char **argv)
+{
+	static const char response[] = "HTTP/1.1 200 OK\r\nContent-Length: 2\r\nConnection: close\r\n\r\nok";
+	struct sockaddr_in addr;
+	uint8_t buf[512];
+	TickType_t start, total = 0;
+	int i, count, server, sock, handshakes = 0, opt = 1;
+	void *tls;
+
+	if (argc < 3) {
+		printf("usage: https=<port>,<count>\n");
+		return;
+	}
+	count = atoi(argv[2]);
+	if (httpd_tls_setup_init(mbedtls_test_srv_crt, mbedtls_test_srv_key, mbedtls_test_ca_crt) != 0)
+		return;
+
+	server = lwip_socket(AF_INET, SOCK_STREAM, 0);
+	lwip_setsockopt(server, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_port = htons(atoi(argv[1]));
+	addr.sin_addr.s_addr = INADDR_ANY;
+	if ((lwip_bind(server, (struct sockaddr *)&addr, sizeof(addr)) != 0) || (lwip_listen(server, 2) != 0)) {
+		printf("https listen on port %s failed\n", argv[1]);
+		goto exit;
+	}
+
+	for (i = 0; i < count; i++) {
+		if ((sock = lwip_accept(server, NULL, NULL)) < 0)
+			break;
+		start = xTaskGetTickCount();
+		tls = httpd_tls_new_handshake(&sock, HTTPD_SECURE_TLS);
+		if (tls) {
+			printf("https handshake %d in %u ms\n", i, (unsigned int)(xTaskGetTickCount() - start));
+			total += xTaskGetTickCount() - start;
+			handshakes++;
+			if (httpd_tls_read(tls, buf, sizeof(buf)) > 0)
+				httpd_tls_write(tls, (uint8_t *)response, strlen(response));
+			httpd_tls_close(tls);
+			httpd_tls_free(tls);
+		}
+		lwip_close(sock);
+	}
+	if (handshakes)
+		printf("https %d handshakes, %u ms average\n", handshakes, (unsigned int)(total / handshakes));
+
+exit:
+	lwip_close(server);
+	httpd_tls_setup_free();
+}
+
+/* sessions=save|load,<file>[,<elapsed s>]: keep the TLS client sessions over a restart like over deep sleep */
+static void host_sessions(int argc, char **argv)
+{
+	static uint8_t buf[4096];
+	FILE *f;
+	int len;
+
+	if ((argc < 3) || ((strcmp(argv[1], "save") != 0) && (strcmp(argv[1], "load") != 0))) {
+		printf("usage: sessions=save|load,<file>[,<elapsed s>]\n");
+		return;
+	}
+	if (strcmp(argv[1], "save") == 0) {
+		if ((len = ssl_session_store_export(buf, sizeof(buf))) < 0) {
+			printf("sessions: export needs %d bytes\n", ssl_session_store_export(NULL, 0));
+			return;
+		}
+		if ((f = fopen(argv[2], "wb")) == NULL) {
+			perror(argv[2]);
+			return;
+		}
+		fwrite(buf, 1, len, f);
+		fclose(f);
+		printf("sessions: saved %d bytes\n", len);
+	} else {
+		if ((f = fopen(argv[2], "rb")) == NULL) {
+			perror(argv[2]);
+			return;
+		}
+		len = fread(buf, 1, sizeof(buf), f);
+		fclose(f);
+		printf("sessions: loaded %d entries\n",
+			ssl_session_store_import(buf, len, (argc > 3) ? atoi(argv[3]) : 0));
+	}
+	memset(buf, 0, sizeof(buf));
+}
+
+#if LWIP_DNS
+/* dns=<name>[,<count>[,<interval s>]]: lwip_getaddrinfo <count> times, e.g. to watch the DNS table */
+static void host_dns(int argc, char **argv)
+{
+	struct addrinfo hints, *res;
+	TickType_t start;
+	int i, err, count = (argc > 2) ? atoi(argv[2]) : 1, interval = (argc > 3) ? atoi(argv[3]) : 0;
+	char addr[IP4ADDR_STRLEN_MAX];
+
+	memset(&hints, 0, sizeof(hints));
+	hints.ai_family = AF_INET;
+	for (i = 0; i < count; i++) {
+		if (i && interval)
+			vTaskDelay(interval * configTICK_RATE_HZ);
+		start = xTaskGetTickCount();
+		err = lwip_getaddrinfo(argv[1], NULL, &hints, &res);
+		if (err == 0) {
+			inet_ntoa_r(((struct sockaddr_in *)res->ai_addr)->sin_addr, addr, sizeof(addr));
+			lwip_freeaddrinfo(res);
+		} else {
+			snprintf(addr, sizeof(addr), "error %d", err);
+		}
+		printf("dns %s: %s in %u ms\n", argv[1], addr, (unsigned int)(xTaskGetTickCount() - start));
+	}
+}
+#endif
+
+/* Returns 0 on quit */
+static int host_command(char *line)
+{
+	char *argv[HOST_MAX_ARGC] = {0};
+	char *arg;
+	int argc;
+
+	line[strcspn(line, "\r\n")] = '\0';
+	if (*line == '\0' || *line == '#')
+		return 1;
+
+	arg = strchr(line, '=');
+	if (arg)
+		*arg++ = '\0';
+
+	if (strcmp(line, "ATWT") == 0 && arg) {
+		argv[0] = "tcp";
+		if ((argc = host_parse_param(arg, argv)) > 1)
+			cmd_tcp(argc, argv);
+	} else if (strcmp(line, "ATWU") == 0 && arg) {
+		argv[0] = "udp";
+		if ((argc = host_parse_param(arg, argv)) > 1)
+			cmd_udp(argc, argv);
+	} else if (strcmp(line, "mqtt") == 0 && arg) {
+		argv[0] = "mqtt";
+		argc = host_parse_param(arg, argv);
+		host_mqtt(argc, argv);
+	} else if (strcmp(line, "https") == 0 && arg) {
+		argv[0] = "https";
+		argc = host_parse_param(arg, argv);
+		host_https(argc, argv);
+	} else if (strcmp(line, "sessions") == 0 && arg) {
+		argv[0] = "sessions";
+		argc = host_parse_param(arg, argv);
+		host_sessions(argc, argv);
+#if LWIP_DNS
+	} else if (strcmp(line, "dns") == 0 && arg) {
+		argv[0] = "dns";
+		argc = host_parse_param(arg, argv);
+		host_dns(argc, argv);
+#endif
+	} else if (strcmp(line, "sleep") == 0 && arg) {
+		vTaskDelay(atoi(arg) * configTICK_RATE_HZ);
+	} else if (strcmp(line, "stats") == 0) {
+		host_print_stats();
+	} else if (strcmp(line, "quit") == 0) {
+		return 0;
+	} else {
+		printf("unknown command %s, use ATWT=..., ATWU=..., mqtt=..., https=..., sessions=..., dns=..., sleep=<s>, stats or quit\n", line);
+	}
+
+	return 1;
+}
+
+static void usage(const char *prog)
+{
+	printf("usage: %s [options] [command ...]\n"
+		"  -i <tap>      exchange frames with tap device <tap>\n"
+		"  -r <pcap>     replay the frames of <pcap> (- for stdin) as received frames\n"
+		"  -P            pace the replay with the pcap timestamps\n"
+		"  -w <pcap>     capture received and sent frames to <pcap>\n"
+		"  -a <ip>       address (default 192.168.7.2), -n <mask>, -g <gw>\n"
+		"  -d            use DHCP\n"
+		"  -m <mac>      hardware address, aa:bb:cc:dd:ee:ff\n"
+		"  -l <permille> drop this share of the IPv4 frames in each direction\n"
+		"  -x <ms>       exit <ms> after the replay is done instead of reading stdin\n"
+		"commands: ATWT=<args> ATWU=<args> mqtt=<host>,<port>,<count>[,<size>[,ssl]]\n"
+		"          https=<port>,<count> sessions=save|load,<file>[,<elapsed s>]\n"
+		"          dns=<name>[,<count>[,<interval s>]] sleep=<s> stats quit\n", prog);
+}
+
+int main(int argc, char **argv)
+{
+	const char *tap = NULL, *replay = NULL, *capture = NULL;
+	char line[256];
+	unsigned int mac[ETHARP_HWADDR_LEN];
+	u8_t hwaddr[ETHARP_HWADDR_LEN];
+	int opt, i, paced = 0, exit_ms = -1, running = 1;
+
+	setvbuf(stdout, NULL, _IOLBF, 0);
+	IP4_ADDR(&host_ip, 192, 168, 7, 2);
+	IP4_ADDR(&host_mask, 255, 255, 255, 0);
+	IP4_ADDR(&host_gw, 192, 168, 7, 1);
+
+	while ((opt = getopt(argc, argv, "i:r:Pw:a:n:g:dm:l:x:h")) != -1) {
+		switch (opt) {
+		case 'i': tap = optarg; break;
+		case 'r': replay = optarg; break;
+		case 'P': paced = 1; break;
+		case 'w': capture = optarg; break;
+		case 'a': ip4addr_aton(optarg, &host_ip); break;
+		case 'n': ip4addr_aton(optarg, &host_mask); break;
+		case 'g': ip4addr_aton(optarg, &host_gw); break;
+		case 'd': host_dhcp = 1; break;
+		case 'x': exit_ms = atoi(optarg); break;
+		case 'l': hostif_set_loss(atoi(optarg)); break;
+		case 'm':
+			if (sscanf(optarg, "%x:%x:%x:%x:%x:%x", &mac[0], &mac[1], &mac[2], &mac[3], &mac[4], &mac[5]) != 6) {
+				usage(argv[0]);
+				return 1;
+			}
+			for (i = 0; i < ETHARP_HWADDR_LEN; i++)
+				hwaddr[i] = (u8_t)mac[i];
+			hostif_set_hwaddr(hwaddr);
+			break;
+		default:
+			usage(argv[0]);
+			return 1;
+		}
+	}
+
+	if ((tap == NULL) && (replay == NULL)) {
+		usage(argv[0]);
+		return 1;
+	}
+	if ((tap && hostif_open_tap(tap)) || (replay && hostif_open_replay(replay, paced)) ||
+		(capture && hostif_open_capture(capture)))
+		return 1;
+
+	if (host_dhcp)
+		ip4_addr_set_zero(&host_ip);
+
+	host_init_sema = xSemaphoreCreateBinary();
+	tcpip_init(host_tcpip_init_done, NULL);
+	xSemaphoreTake(host_init_sema, portMAX_DELAY);
+
+	if (host_dhcp || (replay == NULL)) {
+		hostif_start(&xnetif[0]);
+		for (i = 0; (i < HOST_DHCP_TIMEOUT * 10) && ip4_addr_isany_val(*netif_ip4_addr(&xnetif[0])); i++)
+			vTaskDelay(100);
+	}
+	printf("lwip %s up, ip %s\n", LWIP_VERSION_STRING, ip4addr_ntoa(netif_ip4_addr(&xnetif[0])));
+
+	for (i = optind; running && (i < argc); i++) {
+		strncpy(line, argv[i], sizeof(line) - 1);
+		line[sizeof(line) - 1] = '\0';
+		running = host_command(line);
+	}
+
+	/* the replay starts once the servers of the command line are listening */
+	if (!host_dhcp && replay) {
+		vTaskDelay(HOST_START_DELAY);
+		hostif_start(&xnetif[0]);
+	}
+
+	if (exit_ms >= 0) {
+		while (replay && !hostif_replay_done())
+			vTaskDelay(10);
+		vTaskDelay(exit_ms);
+	} else {
+		while (running && fgets(line, sizeof(line), stdin))
+			running = host_command(line);
+	}
+
+	host_print_stats();
+	hostif_close();
+
+	return 0;
+}
@@ -0,0 +1,43 @@
+/*
+ * Public key handshake micro-benchmark, see README
+ *
+ * Runs mbedtls_pk_bench() of mbedtls_bench.c, built once with the bn_mul.h
+ * assembly (pk_bench_asm) and once with the generic C (pk_bench_c).
+ */
+#include <stdio.h>
+#include <time.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+int mbedtls_pk_bench(void);
+
+/* the tick count of freertos_posix.c without its scheduler */
+TickType_t xTaskGetTickCount(void)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	return (TickType_t)(now.tv_sec * configTICK_RATE_HZ + now.tv_nsec / (1000000000L / configTICK_RATE_HZ));
+}
+
+/* the generator comb table cache of ecp.c, single threaded here */
+void vTaskSuspendAll(void)
+{
+}
+
+BaseType_t xTaskResumeAll(void)
+{
+	return pdFALSE;
+}
+
+int main(void)
+{
+	int ret = mbedtls_pk_bench();
+
+	if (ret != 0)
+		printf("mbedtls_pk_bench failed %d\n", ret);
+
+	return ret != 0;
+}
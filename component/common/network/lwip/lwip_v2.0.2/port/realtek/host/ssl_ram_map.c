@@ -0,0 +1,27 @@
+/*
+ * Host build replacement of ssl_ram_map.c: the mbedtls RAM code finds the
+ * crypto engine through rom_ssl_ram_map, which has no engine functions here.
+ */
+#include <stddef.h>
+#include "rom_ssl_ram_map.h"
+
+struct _rom_ssl_ram_map rom_ssl_ram_map;
+
+int platform_set_malloc_free( void * (*malloc_func)( size_t ),
+                              void (*free_func)( void * ) )
+{
+	/* OS interface */
+	rom_ssl_ram_map.ssl_malloc = (void *(*)(unsigned int))malloc_func;
+	rom_ssl_ram_map.ssl_free = free_func;
+
+	/* Variables */
+	rom_ssl_ram_map.use_hw_crypto_func = 0;
+
+	return 0;
+}
+
+/* Only called when use_hw_crypto_func is set */
+int rtl_cryptoEngine_init(void)
+{
+	return -1;
+}
@@ -216,6 +216,10 @@ struct lwip_sock {
   u8_t err;
   /** counter of how many threads are waiting for this socket using select */
   SELWAIT_T select_waiting;
+#if LWIP_SOCKET_EPOLL
+  /** bit n set: the socket is in interest list n of lwip_epoll_ctl() */
+  u8_t epoll_sets;
+#endif /* LWIP_SOCKET_EPOLL */
 };
 
 #if LWIP_NETCONN_SEM_PER_THREAD
@@ -289,6 +293,43 @@ static struct lwip_select_cb *select_cb_list;
     and checked in event_callback to see if it has changed. */
 static volatile int select_cb_ctr;
 
+#if LWIP_SOCKET_EPOLL
+#if LWIP_SOCKET_EPOLL_SETS > 8
+#error "LWIP_SOCKET_EPOLL_SETS must be 8 or less (lwip_sock.epoll_sets)"
+#endif
+#if NUM_SOCKETS >= 0xff
+#error "lwip_epoll indexes sockets with u8_t"
+#endif
+/** End of a ready list */
+#define EPOLL_NONE     0xff
+/** Flag of lwip_epoll.events: the socket is in the interest list */
+#define EPOLL_MEMBER   0x80
+
+/** An interest list of lwip_epoll_ctl(), indexed like sockets[]. The sockets
+    that may be ready are queued on the ready list by event_callback();
+    lwip_epoll_wait() drops the ones that are not ready any more. */
+struct lwip_epoll {
+  u8_t used;
+  /** a task waits in lwip_epoll_wait(), signal the semaphore once */
+  u8_t waiting;
+  u8_t ready_head;
+  u8_t ready_tail;
+  /** events of interest | EPOLL_MEMBER, 0 if not in the list */
+  u8_t events[NUM_SOCKETS];
+  /** 1 if the socket is on the ready list */
+  u8_t queued[NUM_SOCKETS];
+  /** next socket on the ready list */
+  u8_t ready_next[NUM_SOCKETS];
+  lwip_epoll_data_t data[NUM_SOCKETS];
+  sys_sem_t sem;
+};
+
+static struct lwip_epoll epoll_sets[LWIP_SOCKET_EPOLL_SETS];
+
+static void lwip_epoll_event(struct lwip_sock *sock);
+static void lwip_epoll_forget(struct lwip_sock *sock);
+#endif /* LWIP_SOCKET_EPOLL */
+
 #if LWIP_SOCKET_SET_ERRNO
 #ifndef set_errno
 #define set_errno(err) do { if (err) { errno = (err); } } while(0)
@@ -443,6 +484,12 @@ free_socket(struct lwip_sock *sock, int is_tcp)
   sock->lastoffset = 0;
   sock->err        = 0;
 
+#if LWIP_SOCKET_EPOLL
+  if (sock->epoll_sets != 0) {
+    lwip_epoll_forget(sock);
+  }
+#endif /* LWIP_SOCKET_EPOLL */
+
   /* Protect socket array */
   SYS_ARCH_SET(sock->conn, NULL);
   /* don't use 'sock' after this line, as another task might have allocated it */
@@ -1630,6 +1677,12 @@ event_callback(struct netconn *conn, enum netconn_evt evt, u16_t len)
       break;
   }
 
+#if LWIP_SOCKET_EPOLL
+  if (sock->epoll_sets != 0) {
+    lwip_epoll_event(sock);
+  }
+#endif /* LWIP_SOCKET_EPOLL */
+
   if (sock->select_waiting == 0) {
     /* noone is waiting for this socket, no need to check select_cb_list */
     SYS_ARCH_UNPROTECT(lev);
@@ -1684,6 +1737,303 @@ again:
   SYS_ARCH_UNPROTECT(lev);
 }
 
+#if LWIP_SOCKET_EPOLL
+/** The events of 'events' a socket is ready for, LWIP_EPOLLERR always.
+ * Call with SYS_ARCH protected. */
+static u32_t
+lwip_epoll_ready(struct lwip_sock *sock, u8_t events)
+{
+  u32_t ready = LWIP_EPOLLERR;
+
+  if ((sock->lastdata != NULL) || (sock->rcvevent > 0)) {
+    ready |= LWIP_EPOLLIN;
+  }
+  if (sock->sendevent != 0) {
+    ready |= LWIP_EPOLLOUT;
+  }
+  if (sock->errevent == 0) {
+    ready &= ~LWIP_EPOLLERR;
+  }
+  return ready & (events | LWIP_EPOLLERR);
+}
+
+/** Queue socket i on the ready list if it is not, and wake up the waiting
+ * task. Call with SYS_ARCH protected. */
+static void
+lwip_epoll_queue(struct lwip_epoll *ep, u8_t i)
+{
+  if (!ep->queued[i]) {
+    ep->queued[i] = 1;
+    ep->ready_next[i] = EPOLL_NONE;
+    if (ep->ready_head == EPOLL_NONE) {
+      ep->ready_head = i;
+    } else {
+      ep->ready_next[ep->ready_tail] = i;
+    }
+    ep->ready_tail = i;
+  }
+  if (ep->waiting) {
+    ep->waiting = 0;
+    sys_sem_signal(&ep->sem);
+  }
+}
+
+/** Called by event_callback() with SYS_ARCH protected for a socket in one or
+ * more interest lists */
+static void
+lwip_epoll_event(struct lwip_sock *sock)
+{
+  u8_t i = (u8_t)(sock - sockets);
+  u8_t n;
+
+  for (n = 0; n < LWIP_SOCKET_EPOLL_SETS; n++) {
+    if ((sock->epoll_sets & (1 << n)) &&
+        lwip_epoll_ready(sock, epoll_sets[n].events[i])) {
+      lwip_epoll_queue(&epoll_sets[n], i);
+    }
+  }
+}
+
+/** Take a socket that is freed out of its interest lists. It may stay on a
+ * ready list until the next lwip_epoll_wait(). */
+static void
+lwip_epoll_forget(struct lwip_sock *sock)
+{
+  u8_t i = (u8_t)(sock - sockets);
+  u8_t n;
+  SYS_ARCH_DECL_PROTECT(lev);
+
+  SYS_ARCH_PROTECT(lev);
+  for (n = 0; n < LWIP_SOCKET_EPOLL_SETS; n++) {
+    if (sock->epoll_sets & (1 << n)) {
+      epoll_sets[n].events[i] = 0;
+    }
+  }
+  sock->epoll_sets = 0;
+  SYS_ARCH_UNPROTECT(lev);
+}
+
+static struct lwip_epoll *
+get_epoll(int epfd)
+{
+  if ((epfd < 0) || (epfd >= LWIP_SOCKET_EPOLL_SETS) || !epoll_sets[epfd].used) {
+    set_errno(EBADF);
+    return NULL;
+  }
+  return &epoll_sets[epfd];
+}
+
+/**
+ * Create an empty interest list.
+ *
+ * @return the interest list for lwip_epoll_ctl() and lwip_epoll_wait(),
+ *         -1 if all LWIP_SOCKET_EPOLL_SETS are in use
+ */
+int
+lwip_epoll_create(void)
+{
+  struct lwip_epoll *ep;
+  int epfd;
+  SYS_ARCH_DECL_PROTECT(lev);
+
+  for (epfd = 0; epfd < LWIP_SOCKET_EPOLL_SETS; epfd++) {
+    ep = &epoll_sets[epfd];
+    SYS_ARCH_PROTECT(lev);
+    if (!ep->used) {
+      ep->used = 1;
+      SYS_ARCH_UNPROTECT(lev);
+      if (sys_sem_new(&ep->sem, 0) != ERR_OK) {
+        ep->used = 0;
+        set_errno(ENOMEM);
+        return -1;
+      }
+      ep->waiting = 0;
+      ep->ready_head = EPOLL_NONE;
+      ep->ready_tail = EPOLL_NONE;
+      memset(ep->events, 0, sizeof(ep->events));
+      memset(ep->queued, 0, sizeof(ep->queued));
+      set_errno(0);
+      return epfd;
+    }
+    SYS_ARCH_UNPROTECT(lev);
+  }
+  set_errno(ENFILE);
+  return -1;
+}
+
+/**
+ * Close an interest list. Its sockets stay open. No task may wait in
+ * lwip_epoll_wait() for it.
+ */
+int
+lwip_epoll_close(int epfd)
+{
+  struct lwip_epoll *ep = get_epoll(epfd);
+  int i;
+  SYS_ARCH_DECL_PROTECT(lev);
+
+  if (ep == NULL) {
+    return -1;
+  }
+  SYS_ARCH_PROTECT(lev);
+  for (i = 0; i < NUM_SOCKETS; i++) {
+    if (ep->events[i] != 0) {
+      ep->events[i] = 0;
+      sockets[i].epoll_sets &= (u8_t)~(1 << epfd);
+    }
+  }
+  SYS_ARCH_UNPROTECT(lev);
+  sys_sem_free(&ep->sem);
+  ep->used = 0;
+  set_errno(0);
+  return 0;
+}
+
+/**
+ * Add a socket to an interest list (LWIP_EPOLL_CTL_ADD), change its events
+ * and data (LWIP_EPOLL_CTL_MOD) or remove it (LWIP_EPOLL_CTL_DEL, 'event'
+ * may be NULL). A socket closed is removed from its interest lists.
+ */
+int
+lwip_epoll_ctl(int epfd, int op, int s, struct lwip_epoll_event *event)
+{
+  struct lwip_epoll *ep = get_epoll(epfd);
+  struct lwip_sock *sock;
+  int err = 0;
+  u8_t i;
+  SYS_ARCH_DECL_PROTECT(lev);
+
+  if (ep == NULL) {
+    return -1;
+  }
+  if ((op != LWIP_EPOLL_CTL_DEL) && (event == NULL)) {
+    set_errno(EINVAL);
+    return -1;
+  }
+  sock = get_socket(s);
+  if (sock == NULL) {
+    return -1;
+  }
+  i = (u8_t)(sock - sockets);
+
+  SYS_ARCH_PROTECT(lev);
+  switch (op) {
+    case LWIP_EPOLL_CTL_ADD:
+    case LWIP_EPOLL_CTL_MOD:
+      if ((op == LWIP_EPOLL_CTL_ADD) == (ep->events[i] != 0)) {
+        err = (op == LWIP_EPOLL_CTL_ADD) ? EEXIST : ENOENT;
+        break;
+      }
+      ep->events[i] = (u8_t)(event->events & (LWIP_EPOLLIN | LWIP_EPOLLOUT | LWIP_EPOLLERR)) | EPOLL_MEMBER;
+      ep->data[i] = event->data;
+      sock->epoll_sets |= (u8_t)(1 << epfd);
+      if (lwip_epoll_ready(sock, ep->events[i])) {
+        lwip_epoll_queue(ep, i);
+      }
+      break;
+    case LWIP_EPOLL_CTL_DEL:
+      if (ep->events[i] == 0) {
+        err = ENOENT;
+        break;
+      }
+      ep->events[i] = 0;
+      sock->epoll_sets &= (u8_t)~(1 << epfd);
+      break;
+    default:
+      err = EINVAL;
+      break;
+  }
+  SYS_ARCH_UNPROTECT(lev);
+
+  set_errno(err);
+  return (err == 0) ? 0 : -1;
+}
+
+/**
+ * Wait for sockets of an interest list to be ready. Only one task may wait
+ * for an interest list at a time.
+ *
+ * @param events returns the events and data of up to 'maxevents' sockets;
+ *        when more are ready, the others come first on the next call
+ * @param timeout in milliseconds, 0 to poll, -1 to wait forever
+ * @return the number of sockets returned in 'events', 0 on timeout
+ */
+int
+lwip_epoll_wait(int epfd, struct lwip_epoll_event *events, int maxevents, int timeout)
+{
+  struct lwip_epoll *ep = get_epoll(epfd);
+  u32_t ready, waited;
+  u8_t i, count;
+  int nready;
+  SYS_ARCH_DECL_PROTECT(lev);
+
+  if (ep == NULL) {
+    return -1;
+  }
+  if ((events == NULL) || (maxevents <= 0)) {
+    set_errno(EINVAL);
+    return -1;
+  }
+
+  for (;;) {
+    nready = 0;
+    /* Go through the ready list once: sockets still ready are returned and
+       move to the tail (level-triggered), the others are dropped */
+    SYS_ARCH_PROTECT(lev);
+    count = 0;
+    for (i = ep->ready_head; i != EPOLL_NONE; i = ep->ready_next[i]) {
+      count++;
+    }
+    while ((count-- > 0) && (nready < maxevents)) {
+      i = ep->ready_head;
+      ep->ready_head = ep->ready_next[i];
+      ep->queued[i] = 0;
+      ready = (ep->events[i] != 0) ? lwip_epoll_ready(&sockets[i], ep->events[i]) : 0;
+      if (ready) {
+        events[nready].events = ready;
+        events[nready].data = ep->data[i];
+        nready++;
+        lwip_epoll_queue(ep, i);
+      } else if (ep->ready_head == EPOLL_NONE) {
+        ep->ready_tail = EPOLL_NONE;
+      }
+      /* keep interrupt protection time short */
+      SYS_ARCH_UNPROTECT(lev);
+      SYS_ARCH_PROTECT(lev);
+    }
+    if ((nready > 0) || (timeout == 0)) {
+      SYS_ARCH_UNPROTECT(lev);
+      set_errno(0);
+      return nready;
+    }
+    ep->waiting = 1;
+    SYS_ARCH_UNPROTECT(lev);
+
+    /* 0 means wait forever to sys_arch_sem_wait() */
+    waited = sys_arch_sem_wait(&ep->sem, (timeout < 0) ? 0 : (u32_t)timeout);
+
+    SYS_ARCH_PROTECT(lev);
+    if (waited == SYS_ARCH_TIMEOUT) {
+      if (ep->waiting) {
+        ep->waiting = 0;
+        SYS_ARCH_UNPROTECT(lev);
+        set_errno(0);
+        return 0;
+      }
+      /* signalled after the timeout: take the signal and look once more */
+      SYS_ARCH_UNPROTECT(lev);
+      sys_arch_sem_wait(&ep->sem, 1);
+      timeout = 0;
+    } else {
+      SYS_ARCH_UNPROTECT(lev);
+      if (timeout > 0) {
+        timeout = ((u32_t)timeout > waited) ? (int)(timeout - waited) : 0;
+      }
+    }
+  }
+}
+#endif /* LWIP_SOCKET_EPOLL */
+
 /**
  * Close one end of a full-duplex connection.
  */
@@ -2976,22 +3326,28 @@ void lwip_selectevindicate(int fd)
 int lwip_gettcpstatus(int s, uint32_t *seqno, uint32_t *ackno, uint16_t *wnd)
 {
   struct lwip_sock *sock;
+  struct tcp_pcb *pcb;
+  int ret = -1;
+
   sock = get_socket(s);
   if (!sock) {
     return -1;
   }
 
   if (NETCONNTYPE_GROUP(netconn_type(sock->conn)) == NETCONN_TCP) {
-	struct tcp_pcb *pcb = sock->conn->pcb.tcp;
-    *seqno = pcb->snd_lbb;
-	*ackno = pcb->rcv_nxt;
-	*wnd = pcb->rcv_wnd;
-  }
-  else {
-    return -1;
+    /* the pcb is only stable with the core locked (or in the TCP_IP thread) */
+    LOCK_TCPIP_CORE();
+    pcb = sock->conn->pcb.tcp;
+    if (pcb != NULL) {
+      *seqno = pcb->snd_lbb;
+      *ackno = pcb->rcv_nxt;
+      *wnd = pcb->rcv_wnd;
+      ret = 0;
+    }
+    UNLOCK_TCPIP_CORE();
   }
 
-  return 0;
+  return ret;
 }
 /**************************************************************
 *                           Added  by Realtek        end                    *
@@ -90,6 +90,7 @@
 #include "lwip/udp.h"
 #include "lwip/mem.h"
 #include "lwip/memp.h"
+#include "lwip/stats.h"
 #include "lwip/dns.h"
 #include "lwip/prot/dns.h"
 
@@ -166,6 +167,7 @@ static u16_t dns_txid;
 #if LWIP_IPV4 && LWIP_IPV6
 #define LWIP_DNS_ADDRTYPE_IS_IPV6(t) (((t) == LWIP_DNS_ADDRTYPE_IPV6_IPV4) || ((t) == LWIP_DNS_ADDRTYPE_IPV6))
 #define LWIP_DNS_ADDRTYPE_MATCH_IP(t, ip) (IP_IS_V6_VAL(ip) ? LWIP_DNS_ADDRTYPE_IS_IPV6(t) : (!LWIP_DNS_ADDRTYPE_IS_IPV6(t)))
+#define LWIP_DNS_ADDRTYPE_MATCH_NEG(t, entry) ((t) == (entry)->qaddrtype)
 #define LWIP_DNS_ADDRTYPE_ARG(x) , x
 #define LWIP_DNS_ADDRTYPE_ARG_OR_ZERO(x) x
 #define LWIP_DNS_SET_ADDRTYPE(x, y) do { x = y; } while(0)
@@ -176,6 +178,7 @@ static u16_t dns_txid;
 #define LWIP_DNS_ADDRTYPE_IS_IPV6(t) 0
 #endif
 #define LWIP_DNS_ADDRTYPE_MATCH_IP(t, ip) 1
+#define LWIP_DNS_ADDRTYPE_MATCH_NEG(t, entry) 1
 #define LWIP_DNS_ADDRTYPE_ARG(x)
 #define LWIP_DNS_ADDRTYPE_ARG_OR_ZERO(x) 0
 #define LWIP_DNS_SET_ADDRTYPE(x, y)
@@ -216,12 +219,20 @@ typedef enum {
   DNS_STATE_UNUSED           = 0,
   DNS_STATE_NEW              = 1,
   DNS_STATE_ASKING           = 2,
-  DNS_STATE_DONE             = 3
+  DNS_STATE_DONE             = 3,
+  /* the server answered that the name has no address, see DNS_NEG_TTL */
+  DNS_STATE_NEGATIVE         = 4,
+  /* DONE and asking again before the TTL runs out, see DNS_PREFETCH */
+  DNS_STATE_REFRESH          = 5
 } dns_state_enum_t;
 
 /** DNS table entry */
 struct dns_table_entry {
   u32_t ttl;
+#if DNS_PREFETCH
+  /* a lookup at or below this TTL refreshes the entry, 0 for never */
+  u32_t prefetch_ttl;
+#endif
   ip_addr_t ipaddr;
   u16_t txid;
   u8_t  state;
@@ -235,6 +246,8 @@ struct dns_table_entry {
   char name[DNS_MAX_NAME_LENGTH];
 #if LWIP_IPV4 && LWIP_IPV6
   u8_t reqaddrtype;
+  /* address type of the lookup that queued the entry, matched by negative entries */
+  u8_t qaddrtype;
 #endif /* LWIP_IPV4 && LWIP_IPV6 */
 #if LWIP_DNS_SUPPORT_MDNS_QUERIES
   u8_t is_mdns;
@@ -288,6 +301,9 @@ static err_t dns_lookup_local(const char *hostname, ip_addr_t *addr LWIP_DNS_ADD
 static void dns_recv(void *s, struct udp_pcb *pcb, struct pbuf *p, const ip_addr_t *addr, u16_t port);
 static void dns_check_entries(void);
 static void dns_call_found(u8_t idx, ip_addr_t* addr);
+#if DNS_PREFETCH
+static void dns_prefetch(u8_t idx);
+#endif
 
 /*-----------------------------------------------------------------------------
  * Globals
@@ -364,6 +380,18 @@ void
 dns_setserver(u8_t numdns, const ip_addr_t *dnsserver)
 {
   if (numdns < DNS_MAX_SERVERS) {
+#if DNS_NEG_TTL
+    u8_t i;
+
+    /* the failures were answers of the old server */
+    if ((dnsserver == NULL) || !ip_addr_cmp(&dns_servers[numdns], dnsserver)) {
+      for (i = 0; i < DNS_TABLE_SIZE; i++) {
+        if (dns_table[i].state == DNS_STATE_NEGATIVE) {
+          dns_table[i].state = DNS_STATE_UNUSED;
+        }
+      }
+    }
+#endif /* DNS_NEG_TTL */
     if (dnsserver != NULL) {
       dns_servers[numdns] = (*dnsserver);
     } else {
@@ -599,7 +627,8 @@ dns_local_addhost(const char *hostname, const ip_addr_t *addr)
  * @param addr the hostname's IP address, as u32_t (instead of ip_addr_t to
  *         better check for failure: != IPADDR_NONE) or IPADDR_NONE if the hostname
  *         was not found in the cached dns_table.
- * @return ERR_OK if found, ERR_ARG if not found
+ * @return ERR_OK if found, ERR_ARG if not found, ERR_VAL if the name is known
+ *         not to exist (see DNS_NEG_TTL)
  */
 static err_t
 dns_lookup(const char *name, ip_addr_t *addr LWIP_DNS_ADDRTYPE_ARG(u8_t dns_addrtype))
@@ -620,7 +649,7 @@ dns_lookup(const char *name, ip_addr_t *addr LWIP_DNS_ADDRTYPE_ARG(u8_t dns_addr
 
   /* Walk through name list, return entry if found. If not, return NULL. */
   for (i = 0; i < DNS_TABLE_SIZE; ++i) {
-    if ((dns_table[i].state == DNS_STATE_DONE) &&
+    if (((dns_table[i].state == DNS_STATE_DONE) || (dns_table[i].state == DNS_STATE_REFRESH)) &&
         (lwip_strnicmp(name, dns_table[i].name, sizeof(dns_table[i].name)) == 0) &&
         LWIP_DNS_ADDRTYPE_MATCH_IP(dns_addrtype, dns_table[i].ipaddr)) {
       LWIP_DEBUGF(DNS_DEBUG, ("dns_lookup: \"%s\": found = ", name));
@@ -629,8 +658,25 @@ dns_lookup(const char *name, ip_addr_t *addr LWIP_DNS_ADDRTYPE_ARG(u8_t dns_addr
       if (addr) {
         ip_addr_copy(*addr, dns_table[i].ipaddr);
       }
+      /* recently used, replaced last by dns_enqueue */
+      dns_table[i].seqno = dns_seqno;
+      NETSTATS_INC(dns_hits);
+#if DNS_PREFETCH
+      if ((dns_table[i].state == DNS_STATE_DONE) && (dns_table[i].ttl <= dns_table[i].prefetch_ttl)) {
+        dns_prefetch(i);
+      }
+#endif /* DNS_PREFETCH */
       return ERR_OK;
     }
+#if DNS_NEG_TTL
+    if ((dns_table[i].state == DNS_STATE_NEGATIVE) &&
+        (lwip_strnicmp(name, dns_table[i].name, sizeof(dns_table[i].name)) == 0) &&
+        LWIP_DNS_ADDRTYPE_MATCH_NEG(dns_addrtype, &dns_table[i])) {
+      LWIP_DEBUGF(DNS_DEBUG, ("dns_lookup: \"%s\": known not to exist\n", name));
+      NETSTATS_INC(dns_neg_hits);
+      return ERR_VAL;
+    }
+#endif /* DNS_NEG_TTL */
   }
 
   return ERR_ARG;
@@ -955,11 +1001,11 @@ dns_call_found(u8_t idx, ip_addr_t* addr)
 #endif
 #if ((LWIP_DNS_SECURE & LWIP_DNS_SECURE_RAND_SRC_PORT) != 0)
   /* close the pcb used unless other request are using it */
-  for (i = 0; i < DNS_MAX_REQUESTS; i++) {
+  for (i = 0; i < DNS_TABLE_SIZE; i++) {
     if (i == idx) {
       continue; /* only check other requests */
     }
-    if (dns_table[i].state == DNS_STATE_ASKING) {
+    if ((dns_table[i].state == DNS_STATE_ASKING) || (dns_table[i].state == DNS_STATE_REFRESH)) {
       if (dns_table[i].pcb_idx == dns_table[idx].pcb_idx) {
         /* another request is still using the same pcb */
         dns_table[idx].pcb_idx = DNS_MAX_SOURCE_PORTS;
@@ -988,7 +1034,7 @@ again:
 
   /* check whether the ID is unique */
   for (i = 0; i < DNS_TABLE_SIZE; i++) {
-    if ((dns_table[i].state == DNS_STATE_ASKING) &&
+    if (((dns_table[i].state == DNS_STATE_ASKING) || (dns_table[i].state == DNS_STATE_REFRESH)) &&
         (dns_table[i].txid == txid)) {
       /* ID already used by another pending query */
       goto again;
@@ -998,12 +1044,90 @@ again:
   return txid;
 }
 
+/**
+ * dns_fail_entry() - report a failed query to the callbacks and decide what
+ * stays in the table: a negative entry for a name the server says has no
+ * address, the old answer of a refresh until its TTL runs out, else nothing.
+ *
+ * @param idx dns table index of the entry that failed
+ * @param negative 1 if the server answered, 0 on timeout or server failure
+ */
+static void
+dns_fail_entry(u8_t idx, u8_t negative)
+{
+  struct dns_table_entry *entry = &dns_table[idx];
+#if DNS_PREFETCH
+  u8_t refresh = (entry->state == DNS_STATE_REFRESH);
+#endif
+
+  /* call specified callback function if provided */
+  dns_call_found(idx, NULL);
+
+#if DNS_NEG_TTL
+  if (negative) {
+    LWIP_DEBUGF(DNS_DEBUG, ("dns_fail_entry: \"%s\": negative for %"U32_F" s\n", entry->name, (u32_t)DNS_NEG_TTL));
+    entry->state = DNS_STATE_NEGATIVE;
+    entry->ttl = DNS_NEG_TTL;
+    return;
+  }
+#else
+  LWIP_UNUSED_ARG(negative);
+#endif /* DNS_NEG_TTL */
+#if DNS_PREFETCH
+  if (refresh) {
+    /* keep the old answer, without asking again */
+    entry->state = DNS_STATE_DONE;
+    entry->prefetch_ttl = 0;
+    return;
+  }
+#endif /* DNS_PREFETCH */
+  /* flush this entry */
+  entry->state = DNS_STATE_UNUSED;
+}
+
+#if DNS_PREFETCH
+/**
+ * dns_prefetch() - ask again for a DONE entry that is still looked up near the
+ * end of its TTL. The entry answers lookups until the new answer replaces it.
+ *
+ * @param idx dns table index of the entry to refresh
+ */
+static void
+dns_prefetch(u8_t idx)
+{
+  err_t err;
+  struct dns_table_entry *entry = &dns_table[idx];
+
+#if ((LWIP_DNS_SECURE & LWIP_DNS_SECURE_RAND_SRC_PORT) != 0)
+  entry->pcb_idx = dns_alloc_pcb();
+  if (entry->pcb_idx >= DNS_MAX_SOURCE_PORTS) {
+    /* no pcb now, the next lookup tries again */
+    return;
+  }
+#endif
+
+  LWIP_DEBUGF(DNS_DEBUG, ("dns_prefetch: \"%s\": %"U32_F" s left\n", entry->name, entry->ttl));
+  NETSTATS_INC(dns_prefetch);
+  entry->txid = dns_create_txid();
+  entry->state = DNS_STATE_REFRESH;
+  entry->server_idx = 0;
+  entry->tmr = 1;
+  entry->retries = 0;
+
+  err = dns_send(idx);
+  if (err != ERR_OK) {
+    LWIP_DEBUGF(DNS_DEBUG | LWIP_DBG_LEVEL_WARNING,
+                ("dns_send returned error: %s\n", lwip_strerr(err)));
+  }
+}
+#endif /* DNS_PREFETCH */
+
 /**
  * dns_check_entry() - see if entry has not yet been queried and, if so, sends out a query.
  * Check an entry in the dns_table:
  * - send out query for new entries
  * - retry old pending entries on timeout (also with different servers)
- * - remove completed entries from the table if their TTL has expired
+ * - remove completed and negative entries from the table if their TTL has expired
  *
  * @param i index of the dns_table entry to check
  */
@@ -1031,6 +1155,15 @@ dns_check_entry(u8_t i)
                     ("dns_send returned error: %s\n", lwip_strerr(err)));
       }
       break;
+    case DNS_STATE_REFRESH:
+      if ((entry->ttl == 0) || (--entry->ttl == 0)) {
+        LWIP_DEBUGF(DNS_DEBUG, ("dns_check_entry: \"%s\": flush before refresh\n", entry->name));
+        /* no callbacks, this releases the pcb */
+        dns_call_found(i, NULL);
+        entry->state = DNS_STATE_UNUSED;
+        break;
+      }
+      /* fall through */
     case DNS_STATE_ASKING:
       if (--entry->tmr == 0) {
         if (++entry->retries == DNS_MAX_RETRIES) {
@@ -1045,10 +1178,7 @@ dns_check_entry(u8_t i)
             entry->retries = 0;
           } else {
             LWIP_DEBUGF(DNS_DEBUG, ("dns_check_entry: \"%s\": timeout\n", entry->name));
-            /* call specified callback function if provided */
-            dns_call_found(i, NULL);
-            /* flush this entry */
-            entry->state = DNS_STATE_UNUSED;
+            dns_fail_entry(i, 0);
             break;
           }
         } else {
@@ -1065,6 +1195,7 @@ dns_check_entry(u8_t i)
       }
       break;
     case DNS_STATE_DONE:
+    case DNS_STATE_NEGATIVE:
       /* if the time to live is nul */
       if ((entry->ttl == 0) || (--entry->ttl == 0)) {
         LWIP_DEBUGF(DNS_DEBUG, ("dns_check_entry: \"%s\": flush\n", entry->name));
@@ -1113,6 +1244,9 @@ dns_correct_response(u8_t idx, u32_t ttl)
   if (entry->ttl > DNS_MAX_TTL) {
     entry->ttl = DNS_MAX_TTL;
   }
+#if DNS_PREFETCH
+  entry->prefetch_ttl = entry->ttl / 10;
+#endif
   dns_call_found(idx, &entry->ipaddr);
 
   if (entry->ttl == 0) {
@@ -1139,6 +1273,7 @@ dns_recv(void *arg, struct udp_pcb *pcb, struct pbuf *p, const ip_addr_t *addr,
   struct dns_answer ans;
   struct dns_query qry;
   u16_t nquestions, nanswers;
+  u8_t negative;
 
   LWIP_UNUSED_ARG(arg);
   LWIP_UNUSED_ARG(pcb);
@@ -1157,7 +1292,7 @@ dns_recv(void *arg, struct udp_pcb *pcb, struct pbuf *p, const ip_addr_t *addr,
     txid = lwip_htons(hdr.id);
     for (i = 0; i < DNS_TABLE_SIZE; i++) {
       const struct dns_table_entry *entry = &dns_table[i];
-      if ((entry->state == DNS_STATE_ASKING) &&
+      if (((entry->state == DNS_STATE_ASKING) || (entry->state == DNS_STATE_REFRESH)) &&
           (entry->txid == txid)) {
 
         /* We only care about the question(s) and the answers. The authrr
@@ -1210,6 +1345,8 @@ dns_recv(void *arg, struct udp_pcb *pcb, struct pbuf *p, const ip_addr_t *addr,
         /* Check for error. If so, call callback to inform. */
         if (hdr.flags2 & DNS_FLAG2_ERR_MASK) {
           LWIP_DEBUGF(DNS_DEBUG, ("dns_recv: \"%s\": error in flags\n", entry->name));
+          /* only "no such name" is an answer, other errors are server failures */
+          negative = ((hdr.flags2 & DNS_FLAG2_ERR_MASK) == DNS_FLAG2_ERR_NAME);
         } else {
           while ((nanswers > 0) && (res_idx < p->tot_len)) {
             /* skip answer resource record's host name */
@@ -1288,11 +1425,12 @@ dns_recv(void *arg, struct udp_pcb *pcb, struct pbuf *p, const ip_addr_t *addr,
           }
 #endif /* LWIP_IPV4 && LWIP_IPV6 */
           LWIP_DEBUGF(DNS_DEBUG, ("dns_recv: \"%s\": error in response\n", entry->name));
+          /* no address of the requested type */
+          negative = 1;
         }
         /* call callback to indicate error, clean up memory and return */
         pbuf_free(p);
-        dns_call_found(i, NULL);
-        dns_table[i].state = DNS_STATE_UNUSED;
+        dns_fail_entry(i, negative);
         return;
       }
     }
@@ -1363,9 +1501,10 @@ dns_enqueue(const char *name, size_t hostnamelen, dns_found_callback found,
       break;
     }
     /* check if this is the oldest completed entry */
-    if (entry->state == DNS_STATE_DONE) {
+    if ((entry->state == DNS_STATE_DONE) || (entry->state == DNS_STATE_NEGATIVE)) {
       u8_t age = dns_seqno - entry->seqno;
-      if (age > lseq) {
+      /* lookups refresh seqno, so all completed entries can be of age 0 */
+      if ((age > lseq) || (lseqi == DNS_TABLE_SIZE)) {
         lseq = age;
         lseqi = i;
       }
@@ -1374,7 +1513,7 @@ dns_enqueue(const char *name, size_t hostnamelen, dns_found_callback found,
 
   /* if we don't have found an unused entry, use the oldest completed one */
   if (i == DNS_TABLE_SIZE) {
-    if ((lseqi >= DNS_TABLE_SIZE) || (dns_table[lseqi].state != DNS_STATE_DONE)) {
+    if (lseqi >= DNS_TABLE_SIZE) {
       /* no entry can be used now, table is full */
       LWIP_DEBUGF(DNS_DEBUG, ("dns_enqueue: \"%s\": DNS entries table is full\n", name));
       return ERR_MEM;
@@ -1412,6 +1551,7 @@ dns_enqueue(const char *name, size_t hostnamelen, dns_found_callback found,
   entry->state = DNS_STATE_NEW;
   entry->seqno = dns_seqno;
   LWIP_DNS_SET_ADDRTYPE(entry->reqaddrtype, dns_addrtype);
+  LWIP_DNS_SET_ADDRTYPE(entry->qaddrtype, dns_addrtype);
   LWIP_DNS_SET_ADDRTYPE(req->reqaddrtype, dns_addrtype);
   req->found = found;
   req->arg   = callback_arg;
@@ -1490,6 +1630,7 @@ dns_gethostbyname_addrtype(const char *hostname, ip_addr_t *addr, dns_found_call
                            void *callback_arg, u8_t dns_addrtype)
 {
   size_t hostnamelen;
+  err_t err;
 #if LWIP_DNS_SUPPORT_MDNS_QUERIES
   u8_t is_mdns;
 #endif
@@ -1529,8 +1670,10 @@ dns_gethostbyname_addrtype(const char *hostname, ip_addr_t *addr, dns_found_call
     }
   }
   /* already have this address cached? */
-  if (dns_lookup(hostname, addr LWIP_DNS_ADDRTYPE_ARG(dns_addrtype)) == ERR_OK) {
-    return ERR_OK;
+  err = dns_lookup(hostname, addr LWIP_DNS_ADDRTYPE_ARG(dns_addrtype));
+  if (err != ERR_ARG) {
+    /* ERR_OK, or ERR_VAL for a name known not to exist */
+    return err;
   }
 #if LWIP_IPV4 && LWIP_IPV6
   if ((dns_addrtype == LWIP_DNS_ADDRTYPE_IPV4_IPV6) || (dns_addrtype == LWIP_DNS_ADDRTYPE_IPV6_IPV4)) {
@@ -1566,6 +1709,7 @@ dns_gethostbyname_addrtype(const char *hostname, ip_addr_t *addr, dns_found_call
   }
 
   /* queue query with specified callback */
+  NETSTATS_INC(dns_misses);
   return dns_enqueue(hostname, hostnamelen, found, callback_arg LWIP_DNS_ADDRTYPE_ARG(dns_addrtype)
      LWIP_DNS_ISMDNS_ARG(is_mdns));
 }
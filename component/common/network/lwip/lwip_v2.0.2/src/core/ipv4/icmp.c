@@ -147,6 +147,7 @@ icmp_input(struct pbuf *p, struct netif *inp)
         pbuf_free(p);
         ICMP_STATS_INC(icmp.chkerr);
         MIB2_STATS_INC(mib2.icmpinerrors);
+        NETSTATS_INC(chksum_err);
         return;
       }
     }
@@ -464,6 +464,7 @@ ip4_input(struct pbuf *p, struct netif *inp)
       pbuf_free(p);
       IP_STATS_INC(ip.chkerr);
       IP_STATS_INC(ip.drop);
+      NETSTATS_INC(chksum_err);
       MIB2_STATS_INC(mib2.ipinhdrerrors);
       return ERR_OK;
     }
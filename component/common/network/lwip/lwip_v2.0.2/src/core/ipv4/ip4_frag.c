@@ -147,6 +147,7 @@ ip_reass_tmr(void)
       r = r->next;
       /* free the helper struct and all enqueued pbufs */
       ip_reass_free_complete_datagram(tmp, prev);
+      NETSTATS_INC(reass_timeout);
      }
    }
 }
@@ -131,6 +131,7 @@ ip6_reass_tmr(void)
       r = r->next;
       /* free the helper struct and all enqueued pbufs */
       ip6_reass_free_complete_datagram(tmp);
+      NETSTATS_INC(reass_timeout);
      }
    }
 }
@@ -173,6 +173,7 @@ pbuf_free_ooseq(void)
       LWIP_DEBUGF(PBUF_DEBUG | LWIP_DBG_TRACE, ("pbuf_free_ooseq: freeing out-of-sequence pbufs\n"));
       tcp_segs_free(pcb->ooseq);
       pcb->ooseq = NULL;
+      NETSTATS_INC(tcp_ooseq_drop);
       return;
     }
   }
@@ -286,6 +287,7 @@ pbuf_alloc(pbuf_layer layer, u16_t length, pbuf_type type)
     LWIP_DEBUGF(PBUF_DEBUG | LWIP_DBG_TRACE, ("pbuf_alloc: allocated pbuf %p\n", (void *)p));
     if (p == NULL) {
       PBUF_POOL_IS_EMPTY();
+      NETSTATS_INC_PROTECTED(pbuf_alloc_fail);
       return NULL;
     }
     p->type = type;
@@ -319,6 +321,7 @@ pbuf_alloc(pbuf_layer layer, u16_t length, pbuf_type type)
       q = (struct pbuf *)memp_malloc(MEMP_PBUF_POOL);
       if (q == NULL) {
         PBUF_POOL_IS_EMPTY();
+        NETSTATS_INC_PROTECTED(pbuf_alloc_fail);
         /* free chain so far allocated */
         pbuf_free(p);
         /* bail out unsuccessfully */
@@ -364,6 +367,7 @@ pbuf_alloc(pbuf_layer layer, u16_t length, pbuf_type type)
     }
 
     if (p == NULL) {
+      NETSTATS_INC_PROTECTED(pbuf_alloc_fail);
       return NULL;
     }
     /* Set up internal structure of the pbuf. */
@@ -385,6 +389,7 @@ pbuf_alloc(pbuf_layer layer, u16_t length, pbuf_type type)
       LWIP_DEBUGF(PBUF_DEBUG | LWIP_DBG_LEVEL_SERIOUS,
                   ("pbuf_alloc: Could not allocate MEMP_PBUF for PBUF_%s.\n",
                   (type == PBUF_ROM) ? "ROM" : "REF"));
+      NETSTATS_INC_PROTECTED(pbuf_alloc_fail);
       return NULL;
     }
     /* caller must set this field properly, afterwards */
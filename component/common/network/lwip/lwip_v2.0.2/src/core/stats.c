@@ -38,6 +38,44 @@
 
 #include "lwip/opt.h"
 
+#if LWIP_NETSTATS
+
+#include "lwip/stats.h"
+#include "lwip/sys.h"
+
+#include <string.h>
+
+struct stats_net lwip_netstats;
+
+/**
+ * Copy the LWIP_NETSTATS counters, callable from any task
+ */
+void
+netstats_get(struct stats_net *stats)
+{
+  SYS_ARCH_DECL_PROTECT(lev);
+
+  SYS_ARCH_PROTECT(lev);
+  *stats = lwip_netstats;
+  SYS_ARCH_UNPROTECT(lev);
+}
+
+/**
+ * Clear the LWIP_NETSTATS counters. An increment that runs at the same time
+ * without the protection may be lost or survive the reset.
+ */
+void
+netstats_reset(void)
+{
+  SYS_ARCH_DECL_PROTECT(lev);
+
+  SYS_ARCH_PROTECT(lev);
+  memset(&lwip_netstats, 0, sizeof(lwip_netstats));
+  SYS_ARCH_UNPROTECT(lev);
+}
+
+#endif /* LWIP_NETSTATS */
+
 #if LWIP_STATS /* don't build if not configured for use in lwipopts.h */
 
 #include "lwip/def.h"
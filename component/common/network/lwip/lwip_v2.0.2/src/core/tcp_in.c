@@ -79,12 +79,23 @@ static u8_t flags;
 static u8_t recv_flags;
 static struct pbuf *recv_data;
 
+#if LWIP_TCP_SACK_IN
+/* SACK blocks of the incoming segment (left and right edges, host order),
+   set by tcp_parseopt() */
+static u8_t tcp_sack_num;
+static u32_t tcp_sack_edges[2 * 4];
+#endif /* LWIP_TCP_SACK_IN */
+
 struct tcp_pcb *tcp_input_pcb;
 
 /* Forward declarations. */
 static err_t tcp_process(struct tcp_pcb *pcb);
 static void tcp_receive(struct tcp_pcb *pcb);
 static void tcp_parseopt(struct tcp_pcb *pcb);
+#if LWIP_TCP_SACK_IN
+static void tcp_receive_sack(struct tcp_pcb *pcb);
+static u8_t tcp_sack_early_rexmit(struct tcp_pcb *pcb);
+#endif /* LWIP_TCP_SACK_IN */
 
 static void tcp_listen_input(struct tcp_pcb_listen *pcb);
 static void tcp_timewait_input(struct tcp_pcb *pcb);
@@ -150,6 +161,7 @@ tcp_input(struct pbuf *p, struct netif *inp)
           chksum));
       tcp_debug_print(tcphdr);
       TCP_STATS_INC(tcp.chkerr);
+      NETSTATS_INC(chksum_err);
       goto dropped;
     }
   }
@@ -1025,9 +1037,13 @@ tcp_receive(struct tcp_pcb *pcb)
   u16_t new_tot_len;
   int found_dupack = 0;
 #if TCP_OOSEQ_MAX_BYTES || TCP_OOSEQ_MAX_PBUFS
-  u32_t ooseq_blen;
-  u16_t ooseq_qlen;
+  u32_t ooseq_blen, ooseq_max_blen;
+  u16_t ooseq_qlen, ooseq_max_qlen;
 #endif /* TCP_OOSEQ_MAX_BYTES || TCP_OOSEQ_MAX_PBUFS */
+#if LWIP_TCP_SACK_IN
+  u8_t partial_ack = 0;
+  u32_t acked;
+#endif /* LWIP_TCP_SACK_IN */
 
   LWIP_ASSERT("tcp_receive: wrong state", pcb->state >= ESTABLISHED);
 
@@ -1068,6 +1084,10 @@ tcp_receive(struct tcp_pcb *pcb)
 #endif /* TCP_WND_DEBUG */
     }
 
+#if LWIP_TCP_SACK_IN
+    tcp_receive_sack(pcb);
+#endif /* LWIP_TCP_SACK_IN */
+
     /* (From Stevens TCP/IP Illustrated Vol II, p970.) Its only a
      * duplicate ack if:
      * 1) It doesn't ACK new data
@@ -1102,6 +1122,17 @@ tcp_receive(struct tcp_pcb *pcb)
               if ((u8_t)(pcb->dupacks + 1) > pcb->dupacks) {
                 ++pcb->dupacks;
               }
+#if LWIP_TCP_SACK_IN
+              if (pcb->flags & TF_INFR) {
+                /* In fast recovery every duplicate ACK lets one segment out:
+                   the next hole if the SACK blocks show one, new data
+                   (by inflating the congestion window) otherwise */
+                if ((tcp_rexmit_sack(pcb, 0) != ERR_OK) &&
+                    ((tcpwnd_size_t)(pcb->cwnd + pcb->mss) > pcb->cwnd)) {
+                  pcb->cwnd += pcb->mss;
+                }
+              } else
+#endif /* LWIP_TCP_SACK_IN */
               if (pcb->dupacks > 3) {
                 /* Inflate the congestion window, but not if it means that
                    the value overflows. */
@@ -1112,6 +1143,13 @@ tcp_receive(struct tcp_pcb *pcb)
                 /* Do fast retransmit */
                 tcp_rexmit_fast(pcb);
               }
+#if LWIP_TCP_SACK_IN
+              else if (tcp_sack_early_rexmit(pcb)) {
+                /* Fewer than four segments in flight never give three
+                   duplicate ACKs: retransmit early (RFC 5827) */
+                tcp_rexmit_fast(pcb);
+              }
+#endif /* LWIP_TCP_SACK_IN */
             }
           }
         }
@@ -1128,8 +1166,23 @@ tcp_receive(struct tcp_pcb *pcb)
          in fast retransmit. Also reset the congestion window to the
          slow start threshold. */
       if (pcb->flags & TF_INFR) {
-        pcb->flags &= ~TF_INFR;
-        pcb->cwnd = pcb->ssthresh;
+#if LWIP_TCP_SACK_IN
+        if (TCP_SEQ_LT(ackno, pcb->snd_recover)) {
+          /* Partial ACK (RFC 6582): stay in fast recovery, deflate the
+             congestion window by the amount of new data acknowledged and
+             add back one segment. The next hole is retransmitted below. */
+          partial_ack = 1;
+          acked = ackno - pcb->lastack;
+          pcb->cwnd = (pcb->cwnd > acked) ? (tcpwnd_size_t)(pcb->cwnd - acked) : 0;
+          if ((tcpwnd_size_t)(pcb->cwnd + pcb->mss) > pcb->cwnd) {
+            pcb->cwnd += pcb->mss;
+          }
+        } else
+#endif /* LWIP_TCP_SACK_IN */
+        {
+          pcb->flags &= ~TF_INFR;
+          pcb->cwnd = pcb->ssthresh;
+        }
       }
 
       /* Reset the number of retransmissions. */
@@ -1144,7 +1197,11 @@ tcp_receive(struct tcp_pcb *pcb)
 
       /* Update the congestion control variables (cwnd and
          ssthresh). */
-      if (pcb->state >= ESTABLISHED) {
+      if ((pcb->state >= ESTABLISHED)
+#if LWIP_TCP_SACK_IN
+          && !partial_ack
+#endif /* LWIP_TCP_SACK_IN */
+         ) {
         if (pcb->cwnd < pcb->ssthresh) {
           if ((tcpwnd_size_t)(pcb->cwnd + pcb->mss) > pcb->cwnd) {
             pcb->cwnd += pcb->mss;
@@ -1204,6 +1261,13 @@ tcp_receive(struct tcp_pcb *pcb)
 
       pcb->polltmr = 0;
 
+#if LWIP_TCP_SACK_IN
+      if (partial_ack) {
+        /* tcp_output() sends it once the input processing is done */
+        tcp_rexmit_sack(pcb, 1);
+      }
+#endif /* LWIP_TCP_SACK_IN */
+
 #if LWIP_IPV6 && LWIP_ND6_TCP_REACHABILITY_HINTS
       if (ip_current_is_v6()) {
         /* Inform neighbor reachability of forward progress. */
@@ -1536,6 +1600,13 @@ tcp_receive(struct tcp_pcb *pcb)
 
         /* Acknowledge the segment(s). */
         tcp_ack(pcb);
+#if LWIP_TCP_SACK_OUT
+        if ((pcb->flags & TF_SACK) && (pcb->ooseq != NULL)) {
+          /* A hole was filled but others remain: SACK blocks are only sent
+             in empty ACKs, so send this one right away */
+          tcp_send_empty_ack(pcb);
+        }
+#endif /* LWIP_TCP_SACK_OUT */
 
 #if LWIP_IPV6 && LWIP_ND6_TCP_REACHABILITY_HINTS
         if (ip_current_is_v6()) {
@@ -1546,7 +1617,6 @@ tcp_receive(struct tcp_pcb *pcb)
 
       } else {
         /* We get here if the incoming segment is out-of-sequence. */
-        tcp_send_empty_ack(pcb);
 #if TCP_QUEUE_OOSEQ
         /* We queue the segment on the ->ooseq queue. */
         if (pcb->ooseq == NULL) {
@@ -1671,7 +1741,10 @@ tcp_receive(struct tcp_pcb *pcb)
         }
 #if TCP_OOSEQ_MAX_BYTES || TCP_OOSEQ_MAX_PBUFS
         /* Check that the data on ooseq doesn't exceed one of the limits
-           and throw away everything above that limit. */
+           and throw away everything above that limit. A limit of 0 means
+           no limit. */
+        ooseq_max_blen = TCP_OOSEQ_MAX_BYTES ? (u32_t)TCP_OOSEQ_BYTES_LIMIT(pcb) : 0xFFFFFFFFUL;
+        ooseq_max_qlen = TCP_OOSEQ_MAX_PBUFS ? (u16_t)TCP_OOSEQ_PBUFS_LIMIT(pcb) : 0xFFFF;
         ooseq_blen = 0;
         ooseq_qlen = 0;
         prev = NULL;
@@ -1679,10 +1752,11 @@ tcp_receive(struct tcp_pcb *pcb)
           struct pbuf *p = next->p;
           ooseq_blen += p->tot_len;
           ooseq_qlen += pbuf_clen(p);
-          if ((ooseq_blen > TCP_OOSEQ_MAX_BYTES) ||
-              (ooseq_qlen > TCP_OOSEQ_MAX_PBUFS)) {
+          if ((ooseq_blen > ooseq_max_blen) ||
+              (ooseq_qlen > ooseq_max_qlen)) {
              /* too much ooseq data, dump this and everything after it */
              tcp_segs_free(next);
+             NETSTATS_INC(tcp_ooseq_drop);
              if (prev == NULL) {
                /* first ooseq segment is too much, dump the whole queue */
                pcb->ooseq = NULL;
@@ -1694,7 +1768,14 @@ tcp_receive(struct tcp_pcb *pcb)
           }
         }
 #endif /* TCP_OOSEQ_MAX_BYTES || TCP_OOSEQ_MAX_PBUFS */
+#if LWIP_TCP_SACK_OUT
+        /* The block holding this segment is reported first */
+        pcb->rcv_sack_seqno = seqno;
+#endif /* LWIP_TCP_SACK_OUT */
 #endif /* TCP_QUEUE_OOSEQ */
+        /* Acknowledge the out-of-sequence segment at once (with the
+           SACK blocks of the updated ->ooseq queue) */
+        tcp_send_empty_ack(pcb);
       }
     } else {
       /* The incoming segment is not within the window. */
@@ -1709,6 +1790,81 @@ tcp_receive(struct tcp_pcb *pcb)
   }
 }
 
+#if LWIP_TCP_SACK_IN
+/**
+ * Updates the SACK scoreboard from the SACK blocks of the incoming segment:
+ * marks the unacked segments the peer has received and advances
+ * snd_sack_high, the highest sequence number SACKed.
+ *
+ * Called from tcp_receive() before the ACK is processed.
+ *
+ * @param pcb the tcp_pcb for which a segment arrived
+ */
+static void
+tcp_receive_sack(struct tcp_pcb *pcb)
+{
+  struct tcp_seg *seg;
+  u32_t left, right, seg_seqno;
+  u8_t i;
+
+  if (!TCP_SEQ_BETWEEN(pcb->snd_sack_high, pcb->lastack, pcb->snd_nxt)) {
+    pcb->snd_sack_high = pcb->lastack;
+  }
+
+  for (i = 0; i < tcp_sack_num; i++) {
+    left = tcp_sack_edges[2 * i];
+    right = tcp_sack_edges[2 * i + 1];
+    /* Skip D-SACKs (RFC 2883) and blocks outside of the data in flight */
+    if (!TCP_SEQ_LT(left, right) || TCP_SEQ_LT(left, ackno) ||
+        TCP_SEQ_GT(right, pcb->snd_nxt)) {
+      continue;
+    }
+    LWIP_DEBUGF(TCP_FR_DEBUG, ("tcp_receive_sack: SACK %"U32_F":%"U32_F"\n", left, right));
+    if (TCP_SEQ_GT(right, pcb->snd_sack_high)) {
+      pcb->snd_sack_high = right;
+    }
+    for (seg = pcb->unacked; seg != NULL; seg = seg->next) {
+      seg_seqno = lwip_ntohl(seg->tcphdr->seqno);
+      if (TCP_SEQ_GEQ(seg_seqno, right)) {
+        break;
+      }
+      if (TCP_SEQ_GEQ(seg_seqno, left) &&
+          TCP_SEQ_LEQ(seg_seqno + TCP_TCPLEN(seg), right)) {
+        seg->flags |= TF_SEG_SACKED;
+      }
+    }
+  }
+}
+
+/**
+ * SACK-based early retransmit (RFC 5827): with fewer than four segments in
+ * flight and no new data to send, the first unacked segment is considered
+ * lost once all the segments after it have been SACKed.
+ *
+ * @param pcb the tcp_pcb that received a duplicate ACK
+ * @return 1 if the first unacked segment should be retransmitted
+ */
+static u8_t
+tcp_sack_early_rexmit(struct tcp_pcb *pcb)
+{
+  struct tcp_seg *seg;
+  u8_t oseg = 0, sacked = 0;
+
+  if (!(pcb->flags & TF_SACK) || (pcb->unsent != NULL)) {
+    return 0;
+  }
+  for (seg = pcb->unacked; seg != NULL; seg = seg->next) {
+    if (++oseg > 3) {
+      return 0;
+    }
+    if (seg->flags & TF_SEG_SACKED) {
+      sacked++;
+    }
+  }
+  return (oseg > 1) && (sacked == oseg - 1) && !(pcb->unacked->flags & TF_SEG_SACKED);
+}
+#endif /* LWIP_TCP_SACK_IN */
+
 static u8_t
 tcp_getoptbyte(void)
 {
@@ -1725,7 +1881,7 @@ tcp_getoptbyte(void)
  * Parses the options contained in the incoming segment.
  *
  * Called from tcp_listen_input() and tcp_process().
- * Currently, only the MSS option is supported!
+ * Supports the MSS, window scale, timestamp, SACK-permitted and SACK options.
  *
  * @param pcb the tcp_pcb for which a segment arrived
  */
@@ -1737,6 +1893,12 @@ tcp_parseopt(struct tcp_pcb *pcb)
 #if LWIP_TCP_TIMESTAMPS
   u32_t tsval;
 #endif
+#if LWIP_TCP_SACK_IN
+  u32_t edge;
+  u8_t i;
+
+  tcp_sack_num = 0;
+#endif
 
   /* Parse the TCP MSS option, if present. */
   if (tcphdr_optlen != 0) {
@@ -1814,6 +1976,44 @@ tcp_parseopt(struct tcp_pcb *pcb)
         /* Advance to next option (6 bytes already read) */
         tcp_optidx += LWIP_TCP_OPT_LEN_TS - 6;
         break;
+#endif
+#if LWIP_TCP_SACK_OUT || LWIP_TCP_SACK_IN
+      case LWIP_TCP_OPT_SACK_PERM:
+        LWIP_DEBUGF(TCP_INPUT_DEBUG, ("tcp_parseopt: SACK_PERM\n"));
+        if (tcp_getoptbyte() != LWIP_TCP_OPT_LEN_SACK_PERM || (tcp_optidx - 2 + LWIP_TCP_OPT_LEN_SACK_PERM) > tcphdr_optlen) {
+          /* Bad length */
+          LWIP_DEBUGF(TCP_INPUT_DEBUG, ("tcp_parseopt: bad length\n"));
+          return;
+        }
+        /* SACK is only negotiated in the SYN and SYN/ACK */
+        if (flags & TCP_SYN) {
+          pcb->flags |= TF_SACK;
+        }
+        break;
+#endif
+#if LWIP_TCP_SACK_IN
+      case LWIP_TCP_OPT_SACK:
+        LWIP_DEBUGF(TCP_INPUT_DEBUG, ("tcp_parseopt: SACK\n"));
+        data = tcp_getoptbyte();
+        /* kind, length and 1 to 4 blocks of 8 bytes */
+        if ((data < 2 + 8) || (((data - 2) & 7) != 0) ||
+            (tcp_optidx - 2 + data) > tcphdr_optlen) {
+          /* Bad length */
+          LWIP_DEBUGF(TCP_INPUT_DEBUG, ("tcp_parseopt: bad length\n"));
+          return;
+        }
+        /* Left and right edge of each block, in network order */
+        for (i = 0; i < (data - 2) / 4; i++) {
+          edge = (u32_t)tcp_getoptbyte() << 24;
+          edge |= (u32_t)tcp_getoptbyte() << 16;
+          edge |= (u32_t)tcp_getoptbyte() << 8;
+          edge |= tcp_getoptbyte();
+          if (i < LWIP_ARRAYSIZE(tcp_sack_edges)) {
+            tcp_sack_edges[i] = edge;
+          }
+        }
+        tcp_sack_num = (u8_t)LWIP_MIN((data - 2) / 8, LWIP_ARRAYSIZE(tcp_sack_edges) / 2);
+        break;
 #endif
       default:
         LWIP_DEBUGF(TCP_INPUT_DEBUG, ("tcp_parseopt: other\n"));
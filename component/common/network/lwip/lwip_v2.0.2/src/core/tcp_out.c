@@ -817,6 +817,12 @@ tcp_enqueue_flags(struct tcp_pcb *pcb, u8_t flags)
       optflags |= TF_SEG_OPTS_WND_SCALE;
     }
 #endif /* LWIP_WND_SCALE */
+#if LWIP_TCP_SACK_OUT || LWIP_TCP_SACK_IN
+    if ((pcb->state != SYN_RCVD) || (pcb->flags & TF_SACK)) {
+      /* In a <SYN,ACK>, SACK permitted may only be sent if we received it */
+      optflags |= TF_SEG_OPTS_SACK_PERM;
+    }
+#endif /* LWIP_TCP_SACK_OUT || LWIP_TCP_SACK_IN */
   }
 #if LWIP_TCP_TIMESTAMPS
   if ((pcb->flags & TF_TIMESTAMP)) {
@@ -913,6 +919,66 @@ tcp_build_wnd_scale_option(u32_t *opts)
 }
 #endif
 
+#if LWIP_TCP_SACK_OUT
+/**
+ * Collect the SACK blocks describing the ooseq queue: contiguous segments
+ * make up one block. The block holding the segment received last goes first
+ * (RFC 2018), the others follow in sequence order.
+ *
+ * @param pcb tcp_pcb
+ * @param edges receives the left and right edge of each block
+ * @param max maximum number of blocks
+ * @return the number of blocks
+ */
+static u8_t
+tcp_get_sack_blocks(struct tcp_pcb *pcb, u32_t *edges, u8_t max)
+{
+  struct tcp_seg *seg;
+  u32_t left, right;
+  u8_t num = 0;
+  u8_t pass;
+
+  /* pass 0 looks for the block of rcv_sack_seqno, pass 1 adds the others */
+  for (pass = 0; pass < 2; pass++) {
+    seg = pcb->ooseq;
+    while ((seg != NULL) && (num < max)) {
+      left = seg->tcphdr->seqno;
+      right = left + TCP_TCPLEN(seg);
+      for (seg = seg->next; (seg != NULL) && (seg->tcphdr->seqno == right); seg = seg->next) {
+        right += TCP_TCPLEN(seg);
+      }
+      if (TCP_SEQ_BETWEEN(pcb->rcv_sack_seqno, left, right - 1) == (pass == 0)) {
+        edges[2 * num] = left;
+        edges[2 * num + 1] = right;
+        num++;
+        if (pass == 0) {
+          break;
+        }
+      }
+    }
+  }
+  return num;
+}
+
+/** Build a SACK option (2 + 8 * num bytes long) at the specified options pointer)
+ *
+ * @param opts option pointer where to store the SACK option
+ * @param edges left and right edges of the blocks, host order
+ * @param num number of blocks
+ */
+static void
+tcp_build_sack_option(u32_t *opts, const u32_t *edges, u8_t num)
+{
+  u8_t i;
+
+  /* Pad with two NOP options to make everything nicely aligned */
+  opts[0] = lwip_htonl(0x01010500 | (2 + 8 * num));
+  for (i = 0; i < 2 * num; i++) {
+    opts[1 + i] = lwip_htonl(edges[i]);
+  }
+}
+#endif /* LWIP_TCP_SACK_OUT */
+
 /**
  * Send an ACK without data.
  *
@@ -925,15 +991,29 @@ tcp_send_empty_ack(struct tcp_pcb *pcb)
   struct pbuf *p;
   u8_t optlen = 0;
   struct netif *netif;
-#if LWIP_TCP_TIMESTAMPS || CHECKSUM_GEN_TCP
+#if LWIP_TCP_TIMESTAMPS || CHECKSUM_GEN_TCP || LWIP_TCP_SACK_OUT
   struct tcp_hdr *tcphdr;
-#endif /* LWIP_TCP_TIMESTAMPS || CHECKSUM_GEN_TCP */
+#endif /* LWIP_TCP_TIMESTAMPS || CHECKSUM_GEN_TCP || LWIP_TCP_SACK_OUT */
+#if LWIP_TCP_SACK_OUT
+  u32_t sack_edges[2 * LWIP_TCP_MAX_SACK_NUM];
+  u8_t sack_num = 0;
+#endif /* LWIP_TCP_SACK_OUT */
 
 #if LWIP_TCP_TIMESTAMPS
   if (pcb->flags & TF_TIMESTAMP) {
     optlen = LWIP_TCP_OPT_LENGTH(TF_SEG_OPTS_TS);
   }
 #endif
+#if LWIP_TCP_SACK_OUT
+  if ((pcb->flags & TF_SACK) && (pcb->ooseq != NULL)) {
+    /* as many blocks as fit into the 40 bytes of options */
+    sack_num = tcp_get_sack_blocks(pcb, sack_edges,
+      (u8_t)LWIP_MIN(LWIP_TCP_MAX_SACK_NUM, (40 - optlen - 4) / 8));
+    if (sack_num > 0) {
+      optlen += LWIP_TCP_OPT_LEN_SACK_OUT(sack_num);
+    }
+  }
+#endif /* LWIP_TCP_SACK_OUT */
 
   p = tcp_output_alloc_header(pcb, optlen, 0, lwip_htonl(pcb->snd_nxt));
   if (p == NULL) {
@@ -942,9 +1022,9 @@ tcp_send_empty_ack(struct tcp_pcb *pcb)
     LWIP_DEBUGF(TCP_OUTPUT_DEBUG, ("tcp_output: (ACK) could not allocate pbuf\n"));
     return ERR_BUF;
   }
-#if LWIP_TCP_TIMESTAMPS || CHECKSUM_GEN_TCP
+#if LWIP_TCP_TIMESTAMPS || CHECKSUM_GEN_TCP || LWIP_TCP_SACK_OUT
   tcphdr = (struct tcp_hdr *)p->payload;
-#endif /* LWIP_TCP_TIMESTAMPS || CHECKSUM_GEN_TCP */
+#endif /* LWIP_TCP_TIMESTAMPS || CHECKSUM_GEN_TCP || LWIP_TCP_SACK_OUT */
   LWIP_DEBUGF(TCP_OUTPUT_DEBUG,
               ("tcp_output: sending ACK for %"U32_F"\n", pcb->rcv_nxt));
 
@@ -956,6 +1036,13 @@ tcp_send_empty_ack(struct tcp_pcb *pcb)
     tcp_build_timestamp_option(pcb, (u32_t *)(tcphdr + 1));
   }
 #endif
+#if LWIP_TCP_SACK_OUT
+  if (sack_num > 0) {
+    /* the SACK blocks follow the timestamp option, if any */
+    tcp_build_sack_option((u32_t *)(void *)((u8_t *)(tcphdr + 1) + optlen - LWIP_TCP_OPT_LEN_SACK_OUT(sack_num)),
+      sack_edges, sack_num);
+  }
+#endif /* LWIP_TCP_SACK_OUT */
 
   netif = ip_route(&pcb->local_ip, &pcb->remote_ip);
   if (netif == NULL) {
@@ -1249,6 +1336,13 @@ tcp_output_segment(struct tcp_seg *seg, struct tcp_pcb *pcb, struct netif *netif
     opts += 1;
   }
 #endif
+#if LWIP_TCP_SACK_OUT || LWIP_TCP_SACK_IN
+  if (seg->flags & TF_SEG_OPTS_SACK_PERM) {
+    /* Pad with two NOP options to make everything nicely aligned */
+    *opts = PP_HTONL(0x01010402);
+    opts += 1;
+  }
+#endif /* LWIP_TCP_SACK_OUT || LWIP_TCP_SACK_IN */
 
   /* Set retransmission timer running if it is not currently enabled
      This must be set before checking the route. */
@@ -1408,8 +1502,22 @@ tcp_rexmit_rto(struct tcp_pcb *pcb)
     return;
   }
 
-  /* Move all unacked segments to the head of the unsent queue */
-  for (seg = pcb->unacked; seg->next != NULL; seg = seg->next);
+#if LWIP_TCP_SACK_IN
+  /* A timeout ends fast recovery and the SACK information is dropped, the
+     receiver may have discarded SACKed data (RFC 2018, section 8) */
+  pcb->flags &= ~TF_INFR;
+  pcb->snd_sack_high = pcb->lastack;
+  for (seg = pcb->unacked; seg != NULL; seg = seg->next) {
+    seg->flags &= ~TF_SEG_SACKED;
+  }
+#endif /* LWIP_TCP_SACK_IN */
+
+  /* Move all unacked segments to the head of the unsent queue, they are all
+     sent again */
+  NETSTATS_INC(tcp_rexmit);
+  for (seg = pcb->unacked; seg->next != NULL; seg = seg->next) {
+    NETSTATS_INC(tcp_rexmit);
+  }
   /* concatenate unsent queue after unacked queue */
   seg->next = pcb->unsent;
 #if TCP_OVERSIZE_DBGCHECK
@@ -1480,11 +1588,77 @@ tcp_rexmit(struct tcp_pcb *pcb)
 
   /* Do the actual retransmission. */
   MIB2_STATS_INC(mib2.tcpretranssegs);
+  NETSTATS_INC(tcp_rexmit);
   /* No need to call tcp_output: we are always called from tcp_input()
      and thus tcp_output directly returns. */
 }
 
 
+#if LWIP_TCP_SACK_IN
+/**
+ * Requeue the next hole of the unacked queue for retransmission in fast
+ * recovery: the first segment that was neither SACKed nor retransmitted in
+ * this recovery, if SACKed data above it shows that it was lost, or if it is
+ * the first unacked segment after a partial ACK.
+ *
+ * Called by tcp_receive() for duplicate and partial ACKs in fast recovery.
+ *
+ * @param pcb the tcp_pcb for which to retransmit a hole
+ * @param partial_ack 1 if called for a partial ACK
+ * @return ERR_OK if a segment was requeued, ERR_VAL if there is no hole
+ */
+err_t
+tcp_rexmit_sack(struct tcp_pcb *pcb, u8_t partial_ack)
+{
+  struct tcp_seg *seg;
+  struct tcp_seg **prev_seg;
+  struct tcp_seg **cur_seg;
+  u32_t seqno = 0;
+
+  for (prev_seg = &(pcb->unacked); (seg = *prev_seg) != NULL; prev_seg = &(seg->next)) {
+    seqno = lwip_ntohl(seg->tcphdr->seqno);
+    if (TCP_SEQ_GEQ(seqno, pcb->snd_sack_high) && !(partial_ack && (seg == pcb->unacked))) {
+      /* nothing above is known to have arrived */
+      return ERR_VAL;
+    }
+    if (!(seg->flags & TF_SEG_SACKED) && TCP_SEQ_GEQ(seqno, pcb->snd_sack_rexmit)) {
+      break;
+    }
+  }
+  if (seg == NULL) {
+    return ERR_VAL;
+  }
+
+  LWIP_DEBUGF(TCP_FR_DEBUG, ("tcp_rexmit_sack: retransmit %"U32_F", lastack %"U32_F", SACKed up to %"U32_F"\n",
+                             seqno, pcb->lastack, pcb->snd_sack_high));
+
+  /* Move the segment to the unsent queue, keeping it sorted */
+  *prev_seg = seg->next;
+  pcb->snd_sack_rexmit = seqno + TCP_TCPLEN(seg);
+  cur_seg = &(pcb->unsent);
+  while (*cur_seg &&
+    TCP_SEQ_LT(lwip_ntohl((*cur_seg)->tcphdr->seqno), seqno)) {
+      cur_seg = &((*cur_seg)->next );
+  }
+  seg->next = *cur_seg;
+  *cur_seg = seg;
+#if TCP_OVERSIZE
+  if (seg->next == NULL) {
+    /* the retransmitted segment is last in unsent, so reset unsent_oversize */
+    pcb->unsent_oversize = 0;
+  }
+#endif /* TCP_OVERSIZE */
+
+  /* Don't take any rtt measurements after retransmitting. */
+  pcb->rttest = 0;
+
+  MIB2_STATS_INC(mib2.tcpretranssegs);
+  NETSTATS_INC(tcp_rexmit);
+  /* tcp_input() calls tcp_output() when done with the ACK */
+  return ERR_OK;
+}
+#endif /* LWIP_TCP_SACK_IN */
+
 /**
  * Handle retransmission after three dupacks received
  *
@@ -1500,6 +1674,11 @@ tcp_rexmit_fast(struct tcp_pcb *pcb)
                  "), fast retransmit %"U32_F"\n",
                  (u16_t)pcb->dupacks, pcb->lastack,
                  lwip_ntohl(pcb->unacked->tcphdr->seqno)));
+#if LWIP_TCP_SACK_IN
+    /* Fast recovery lasts until everything sent so far is acknowledged */
+    pcb->snd_recover = pcb->snd_nxt;
+    pcb->snd_sack_rexmit = lwip_ntohl(pcb->unacked->tcphdr->seqno) + TCP_TCPLEN(pcb->unacked);
+#endif /* LWIP_TCP_SACK_IN */
     tcp_rexmit(pcb);
 
     /* Set ssthresh to half of the minimum of the current
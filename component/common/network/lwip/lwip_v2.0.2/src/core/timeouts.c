@@ -108,8 +108,36 @@ const struct lwip_cyclic_timer lwip_cyclic_timers[] = {
 
 #if LWIP_TIMERS && !LWIP_TIMERS_CUSTOM
 
+#if LWIP_TIMERS_WHEEL
+/* The timer wheel: level n has 32 slots of 32^n ms each. A timeout is filed
+ * at the lowest level whose range covers the time left, in the slot of its
+ * expiry time. When sys_check_timeouts() reaches the start of a slot of an
+ * upper level, the timeouts of that slot are filed again one or more levels
+ * down. Level 0 slots are 1 ms, so timeouts expire at the same time as with
+ * the sorted list. */
+#define TIMEOUTS_WHEEL_BITS       5
+#define TIMEOUTS_WHEEL_SLOTS      (1UL << TIMEOUTS_WHEEL_BITS)
+#define TIMEOUTS_WHEEL_MASK       (TIMEOUTS_WHEEL_SLOTS - 1)
+#define TIMEOUTS_WHEEL_LEVELS     5
+#define TIMEOUTS_WHEEL_SHIFT(level) ((level) * TIMEOUTS_WHEEL_BITS)
+/** Timeouts further away are parked in the last slot of the top level and
+ * filed again when that slot begins */
+#define TIMEOUTS_WHEEL_RANGE      (1UL << TIMEOUTS_WHEEL_SHIFT(TIMEOUTS_WHEEL_LEVELS))
+
+/** The slot lists, most recently added timeout first */
+static struct sys_timeo *timeouts_wheel[TIMEOUTS_WHEEL_LEVELS][TIMEOUTS_WHEEL_SLOTS];
+/** Bit n set: slot n of the level is not empty */
+static u32_t timeouts_wheel_used[TIMEOUTS_WHEEL_LEVELS];
+/** Number of timeouts in the wheel */
+static u16_t timeouts_count;
+/** Expiry time of the first timeout if timeouts_count != 0. It may be early
+ * (after sys_untimeout()), never late. sys_timeouts_sleeptime() reads it
+ * from other tasks, so it is written with SYS_ARCH_PROTECT. */
+static u32_t timeouts_deadline;
+#else /* LWIP_TIMERS_WHEEL */
 /** The one and only timeout list */
 static struct sys_timeo *next_timeout;
+#endif /* LWIP_TIMERS_WHEEL */
 static u32_t timeouts_last_time;
 
 #if LWIP_TCP
@@ -182,10 +210,119 @@ void sys_timeouts_init(void)
     sys_timeout(lwip_cyclic_timers[i].interval_ms, cyclic_timer, LWIP_CONST_CAST(void*, &lwip_cyclic_timers[i]));
   }
 
+#if !LWIP_TIMERS_WHEEL
   /* Initialise timestamp for sys_check_timeouts */
   timeouts_last_time = sys_now();
+#endif /* !LWIP_TIMERS_WHEEL */
 }
 
+#if LWIP_TIMERS_WHEEL
+/** Index of the lowest bit set in a non-zero value */
+static u8_t
+sys_timeouts_wheel_ffs(u32_t x)
+{
+  static const u8_t debruijn[32] = {
+    0, 1, 28, 2, 29, 14, 24, 3, 30, 22, 20, 15, 25, 17, 4, 8,
+    31, 27, 13, 23, 21, 19, 16, 7, 26, 12, 18, 6, 11, 5, 10, 9
+  };
+  return debruijn[(u32_t)((x & (0U - x)) * 0x077CB531UL) >> 27];
+}
+
+/** File a timeout according to its time left after timeouts_last_time */
+static void
+sys_timeouts_wheel_add(struct sys_timeo *timeout)
+{
+  u32_t left, when;
+  u8_t level, slot;
+
+  left = timeout->time - timeouts_last_time;
+  if ((s32_t)left < 0) {
+    /* overdue: expires with the next sys_check_timeouts() */
+    left = 0;
+    timeout->time = timeouts_last_time;
+  }
+  when = timeout->time;
+  if (left >= TIMEOUTS_WHEEL_RANGE) {
+    left = TIMEOUTS_WHEEL_RANGE - 1;
+    when = timeouts_last_time + left;
+  }
+  level = 0;
+  while (left >= (1UL << TIMEOUTS_WHEEL_SHIFT(level + 1))) {
+    level++;
+  }
+  slot = (u8_t)((when >> TIMEOUTS_WHEEL_SHIFT(level)) & TIMEOUTS_WHEEL_MASK);
+  timeout->next = timeouts_wheel[level][slot];
+  timeouts_wheel[level][slot] = timeout;
+  timeouts_wheel_used[level] |= 1UL << slot;
+}
+
+/** Unlink the oldest timeout of a slot that is not empty */
+static struct sys_timeo *
+sys_timeouts_wheel_pop(u8_t level, u8_t slot)
+{
+  struct sys_timeo **t = &timeouts_wheel[level][slot];
+  struct sys_timeo *timeout;
+
+  while ((*t)->next != NULL) {
+    t = &(*t)->next;
+  }
+  timeout = *t;
+  *t = NULL;
+  if (timeouts_wheel[level][slot] == NULL) {
+    timeouts_wheel_used[level] &= ~(1UL << slot);
+  }
+  return timeout;
+}
+
+/** Return the next slot of a level that is not empty, and in 'ahead' how many
+ * slot periods of that level it begins after the current one */
+static u8_t
+sys_timeouts_wheel_first(u8_t level, u32_t *ahead)
+{
+  u32_t used = timeouts_wheel_used[level];
+  u8_t start, skip = 0, first;
+
+  start = (u8_t)((timeouts_last_time >> TIMEOUTS_WHEEL_SHIFT(level)) & TIMEOUTS_WHEEL_MASK);
+  if (level > 0) {
+    /* the current slot of an upper level was filed down when it began,
+       timeouts in it now are a full turn away */
+    start = (u8_t)((start + 1) & TIMEOUTS_WHEEL_MASK);
+    skip = 1;
+  }
+  if (start != 0) {
+    used = (used >> start) | (used << (TIMEOUTS_WHEEL_SLOTS - start));
+  }
+  first = sys_timeouts_wheel_ffs(used);
+  *ahead = (u32_t)skip + first;
+  return (u8_t)((start + first) & TIMEOUTS_WHEEL_MASK);
+}
+
+/** Recalculate timeouts_deadline: the first timeout of a level is in its
+ * first slot that is not empty, so only one slot per level is searched */
+static void
+sys_timeouts_wheel_deadline(void)
+{
+  struct sys_timeo *t;
+  u32_t first = 0xffffffff, ahead;
+  u8_t level, slot;
+  SYS_ARCH_DECL_PROTECT(lev);
+
+  for (level = 0; level < TIMEOUTS_WHEEL_LEVELS; level++) {
+    if (timeouts_wheel_used[level] != 0) {
+      slot = sys_timeouts_wheel_first(level, &ahead);
+      for (t = timeouts_wheel[level][slot]; t != NULL; t = t->next) {
+        if (t->time - timeouts_last_time < first) {
+          first = t->time - timeouts_last_time;
+        }
+      }
+    }
+  }
+  SYS_ARCH_PROTECT(lev);
+  timeouts_deadline = timeouts_last_time + first;
+  SYS_ARCH_UNPROTECT(lev);
+}
+#endif /* LWIP_TIMERS_WHEEL */
+
 /**
  * Create a one-shot timer (aka timeout). Timeouts are processed in the
  * following cases:
@@ -204,6 +341,41 @@ void
 sys_timeout(u32_t msecs, sys_timeout_handler handler, void *arg)
 #endif /* LWIP_DEBUG_TIMERNAMES */
 {
+#if LWIP_TIMERS_WHEEL
+  struct sys_timeo *timeout;
+  u32_t now;
+  SYS_ARCH_DECL_PROTECT(lev);
+
+  timeout = (struct sys_timeo *)memp_malloc(MEMP_SYS_TIMEOUT);
+  if (timeout == NULL) {
+    LWIP_ASSERT("sys_timeout: timeout != NULL, pool MEMP_SYS_TIMEOUT is empty", timeout != NULL);
+    return;
+  }
+
+  now = sys_now();
+  if (timeouts_count == 0) {
+    /* empty wheel: start it at the current time */
+    timeouts_last_time = now;
+  }
+
+  timeout->h = handler;
+  timeout->arg = arg;
+  timeout->time = now + msecs;
+#if LWIP_DEBUG_TIMERNAMES
+  timeout->handler_name = handler_name;
+  LWIP_DEBUGF(TIMERS_DEBUG, ("sys_timeout: %p msecs=%"U32_F" handler=%s arg=%p\n",
+    (void *)timeout, msecs, handler_name, (void *)arg));
+#endif /* LWIP_DEBUG_TIMERNAMES */
+
+  sys_timeouts_wheel_add(timeout);
+
+  SYS_ARCH_PROTECT(lev);
+  if ((timeouts_count == 0) || ((s32_t)(timeout->time - timeouts_deadline) < 0)) {
+    timeouts_deadline = timeout->time;
+  }
+  timeouts_count++;
+  SYS_ARCH_UNPROTECT(lev);
+#else /* LWIP_TIMERS_WHEEL */
   struct sys_timeo *timeout, *t;
   u32_t now, diff;
 
@@ -259,6 +431,7 @@ sys_timeout(u32_t msecs, sys_timeout_handler handler, void *arg)
       }
     }
   }
+#endif /* LWIP_TIMERS_WHEEL */
 }
 
 /**
@@ -272,6 +445,30 @@ sys_timeout(u32_t msecs, sys_timeout_handler handler, void *arg)
 void
 sys_untimeout(sys_timeout_handler handler, void *arg)
 {
+#if LWIP_TIMERS_WHEEL
+  struct sys_timeo **prev_t, *t;
+  u32_t used;
+  u8_t level, slot;
+
+  /* all timeouts are searched: only (handler, arg) identifies one */
+  for (level = 0; level < TIMEOUTS_WHEEL_LEVELS; level++) {
+    for (used = timeouts_wheel_used[level]; used != 0; used &= used - 1) {
+      slot = sys_timeouts_wheel_ffs(used);
+      for (prev_t = &timeouts_wheel[level][slot]; *prev_t != NULL; prev_t = &(*prev_t)->next) {
+        t = *prev_t;
+        if ((t->h == handler) && (t->arg == arg)) {
+          *prev_t = t->next;
+          if (timeouts_wheel[level][slot] == NULL) {
+            timeouts_wheel_used[level] &= ~(1UL << slot);
+          }
+          timeouts_count--;
+          memp_free(MEMP_SYS_TIMEOUT, t);
+          return;
+        }
+      }
+    }
+  }
+#else /* LWIP_TIMERS_WHEEL */
   struct sys_timeo *prev_t, *t;
 
   if (next_timeout == NULL) {
@@ -296,6 +493,7 @@ sys_untimeout(sys_timeout_handler handler, void *arg)
     }
   }
   return;
+#endif /* LWIP_TIMERS_WHEEL */
 }
 
 /**
@@ -312,6 +510,82 @@ static
 void
 sys_check_timeouts(void)
 {
+#if !NO_SYS
+  /* With LWIP_TCPIP_CORE_LOCKING, application tasks add and remove timeouts
+     (e.g. tcp_timer_needed() from tcp_write()) with the core locked, so the
+     list is walked and the handlers are called with the core locked. */
+  LOCK_TCPIP_CORE();
+#endif /* !NO_SYS */
+#if LWIP_TIMERS_WHEEL
+  /* Nothing to do before the first timeout: the wheel stays where it is,
+     filing timeouts down can wait until then */
+  if ((timeouts_count != 0) && ((s32_t)(sys_now() - timeouts_deadline) >= 0)) {
+    struct sys_timeo *tmptimeout;
+    sys_timeout_handler handler;
+    void *arg;
+    u32_t now, first, ahead, next;
+    u8_t level, l, slot, s;
+
+    now = sys_now();
+    while (timeouts_count != 0) {
+      /* find the slot to process next, upper levels first on a tie */
+      first = 0xffffffff;
+      level = slot = 0;
+      for (l = TIMEOUTS_WHEEL_LEVELS; l-- > 0; ) {
+        if (timeouts_wheel_used[l] != 0) {
+          s = sys_timeouts_wheel_first(l, &ahead);
+          next = (((timeouts_last_time >> TIMEOUTS_WHEEL_SHIFT(l)) + ahead) << TIMEOUTS_WHEEL_SHIFT(l)) - timeouts_last_time;
+          if (next < first) {
+            first = next;
+            level = l;
+            slot = s;
+          }
+        }
+      }
+      if (now - timeouts_last_time < first) {
+        break;
+      }
+      PBUF_CHECK_FREE_OOSEQ();
+      timeouts_last_time += first;
+      if (level > 0) {
+        /* a slot begins: file its timeouts further down. The current slots
+           of the levels below may begin at the same time, and are filed
+           down now, too, as the next search skips them. */
+        for (l = level; l > 0; l--) {
+          if ((timeouts_last_time & ((1UL << TIMEOUTS_WHEEL_SHIFT(l)) - 1)) != 0) {
+            break;
+          }
+          s = (u8_t)((timeouts_last_time >> TIMEOUTS_WHEEL_SHIFT(l)) & TIMEOUTS_WHEEL_MASK);
+          while (timeouts_wheel[l][s] != NULL) {
+            sys_timeouts_wheel_add(sys_timeouts_wheel_pop(l, s));
+          }
+        }
+        continue;
+      }
+      /* timeout has expired */
+      tmptimeout = sys_timeouts_wheel_pop(0, slot);
+      timeouts_count--;
+      handler = tmptimeout->h;
+      arg = tmptimeout->arg;
+#if LWIP_DEBUG_TIMERNAMES
+      if (handler != NULL) {
+        LWIP_DEBUGF(TIMERS_DEBUG, ("sct calling h=%s arg=%p\n",
+          tmptimeout->handler_name, arg));
+      }
+#endif /* LWIP_DEBUG_TIMERNAMES */
+      memp_free(MEMP_SYS_TIMEOUT, tmptimeout);
+      if (handler != NULL) {
+        handler(arg);
+      }
+      LWIP_TCPIP_THREAD_ALIVE();
+    }
+    /* no slot begins before now */
+    timeouts_last_time = now;
+    if (timeouts_count != 0) {
+      sys_timeouts_wheel_deadline();
+    }
+  }
+#else /* LWIP_TIMERS_WHEEL */
   if (next_timeout) {
     struct sys_timeo *tmptimeout;
     u32_t diff;
@@ -343,21 +617,17 @@ sys_check_timeouts(void)
 #endif /* LWIP_DEBUG_TIMERNAMES */
         memp_free(MEMP_SYS_TIMEOUT, tmptimeout);
         if (handler != NULL) {
-#if !NO_SYS
-          /* For LWIP_TCPIP_CORE_LOCKING, lock the core before calling the
-             timeout handler function. */
-          LOCK_TCPIP_CORE();
-#endif /* !NO_SYS */
           handler(arg);
-#if !NO_SYS
-          UNLOCK_TCPIP_CORE();
-#endif /* !NO_SYS */
         }
         LWIP_TCPIP_THREAD_ALIVE();
       }
     /* repeat until all expired timers have been called */
     } while (had_one);
   }
+#endif /* LWIP_TIMERS_WHEEL */
+#if !NO_SYS
+  UNLOCK_TCPIP_CORE();
+#endif /* !NO_SYS */
 }
 
 /** Set back the timestamp of the last call to sys_check_timeouts()
@@ -368,18 +638,65 @@ sys_check_timeouts(void)
 void
 sys_restart_timeouts(void)
 {
+#if LWIP_TIMERS_WHEEL
+  struct sys_timeo *timeouts = NULL, *t;
+  u32_t now, skipped;
+  u8_t level, slot;
+
+  /* move all timeouts by the time skipped and file them again */
+  now = sys_now();
+  skipped = now - timeouts_last_time;
+  for (level = 0; level < TIMEOUTS_WHEEL_LEVELS; level++) {
+    while (timeouts_wheel_used[level] != 0) {
+      slot = sys_timeouts_wheel_ffs(timeouts_wheel_used[level]);
+      t = sys_timeouts_wheel_pop(level, slot);
+      t->time += skipped;
+      t->next = timeouts;
+      timeouts = t;
+    }
+  }
+  timeouts_last_time = now;
+  while (timeouts != NULL) {
+    t = timeouts;
+    timeouts = t->next;
+    sys_timeouts_wheel_add(t);
+  }
+  if (timeouts_count != 0) {
+    sys_timeouts_wheel_deadline();
+  }
+#else /* LWIP_TIMERS_WHEEL */
   timeouts_last_time = sys_now();
+#endif /* LWIP_TIMERS_WHEEL */
 }
 
 /** Return the time left before the next timeout is due. If no timeouts are
  * enqueued, returns 0xffffffff
+ * With LWIP_TIMERS_WHEEL, this can be called from any task.
  */
-#if !NO_SYS
+#if !NO_SYS && !LWIP_TIMERS_WHEEL
 static
-#endif /* !NO_SYS */
+#endif /* !NO_SYS && !LWIP_TIMERS_WHEEL */
 u32_t
 sys_timeouts_sleeptime(void)
 {
+#if LWIP_TIMERS_WHEEL
+  u32_t deadline, left;
+  u16_t count;
+  SYS_ARCH_DECL_PROTECT(lev);
+
+  SYS_ARCH_PROTECT(lev);
+  count = timeouts_count;
+  deadline = timeouts_deadline;
+  SYS_ARCH_UNPROTECT(lev);
+  if (count == 0) {
+    return 0xffffffff;
+  }
+  left = deadline - sys_now();
+  if ((s32_t)left < 0) {
+    return 0;
+  }
+  return left;
+#else /* LWIP_TIMERS_WHEEL */
   u32_t diff;
   if (next_timeout == NULL) {
     return 0xffffffff;
@@ -390,6 +707,7 @@ sys_timeouts_sleeptime(void)
   } else {
     return next_timeout->time - diff;
   }
+#endif /* LWIP_TIMERS_WHEEL */
 }
 
 #if !NO_SYS
@@ -407,12 +725,14 @@ sys_timeouts_mbox_fetch(sys_mbox_t *mbox, void **msg)
   u32_t sleeptime;
 
 again:
-  if (!next_timeout) {
+  LOCK_TCPIP_CORE();
+  sleeptime = sys_timeouts_sleeptime();
+  UNLOCK_TCPIP_CORE();
+  if (sleeptime == 0xffffffff) {
     sys_arch_mbox_fetch(mbox, msg, 0);
     return;
   }
 
-  sleeptime = sys_timeouts_sleeptime();
   if (sleeptime == 0 || sys_arch_mbox_fetch(mbox, msg, sleeptime) == SYS_ARCH_TIMEOUT) {
     /* If a SYS_ARCH_TIMEOUT value is returned, a timeout occurred
        before a message could be fetched. */
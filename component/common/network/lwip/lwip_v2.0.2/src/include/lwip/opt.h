@@ -120,6 +120,18 @@
 #if !defined LWIP_TIMERS_CUSTOM || defined __DOXYGEN__
 #define LWIP_TIMERS_CUSTOM              0
 #endif
+
+/**
+ * LWIP_TIMERS_WHEEL==1: Keep the timeouts of sys_timeout() in a hierarchical
+ * timer wheel (5 levels of 32 slots, 1 ms to 9.3 hours) instead of a list
+ * sorted by expiry time. Adding a timeout is O(1) instead of a walk of the
+ * list, and sys_timeouts_sleeptime() can be called from any task (e.g. the
+ * tickless idle code) to get the time left before the next timeout.
+ * Costs 160 pointers of RAM.
+ */
+#if !defined LWIP_TIMERS_WHEEL || defined __DOXYGEN__
+#define LWIP_TIMERS_WHEEL               0
+#endif
 /**
  * @}
  */
@@ -1029,6 +1041,23 @@
 #define DNS_MAX_SERVERS                 2
 #endif
 
+/** DNS_NEG_TTL: number of seconds a name stays in the table when the server
+ * answered that it does not exist or has no address of the requested type.
+ * Lookups of the name fail at once with ERR_VAL until then, instead of asking
+ * the server again. Timeouts are not cached. 0 keeps no negative answers.
+ */
+#if !defined DNS_NEG_TTL || defined __DOXYGEN__
+#define DNS_NEG_TTL                     0
+#endif
+
+/** DNS_PREFETCH==1: a lookup that hits a table entry in the last tenth of its
+ * TTL sends a new query in the background. The entry keeps answering lookups
+ * meanwhile, so names in use do not expire and stall the next lookup.
+ */
+#if !defined DNS_PREFETCH || defined __DOXYGEN__
+#define DNS_PREFETCH                    0
+#endif
+
 /** DNS do a name checking between the query and the response. */
 #if !defined DNS_DOES_NAME_CHECK || defined __DOXYGEN__
 #define DNS_DOES_NAME_CHECK             1
@@ -1172,6 +1201,34 @@
 #define TCP_QUEUE_OOSEQ                 (LWIP_TCP)
 #endif
 
+/**
+ * LWIP_TCP_SACK_OUT==1: TCP will support sending selective acknowledgements
+ * (SACKs, RFC 2018). The SACK blocks describe the data on the ooseq queue and
+ * are sent in empty ACKs. Only valid for TCP_QUEUE_OOSEQ==1.
+ */
+#if !defined LWIP_TCP_SACK_OUT || defined __DOXYGEN__
+#define LWIP_TCP_SACK_OUT               0
+#endif
+
+/**
+ * LWIP_TCP_MAX_SACK_NUM: The maximum number of SACK blocks to include in an
+ * ACK. At most 4 fit into the TCP header (3 with timestamps).
+ */
+#if !defined LWIP_TCP_MAX_SACK_NUM || defined __DOXYGEN__
+#define LWIP_TCP_MAX_SACK_NUM           4
+#endif
+
+/**
+ * LWIP_TCP_SACK_IN==1: TCP will use the SACK blocks received from the remote
+ * host in fast recovery: segments it has already received are not
+ * retransmitted, the holes below the highest SACKed sequence number are
+ * retransmitted one per duplicate ACK, and a partial ACK retransmits the next
+ * hole instead of ending fast recovery (RFC 6582/6675 style recovery).
+ */
+#if !defined LWIP_TCP_SACK_IN || defined __DOXYGEN__
+#define LWIP_TCP_SACK_IN                0
+#endif
+
 /**
  * TCP_MSS: TCP Maximum segment size. (default is 536, a conservative default,
  * you might want to increase this.)
@@ -1246,6 +1303,23 @@
 #define TCP_OOSEQ_MAX_PBUFS             0
 #endif
 
+/**
+ * TCP_OOSEQ_BYTES_LIMIT(pcb): The maximum number of bytes queued on ooseq for
+ * the given pcb. Only used if TCP_OOSEQ_MAX_BYTES != 0. Define it to a
+ * function to set the limit per connection, e.g. from its receive window.
+ */
+#if !defined TCP_OOSEQ_BYTES_LIMIT || defined __DOXYGEN__
+#define TCP_OOSEQ_BYTES_LIMIT(pcb)      TCP_OOSEQ_MAX_BYTES
+#endif
+
+/**
+ * TCP_OOSEQ_PBUFS_LIMIT(pcb): The maximum number of pbufs queued on ooseq for
+ * the given pcb. Only used if TCP_OOSEQ_MAX_PBUFS != 0.
+ */
+#if !defined TCP_OOSEQ_PBUFS_LIMIT || defined __DOXYGEN__
+#define TCP_OOSEQ_PBUFS_LIMIT(pcb)      TCP_OOSEQ_MAX_PBUFS
+#endif
+
 /**
  * TCP_LISTEN_BACKLOG: Enable the backlog option for tcp listen pcb.
  */
@@ -1858,6 +1932,24 @@
 #if !defined LWIP_FIONREAD_LINUXMODE || defined __DOXYGEN__
 #define LWIP_FIONREAD_LINUXMODE         0
 #endif
+
+/**
+ * LWIP_SOCKET_EPOLL==1: Enable lwip_epoll_create(), lwip_epoll_ctl() and
+ * lwip_epoll_wait(). An interest list registers its sockets once and the
+ * socket event callback queues the ones that become ready, so a wait costs
+ * O(ready sockets) instead of O(sockets) like select().
+ */
+#if !defined LWIP_SOCKET_EPOLL || defined __DOXYGEN__
+#define LWIP_SOCKET_EPOLL               0
+#endif
+
+/**
+ * LWIP_SOCKET_EPOLL_SETS: the number of interest lists that can be open at
+ * the same time (8 at most).
+ */
+#if !defined LWIP_SOCKET_EPOLL_SETS || defined __DOXYGEN__
+#define LWIP_SOCKET_EPOLL_SETS          2
+#endif
 /**
  * @}
  */
@@ -2032,6 +2124,17 @@
 #define MIB2_STATS                      0
 
 #endif /* LWIP_STATS */
+
+/**
+ * LWIP_NETSTATS==1: Keep a small set of 32-bit counters in lwip_netstats,
+ * independent of LWIP_STATS: frames and drops of the netif drivers, pbuf
+ * allocation failures, full mboxes, TCP retransmissions and out-of-sequence
+ * discards, checksum errors and IP reassembly timeouts. Counting is one
+ * increment on a per-frame or error path, see NETSTATS_INC() in lwip/stats.h.
+ */
+#if !defined LWIP_NETSTATS || defined __DOXYGEN__
+#define LWIP_NETSTATS                   0
+#endif
 /**
  * @}
  */
@@ -508,6 +508,36 @@ int lwip_select(int maxfdp1, fd_set *readset, fd_set *writeset, fd_set *exceptse
 int lwip_ioctl(int s, long cmd, void *argp);
 int lwip_fcntl(int s, int cmd, int val);
 
+#if LWIP_SOCKET_EPOLL
+/* Events of lwip_epoll_ctl() and lwip_epoll_wait(), LWIP_EPOLLERR is always
+   reported. Readiness is level-triggered. */
+#define LWIP_EPOLLIN      0x01
+#define LWIP_EPOLLOUT     0x04
+#define LWIP_EPOLLERR     0x08
+
+/* Operations of lwip_epoll_ctl() */
+#define LWIP_EPOLL_CTL_ADD 1
+#define LWIP_EPOLL_CTL_DEL 2
+#define LWIP_EPOLL_CTL_MOD 3
+
+/** User data of a socket in an interest list, returned with its events */
+typedef union lwip_epoll_data {
+  void *ptr;
+  int fd;
+  u32_t u32;
+} lwip_epoll_data_t;
+
+struct lwip_epoll_event {
+  u32_t events;
+  lwip_epoll_data_t data;
+};
+
+int lwip_epoll_create(void);
+int lwip_epoll_close(int epfd);
+int lwip_epoll_ctl(int epfd, int op, int s, struct lwip_epoll_event *event);
+int lwip_epoll_wait(int epfd, struct lwip_epoll_event *events, int maxevents, int timeout);
+#endif /* LWIP_SOCKET_EPOLL */
+
 #if LWIP_COMPAT_SOCKETS
 #if LWIP_COMPAT_SOCKETS != 2
 /** @ingroup socket */
@@ -467,6 +467,44 @@ void stats_init(void);
 #define MIB2_STATS_INC(x)
 #endif
 
+#if LWIP_NETSTATS
+/** Always-on network counters, see LWIP_NETSTATS */
+struct stats_net {
+  u32_t rx_frames;       /* frames passed to the stack by the netif drivers */
+  u32_t rx_drops;        /* frames dropped before the TCP_IP thread: no pbuf, tcpip mbox full */
+  u32_t tx_frames;       /* frames sent by the netif drivers */
+  u32_t tx_errors;       /* frames the drivers failed to send */
+  u32_t pbuf_alloc_fail; /* pbuf_alloc() out of pool pbufs or heap */
+  u32_t mbox_full;       /* sys_mbox_trypost() to a full mbox */
+  u32_t tcp_rexmit;      /* TCP segments retransmitted */
+  u32_t tcp_ooseq_drop;  /* TCP out-of-sequence queues cut by the limits or freed for pool pbufs */
+  u32_t chksum_err;      /* IPv4 header, ICMP, UDP and TCP checksum errors */
+  u32_t reass_timeout;   /* IP datagrams whose reassembly timed out */
+  u32_t dns_hits;        /* names answered from the DNS table */
+  u32_t dns_neg_hits;    /* names failed from a negative DNS table entry, see DNS_NEG_TTL */
+  u32_t dns_misses;      /* names sent to the DNS server */
+  u32_t dns_prefetch;    /* DNS table entries refreshed before expiry, see DNS_PREFETCH */
+};
+
+/** Global variable containing the LWIP_NETSTATS counters */
+extern struct stats_net lwip_netstats;
+
+/* The counters are written without locking when each one is only updated from
+   the TCP_IP thread (or with the core locked). Counters updated from any task,
+   e.g. rx_frames and rx_drops from the rx tasks of several drivers, use
+   NETSTATS_INC_PROTECTED(). */
+#define NETSTATS_INC(x) ++lwip_netstats.x
+#define NETSTATS_ADD(x, n) lwip_netstats.x += (n)
+#define NETSTATS_INC_PROTECTED(x) SYS_ARCH_INC(lwip_netstats.x, 1)
+
+void netstats_get(struct stats_net *stats);
+void netstats_reset(void);
+#else /* LWIP_NETSTATS */
+#define NETSTATS_INC(x)
+#define NETSTATS_ADD(x, n)
+#define NETSTATS_INC_PROTECTED(x)
+#endif /* LWIP_NETSTATS */
+
 /* Display of statistics */
 #if LWIP_STATS_DISPLAY
 void stats_display(void);
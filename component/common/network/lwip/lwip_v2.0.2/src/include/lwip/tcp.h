@@ -147,7 +147,7 @@ typedef u32_t tcpwnd_size_t;
 typedef u16_t tcpwnd_size_t;
 #endif
 
-#if LWIP_WND_SCALE || TCP_LISTEN_BACKLOG || LWIP_TCP_TIMESTAMPS
+#if LWIP_WND_SCALE || TCP_LISTEN_BACKLOG || LWIP_TCP_TIMESTAMPS || LWIP_TCP_SACK_OUT || LWIP_TCP_SACK_IN
 typedef u16_t tcpflags_t;
 #else
 typedef u8_t tcpflags_t;
@@ -226,6 +226,9 @@ struct tcp_pcb {
 #endif
 #if LWIP_TCP_TIMESTAMPS
 #define TF_TIMESTAMP   0x0400U   /* Timestamp option enabled */
+#endif
+#if LWIP_TCP_SACK_OUT || LWIP_TCP_SACK_IN
+#define TF_SACK        0x1000U   /* Selective ACKs permitted by the remote host */
 #endif
 
   /* the rest of the fields are in host byte order
@@ -241,6 +244,9 @@ struct tcp_pcb {
   tcpwnd_size_t rcv_wnd;   /* receiver window available */
   tcpwnd_size_t rcv_ann_wnd; /* receiver window to announce */
   u32_t rcv_ann_right_edge; /* announced right edge of window */
+#if LWIP_TCP_SACK_OUT
+  u32_t rcv_sack_seqno; /* seqno of the segment last put on ooseq, its SACK block goes first */
+#endif /* LWIP_TCP_SACK_OUT */
 
   /* Retransmission timer. */
   s16_t rtime;
@@ -258,6 +264,11 @@ struct tcp_pcb {
   /* fast retransmit/recovery */
   u8_t dupacks;
   u32_t lastack; /* Highest acknowledged seqno. */
+#if LWIP_TCP_SACK_IN
+  u32_t snd_recover;     /* snd_nxt when fast recovery was entered */
+  u32_t snd_sack_high;   /* highest seqno SACKed by the remote host */
+  u32_t snd_sack_rexmit; /* the holes below have been retransmitted in this recovery */
+#endif /* LWIP_TCP_SACK_IN */
 
   /* congestion avoidance/control variables */
   tcpwnd_size_t cwnd;
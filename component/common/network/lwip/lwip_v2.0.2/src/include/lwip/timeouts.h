@@ -85,6 +85,8 @@ typedef void (* sys_timeout_handler)(void *arg);
 
 struct sys_timeo {
   struct sys_timeo *next;
+  /** Time relative to the previous timeout in the list, or the absolute
+   * sys_now() time of expiry with LWIP_TIMERS_WHEEL */
   u32_t time;
   sys_timeout_handler h;
   void *arg;
@@ -117,6 +119,9 @@ void sys_check_timeouts(void);
 u32_t sys_timeouts_sleeptime(void);
 #else /* NO_SYS */
 void sys_timeouts_mbox_fetch(sys_mbox_t *mbox, void **msg);
+#if LWIP_TIMERS_WHEEL
+u32_t sys_timeouts_sleeptime(void);
+#endif /* LWIP_TIMERS_WHEEL */
 #endif /* NO_SYS */
 
 
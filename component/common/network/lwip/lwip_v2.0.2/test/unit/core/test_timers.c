@@ -0,0 +1,164 @@
+#include "test_timers.h"
+
+#include "lwip/timeouts.h"
+#include "lwip/def.h"
+#include "lwip/sys.h"
+#include "lwip/memp.h"
+#include "lwip/stats.h"
+
+#if !LWIP_STATS || !MEMP_STATS
+#error "This tests needs MEMP-statistics enabled"
+#endif
+#if !LWIP_TIMERS || LWIP_TIMERS_CUSTOM
+#error "This tests needs the lwIP timers"
+#endif
+
+#define TIMERS_MAX_FIRED 8
+
+static int timers_fired;
+static int timers_fired_arg[TIMERS_MAX_FIRED];
+static u32_t timers_fired_at[TIMERS_MAX_FIRED];
+static u16_t timers_used;
+
+/* Setups/teardown functions */
+
+static void
+timers_setup(void)
+{
+  timers_fired = 0;
+  timers_used = MEMP_STATS_GET(used, MEMP_SYS_TIMEOUT);
+}
+
+static void
+timers_teardown(void)
+{
+}
+
+/* Helper functions */
+
+static void
+timers_handler(void *arg)
+{
+  if (timers_fired < TIMERS_MAX_FIRED) {
+    timers_fired_arg[timers_fired] = *(int *)arg;
+    timers_fired_at[timers_fired] = sys_now();
+  }
+  timers_fired++;
+}
+
+/** Call sys_check_timeouts() for msecs */
+static void
+timers_run(u32_t msecs)
+{
+  u32_t start = sys_now();
+
+  while (sys_now() - start < msecs) {
+    sys_check_timeouts();
+  }
+  sys_check_timeouts();
+}
+
+/* Test functions */
+
+/** Timeouts on all wheel levels expire in order and not early */
+START_TEST(test_timers_order)
+{
+  static int args[] = {0, 1, 2, 3, 4};
+  static const u32_t msecs[] = {0, 3, 20, 45, 1100};
+  u32_t start;
+  int i;
+  LWIP_UNUSED_ARG(_i);
+
+  start = sys_now();
+  for (i = LWIP_ARRAYSIZE(args); i-- > 0; ) {
+    sys_timeout(msecs[i], timers_handler, &args[i]);
+  }
+  fail_unless(MEMP_STATS_GET(used, MEMP_SYS_TIMEOUT) == timers_used + LWIP_ARRAYSIZE(args));
+  fail_unless(sys_timeouts_sleeptime() == 0);
+
+  sys_check_timeouts();
+  fail_unless(timers_fired == 1);
+  fail_unless(sys_timeouts_sleeptime() <= 3);
+
+  timers_run(1200);
+  fail_unless(timers_fired == LWIP_ARRAYSIZE(args));
+  for (i = 0; i < (int)LWIP_ARRAYSIZE(args); i++) {
+    fail_unless(timers_fired_arg[i] == i);
+    fail_unless(timers_fired_at[i] - start >= msecs[i]);
+  }
+}
+END_TEST
+
+/** sys_untimeout() removes the timeout given and nothing else */
+START_TEST(test_timers_untimeout)
+{
+  static int args[] = {0, 1, 2};
+  LWIP_UNUSED_ARG(_i);
+
+  sys_timeout(10, timers_handler, &args[0]);
+  sys_timeout(10, timers_handler, &args[1]);
+  /* 10 hours, beyond the range of the wheel */
+  sys_timeout(10 * 3600 * 1000, timers_handler, &args[2]);
+  fail_unless(MEMP_STATS_GET(used, MEMP_SYS_TIMEOUT) == timers_used + 3);
+  fail_unless(sys_timeouts_sleeptime() <= 10);
+
+  sys_untimeout(timers_handler, &args[0]);
+  fail_unless(MEMP_STATS_GET(used, MEMP_SYS_TIMEOUT) == timers_used + 2);
+  timers_run(20);
+  fail_unless(timers_fired == 1);
+  fail_unless(timers_fired_arg[0] == 1);
+
+  /* the stack's timeouts may have changed while running */
+  timers_used = MEMP_STATS_GET(used, MEMP_SYS_TIMEOUT);
+  sys_untimeout(timers_handler, &args[2]);
+  fail_unless(MEMP_STATS_GET(used, MEMP_SYS_TIMEOUT) == timers_used - 1);
+  /* not pending any more */
+  sys_untimeout(timers_handler, &args[2]);
+  fail_unless(MEMP_STATS_GET(used, MEMP_SYS_TIMEOUT) == timers_used - 1);
+}
+END_TEST
+
+/** sys_restart_timeouts() moves the timeouts by the time skipped */
+START_TEST(test_timers_restart)
+{
+  static int args[] = {0, 1};
+  u32_t start;
+  LWIP_UNUSED_ARG(_i);
+
+  /* the time skipped counts from the last timeout that expired, which may
+     be long ago with the stack's timeouts pending: expire one now */
+  sys_timeout(1, timers_handler, &args[1]);
+  start = sys_now();
+  while ((timers_fired == 0) && (sys_now() - start < 100)) {
+    sys_check_timeouts();
+  }
+  fail_unless(timers_fired == 1);
+  timers_fired = 0;
+
+  sys_timeout(10, timers_handler, &args[0]);
+  start = sys_now();
+  while (sys_now() - start < 30) {
+  }
+  sys_restart_timeouts();
+  sys_check_timeouts();
+  fail_unless(timers_fired == 0);
+  /* plus the tick that may have passed since the sync */
+  fail_unless(sys_timeouts_sleeptime() <= 11);
+
+  timers_run(15);
+  fail_unless(timers_fired == 1);
+  fail_unless(timers_fired_at[0] - start >= 40);
+}
+END_TEST
+
+/** Create the suite including all tests for this module */
+Suite *
+timers_suite(void)
+{
+  testfunc tests[] = {
+    TESTFUNC(test_timers_order),
+    TESTFUNC(test_timers_untimeout),
+    TESTFUNC(test_timers_restart)
+  };
+  return create_suite("TIMERS", tests, sizeof(tests)/sizeof(testfunc), timers_setup, timers_teardown);
+}
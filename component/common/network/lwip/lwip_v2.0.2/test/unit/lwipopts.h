@@ -49,6 +49,8 @@
 #define TCP_WND                         (10 * TCP_MSS)
 #define LWIP_WND_SCALE                  1
 #define TCP_RCV_SCALE                   0
+#define LWIP_TCP_SACK_OUT               1
+#define LWIP_TCP_SACK_IN                1
 #define PBUF_POOL_SIZE                  400 /* pbuf tests need ~200KByte */
 
 /* Enable IGMP and MDNS for MDNS tests */
@@ -56,6 +58,11 @@
 #define LWIP_MDNS_RESPONDER             1
 #define LWIP_NUM_NETIF_CLIENT_DATA      (LWIP_MDNS_RESPONDER)
 
+/* Test the timer wheel implementation of sys_timeout(), the timers tests
+   add up to 5 timeouts to those of the stack */
+#define LWIP_TIMERS_WHEEL               1
+#define MEMP_NUM_SYS_TIMEOUT            20
+
 /* Minimal changes to opt.h required for etharp unit tests: */
 #define ETHARP_SUPPORT_STATIC_ENTRIES   1
 
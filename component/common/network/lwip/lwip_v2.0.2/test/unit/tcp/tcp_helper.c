@@ -39,23 +39,26 @@ tcp_remove_all(void)
 
 /** Create a TCP segment usable for passing to tcp_input */
 static struct pbuf*
-tcp_create_segment_wnd(ip_addr_t* src_ip, ip_addr_t* dst_ip,
+tcp_create_segment_wnd_opts(ip_addr_t* src_ip, ip_addr_t* dst_ip,
                    u16_t src_port, u16_t dst_port, void* data, size_t data_len,
-                   u32_t seqno, u32_t ackno, u8_t headerflags, u16_t wnd)
+                   u32_t seqno, u32_t ackno, u8_t headerflags, u16_t wnd,
+                   const u8_t* opts, u8_t optlen)
 {
   struct pbuf *p, *q;
   struct ip_hdr* iphdr;
   struct tcp_hdr* tcphdr;
-  u16_t pbuf_len = (u16_t)(sizeof(struct ip_hdr) + sizeof(struct tcp_hdr) + data_len);
+  u16_t tcphdr_len = (u16_t)(sizeof(struct tcp_hdr) + optlen);
+  u16_t pbuf_len = (u16_t)(sizeof(struct ip_hdr) + tcphdr_len + data_len);
   LWIP_ASSERT("data_len too big", data_len <= 0xFFFF);
+  LWIP_ASSERT("optlen must be a multiple of 4", (optlen & 3) == 0);
 
   p = pbuf_alloc(PBUF_RAW, pbuf_len, PBUF_POOL);
   EXPECT_RETNULL(p != NULL);
   /* first pbuf must be big enough to hold the headers */
-  EXPECT_RETNULL(p->len >= (sizeof(struct ip_hdr) + sizeof(struct tcp_hdr)));
+  EXPECT_RETNULL(p->len >= (sizeof(struct ip_hdr) + tcphdr_len));
   if (data_len > 0) {
     /* first pbuf must be big enough to hold at least 1 data byte, too */
-    EXPECT_RETNULL(p->len > (sizeof(struct ip_hdr) + sizeof(struct tcp_hdr)));
+    EXPECT_RETNULL(p->len > (sizeof(struct ip_hdr) + tcphdr_len));
   }
 
   for(q = p; q != NULL; q = q->next) {
@@ -79,17 +82,20 @@ tcp_create_segment_wnd(ip_addr_t* src_ip, ip_addr_t* dst_ip,
   tcphdr->dest  = htons(dst_port);
   tcphdr->seqno = htonl(seqno);
   tcphdr->ackno = htonl(ackno);
-  TCPH_HDRLEN_SET(tcphdr, sizeof(struct tcp_hdr)/4);
+  TCPH_HDRLEN_SET(tcphdr, tcphdr_len/4);
   TCPH_FLAGS_SET(tcphdr, headerflags);
   tcphdr->wnd   = htons(wnd);
+  if (optlen > 0) {
+    memcpy(tcphdr + 1, opts, optlen);
+  }
 
   if (data_len > 0) {
     /* let p point to TCP data */
-    pbuf_header(p, -(s16_t)sizeof(struct tcp_hdr));
+    pbuf_header(p, -(s16_t)tcphdr_len);
     /* copy data */
     pbuf_take(p, data, (u16_t)data_len);
     /* let p point to TCP header again */
-    pbuf_header(p, sizeof(struct tcp_hdr));
+    pbuf_header(p, (s16_t)tcphdr_len);
   }
 
   /* calculate checksum */
@@ -102,6 +108,16 @@ tcp_create_segment_wnd(ip_addr_t* src_ip, ip_addr_t* dst_ip,
   return p;
 }
 
+/** Create a TCP segment usable for passing to tcp_input */
+static struct pbuf*
+tcp_create_segment_wnd(ip_addr_t* src_ip, ip_addr_t* dst_ip,
+                   u16_t src_port, u16_t dst_port, void* data, size_t data_len,
+                   u32_t seqno, u32_t ackno, u8_t headerflags, u16_t wnd)
+{
+  return tcp_create_segment_wnd_opts(src_ip, dst_ip, src_port, dst_port, data,
+    data_len, seqno, ackno, headerflags, wnd, NULL, 0);
+}
+
 /** Create a TCP segment usable for passing to tcp_input */
 struct pbuf*
 tcp_create_segment(ip_addr_t* src_ip, ip_addr_t* dst_ip,
@@ -112,6 +128,19 @@ tcp_create_segment(ip_addr_t* src_ip, ip_addr_t* dst_ip,
     data_len, seqno, ackno, headerflags, TCP_WND);
 }
 
+/** Create a TCP segment with TCP options usable for passing to tcp_input
+ * - optlen must be a multiple of 4 (pad the options with NOPs)
+ */
+struct pbuf*
+tcp_create_segment_opts(ip_addr_t* src_ip, ip_addr_t* dst_ip,
+                   u16_t src_port, u16_t dst_port, void* data, size_t data_len,
+                   u32_t seqno, u32_t ackno, u8_t headerflags,
+                   const u8_t* opts, u8_t optlen)
+{
+  return tcp_create_segment_wnd_opts(src_ip, dst_ip, src_port, dst_port, data,
+    data_len, seqno, ackno, headerflags, TCP_WND, opts, optlen);
+}
+
 /** Create a TCP segment usable for passing to tcp_input
  * - IP-addresses, ports, seqno and ackno are taken from pcb
  * - seqno and ackno can be altered with an offset
@@ -136,6 +165,43 @@ struct pbuf* tcp_create_rx_segment_wnd(struct tcp_pcb* pcb, void* data, size_t d
     data, data_len, pcb->rcv_nxt + seqno_offset, pcb->lastack + ackno_offset, headerflags, wnd);
 }
 
+/** Find a TCP option in a segment sent by lwIP
+ *
+ * @param p the packet as passed to netif->output (starting at the IP header)
+ * @param kind the option to look for
+ * @param opt receives the option (kind and length included)
+ * @param opt_size size of opt
+ * @return the option length or 0 if the option is not present
+ */
+u8_t
+test_tcp_find_option(struct pbuf* p, u8_t kind, u8_t* opt, u8_t opt_size)
+{
+  struct tcp_hdr tcphdr;
+  u8_t opts[40];
+  u16_t optlen, i;
+
+  EXPECT_RETX(pbuf_copy_partial(p, &tcphdr, sizeof(tcphdr), IP_HLEN) == sizeof(tcphdr), 0);
+  optlen = (u16_t)(TCPH_HDRLEN(&tcphdr) * 4 - TCP_HLEN);
+  EXPECT_RETX(pbuf_copy_partial(p, opts, optlen, IP_HLEN + TCP_HLEN) == optlen, 0);
+  for (i = 0; i < optlen; ) {
+    if (opts[i] == LWIP_TCP_OPT_EOL) {
+      break;
+    }
+    if (opts[i] == LWIP_TCP_OPT_NOP) {
+      i++;
+      continue;
+    }
+    EXPECT_RETX((i + 1 < optlen) && (opts[i + 1] >= 2) && (i + opts[i + 1] <= optlen), 0);
+    if (opts[i] == kind) {
+      EXPECT_RETX(opts[i + 1] <= opt_size, 0);
+      memcpy(opt, &opts[i], opts[i + 1]);
+      return opts[i + 1];
+    }
+    i += opts[i + 1];
+  }
+  return 0;
+}
+
 /** Safely bring a tcp_pcb into the requested state */
 void
 tcp_set_state(struct tcp_pcb* pcb, enum tcp_state state, ip_addr_t* local_ip,
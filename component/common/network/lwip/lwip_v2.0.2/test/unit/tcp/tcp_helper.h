@@ -32,6 +32,10 @@ void tcp_remove_all(void);
 struct pbuf* tcp_create_segment(ip_addr_t* src_ip, ip_addr_t* dst_ip,
                    u16_t src_port, u16_t dst_port, void* data, size_t data_len,
                    u32_t seqno, u32_t ackno, u8_t headerflags);
+struct pbuf* tcp_create_segment_opts(ip_addr_t* src_ip, ip_addr_t* dst_ip,
+                   u16_t src_port, u16_t dst_port, void* data, size_t data_len,
+                   u32_t seqno, u32_t ackno, u8_t headerflags,
+                   const u8_t* opts, u8_t optlen);
 struct pbuf* tcp_create_rx_segment(struct tcp_pcb* pcb, void* data, size_t data_len,
                    u32_t seqno_offset, u32_t ackno_offset, u8_t headerflags);
 struct pbuf* tcp_create_rx_segment_wnd(struct tcp_pcb* pcb, void* data, size_t data_len,
@@ -44,6 +48,7 @@ err_t test_tcp_counters_recv(void* arg, struct tcp_pcb* pcb, struct pbuf* p, err
 struct tcp_pcb* test_tcp_new_counters_pcb(struct test_tcp_counters* counters);
 
 void test_tcp_input(struct pbuf *p, struct netif *inp);
+u8_t test_tcp_find_option(struct pbuf* p, u8_t kind, u8_t* opt, u8_t opt_size);
 
 void test_tcp_init_netif(struct netif *netif, struct test_tcp_txcounters *txcounters,
                          ip_addr_t *ip_addr, ip_addr_t *netmask);
@@ -726,6 +726,292 @@ START_TEST(test_tcp_tx_full_window_lost_from_unacked)
 }
 END_TEST
 
+#if LWIP_TCP_SACK_OUT || LWIP_TCP_SACK_IN
+/** Check that SACK is only used if the SYN permits it */
+START_TEST(test_tcp_sack_perm)
+{
+  struct netif netif;
+  struct test_tcp_txcounters txcounters;
+  struct tcp_pcb *lpcb, *pcb1, *pcb2;
+  struct pbuf* p;
+  ip_addr_t remote_ip, local_ip, netmask;
+  u16_t remote_port = 0x100, local_port = 0x101;
+  u8_t opts[] = {LWIP_TCP_OPT_MSS, LWIP_TCP_OPT_LEN_MSS, TCP_MSS >> 8, TCP_MSS & 0xFF,
+                 LWIP_TCP_OPT_NOP, LWIP_TCP_OPT_NOP, LWIP_TCP_OPT_SACK_PERM, LWIP_TCP_OPT_LEN_SACK_PERM};
+  u8_t opt[LWIP_TCP_OPT_LEN_SACK_PERM];
+  err_t err;
+  LWIP_UNUSED_ARG(_i);
+
+  /* initialize local vars */
+  IP_ADDR4(&local_ip,  192, 168,   1, 1);
+  IP_ADDR4(&remote_ip, 192, 168,   1, 2);
+  IP_ADDR4(&netmask,   255, 255, 255, 0);
+  test_tcp_init_netif(&netif, &txcounters, &local_ip, &netmask);
+
+  lpcb = tcp_new();
+  EXPECT_RET(lpcb != NULL);
+  err = tcp_bind(lpcb, &local_ip, local_port);
+  EXPECT_RET(err == ERR_OK);
+  lpcb = tcp_listen(lpcb);
+  EXPECT_RET(lpcb != NULL);
+  txcounters.copy_tx_packets = 1;
+
+  /* SYN with SACK-permitted: the SYN/ACK permits SACK, too */
+  p = tcp_create_segment_opts(&remote_ip, &local_ip, remote_port, local_port, NULL, 0,
+                              1000, 0, TCP_SYN, opts, sizeof(opts));
+  EXPECT_RET(p != NULL);
+  test_tcp_input(p, &netif);
+  EXPECT_RET(txcounters.num_tx_calls == 1);
+  EXPECT(test_tcp_find_option(txcounters.tx_packets, LWIP_TCP_OPT_SACK_PERM, opt, sizeof(opt)) == LWIP_TCP_OPT_LEN_SACK_PERM);
+  pcb1 = tcp_active_pcbs;
+  EXPECT_RET((pcb1 != NULL) && (pcb1->remote_port == remote_port));
+  EXPECT(pcb1->flags & TF_SACK);
+  pbuf_free(txcounters.tx_packets);
+  txcounters.tx_packets = NULL;
+  txcounters.num_tx_calls = 0;
+
+  /* SYN without options: no SACK */
+  p = tcp_create_segment(&remote_ip, &local_ip, remote_port + 1, local_port, NULL, 0,
+                         2000, 0, TCP_SYN);
+  EXPECT_RET(p != NULL);
+  test_tcp_input(p, &netif);
+  EXPECT_RET(txcounters.num_tx_calls == 1);
+  EXPECT(test_tcp_find_option(txcounters.tx_packets, LWIP_TCP_OPT_SACK_PERM, opt, sizeof(opt)) == 0);
+  pcb2 = tcp_active_pcbs;
+  EXPECT_RET((pcb2 != NULL) && (pcb2->remote_port == remote_port + 1));
+  EXPECT((pcb2->flags & TF_SACK) == 0);
+  pbuf_free(txcounters.tx_packets);
+  txcounters.tx_packets = NULL;
+
+  /* make sure the pcbs are freed */
+  EXPECT_RET(MEMP_STATS_GET(used, MEMP_TCP_PCB) == 2);
+  tcp_abort(pcb1);
+  tcp_abort(pcb2);
+  EXPECT_RET(MEMP_STATS_GET(used, MEMP_TCP_PCB) == 0);
+  tcp_close(lpcb);
+  EXPECT_RET(MEMP_STATS_GET(used, MEMP_TCP_PCB_LISTEN) == 0);
+}
+END_TEST
+#endif /* LWIP_TCP_SACK_OUT || LWIP_TCP_SACK_IN */
+
+#if LWIP_TCP_SACK_IN
+/** Create a duplicate ACK for pcb carrying num SACK blocks (edges are
+ * offsets to pcb->lastack) */
+static struct pbuf*
+test_tcp_create_sack(struct tcp_pcb* pcb, u32_t ackno_offset, const u32_t* edges, u8_t num)
+{
+  u8_t opts[4 + 8 * 4];
+  u32_t edge;
+  u8_t i;
+
+  opts[0] = LWIP_TCP_OPT_NOP;
+  opts[1] = LWIP_TCP_OPT_NOP;
+  opts[2] = LWIP_TCP_OPT_SACK;
+  opts[3] = (u8_t)(2 + 8 * num);
+  for (i = 0; i < 2 * num; i++) {
+    edge = lwip_htonl(pcb->lastack + edges[i]);
+    memcpy(&opts[4 + 4 * i], &edge, sizeof(edge));
+  }
+  return tcp_create_segment_opts(&pcb->remote_ip, &pcb->local_ip, pcb->remote_port, pcb->local_port,
+    NULL, 0, pcb->rcv_nxt, pcb->lastack + ackno_offset, TCP_ACK, opts, (u8_t)(4 + 8 * num));
+}
+
+/** Check the number of segments sent and the seqno of the first one */
+static void
+check_tx_seqno(struct test_tcp_txcounters* txcounters, u32_t num_expected, u32_t seqno_expected)
+{
+  struct tcp_hdr tcphdr;
+
+  EXPECT(txcounters->num_tx_calls == num_expected);
+  if (txcounters->tx_packets != NULL) {
+    EXPECT(pbuf_copy_partial(txcounters->tx_packets, &tcphdr, sizeof(tcphdr), IP_HLEN) == sizeof(tcphdr));
+    EXPECT(lwip_ntohl(tcphdr.seqno) == seqno_expected);
+    pbuf_free(txcounters->tx_packets);
+    txcounters->tx_packets = NULL;
+  }
+  txcounters->num_tx_calls = 0;
+  txcounters->num_tx_bytes = 0;
+}
+
+/** Lose the 1st and 3rd of 6 segments: fast retransmit resends the 1st,
+ * the SACK blocks of the next duplicate ACK the 3rd, and fast recovery
+ * lasts until everything is acknowledged. */
+START_TEST(test_tcp_sack_rexmit_holes)
+{
+  struct netif netif;
+  struct test_tcp_txcounters txcounters;
+  struct test_tcp_counters counters;
+  struct tcp_pcb* pcb;
+  struct pbuf* p;
+  ip_addr_t remote_ip, local_ip, netmask;
+  u16_t remote_port = 0x100, local_port = 0x101;
+  u32_t iss;
+  u32_t sack1[] = {1 * TCP_MSS, 2 * TCP_MSS};
+  u32_t sack2[] = {3 * TCP_MSS, 4 * TCP_MSS, 1 * TCP_MSS, 2 * TCP_MSS};
+  u32_t sack3[] = {3 * TCP_MSS, 5 * TCP_MSS, 1 * TCP_MSS, 2 * TCP_MSS};
+  u32_t sack4[] = {3 * TCP_MSS, 6 * TCP_MSS, 1 * TCP_MSS, 2 * TCP_MSS};
+  u16_t i;
+  err_t err;
+  LWIP_UNUSED_ARG(_i);
+
+  for (i = 0; i < sizeof(tx_data); i++) {
+    tx_data[i] = (u8_t)i;
+  }
+
+  /* initialize local vars */
+  IP_ADDR4(&local_ip,  192, 168,   1, 1);
+  IP_ADDR4(&remote_ip, 192, 168,   1, 2);
+  IP_ADDR4(&netmask,   255, 255, 255, 0);
+  test_tcp_init_netif(&netif, &txcounters, &local_ip, &netmask);
+  memset(&counters, 0, sizeof(counters));
+
+  /* create and initialize the pcb */
+  pcb = test_tcp_new_counters_pcb(&counters);
+  EXPECT_RET(pcb != NULL);
+  tcp_set_state(pcb, ESTABLISHED, &local_ip, &remote_ip, local_port, remote_port);
+  pcb->mss = TCP_MSS;
+  pcb->flags |= TF_SACK;
+  /* disable initial congestion window (we don't send a SYN here...) */
+  pcb->cwnd = pcb->snd_wnd;
+  iss = pcb->lastack;
+
+  /* send 6 mss-sized segments */
+  err = tcp_write(pcb, tx_data, 6 * TCP_MSS, TCP_WRITE_FLAG_COPY);
+  EXPECT_RET(err == ERR_OK);
+  err = tcp_output(pcb);
+  EXPECT_RET(err == ERR_OK);
+  EXPECT_RET(txcounters.num_tx_calls == 6);
+  memset(&txcounters, 0, sizeof(txcounters));
+  txcounters.copy_tx_packets = 1;
+
+  /* segments 0 and 2 are lost, 2 duplicate ACKs */
+  p = test_tcp_create_sack(pcb, 0, sack1, 1);
+  EXPECT_RET(p != NULL);
+  test_tcp_input(p, &netif);
+  EXPECT(pcb->dupacks == 1);
+  check_tx_seqno(&txcounters, 0, 0);
+  p = test_tcp_create_sack(pcb, 0, sack2, 2);
+  EXPECT_RET(p != NULL);
+  test_tcp_input(p, &netif);
+  EXPECT(pcb->dupacks == 2);
+  check_tx_seqno(&txcounters, 0, 0);
+
+  /* 3rd duplicate ACK -> fast retransmit of segment 0 */
+  p = test_tcp_create_sack(pcb, 0, sack3, 2);
+  EXPECT_RET(p != NULL);
+  test_tcp_input(p, &netif);
+  EXPECT(pcb->dupacks == 3);
+  EXPECT(pcb->flags & TF_INFR);
+  check_tx_seqno(&txcounters, 1, iss);
+
+  /* the next duplicate ACK shows the hole at segment 2 */
+  p = test_tcp_create_sack(pcb, 0, sack4, 2);
+  EXPECT_RET(p != NULL);
+  test_tcp_input(p, &netif);
+  check_tx_seqno(&txcounters, 1, iss + 2 * TCP_MSS);
+
+  /* no more holes: no retransmission */
+  p = test_tcp_create_sack(pcb, 0, sack4, 2);
+  EXPECT_RET(p != NULL);
+  test_tcp_input(p, &netif);
+  check_tx_seqno(&txcounters, 0, 0);
+
+  /* partial ACK up to the 2nd hole, already retransmitted: still in fast recovery */
+  p = test_tcp_create_sack(pcb, 2 * TCP_MSS, &sack4[0], 1);
+  EXPECT_RET(p != NULL);
+  test_tcp_input(p, &netif);
+  EXPECT(pcb->lastack == iss + 2 * TCP_MSS);
+  EXPECT(pcb->flags & TF_INFR);
+  check_tx_seqno(&txcounters, 0, 0);
+
+  /* ACK for everything ends fast recovery */
+  p = tcp_create_rx_segment(pcb, NULL, 0, 0, 4 * TCP_MSS, TCP_ACK);
+  EXPECT_RET(p != NULL);
+  test_tcp_input(p, &netif);
+  EXPECT((pcb->flags & TF_INFR) == 0);
+  EXPECT(pcb->cwnd >= pcb->ssthresh);
+  EXPECT(pcb->unacked == NULL);
+  EXPECT(pcb->unsent == NULL);
+  check_tx_seqno(&txcounters, 0, 0);
+
+  /* make sure the pcb is freed */
+  EXPECT_RET(MEMP_STATS_GET(used, MEMP_TCP_PCB) == 1);
+  tcp_abort(pcb);
+  EXPECT_RET(MEMP_STATS_GET(used, MEMP_TCP_PCB) == 0);
+}
+END_TEST
+
+/** Lose the 1st of 3 segments: 2 duplicate ACKs SACKing the others
+ * retransmit it (early retransmit) */
+START_TEST(test_tcp_sack_early_rexmit)
+{
+  struct netif netif;
+  struct test_tcp_txcounters txcounters;
+  struct test_tcp_counters counters;
+  struct tcp_pcb* pcb;
+  struct pbuf* p;
+  ip_addr_t remote_ip, local_ip, netmask;
+  u16_t remote_port = 0x100, local_port = 0x101;
+  u32_t iss;
+  u32_t sack1[] = {1 * TCP_MSS, 2 * TCP_MSS};
+  u32_t sack2[] = {1 * TCP_MSS, 3 * TCP_MSS};
+  u16_t i;
+  err_t err;
+  LWIP_UNUSED_ARG(_i);
+
+  for (i = 0; i < sizeof(tx_data); i++) {
+    tx_data[i] = (u8_t)i;
+  }
+
+  /* initialize local vars */
+  IP_ADDR4(&local_ip,  192, 168,   1, 1);
+  IP_ADDR4(&remote_ip, 192, 168,   1, 2);
+  IP_ADDR4(&netmask,   255, 255, 255, 0);
+  test_tcp_init_netif(&netif, &txcounters, &local_ip, &netmask);
+  memset(&counters, 0, sizeof(counters));
+
+  /* create and initialize the pcb */
+  pcb = test_tcp_new_counters_pcb(&counters);
+  EXPECT_RET(pcb != NULL);
+  tcp_set_state(pcb, ESTABLISHED, &local_ip, &remote_ip, local_port, remote_port);
+  pcb->mss = TCP_MSS;
+  pcb->flags |= TF_SACK;
+  /* disable initial congestion window (we don't send a SYN here...) */
+  pcb->cwnd = pcb->snd_wnd;
+  iss = pcb->lastack;
+
+  /* send 3 mss-sized segments */
+  err = tcp_write(pcb, tx_data, 3 * TCP_MSS, TCP_WRITE_FLAG_COPY);
+  EXPECT_RET(err == ERR_OK);
+  err = tcp_output(pcb);
+  EXPECT_RET(err == ERR_OK);
+  EXPECT_RET(txcounters.num_tx_calls == 3);
+  memset(&txcounters, 0, sizeof(txcounters));
+  txcounters.copy_tx_packets = 1;
+
+  /* segment 0 is lost */
+  p = test_tcp_create_sack(pcb, 0, sack1, 1);
+  EXPECT_RET(p != NULL);
+  test_tcp_input(p, &netif);
+  EXPECT(pcb->dupacks == 1);
+  check_tx_seqno(&txcounters, 0, 0);
+
+  /* the 2nd duplicate ACK SACKs all the other segments */
+  p = test_tcp_create_sack(pcb, 0, sack2, 1);
+  EXPECT_RET(p != NULL);
+  test_tcp_input(p, &netif);
+  EXPECT(pcb->dupacks == 2);
+  EXPECT(pcb->flags & TF_INFR);
+  check_tx_seqno(&txcounters, 1, iss);
+
+  /* make sure the pcb is freed */
+  EXPECT_RET(MEMP_STATS_GET(used, MEMP_TCP_PCB) == 1);
+  tcp_abort(pcb);
+  EXPECT_RET(MEMP_STATS_GET(used, MEMP_TCP_PCB) == 0);
+}
+END_TEST
+#endif /* LWIP_TCP_SACK_IN */
+
 /** Create the suite including all tests for this module */
 Suite *
 tcp_suite(void)
@@ -738,7 +1024,14 @@ tcp_suite(void)
     TESTFUNC(test_tcp_fast_rexmit_wraparound),
     TESTFUNC(test_tcp_rto_rexmit_wraparound),
     TESTFUNC(test_tcp_tx_full_window_lost_from_unacked),
-    TESTFUNC(test_tcp_tx_full_window_lost_from_unsent)
+    TESTFUNC(test_tcp_tx_full_window_lost_from_unsent),
+#if LWIP_TCP_SACK_OUT || LWIP_TCP_SACK_IN
+    TESTFUNC(test_tcp_sack_perm),
+#endif
+#if LWIP_TCP_SACK_IN
+    TESTFUNC(test_tcp_sack_rexmit_holes),
+    TESTFUNC(test_tcp_sack_early_rexmit),
+#endif
   };
   return create_suite("TCP", tests, sizeof(tests)/sizeof(testfunc), tcp_setup, tcp_teardown);
 }
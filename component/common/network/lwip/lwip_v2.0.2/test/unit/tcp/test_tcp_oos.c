@@ -805,6 +805,120 @@ START_TEST(test_tcp_recv_ooseq_max_pbufs)
 }
 END_TEST
 
+#if LWIP_TCP_SACK_OUT
+/** Check that one ACK was sent carrying the SACK blocks given as offsets
+ * to base (num 0: no SACK option) */
+static void
+check_tx_sack(struct test_tcp_txcounters* txcounters, u32_t base, const u32_t* edges, u8_t num)
+{
+  u8_t opt[2 + 8 * LWIP_TCP_MAX_SACK_NUM];
+  u32_t edge;
+  u8_t i;
+
+  EXPECT(txcounters->num_tx_calls == 1);
+  if (txcounters->tx_packets != NULL) {
+    EXPECT(test_tcp_find_option(txcounters->tx_packets, LWIP_TCP_OPT_SACK, opt, sizeof(opt)) == (num ? 2 + 8 * num : 0));
+    for (i = 0; (num != 0) && (i < 2 * num); i++) {
+      memcpy(&edge, &opt[2 + 4 * i], sizeof(edge));
+      EXPECT(lwip_ntohl(edge) == base + edges[i]);
+    }
+    pbuf_free(txcounters->tx_packets);
+    txcounters->tx_packets = NULL;
+  }
+  txcounters->num_tx_calls = 0;
+  txcounters->num_tx_bytes = 0;
+}
+
+/** Receive 4-byte segments at 4, 12, 8, 20, 0 and 16: each ACK sent while
+ * ooseq is not empty reports the queued ranges, most recent first */
+START_TEST(test_tcp_recv_ooseq_sack)
+{
+  struct test_tcp_counters counters;
+  struct test_tcp_txcounters txcounters;
+  struct tcp_pcb* pcb;
+  struct pbuf *p;
+  ip_addr_t remote_ip, local_ip, netmask;
+  u16_t remote_port = 0x100, local_port = 0x101;
+  struct netif netif;
+  u32_t base;
+  u32_t sack1[] = {4, 8};
+  u32_t sack2[] = {12, 16, 4, 8};
+  u32_t sack3[] = {4, 16};
+  u32_t sack4[] = {20, 24, 4, 16};
+  u32_t sack5[] = {20, 24};
+  int i;
+  LWIP_UNUSED_ARG(_i);
+
+  for(i = 0; i < sizeof(data_full_wnd); i++) {
+    data_full_wnd[i] = (char)i;
+  }
+
+  /* initialize local vars */
+  IP_ADDR4(&local_ip, 192, 168, 1, 1);
+  IP_ADDR4(&remote_ip, 192, 168, 1, 2);
+  IP_ADDR4(&netmask,   255, 255, 255, 0);
+  test_tcp_init_netif(&netif, &txcounters, &local_ip, &netmask);
+  txcounters.copy_tx_packets = 1;
+  /* initialize counter struct */
+  memset(&counters, 0, sizeof(counters));
+  counters.expected_data_len = 24;
+  counters.expected_data = data_full_wnd;
+
+  /* create and initialize the pcb */
+  pcb = test_tcp_new_counters_pcb(&counters);
+  EXPECT_RET(pcb != NULL);
+  tcp_set_state(pcb, ESTABLISHED, &local_ip, &remote_ip, local_port, remote_port);
+  pcb->flags |= TF_SACK;
+  base = pcb->rcv_nxt;
+
+  p = tcp_create_rx_segment(pcb, &data_full_wnd[4], 4, 4, 0, TCP_ACK);
+  EXPECT_RET(p != NULL);
+  test_tcp_input(p, &netif);
+  check_tx_sack(&txcounters, base, sack1, 1);
+
+  p = tcp_create_rx_segment(pcb, &data_full_wnd[12], 4, 12, 0, TCP_ACK);
+  EXPECT_RET(p != NULL);
+  test_tcp_input(p, &netif);
+  check_tx_sack(&txcounters, base, sack2, 2);
+
+  /* filling the gap between the blocks merges them */
+  p = tcp_create_rx_segment(pcb, &data_full_wnd[8], 4, 8, 0, TCP_ACK);
+  EXPECT_RET(p != NULL);
+  test_tcp_input(p, &netif);
+  check_tx_sack(&txcounters, base, sack3, 1);
+
+  p = tcp_create_rx_segment(pcb, &data_full_wnd[20], 4, 20, 0, TCP_ACK);
+  EXPECT_RET(p != NULL);
+  test_tcp_input(p, &netif);
+  check_tx_sack(&txcounters, base, sack4, 2);
+
+  /* in-order data while a hole remains is acknowledged at once */
+  p = tcp_create_rx_segment(pcb, &data_full_wnd[0], 4, 0, 0, TCP_ACK);
+  EXPECT_RET(p != NULL);
+  test_tcp_input(p, &netif);
+  EXPECT(counters.recved_bytes == 16);
+  EXPECT(pcb->rcv_nxt == base + 16);
+  check_tx_sack(&txcounters, base, sack5, 1);
+
+  /* closing the last hole empties ooseq: no more SACK blocks */
+  p = tcp_create_rx_segment(pcb, &data_full_wnd[16], 4, 0, 0, TCP_ACK);
+  EXPECT_RET(p != NULL);
+  test_tcp_input(p, &netif);
+  EXPECT(counters.recved_bytes == 24);
+  EXPECT(counters.err_calls == 0);
+  EXPECT(pcb->ooseq == NULL);
+  /* send the delayed ACK */
+  tcp_fasttmr();
+  check_tx_sack(&txcounters, base, NULL, 0);
+
+  /* make sure the pcb is freed */
+  EXPECT(MEMP_STATS_GET(used, MEMP_TCP_PCB) == 1);
+  tcp_abort(pcb);
+  EXPECT(MEMP_STATS_GET(used, MEMP_TCP_PCB) == 0);
+}
+END_TEST
+#endif /* LWIP_TCP_SACK_OUT */
+
 static void
 check_rx_counters(struct tcp_pcb *pcb, struct test_tcp_counters *counters, u32_t exp_close_calls, u32_t exp_rx_calls,
                   u32_t exp_rx_bytes, u32_t exp_err_calls, int exp_oos_count, int exp_oos_len)
@@ -1028,6 +1142,9 @@ tcp_oos_suite(void)
     TESTFUNC(test_tcp_recv_ooseq_overrun_rxwin_edge),
     TESTFUNC(test_tcp_recv_ooseq_max_bytes),
     TESTFUNC(test_tcp_recv_ooseq_max_pbufs),
+#if LWIP_TCP_SACK_OUT
+    TESTFUNC(test_tcp_recv_ooseq_sack),
+#endif
     TESTFUNC(test_tcp_recv_ooseq_double_FIN_0),
     TESTFUNC(test_tcp_recv_ooseq_double_FIN_1),
     TESTFUNC(test_tcp_recv_ooseq_double_FIN_2),
@@ -176,10 +176,35 @@
         "adcq   %%rdx,   %%rcx      \n\t"   \
         "addq   $8,      %%rdi      \n\t"
 
+/*
+ * Eight limbs with one pointer update, the carry goes straight from rdx to
+ * rcx: s * b + c + *d fits in rdx:rax
+ */
+#define MULADDC_AMD64_LIMB( o )             \
+        "movq   " #o "(%%rsi), %%rax    \n\t"   \
+        "mulq   %%rbx                   \n\t"   \
+        "addq   %%rcx,   %%rax          \n\t"   \
+        "adcq   $0,      %%rdx          \n\t"   \
+        "addq   %%rax,   " #o "(%%rdi)  \n\t"   \
+        "adcq   $0,      %%rdx          \n\t"   \
+        "movq   %%rdx,   %%rcx          \n\t"
+
+#define MULADDC_HUIT                        \
+        MULADDC_AMD64_LIMB( 0 )             \
+        MULADDC_AMD64_LIMB( 8 )             \
+        MULADDC_AMD64_LIMB( 16 )            \
+        MULADDC_AMD64_LIMB( 24 )            \
+        MULADDC_AMD64_LIMB( 32 )            \
+        MULADDC_AMD64_LIMB( 40 )            \
+        MULADDC_AMD64_LIMB( 48 )            \
+        MULADDC_AMD64_LIMB( 56 )            \
+        "addq   $64,     %%rsi          \n\t"   \
+        "addq   $64,     %%rdi          \n\t"
+
 #define MULADDC_STOP                        \
         : "+c" (c), "+D" (d), "+S" (s)      \
         : "b" (b)                           \
-        : "rax", "rdx", "r8"                \
+        : "rax", "rdx", "r8", "cc", "memory" \
     );
 
 #endif /* AMD64 */
@@ -117,6 +117,13 @@
 #error "MBEDTLS_ECP_C defined, but not all prerequisites"
 #endif
 
+#if defined(MBEDTLS_ECP_FIXED_POINT_CACHE) &&                      \
+    ( !defined(MBEDTLS_ECP_C) ||                                   \
+      ( defined(MBEDTLS_ECP_FIXED_POINT_OPTIM) &&                  \
+        MBEDTLS_ECP_FIXED_POINT_OPTIM != 1 ) )
+#error "MBEDTLS_ECP_FIXED_POINT_CACHE defined, but not all prerequisites"
+#endif
+
 #if defined(MBEDTLS_ENTROPY_C) && (!defined(MBEDTLS_SHA512_C) &&      \
                                     !defined(MBEDTLS_SHA256_C))
 #error "MBEDTLS_ENTROPY_C defined, but not all prerequisites"
@@ -17,6 +17,8 @@
 
 #if defined(CONFIG_PLATFORM_8710C)
 //#define SUPPORT_HW_SSL_HMAC_SHA256
+/* AES-GCM counter mode keystream by the crypto engine (gcm.c), software GCM without it */
+#define SUPPORT_HW_SSL_AES_GCM
 #endif
 
 /* RTL_CRYPTO_FRAGMENT should be less than 16000, and should be 16bytes-aligned */
@@ -463,6 +463,28 @@
  */
 #define MBEDTLS_ECP_NIST_OPTIM
 
+/**
+ * \def MBEDTLS_ECP_FIXED_POINT_CACHE
+ *
+ * Keep the comb table of a curve generator for the whole program instead
+ * of the lifetime of one group (which is one handshake for the ECDH context
+ * and for the ECDSA context pk_sign() and pk_verify() copy a key into).
+ * ECDHE key generation, ECDSA signing and half of ECDSA verification
+ * multiply the generator, only the first one per curve then computes the
+ * table.
+ *
+ * Costs 1 << ( MBEDTLS_ECP_WINDOW_SIZE - 1 ) points per curve used (16
+ * points, about 2 KB for P-256 with a window of 5), freed by
+ * mbedtls_ecp_fixed_point_cache_free(). The cached table is computed with
+ * the full window, see MBEDTLS_ECP_WINDOW_SIZE. With the ROM ecp.c of
+ * AmebaZ2 the table of the ROM build is kept by ssl_func_stubs.c.
+ *
+ * Requires: MBEDTLS_ECP_C, MBEDTLS_ECP_FIXED_POINT_OPTIM == 1
+ *
+ * Comment this macro to compute the table once per group.
+ */
+#define MBEDTLS_ECP_FIXED_POINT_CACHE
+
 /**
  * \def MBEDTLS_ECDSA_DETERMINISTIC
  *
@@ -2504,7 +2526,7 @@
 
 /* ECP options */
 //#define MBEDTLS_ECP_MAX_BITS             521 /**< Maximum bit size of groups */
-//#define MBEDTLS_ECP_WINDOW_SIZE            6 /**< Maximum window size used */
+#define MBEDTLS_ECP_WINDOW_SIZE            5 /**< Maximum window size used, also of the cached generator tables */
 //#define MBEDTLS_ECP_FIXED_POINT_OPTIM      1 /**< Enable fixed-point speed-up */
 
 /* Entropy options */
@@ -463,6 +463,28 @@
  */
 #define MBEDTLS_ECP_NIST_OPTIM
 
+/**
+ * \def MBEDTLS_ECP_FIXED_POINT_CACHE
+ *
+ * Keep the comb table of a curve generator for the whole program instead
+ * of the lifetime of one group (which is one handshake for the ECDH context
+ * and for the ECDSA context pk_sign() and pk_verify() copy a key into).
+ * ECDHE key generation, ECDSA signing and half of ECDSA verification
+ * multiply the generator, only the first one per curve then computes the
+ * table.
+ *
+ * Costs 1 << ( MBEDTLS_ECP_WINDOW_SIZE - 1 ) points per curve used (16
+ * points, about 2 KB for P-256 with a window of 5), freed by
+ * mbedtls_ecp_fixed_point_cache_free(). The cached table is computed with
+ * the full window, see MBEDTLS_ECP_WINDOW_SIZE. With the ROM ecp.c of
+ * AmebaZ2 the table of the ROM build is kept by ssl_func_stubs.c.
+ *
+ * Requires: MBEDTLS_ECP_C, MBEDTLS_ECP_FIXED_POINT_OPTIM == 1
+ *
+ * Comment this macro to compute the table once per group.
+ */
+//#define MBEDTLS_ECP_FIXED_POINT_CACHE
+
 /**
  * \def MBEDTLS_ECDSA_DETERMINISTIC
  *
@@ -1842,7 +1864,7 @@
  * This module enables the AES-GCM and CAMELLIA-GCM ciphersuites, if other
  * requisites are enabled as well.
  */
-//#define MBEDTLS_GCM_C
+#define MBEDTLS_GCM_C
 
 /**
  * \def MBEDTLS_HAVEGE_C
@@ -653,6 +653,17 @@ int mbedtls_ecp_gen_key( mbedtls_ecp_group_id grp_id, mbedtls_ecp_keypair *key,
  */
 int mbedtls_ecp_check_pub_priv( const mbedtls_ecp_keypair *pub, const mbedtls_ecp_keypair *prv );
 
+#if defined(MBEDTLS_ECP_FIXED_POINT_CACHE)
+/**
+ * \brief           Free the generator comb tables kept by
+ *                  MBEDTLS_ECP_FIXED_POINT_CACHE
+ *
+ * \note            Only call it while no EC operation runs. The next
+ *                  multiplication of a generator computes its table again.
+ */
+void mbedtls_ecp_fixed_point_cache_free( void );
+#endif
+
 #if defined(MBEDTLS_SELF_TEST)
 /**
  * \brief          Checkup routine
@@ -888,7 +888,7 @@ int mbedtls_aes_crypt_ecb( mbedtls_aes_context *ctx,
         unsigned char key_buf[32 + 4], *key_buf_aligned;
         unsigned char output_buf[16 + 4];
 
-        key_buf_aligned = (unsigned char *) (((unsigned int) key_buf + 4) / 4 * 4);
+        key_buf_aligned = (unsigned char *) (((size_t) key_buf + 4) / 4 * 4);
 
         if(mode == MBEDTLS_AES_DECRYPT)
         {
@@ -912,7 +912,7 @@ int mbedtls_aes_crypt_ecb( mbedtls_aes_context *ctx,
     {
         unsigned char key_buf[32 + 32 + 32], *key_buf_aligned;
 
-        key_buf_aligned = (unsigned char *) (((unsigned int) key_buf + 32) / 32 * 32);
+        key_buf_aligned = (unsigned char *) (((size_t) key_buf + 32) / 32 * 32);
 
         if(mode == MBEDTLS_AES_DECRYPT)
         {
@@ -988,8 +988,8 @@ int mbedtls_aes_crypt_cbc( mbedtls_aes_context *ctx,
 
         if(length > 0)
         {
-            key_buf_aligned = (unsigned char *) (((unsigned int) key_buf + 4) / 4 * 4);
-            iv_buf_aligned = (unsigned char *) (((unsigned int) iv_buf + 4) / 4 * 4);
+            key_buf_aligned = (unsigned char *) (((size_t) key_buf + 4) / 4 * 4);
+            iv_buf_aligned = (unsigned char *) (((size_t) iv_buf + 4) / 4 * 4);
 
             if(length < RTL_CRYPTO_FRAGMENT)
                 output_buf = (unsigned char *)mbedtls_calloc(1, length + 4);
@@ -1055,8 +1055,8 @@ int mbedtls_aes_crypt_cbc( mbedtls_aes_context *ctx,
 
         if(length > 0)
         {
-            key_buf_aligned = (unsigned char *) (((unsigned int) key_buf + 32) / 32 * 32);
-            iv_buf_aligned = (unsigned char *) (((unsigned int) iv_buf + 32) / 32 * 32);
+            key_buf_aligned = (unsigned char *) (((size_t) key_buf + 32) / 32 * 32);
+            iv_buf_aligned = (unsigned char *) (((size_t) iv_buf + 32) / 32 * 32);
 
             memcpy(iv_buf_aligned, iv, 16);
 
@@ -1302,6 +1302,39 @@ cleanup:
     return( ret );
 }
 
+#if defined(MBEDTLS_ECP_FIXED_POINT_CACHE)
+#include "FreeRTOS.h"
+#include "task.h"
+
+/*
+ * Comb tables of the generators by group ID, computed by the first
+ * multiplication of G and then shared by all groups loaded with that ID
+ * (grp->T only lives as long as its group, e.g. the ECDH context of one
+ * handshake). If two threads compute the first table of a curve at once,
+ * the first one to finish installs its table and the other one frees its own.
+ */
+static mbedtls_ecp_point *ecp_comb_cache[MBEDTLS_ECP_DP_MAX];
+static unsigned char ecp_comb_cache_len[MBEDTLS_ECP_DP_MAX];
+
+void mbedtls_ecp_fixed_point_cache_free( void )
+{
+    size_t id, i;
+
+    for( id = 0; id < MBEDTLS_ECP_DP_MAX; id++ )
+    {
+        if( ecp_comb_cache[id] == NULL )
+            continue;
+
+        for( i = 0; i < ecp_comb_cache_len[id]; i++ )
+            mbedtls_ecp_point_free( &ecp_comb_cache[id][i] );
+        mbedtls_free( ecp_comb_cache[id] );
+
+        ecp_comb_cache[id] = NULL;
+        ecp_comb_cache_len[id] = 0;
+    }
+}
+#endif /* MBEDTLS_ECP_FIXED_POINT_CACHE */
+
 /*
  * Multiplication using the comb method,
  * for curves in short Weierstrass form
@@ -1312,7 +1345,7 @@ static int ecp_mul_comb( mbedtls_ecp_group *grp, mbedtls_ecp_point *R,
                          void *p_rng )
 {
     int ret;
-    unsigned char w, m_is_odd, p_eq_g, pre_len, i;
+    unsigned char w, m_is_odd, p_eq_g, p_cache, pre_len, i;
     size_t d;
     unsigned char k[COMB_MAX_D + 1];
     mbedtls_ecp_point *T;
@@ -1346,6 +1379,19 @@ static int ecp_mul_comb( mbedtls_ecp_group *grp, mbedtls_ecp_point *R,
     p_eq_g = 0;
 #endif
 
+    /*
+     * The table of a cached generator is computed once, so it gets the
+     * largest window: fewer additions per multiplication for
+     * 1 << ( MBEDTLS_ECP_WINDOW_SIZE - 1 ) points kept per curve.
+     */
+#if defined(MBEDTLS_ECP_FIXED_POINT_CACHE)
+    p_cache = ( p_eq_g && grp->id > MBEDTLS_ECP_DP_NONE && grp->id < MBEDTLS_ECP_DP_MAX );
+    if( p_cache )
+        w = MBEDTLS_ECP_WINDOW_SIZE;
+#else
+    p_cache = 0;
+#endif
+
     /*
      * Make sure w is within bounds.
      * (The last test is useful only for very small curves in the test suite.)
@@ -1365,6 +1411,11 @@ static int ecp_mul_comb( mbedtls_ecp_group *grp, mbedtls_ecp_point *R,
      */
     T = p_eq_g ? grp->T : NULL;
 
+#if defined(MBEDTLS_ECP_FIXED_POINT_CACHE)
+    if( p_cache && T == NULL )
+        T = ecp_comb_cache[grp->id];
+#endif
+
     if( T == NULL )
     {
         T = mbedtls_calloc( pre_len, sizeof( mbedtls_ecp_point ) );
@@ -1376,6 +1427,30 @@ static int ecp_mul_comb( mbedtls_ecp_group *grp, mbedtls_ecp_point *R,
 
         MBEDTLS_MPI_CHK( ecp_precompute_comb( grp, T, P, w, d ) );
 
+#if defined(MBEDTLS_ECP_FIXED_POINT_CACHE)
+        if( p_cache )
+        {
+            mbedtls_ecp_point *cached;
+
+            vTaskSuspendAll();
+            if( ( cached = ecp_comb_cache[grp->id] ) == NULL )
+            {
+                ecp_comb_cache_len[grp->id] = pre_len;
+                ecp_comb_cache[grp->id] = T;
+            }
+            xTaskResumeAll();
+
+            /* computed at the same time by another thread, use its table */
+            if( cached != NULL )
+            {
+                for( i = 0; i < pre_len; i++ )
+                    mbedtls_ecp_point_free( &T[i] );
+                mbedtls_free( T );
+                T = cached;
+            }
+        }
+        else
+#endif
         if( p_eq_g )
         {
             grp->T = T;
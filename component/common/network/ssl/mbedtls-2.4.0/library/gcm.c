@@ -45,6 +45,11 @@
 #include "mbedtls/aesni.h"
 #endif
 
+#if defined(RTL_HW_CRYPTO) && defined(SUPPORT_HW_SSL_AES_GCM)
+#include "mbedtls/aes.h"
+#include "device_lock.h"
+#endif
+
 #if defined(MBEDTLS_SELF_TEST) && defined(MBEDTLS_AES_C)
 #if defined(MBEDTLS_PLATFORM_C)
 #include "mbedtls/platform.h"
@@ -344,6 +349,107 @@ int mbedtls_gcm_starts( mbedtls_gcm_context *ctx,
     return( 0 );
 }
 
+#if defined(RTL_HW_CRYPTO) && defined(SUPPORT_HW_SSL_AES_GCM)
+/*
+ * Counter blocks encrypted per crypto engine call. The cipher layer takes one
+ * engine key setup and one ECB pass for every 16-byte block, here both are
+ * taken once for up to GCM_HW_CTR_BLOCKS blocks of keystream.
+ */
+#ifndef GCM_HW_CTR_BLOCKS
+#define GCM_HW_CTR_BLOCKS       16
+#endif
+
+static int gcm_hw_use( mbedtls_gcm_context *ctx )
+{
+    mbedtls_cipher_type_t type = mbedtls_cipher_get_type( &ctx->cipher_ctx );
+
+    return( rom_ssl_ram_map.use_hw_crypto_func &&
+            rom_ssl_ram_map.hw_crypto_aes_ecb_init != NULL &&
+            rom_ssl_ram_map.hw_crypto_aes_ecb_encrypt != NULL &&
+            ( type == MBEDTLS_CIPHER_AES_128_ECB ||
+              type == MBEDTLS_CIPHER_AES_192_ECB ||
+              type == MBEDTLS_CIPHER_AES_256_ECB ) );
+}
+
+/*
+ * CTR keystream from the AES engine, GHASH with the 4-bit tables as in
+ * mbedtls_gcm_update()
+ */
+static int gcm_hw_update( mbedtls_gcm_context *ctx,
+                          size_t length,
+                          const unsigned char *input,
+                          unsigned char *output )
+{
+    int ret = 0;
+    mbedtls_aes_context *aes = (mbedtls_aes_context *) ctx->cipher_ctx.cipher_ctx;
+    unsigned char key_buf[32 + 32 + 32], *key_buf_aligned;
+    unsigned char ctr_buf[GCM_HW_CTR_BLOCKS * 16 + 32], *ctr;
+    unsigned char ectr_buf[GCM_HW_CTR_BLOCKS * 16 + 32], *ectr;
+    size_t i, b, n, use_len;
+    const unsigned char *p = input;
+    unsigned char *out_p = output;
+
+    key_buf_aligned = (unsigned char *) (((size_t) key_buf + 32) / 32 * 32);
+    ctr = (unsigned char *) (((size_t) ctr_buf + 32) / 32 * 32);
+    ectr = (unsigned char *) (((size_t) ectr_buf + 32) / 32 * 32);
+
+    memcpy( key_buf_aligned, aes->enc_key, ( aes->nr - 6 ) * 4 );
+
+    while( length > 0 )
+    {
+        n = ( length + 15 ) / 16;
+        if( n > GCM_HW_CTR_BLOCKS )
+            n = GCM_HW_CTR_BLOCKS;
+
+        for( b = 0; b < n; b++ )
+        {
+            for( i = 16; i > 12; i-- )
+                if( ++ctx->y[i - 1] != 0 )
+                    break;
+
+            memcpy( ctr + b * 16, ctx->y, 16 );
+        }
+
+        device_mutex_lock( RT_DEV_LOCK_CRYPTO );
+        ret = rom_ssl_ram_map.hw_crypto_aes_ecb_init( key_buf_aligned, ( aes->nr - 6 ) * 4 );
+        if( ret == 0 )
+            ret = rom_ssl_ram_map.hw_crypto_aes_ecb_encrypt( ctr, n * 16, NULL, 0, ectr );
+        device_mutex_unlock( RT_DEV_LOCK_CRYPTO );
+
+        if( ret != 0 )
+        {
+            ret = MBEDTLS_ERR_GCM_HW_ACCEL_FAILED;
+            break;
+        }
+
+        for( b = 0; b < n; b++ )
+        {
+            use_len = ( length < 16 ) ? length : 16;
+
+            for( i = 0; i < use_len; i++ )
+            {
+                if( ctx->mode == MBEDTLS_GCM_DECRYPT )
+                    ctx->buf[i] ^= p[i];
+                out_p[i] = ectr[b * 16 + i] ^ p[i];
+                if( ctx->mode == MBEDTLS_GCM_ENCRYPT )
+                    ctx->buf[i] ^= out_p[i];
+            }
+
+            gcm_mult( ctx, ctx->buf, ctx->buf );
+
+            length -= use_len;
+            p += use_len;
+            out_p += use_len;
+        }
+    }
+
+    mbedtls_zeroize( key_buf, sizeof( key_buf ) );
+    mbedtls_zeroize( ectr_buf, sizeof( ectr_buf ) );
+
+    return( ret );
+}
+#endif /* RTL_HW_CRYPTO && SUPPORT_HW_SSL_AES_GCM */
+
 int mbedtls_gcm_update( mbedtls_gcm_context *ctx,
                 size_t length,
                 const unsigned char *input,
@@ -369,6 +475,11 @@ int mbedtls_gcm_update( mbedtls_gcm_context *ctx,
 
     ctx->len += length;
 
+#if defined(RTL_HW_CRYPTO) && defined(SUPPORT_HW_SSL_AES_GCM)
+    if( gcm_hw_use( ctx ) )
+        return( gcm_hw_update( ctx, length, input, output ) );
+#endif
+
     p = input;
     while( length > 0 )
     {
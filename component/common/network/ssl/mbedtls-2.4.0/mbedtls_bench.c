@@ -0,0 +1,397 @@
+/*
+ *  Public key micro-benchmark of the TLS handshake
+ *
+ *  Times the RSA-2048, DHE-2048, ECDSA P-256 and ECDHE P-256 operations a
+ *  handshake takes, to compare bignum and ECP builds, e.g. with and without
+ *  the bn_mul.h assembly (MBEDTLS_HAVE_ASM). Each operation is checked once
+ *  and repeated for at least BENCH_MIN_MS. Algorithms the configuration
+ *  leaves out are skipped.
+ *
+ *  Call mbedtls_pk_bench() from a task with CONFIG_SSL_BENCH defined. Only
+ *  the mbedtls code built in RAM is measured, the ROM bignum of AmebaZ2 is
+ *  not built with bn_mul.h of this tree. The lwIP host build runs it as
+ *  pk_bench (see its README).
+ */
+
+#if !defined(MBEDTLS_CONFIG_FILE)
+#include "mbedtls/config.h"
+#else
+#include MBEDTLS_CONFIG_FILE
+#endif
+
+#ifdef CONFIG_SSL_BENCH
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#if defined(MBEDTLS_PLATFORM_C)
+#include "mbedtls/platform.h"
+#else
+#include <stdio.h>
+#define mbedtls_printf     printf
+#endif
+
+#include "mbedtls/bignum.h"
+#include "mbedtls/rsa.h"
+#include "mbedtls/dhm.h"
+#include "mbedtls/ecdsa.h"
+#include "mbedtls/ecdh.h"
+
+#define BENCH_MIN_MS        1000
+#define BENCH_MIN_COUNT     2
+
+/*
+ * RSA-2048 test key
+ */
+#define KEY_LEN  256
+
+#define RSA_N  \
+    "AC9357E6DA46EDAA3450F85BFAAF93D6C0B59386D834DDFE7C72845CFF37C3C8" \
+    "7D3307AF6BFAF0ADC5C7091708C2FAC93765F8963EA6F1AC4CB7BDE29E36F738" \
+    "2A5D3B2898AB913CAA0C574A53177CB5CA8E102F99E783BA28D99EDC1E926A54" \
+    "8932D95921541A38AA5C2E7D60D6150C06ACE39CC73F67C56232E91A0069AD13" \
+    "CC728B5F99EE7C84C4847CE89C20D89DCC91AC82C684726D916DB5585524836C" \
+    "2BC0DABE3D688E1E305E48AF4A86E7A646CA1368FD7B90A0DE56B2807BAE3B94" \
+    "7AAD383A75AB322C758E2EE9D8A36D1C107BAF9E788C950F8EEF5A110EA93B45" \
+    "BD8075302D4240A9B44F26034701C490163370EB8B9528CC5BEC86483CEC8BC5"
+
+#define RSA_D  \
+    "072B70EFB59A5445E9BA027379D101149F397BF95272B1D56090B66891AEDCAA" \
+    "AFEEE68F166E9CC0AF7293315A8B1535B6603D696A8D6F856FC383774E88EC90" \
+    "F00BA3094EFC73C28033168E4F30EEDCB39F5ED34772DBA168908FFDC7A46018" \
+    "06822F0EF9A83F95A29845532EAA7E41DB6623E7AFCC75D078C1B2370314E0DC" \
+    "9BFBB52C56CC23E714E85C694BF09BAFA15BC6391D7E58F848825BF284D92B39" \
+    "7744A8CEBA57E2B9A2F7265B2EB292B1BB39A630CC39020B4BD706E9A618E40B" \
+    "ECBCB3AE2719F4FCAFCE6696A99BAF804C0AB280E93AE580479872557BE996C4" \
+    "E2815E3DF7AECB7991277A0EB7021CC54F0784A010ADCF3A7B566119A5D50D31"
+
+#define RSA_P  \
+    "DA7D9739018B020F3375A83C4C40B8A8FA76DBF397A40FD78FE6E6F6ABE42D3C" \
+    "1581EC59F0B4174D9E08C2418E4075B65A3525793FB3D467C3BC78878E532284" \
+    "1018E0AE2B5FA96E505C6B74E9EF180E38AC282296D521AD5F289C82760741C4" \
+    "1E54684F17E46A0BB8C14144663B96AE4E93E0733BFB706E3AAD7D29BDF0D1D1"
+
+#define RSA_Q  \
+    "CA33D711E3B9E3CA6A95A714B0EA6E957441734699CEA44BA2D51B89D9FBFFB8" \
+    "ADCC6792F1B432F9B046DFD61E752F391AD41EDB52B4EDDCA4C3022D4BFC6150" \
+    "774EBFE13690419FE9B785413FA0095E1656124045DE66BE9407B779BF3EE19A" \
+    "830F1D7756B005D456CC902D834EF4B33BE0009585FB16DB448A90AC73F6C3B5"
+
+#define RSA_DP  \
+    "46B37336D028023F970050B34A5D7B23BB00B1460EE0D8FB81264FC0AC78C6A6" \
+    "75B3381F1683C032AE9BD8F84BA6D23072DA55C8F973209D7F3A42AA62C4C61B" \
+    "83F5F8E683448E58130B04FEAD20606161B75BB96DA384254CF0A04C9B12D816" \
+    "35564CF6A31D97AF3956D7DEE15210FD50920B845E798BB52FA9AA21D2C3D5B1"
+
+#define RSA_DQ  \
+    "9A7CF11D61F86CEA027544AAB260EB0C953E4C6CECA6CD305CC0A5C1B522AC46" \
+    "D5C30E7F5EDC66F60E9098046850F03B991BE85779E172BAD9C784AA471C14DD" \
+    "FDC9D520A527A27C237D6BFA663A47EDF2F2E00EEB52F8FD32EC926A1A8C58A2" \
+    "4CF0077B5E682E8C05A555A2F0682ADDA6298748B68D18F17E74C00482B54EE1"
+
+#define RSA_QP  \
+    "95FB3B1CDFEE797410949025CDEBC63A9F8EDF622983840DC2C371DAFE727780" \
+    "370A58CE509EA005BEEE5D27A9044EF640F6C3E6CED0B9D7DCC08F3B253F36D1" \
+    "B4D1A86BDDCCCCA701B349D7EB32BE70AF788D9C52B304F58CD6D34A405E5B94" \
+    "57BE45E65CF37D964F9343D1F7B0452682660E30F5A8D17D2F56C8AF0B715820"
+
+#define RSA_E   "10001"
+
+static int myrand( void *rng_state, unsigned char *output, size_t len )
+{
+    size_t i;
+
+    if( rng_state != NULL )
+        rng_state  = NULL;
+
+    for( i = 0; i < len; ++i )
+        output[i] = rand();
+
+    return( 0 );
+}
+
+/*
+ * Runs op until BENCH_MIN_MS passed, prints the time per operation
+ */
+static int bench_run( const char *name, int (*op)( void * ), void *arg )
+{
+    int ret;
+    unsigned long count = 0, elapsed;
+    TickType_t start = xTaskGetTickCount();
+
+    do
+    {
+        if( ( ret = op( arg ) ) != 0 )
+        {
+            mbedtls_printf( "  %-24s failed -0x%04x\n", name, -ret );
+            return( ret );
+        }
+
+        count++;
+        elapsed = ( xTaskGetTickCount() - start ) * portTICK_PERIOD_MS;
+    }
+    while( elapsed < BENCH_MIN_MS || count < BENCH_MIN_COUNT );
+
+    mbedtls_printf( "  %-24s %6lu.%02lu ms  (%lu in %lu ms)\n", name,
+                    elapsed / count, ( elapsed * 100 / count ) % 100, count, elapsed );
+
+    return( 0 );
+}
+
+#if defined(MBEDTLS_RSA_C)
+static unsigned char rsa_in[KEY_LEN], rsa_out[KEY_LEN], rsa_chk[KEY_LEN];
+
+/* server signature verification, RSA key exchange encryption */
+static int bench_rsa_public( void *ctx )
+{
+    return( mbedtls_rsa_public( (mbedtls_rsa_context *) ctx, rsa_in, rsa_out ) );
+}
+
+/* CRT with blinding, as the server signs or decrypts */
+static int bench_rsa_private( void *ctx )
+{
+    return( mbedtls_rsa_private( (mbedtls_rsa_context *) ctx, myrand, NULL, rsa_in, rsa_out ) );
+}
+
+static int bench_rsa( void )
+{
+    int ret;
+    mbedtls_rsa_context rsa;
+
+    mbedtls_rsa_init( &rsa, MBEDTLS_RSA_PKCS_V15, 0 );
+
+    rsa.len = KEY_LEN;
+    MBEDTLS_MPI_CHK( mbedtls_mpi_read_string( &rsa.N , 16, RSA_N  ) );
+    MBEDTLS_MPI_CHK( mbedtls_mpi_read_string( &rsa.E , 16, RSA_E  ) );
+    MBEDTLS_MPI_CHK( mbedtls_mpi_read_string( &rsa.D , 16, RSA_D  ) );
+    MBEDTLS_MPI_CHK( mbedtls_mpi_read_string( &rsa.P , 16, RSA_P  ) );
+    MBEDTLS_MPI_CHK( mbedtls_mpi_read_string( &rsa.Q , 16, RSA_Q  ) );
+    MBEDTLS_MPI_CHK( mbedtls_mpi_read_string( &rsa.DP, 16, RSA_DP ) );
+    MBEDTLS_MPI_CHK( mbedtls_mpi_read_string( &rsa.DQ, 16, RSA_DQ ) );
+    MBEDTLS_MPI_CHK( mbedtls_mpi_read_string( &rsa.QP, 16, RSA_QP ) );
+
+    myrand( NULL, rsa_in, KEY_LEN );
+    rsa_in[0] = 0;
+
+    /* private( public( x ) ) == x */
+    MBEDTLS_MPI_CHK( mbedtls_rsa_public( &rsa, rsa_in, rsa_out ) );
+    MBEDTLS_MPI_CHK( mbedtls_rsa_private( &rsa, myrand, NULL, rsa_out, rsa_chk ) );
+    if( memcmp( rsa_chk, rsa_in, KEY_LEN ) != 0 )
+    {
+        mbedtls_printf( "  RSA-2048 check failed\n" );
+        ret = 1;
+        goto cleanup;
+    }
+
+    MBEDTLS_MPI_CHK( bench_run( "RSA-2048 public", bench_rsa_public, &rsa ) );
+    MBEDTLS_MPI_CHK( bench_run( "RSA-2048 private", bench_rsa_private, &rsa ) );
+
+cleanup:
+    mbedtls_rsa_free( &rsa );
+
+    return( ret );
+}
+#endif /* MBEDTLS_RSA_C */
+
+#if defined(MBEDTLS_DHM_C)
+/* client side of DHE: own public value and the shared secret */
+static int bench_dhe_client( void *ctx )
+{
+    int ret;
+    size_t olen;
+    unsigned char buf[KEY_LEN];
+    mbedtls_dhm_context *dhm = (mbedtls_dhm_context *) ctx;
+
+    MBEDTLS_MPI_CHK( mbedtls_dhm_make_public( dhm, (int) dhm->len, buf, dhm->len, myrand, NULL ) );
+    MBEDTLS_MPI_CHK( mbedtls_dhm_calc_secret( dhm, buf, sizeof( buf ), &olen, myrand, NULL ) );
+
+cleanup:
+    return( ret );
+}
+
+static int bench_dhm( void )
+{
+    int ret;
+    unsigned char buf[KEY_LEN];
+    mbedtls_dhm_context srv, cli;
+
+    mbedtls_dhm_init( &srv );
+    mbedtls_dhm_init( &cli );
+
+    MBEDTLS_MPI_CHK( mbedtls_mpi_read_string( &srv.P, 16, MBEDTLS_DHM_RFC3526_MODP_2048_P ) );
+    MBEDTLS_MPI_CHK( mbedtls_mpi_read_string( &srv.G, 16, MBEDTLS_DHM_RFC3526_MODP_2048_G ) );
+    srv.len = mbedtls_mpi_size( &srv.P );
+    MBEDTLS_MPI_CHK( mbedtls_dhm_make_public( &srv, (int) srv.len, buf, srv.len, myrand, NULL ) );
+
+    MBEDTLS_MPI_CHK( mbedtls_mpi_copy( &cli.P, &srv.P ) );
+    MBEDTLS_MPI_CHK( mbedtls_mpi_copy( &cli.G, &srv.G ) );
+    MBEDTLS_MPI_CHK( mbedtls_mpi_copy( &cli.GY, &srv.GX ) );
+    cli.len = srv.len;
+
+    MBEDTLS_MPI_CHK( bench_run( "DHE-2048 client", bench_dhe_client, &cli ) );
+
+    /* both sides agree */
+    MBEDTLS_MPI_CHK( mbedtls_mpi_copy( &srv.GY, &cli.GX ) );
+    MBEDTLS_MPI_CHK( mbedtls_mpi_exp_mod( &srv.K, &srv.GY, &srv.X, &srv.P, &srv.RP ) );
+    if( mbedtls_mpi_cmp_mpi( &srv.K, &cli.K ) != 0 )
+    {
+        mbedtls_printf( "  DHE-2048 check failed\n" );
+        ret = 1;
+    }
+
+cleanup:
+    mbedtls_dhm_free( &srv );
+    mbedtls_dhm_free( &cli );
+
+    return( ret );
+}
+#endif /* MBEDTLS_DHM_C */
+
+#if defined(MBEDTLS_ECP_C) && defined(MBEDTLS_ECP_DP_SECP256R1_ENABLED)
+/*
+ * The operations load a group of their own, as a handshake does with its
+ * ECDH context or the ECDSA context pk_sign() and pk_verify() copy the key
+ * to, so the generator comb table of a group is not reused between them.
+ */
+typedef struct
+{
+    mbedtls_ecp_group grp;
+    mbedtls_mpi d, r, s, z;
+    mbedtls_ecp_point Q, peer_Q;
+    unsigned char hash[32];
+}
+bench_ecp_context;
+
+#if defined(MBEDTLS_ECDSA_C)
+static int bench_ecdsa_sign( void *arg )
+{
+    int ret;
+    mbedtls_ecp_group grp;
+    bench_ecp_context *ctx = (bench_ecp_context *) arg;
+
+    mbedtls_ecp_group_init( &grp );
+    MBEDTLS_MPI_CHK( mbedtls_ecp_group_load( &grp, MBEDTLS_ECP_DP_SECP256R1 ) );
+    MBEDTLS_MPI_CHK( mbedtls_ecdsa_sign( &grp, &ctx->r, &ctx->s, &ctx->d,
+                                         ctx->hash, sizeof( ctx->hash ), myrand, NULL ) );
+
+cleanup:
+    mbedtls_ecp_group_free( &grp );
+
+    return( ret );
+}
+
+static int bench_ecdsa_verify( void *arg )
+{
+    int ret;
+    mbedtls_ecp_group grp;
+    bench_ecp_context *ctx = (bench_ecp_context *) arg;
+
+    mbedtls_ecp_group_init( &grp );
+    MBEDTLS_MPI_CHK( mbedtls_ecp_group_load( &grp, MBEDTLS_ECP_DP_SECP256R1 ) );
+    MBEDTLS_MPI_CHK( mbedtls_ecdsa_verify( &grp, ctx->hash, sizeof( ctx->hash ),
+                                           &ctx->Q, &ctx->r, &ctx->s ) );
+
+cleanup:
+    mbedtls_ecp_group_free( &grp );
+
+    return( ret );
+}
+#endif /* MBEDTLS_ECDSA_C */
+
+#if defined(MBEDTLS_ECDH_C)
+/* client side of ECDHE: ephemeral key pair and the shared secret */
+static int bench_ecdhe_client( void *arg )
+{
+    int ret;
+    mbedtls_ecp_group grp;
+    bench_ecp_context *ctx = (bench_ecp_context *) arg;
+
+    mbedtls_ecp_group_init( &grp );
+    MBEDTLS_MPI_CHK( mbedtls_ecp_group_load( &grp, MBEDTLS_ECP_DP_SECP256R1 ) );
+    MBEDTLS_MPI_CHK( mbedtls_ecdh_gen_public( &grp, &ctx->d, &ctx->Q, myrand, NULL ) );
+    MBEDTLS_MPI_CHK( mbedtls_ecdh_compute_shared( &grp, &ctx->z, &ctx->peer_Q, &ctx->d,
+                                                  myrand, NULL ) );
+
+cleanup:
+    mbedtls_ecp_group_free( &grp );
+
+    return( ret );
+}
+#endif /* MBEDTLS_ECDH_C */
+
+static int bench_ecp( void )
+{
+    int ret;
+    bench_ecp_context ctx;
+    mbedtls_mpi peer_d;
+
+    mbedtls_ecp_group_init( &ctx.grp );
+    mbedtls_mpi_init( &ctx.d ); mbedtls_mpi_init( &ctx.r ); mbedtls_mpi_init( &ctx.s );
+    mbedtls_mpi_init( &ctx.z ); mbedtls_mpi_init( &peer_d );
+    mbedtls_ecp_point_init( &ctx.Q ); mbedtls_ecp_point_init( &ctx.peer_Q );
+    myrand( NULL, ctx.hash, sizeof( ctx.hash ) );
+
+    MBEDTLS_MPI_CHK( mbedtls_ecp_group_load( &ctx.grp, MBEDTLS_ECP_DP_SECP256R1 ) );
+    MBEDTLS_MPI_CHK( mbedtls_ecp_gen_keypair( &ctx.grp, &ctx.d, &ctx.Q, myrand, NULL ) );
+    MBEDTLS_MPI_CHK( mbedtls_ecp_gen_keypair( &ctx.grp, &peer_d, &ctx.peer_Q, myrand, NULL ) );
+
+#if defined(MBEDTLS_ECDSA_C)
+    /* verify() checks sign() */
+    MBEDTLS_MPI_CHK( bench_run( "ECDSA P-256 sign", bench_ecdsa_sign, &ctx ) );
+    MBEDTLS_MPI_CHK( bench_run( "ECDSA P-256 verify", bench_ecdsa_verify, &ctx ) );
+#endif
+
+#if defined(MBEDTLS_ECDH_C)
+    MBEDTLS_MPI_CHK( bench_run( "ECDHE P-256 client", bench_ecdhe_client, &ctx ) );
+
+    /* both sides agree */
+    MBEDTLS_MPI_CHK( mbedtls_ecdh_compute_shared( &ctx.grp, &ctx.r, &ctx.Q, &peer_d, myrand, NULL ) );
+    if( mbedtls_mpi_cmp_mpi( &ctx.r, &ctx.z ) != 0 )
+    {
+        mbedtls_printf( "  ECDHE P-256 check failed\n" );
+        ret = 1;
+    }
+#endif
+
+cleanup:
+    mbedtls_ecp_group_free( &ctx.grp );
+    mbedtls_mpi_free( &ctx.d ); mbedtls_mpi_free( &ctx.r ); mbedtls_mpi_free( &ctx.s );
+    mbedtls_mpi_free( &ctx.z ); mbedtls_mpi_free( &peer_d );
+    mbedtls_ecp_point_free( &ctx.Q ); mbedtls_ecp_point_free( &ctx.peer_Q );
+
+    return( ret );
+}
+#endif /* MBEDTLS_ECP_C && MBEDTLS_ECP_DP_SECP256R1_ENABLED */
+
+int mbedtls_pk_bench( void )
+{
+    int ret = 0;
+
+    mbedtls_printf( "mbedtls_pk_bench: bn_mul.h %s\n",
+#if defined(MBEDTLS_HAVE_ASM)
+                    "assembly"
+#else
+                    "C"
+#endif
+                    );
+
+#if defined(MBEDTLS_RSA_C)
+    if( ret == 0 )
+        ret = bench_rsa();
+#endif
+#if defined(MBEDTLS_DHM_C)
+    if( ret == 0 )
+        ret = bench_dhm();
+#endif
+#if defined(MBEDTLS_ECP_C) && defined(MBEDTLS_ECP_DP_SECP256R1_ENABLED)
+    if( ret == 0 )
+        ret = bench_ecp();
+#endif
+
+    return( ret );
+}
+
+#endif /* CONFIG_SSL_BENCH */
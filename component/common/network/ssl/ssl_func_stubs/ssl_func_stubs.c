@@ -423,6 +423,12 @@ int platform_set_malloc_free(
 	init_rom_ssl_hw_crypto_aes_cbc(rtl_crypto_aes_cbc_init, rtl_crypto_aes_cbc_decrypt, rtl_crypto_aes_cbc_encrypt);
 #endif
 #endif
+#if defined(CONFIG_PLATFORM_8710C) && defined(SUPPORT_HW_SSL_AES_GCM) && (defined(MBEDTLS_VERSION_NUMBER) && MBEDTLS_VERSION_NUMBER == 0x02040000)
+	//AES HW CRYPTO for the GCM keystream of gcm.c in RAM
+	rom_ssl_ram_map.hw_crypto_aes_ecb_init = rtl_crypto_aes_ecb_init;
+	rom_ssl_ram_map.hw_crypto_aes_ecb_decrypt = rtl_crypto_aes_ecb_decrypt;
+	rom_ssl_ram_map.hw_crypto_aes_ecb_encrypt = rtl_crypto_aes_ecb_encrypt;
+#endif
 #if defined(CONFIG_PLATFORM_8710C)
 	/// DES funtions are on longer supported on AmebaZ2's HW crypto
 	/// Must set them to NULL, so it will use SW instead of HW even use_hw_crypto_func is enabled
@@ -654,6 +660,72 @@ int mbedtls_mpi_gen_prime(mbedtls_mpi *X, size_t nbits, int dh_flag, int (*f_rng
 }
 
 /* ecp */
+#if defined(MBEDTLS_ECP_FIXED_POINT_CACHE)
+#include "FreeRTOS.h"
+#include "task.h"
+
+/*
+ * Generator comb tables by group ID (MBEDTLS_ECP_FIXED_POINT_CACHE of ecp.c for the ROM).
+ * The ROM ecp_mul() keeps the table of G in grp->T only until the group is freed, i.e.
+ * once per handshake. The stubs below lend the cached table to the group for the ROM call
+ * and take it back before the group can be freed, so it is computed once per curve, with
+ * the window of the ROM build.
+ */
+static mbedtls_ecp_point *ecp_comb_cache[MBEDTLS_ECP_DP_MAX];
+static size_t ecp_comb_cache_len[MBEDTLS_ECP_DP_MAX];
+
+static void ecp_comb_cache_lend(mbedtls_ecp_group *grp)
+{
+	if (grp->id > MBEDTLS_ECP_DP_NONE && grp->id < MBEDTLS_ECP_DP_MAX && grp->T == NULL) {
+		grp->T = ecp_comb_cache[grp->id];
+		grp->T_size = ecp_comb_cache_len[grp->id];
+	}
+}
+
+static void ecp_comb_cache_return(mbedtls_ecp_group *grp)
+{
+	if (grp->id <= MBEDTLS_ECP_DP_NONE || grp->id >= MBEDTLS_ECP_DP_MAX || grp->T == NULL)
+		return;
+
+	vTaskSuspendAll();
+	if (ecp_comb_cache[grp->id] == NULL) {
+		/* computed by this call */
+		ecp_comb_cache[grp->id] = grp->T;
+		ecp_comb_cache_len[grp->id] = grp->T_size;
+	}
+	if (grp->T == ecp_comb_cache[grp->id]) {
+		grp->T = NULL;
+		grp->T_size = 0;
+	}
+	xTaskResumeAll();
+}
+
+void mbedtls_ecp_fixed_point_cache_free(void)
+{
+	mbedtls_ecp_group grp;
+	int id;
+
+	/* the ROM frees what it allocated */
+	for (id = 0; id < MBEDTLS_ECP_DP_MAX; id++) {
+		if (ecp_comb_cache[id] == NULL)
+			continue;
+
+		mbedtls_ecp_group_init(&grp);
+		grp.T = ecp_comb_cache[id];
+		grp.T_size = ecp_comb_cache_len[id];
+		ecp_comb_cache[id] = NULL;
+		ecp_comb_cache_len[id] = 0;
+		mbedtls_ecp_group_free(&grp);
+	}
+}
+
+#define ECP_COMB_CACHE_LEND(grp)    ecp_comb_cache_lend(grp)
+#define ECP_COMB_CACHE_RETURN(grp)  ecp_comb_cache_return(grp)
+#else
+#define ECP_COMB_CACHE_LEND(grp)
+#define ECP_COMB_CACHE_RETURN(grp)
+#endif /* MBEDTLS_ECP_FIXED_POINT_CACHE */
+
 const mbedtls_ecp_curve_info *mbedtls_ecp_curve_list(void)
 {
 	return __rom_stubs_ssl.mbedtls_ecp_curve_list();
@@ -776,22 +848,46 @@ int mbedtls_ecp_check_privkey(const mbedtls_ecp_group *grp, const mbedtls_mpi *d
 
 int mbedtls_ecp_mul(mbedtls_ecp_group *grp, mbedtls_ecp_point *R, const mbedtls_mpi *m, const mbedtls_ecp_point *P, int (*f_rng)(void *, unsigned char *, size_t), void *p_rng)
 {
-	return __rom_stubs_ssl.mbedtls_ecp_mul(grp, R, m, P, f_rng, p_rng);
+	int ret;
+
+	ECP_COMB_CACHE_LEND(grp);
+	ret = __rom_stubs_ssl.mbedtls_ecp_mul(grp, R, m, P, f_rng, p_rng);
+	ECP_COMB_CACHE_RETURN(grp);
+
+	return ret;
 }
 
 int mbedtls_ecp_muladd(mbedtls_ecp_group *grp, mbedtls_ecp_point *R, const mbedtls_mpi *m, const mbedtls_ecp_point *P, const mbedtls_mpi *n, const mbedtls_ecp_point *Q)
 {
-	return __rom_stubs_ssl.mbedtls_ecp_muladd(grp, R, m, P, n, Q);
+	int ret;
+
+	ECP_COMB_CACHE_LEND(grp);
+	ret = __rom_stubs_ssl.mbedtls_ecp_muladd(grp, R, m, P, n, Q);
+	ECP_COMB_CACHE_RETURN(grp);
+
+	return ret;
 }
 
 int mbedtls_ecp_gen_keypair_base(mbedtls_ecp_group *grp, const mbedtls_ecp_point *G, mbedtls_mpi *d, mbedtls_ecp_point *Q, int (*f_rng)(void *, unsigned char *, size_t), void *p_rng)
 {
-	return __rom_stubs_ssl.mbedtls_ecp_gen_keypair_base(grp, G, d, Q, f_rng, p_rng);
+	int ret;
+
+	ECP_COMB_CACHE_LEND(grp);
+	ret = __rom_stubs_ssl.mbedtls_ecp_gen_keypair_base(grp, G, d, Q, f_rng, p_rng);
+	ECP_COMB_CACHE_RETURN(grp);
+
+	return ret;
 }
 
 int mbedtls_ecp_gen_keypair(mbedtls_ecp_group *grp, mbedtls_mpi *d, mbedtls_ecp_point *Q, int (*f_rng)(void *, unsigned char *, size_t), void *p_rng)
 {
-	return __rom_stubs_ssl.mbedtls_ecp_gen_keypair(grp, d, Q, f_rng, p_rng);
+	int ret;
+
+	ECP_COMB_CACHE_LEND(grp);
+	ret = __rom_stubs_ssl.mbedtls_ecp_gen_keypair(grp, d, Q, f_rng, p_rng);
+	ECP_COMB_CACHE_RETURN(grp);
+
+	return ret;
 }
 
 int mbedtls_ecp_gen_key(mbedtls_ecp_group_id grp_id, mbedtls_ecp_keypair *key, int (*f_rng)(void *, unsigned char *, size_t), void *p_rng)
@@ -1833,7 +1929,13 @@ int mbedtls_arc4_crypt(mbedtls_arc4_context *ctx, size_t length, const unsigned
 /* ecdh */
 int mbedtls_ecdh_gen_public(mbedtls_ecp_group *grp, mbedtls_mpi *d, mbedtls_ecp_point *Q, int (*f_rng)(void *, unsigned char *, size_t), void *p_rng)
 {
-	return __rom_stubs_ssl.mbedtls_ecdh_gen_public(grp, d, Q, f_rng, p_rng);
+	int ret;
+
+	ECP_COMB_CACHE_LEND(grp);
+	ret = __rom_stubs_ssl.mbedtls_ecdh_gen_public(grp, d, Q, f_rng, p_rng);
+	ECP_COMB_CACHE_RETURN(grp);
+
+	return ret;
 }
 
 int mbedtls_ecdh_compute_shared(mbedtls_ecp_group *grp, mbedtls_mpi *z, const mbedtls_ecp_point *Q, const mbedtls_mpi *d, int (*f_rng)(void *, unsigned char *, size_t), void *p_rng)
@@ -1853,7 +1955,13 @@ void mbedtls_ecdh_free(mbedtls_ecdh_context *ctx)
 
 int mbedtls_ecdh_make_params(mbedtls_ecdh_context *ctx, size_t *olen, unsigned char *buf, size_t blen, int (*f_rng)(void *, unsigned char *, size_t), void *p_rng)
 {
-	return __rom_stubs_ssl.mbedtls_ecdh_make_params(ctx, olen, buf, blen, f_rng, p_rng);
+	int ret;
+
+	ECP_COMB_CACHE_LEND(&ctx->grp);
+	ret = __rom_stubs_ssl.mbedtls_ecdh_make_params(ctx, olen, buf, blen, f_rng, p_rng);
+	ECP_COMB_CACHE_RETURN(&ctx->grp);
+
+	return ret;
 }
 
 int mbedtls_ecdh_read_params(mbedtls_ecdh_context *ctx, const unsigned char **buf, const unsigned char *end)
@@ -1868,7 +1976,13 @@ int mbedtls_ecdh_get_params(mbedtls_ecdh_context *ctx, const mbedtls_ecp_keypair
 
 int mbedtls_ecdh_make_public(mbedtls_ecdh_context *ctx, size_t *olen, unsigned char *buf, size_t blen, int (*f_rng)(void *, unsigned char *, size_t), void *p_rng)
 {
-	return __rom_stubs_ssl.mbedtls_ecdh_make_public(ctx, olen, buf, blen, f_rng, p_rng);
+	int ret;
+
+	ECP_COMB_CACHE_LEND(&ctx->grp);
+	ret = __rom_stubs_ssl.mbedtls_ecdh_make_public(ctx, olen, buf, blen, f_rng, p_rng);
+	ECP_COMB_CACHE_RETURN(&ctx->grp);
+
+	return ret;
 }
 
 int mbedtls_ecdh_read_public(mbedtls_ecdh_context *ctx, const unsigned char *buf, size_t blen)
@@ -1884,32 +1998,68 @@ int mbedtls_ecdh_calc_secret(mbedtls_ecdh_context *ctx, size_t *olen, unsigned c
 /* ecdsa */
 int mbedtls_ecdsa_sign(mbedtls_ecp_group *grp, mbedtls_mpi *r, mbedtls_mpi *s, const mbedtls_mpi *d, const unsigned char *buf, size_t blen, int (*f_rng)(void *, unsigned char *, size_t), void *p_rng)
 {
-	return __rom_stubs_ssl.mbedtls_ecdsa_sign(grp, r, s, d, buf, blen, f_rng, p_rng);
+	int ret;
+
+	ECP_COMB_CACHE_LEND(grp);
+	ret = __rom_stubs_ssl.mbedtls_ecdsa_sign(grp, r, s, d, buf, blen, f_rng, p_rng);
+	ECP_COMB_CACHE_RETURN(grp);
+
+	return ret;
 }
 
 int mbedtls_ecdsa_sign_det(mbedtls_ecp_group *grp, mbedtls_mpi *r, mbedtls_mpi *s, const mbedtls_mpi *d, const unsigned char *buf, size_t blen, mbedtls_md_type_t md_alg)
 {
-	return __rom_stubs_ssl.mbedtls_ecdsa_sign_det(grp, r, s, d, buf, blen, md_alg);
+	int ret;
+
+	ECP_COMB_CACHE_LEND(grp);
+	ret = __rom_stubs_ssl.mbedtls_ecdsa_sign_det(grp, r, s, d, buf, blen, md_alg);
+	ECP_COMB_CACHE_RETURN(grp);
+
+	return ret;
 }
 
 int mbedtls_ecdsa_verify(mbedtls_ecp_group *grp, const unsigned char *buf, size_t blen, const mbedtls_ecp_point *Q, const mbedtls_mpi *r, const mbedtls_mpi *s)
 {
-	return __rom_stubs_ssl.mbedtls_ecdsa_verify(grp, buf, blen, Q, r, s);
+	int ret;
+
+	ECP_COMB_CACHE_LEND(grp);
+	ret = __rom_stubs_ssl.mbedtls_ecdsa_verify(grp, buf, blen, Q, r, s);
+	ECP_COMB_CACHE_RETURN(grp);
+
+	return ret;
 }
 
 int mbedtls_ecdsa_write_signature(mbedtls_ecdsa_context *ctx, mbedtls_md_type_t md_alg, const unsigned char *hash, size_t hlen, unsigned char *sig, size_t *slen, int (*f_rng)(void *, unsigned char *, size_t), void *p_rng)
 {
-	return __rom_stubs_ssl.mbedtls_ecdsa_write_signature(ctx, md_alg, hash, hlen, sig, slen, f_rng, p_rng);
+	int ret;
+
+	ECP_COMB_CACHE_LEND(&ctx->grp);
+	ret = __rom_stubs_ssl.mbedtls_ecdsa_write_signature(ctx, md_alg, hash, hlen, sig, slen, f_rng, p_rng);
+	ECP_COMB_CACHE_RETURN(&ctx->grp);
+
+	return ret;
 }
 
 int mbedtls_ecdsa_write_signature_det(mbedtls_ecdsa_context *ctx, const unsigned char *hash, size_t hlen, unsigned char *sig, size_t *slen, mbedtls_md_type_t md_alg)
 {
-	return __rom_stubs_ssl.mbedtls_ecdsa_write_signature_det(ctx, hash, hlen, sig, slen, md_alg);
+	int ret;
+
+	ECP_COMB_CACHE_LEND(&ctx->grp);
+	ret = __rom_stubs_ssl.mbedtls_ecdsa_write_signature_det(ctx, hash, hlen, sig, slen, md_alg);
+	ECP_COMB_CACHE_RETURN(&ctx->grp);
+
+	return ret;
 }
 
 int mbedtls_ecdsa_read_signature(mbedtls_ecdsa_context *ctx, const unsigned char *hash, size_t hlen, const unsigned char *sig, size_t slen)
 {
-	return __rom_stubs_ssl.mbedtls_ecdsa_read_signature(ctx, hash, hlen, sig, slen);
+	int ret;
+
+	ECP_COMB_CACHE_LEND(&ctx->grp);
+	ret = __rom_stubs_ssl.mbedtls_ecdsa_read_signature(ctx, hash, hlen, sig, slen);
+	ECP_COMB_CACHE_RETURN(&ctx->grp);
+
+	return ret;
 }
 
 int mbedtls_ecdsa_genkey(mbedtls_ecdsa_context *ctx, mbedtls_ecp_group_id gid, int (*f_rng)(void *, unsigned char *, size_t), void *p_rng)
@@ -1933,6 +2083,71 @@ void mbedtls_ecdsa_free(mbedtls_ecdsa_context *ctx)
 }
 
 /* pk */
+#if defined(MBEDTLS_ECP_FIXED_POINT_CACHE)
+/*
+ * ECDSA with EC keys as in pk_wrap.c of the ROM, but through the ecdsa stubs above, so the
+ * group copied from the key gets the cached comb table (ServerKeyExchange signature and
+ * ECDSA certificate verification of x509_crt.c)
+ */
+static int pk_is_ecdsa(mbedtls_pk_context *ctx)
+{
+	mbedtls_pk_type_t type = mbedtls_pk_get_type(ctx);
+
+	return (type == MBEDTLS_PK_ECKEY || type == MBEDTLS_PK_ECDSA);
+}
+
+static int pk_hash_len(mbedtls_md_type_t md_alg, size_t *hash_len)
+{
+	const mbedtls_md_info_t *md_info;
+
+	if (*hash_len != 0)
+		return 0;
+
+	if ((md_info = mbedtls_md_info_from_type(md_alg)) == NULL)
+		return -1;
+
+	*hash_len = mbedtls_md_get_size(md_info);
+	return 0;
+}
+
+static int pk_ecdsa_verify(mbedtls_pk_context *ctx, const unsigned char *hash, size_t hash_len, const unsigned char *sig, size_t sig_len)
+{
+	int ret;
+	mbedtls_ecdsa_context ecdsa;
+
+	if (mbedtls_pk_get_type(ctx) == MBEDTLS_PK_ECDSA) {
+		ret = mbedtls_ecdsa_read_signature((mbedtls_ecdsa_context *) ctx->pk_ctx, hash, hash_len, sig, sig_len);
+	}
+	else {
+		mbedtls_ecdsa_init(&ecdsa);
+		if ((ret = mbedtls_ecdsa_from_keypair(&ecdsa, mbedtls_pk_ec(*ctx))) == 0)
+			ret = mbedtls_ecdsa_read_signature(&ecdsa, hash, hash_len, sig, sig_len);
+		mbedtls_ecdsa_free(&ecdsa);
+	}
+
+	if (ret == MBEDTLS_ERR_ECP_SIG_LEN_MISMATCH)
+		return MBEDTLS_ERR_PK_SIG_LEN_MISMATCH;
+
+	return ret;
+}
+
+static int pk_ecdsa_sign(mbedtls_pk_context *ctx, mbedtls_md_type_t md_alg, const unsigned char *hash, size_t hash_len, unsigned char *sig, size_t *sig_len, int (*f_rng)(void *, unsigned char *, size_t), void *p_rng)
+{
+	int ret;
+	mbedtls_ecdsa_context ecdsa;
+
+	if (mbedtls_pk_get_type(ctx) == MBEDTLS_PK_ECDSA)
+		return mbedtls_ecdsa_write_signature((mbedtls_ecdsa_context *) ctx->pk_ctx, md_alg, hash, hash_len, sig, sig_len, f_rng, p_rng);
+
+	mbedtls_ecdsa_init(&ecdsa);
+	if ((ret = mbedtls_ecdsa_from_keypair(&ecdsa, mbedtls_pk_ec(*ctx))) == 0)
+		ret = mbedtls_ecdsa_write_signature(&ecdsa, md_alg, hash, hash_len, sig, sig_len, f_rng, p_rng);
+	mbedtls_ecdsa_free(&ecdsa);
+
+	return ret;
+}
+#endif /* MBEDTLS_ECP_FIXED_POINT_CACHE */
+
 void mbedtls_pk_init(mbedtls_pk_context *ctx)
 {
 	__rom_stubs_ssl.mbedtls_pk_init(ctx);
@@ -1965,16 +2180,36 @@ int mbedtls_pk_can_do(const mbedtls_pk_context *ctx, mbedtls_pk_type_t type)
 
 int mbedtls_pk_verify(mbedtls_pk_context *ctx, mbedtls_md_type_t md_alg, const unsigned char *hash, size_t hash_len, const unsigned char *sig, size_t sig_len)
 {
+#if defined(MBEDTLS_ECP_FIXED_POINT_CACHE)
+	if (ctx != NULL && pk_is_ecdsa(ctx)) {
+		if (pk_hash_len(md_alg, &hash_len) != 0)
+			return MBEDTLS_ERR_PK_BAD_INPUT_DATA;
+		return pk_ecdsa_verify(ctx, hash, hash_len, sig, sig_len);
+	}
+#endif
 	return __rom_stubs_ssl.mbedtls_pk_verify(ctx, md_alg, hash, hash_len, sig, sig_len);
 }
 
 int mbedtls_pk_verify_ext(mbedtls_pk_type_t type, const void *options, mbedtls_pk_context *ctx, mbedtls_md_type_t md_alg, const unsigned char *hash, size_t hash_len, const unsigned char *sig, size_t sig_len)
 {
+#if defined(MBEDTLS_ECP_FIXED_POINT_CACHE)
+	/* no options for ECDSA */
+	if (ctx != NULL && options == NULL && (type == MBEDTLS_PK_ECKEY || type == MBEDTLS_PK_ECDSA) &&
+		pk_is_ecdsa(ctx) && mbedtls_pk_can_do(ctx, type))
+		return mbedtls_pk_verify(ctx, md_alg, hash, hash_len, sig, sig_len);
+#endif
 	return __rom_stubs_ssl.mbedtls_pk_verify_ext(type, options, ctx, md_alg, hash, hash_len, sig, sig_len);
 }
 
 int mbedtls_pk_sign(mbedtls_pk_context *ctx, mbedtls_md_type_t md_alg, const unsigned char *hash, size_t hash_len, unsigned char *sig, size_t *sig_len, int (*f_rng)(void *, unsigned char *, size_t), void *p_rng)
 {
+#if defined(MBEDTLS_ECP_FIXED_POINT_CACHE)
+	if (ctx != NULL && pk_is_ecdsa(ctx)) {
+		if (pk_hash_len(md_alg, &hash_len) != 0)
+			return MBEDTLS_ERR_PK_BAD_INPUT_DATA;
+		return pk_ecdsa_sign(ctx, md_alg, hash, hash_len, sig, sig_len, f_rng, p_rng);
+	}
+#endif
 	return __rom_stubs_ssl.mbedtls_pk_sign(ctx, md_alg, hash, hash_len, sig, sig_len, f_rng, p_rng);
 }
 
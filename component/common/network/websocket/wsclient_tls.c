@@ -14,11 +14,14 @@ struct wss_tls{
 #elif (WSCLIENT_USE_TLS == WSCLIENT_TLS_MBEDTLS)
 #include "mbedtls/ssl.h"
 #include "mbedtls/net_sockets.h"
+#include "ssl_session_store.h"
 
 struct wss_tls{
 	mbedtls_ssl_context ctx;
 	mbedtls_ssl_config conf;
 	mbedtls_net_context socket;
+	char *host;
+	int port;
 };
 
 static void* my_calloc(size_t nelements, size_t elementSize){
@@ -139,6 +142,13 @@ exit:
 			printf("\n[WSCLIENT] ERROR: ssl_setup %d\n", ret);
 			goto exit;
 		}
+
+		tls->host = (char *) malloc(strlen(host) + 1);
+		if(tls->host) {
+			strcpy(tls->host, host);
+			tls->port = port;
+			ssl_session_store_set(ssl, host, port);
+		}
 	}
 	else{
 		printf("\n[WSCLIENT] ERROR: malloc\n");
@@ -150,6 +160,7 @@ exit:
 		mbedtls_net_free(&tls->socket);
 		mbedtls_ssl_free(&tls->ctx);
 		mbedtls_ssl_config_free(&tls->conf);
+		free(tls->host);
 		free(tls);
 		tls = NULL;
 	}
@@ -181,6 +192,8 @@ int wss_tls_handshake(void *tls_in){
 	}
 	else {
 		printf("\n[WSCLIENT] Use ciphersuite %s\n", mbedtls_ssl_get_ciphersuite(&tls->ctx));
+		if(tls->host)
+			ssl_session_store_get(&tls->ctx, tls->host, tls->port);
 	}
 
 	return ret;
@@ -211,8 +224,10 @@ void wss_tls_close(void *tls_in,int *sock){
 		*sock = -1;
 	}
 	mbedtls_ssl_free(&tls->ctx);
-	if(tls)
+	if(tls){
 		mbedtls_ssl_config_free(&tls->conf);
+		free(tls->host);
+	}
 	free(tls);
 	tls = NULL;
 #endif /* WSCLIENT_USE_TLS */
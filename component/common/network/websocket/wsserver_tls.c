@@ -36,15 +36,46 @@ static int _verify_func(void *data, x509_crt *crt, int depth, int *flags)
 #include "mbedtls/platform.h"
 #include "mbedtls/base64.h"
 #include "mbedtls/sha1.h"
+#include "mbedtls/ssl_cache.h"
+#include "mbedtls/ssl_ticket.h"
 #include "osdep_service.h"
 
+/* Sessions kept for abbreviated handshakes of reconnecting clients, 0 for none.
+ * Without MBEDTLS_HAVE_TIME the oldest session is replaced, none expires. */
+#ifndef WS_SERVER_TLS_CACHE_SIZE
+#define WS_SERVER_TLS_CACHE_SIZE     4
+#endif
+#if !defined(MBEDTLS_SSL_CACHE_C) || !defined(MBEDTLS_SSL_SRV_C)
+#undef WS_SERVER_TLS_CACHE_SIZE
+#define WS_SERVER_TLS_CACHE_SIZE     0
+#endif
+
+/* Session tickets keep the sessions at the clients, sealed with an AEAD key */
+#ifndef WS_SERVER_TLS_TICKETS
+#define WS_SERVER_TLS_TICKETS        1
+#endif
+#if !defined(MBEDTLS_SSL_TICKET_C) || !defined(MBEDTLS_SSL_SESSION_TICKETS) || !defined(MBEDTLS_SSL_SRV_C) || \
+	(!defined(MBEDTLS_GCM_C) && !defined(MBEDTLS_CCM_C))
+#undef WS_SERVER_TLS_TICKETS
+#define WS_SERVER_TLS_TICKETS        0
+#endif
+
 struct wss_tls{
 	mbedtls_ssl_context ctx;
-	mbedtls_ssl_config conf;
 };
 
 static mbedtls_x509_crt wss_certs; /*!< Certificates of server and CA */
 static mbedtls_pk_context wss_key; /*!< Private key of server */
+static mbedtls_ssl_config wss_conf[2]; /*!< Configurations shared by connections, without and with client verification */
+#if WS_SERVER_TLS_CACHE_SIZE || WS_SERVER_TLS_TICKETS
+static _mutex wss_session_mutex;   /*!< Lock of the cache and tickets */
+#endif
+#if WS_SERVER_TLS_CACHE_SIZE
+static mbedtls_ssl_cache_context wss_cache[2]; /*!< Sessions of the clients, one cache per configuration */
+#endif
+#if WS_SERVER_TLS_TICKETS
+static mbedtls_ssl_ticket_context wss_ticket[2]; /*!< Key of the session tickets, one per configuration */
+#endif
 
 static int _verify_func(void *data, mbedtls_x509_crt *crt, int depth, uint32_t *flags)
 {
@@ -77,6 +108,55 @@ static void* _calloc_func(size_t nmemb, size_t size)
 	return ptr;
 }
 
+#if WS_SERVER_TLS_CACHE_SIZE
+static int _cache_get(void *data, mbedtls_ssl_session *session)
+{
+	int ret;
+
+	rtw_mutex_get(&wss_session_mutex);
+	ret = mbedtls_ssl_cache_get(data, session);
+	rtw_mutex_put(&wss_session_mutex);
+
+	return ret;
+}
+
+static int _cache_set(void *data, const mbedtls_ssl_session *session)
+{
+	int ret;
+
+	rtw_mutex_get(&wss_session_mutex);
+	ret = mbedtls_ssl_cache_set(data, session);
+	rtw_mutex_put(&wss_session_mutex);
+
+	return ret;
+}
+#endif
+
+#if WS_SERVER_TLS_TICKETS
+static int _ticket_write(void *p_ticket, const mbedtls_ssl_session *session,
+	unsigned char *start, const unsigned char *end, size_t *tlen, uint32_t *lifetime)
+{
+	int ret;
+
+	rtw_mutex_get(&wss_session_mutex);
+	ret = mbedtls_ssl_ticket_write(p_ticket, session, start, end, tlen, lifetime);
+	rtw_mutex_put(&wss_session_mutex);
+
+	return ret;
+}
+
+static int _ticket_parse(void *p_ticket, mbedtls_ssl_session *session, unsigned char *buf, size_t len)
+{
+	int ret;
+
+	rtw_mutex_get(&wss_session_mutex);
+	ret = mbedtls_ssl_ticket_parse(p_ticket, session, buf, len);
+	rtw_mutex_put(&wss_session_mutex);
+
+	return ret;
+}
+#endif
+
 #endif /* WS_SERVER_USE_TLS */
 
 static int _random_func(void *p_rng, unsigned char *output, size_t output_len)
@@ -88,6 +168,48 @@ static int _random_func(void *p_rng, unsigned char *output, size_t output_len)
 	return 0;
 }
 
+#if (WS_SERVER_USE_TLS == WS_SERVER_TLS_MBEDTLS)
+static int _conf_setup(mbedtls_ssl_config *conf, uint8_t verify)
+{
+	int ret = 0;
+
+	if((ret = mbedtls_ssl_config_defaults(conf,
+			MBEDTLS_SSL_IS_SERVER,
+			MBEDTLS_SSL_TRANSPORT_STREAM,
+			MBEDTLS_SSL_PRESET_DEFAULT)) != 0) {
+
+		printf("\n[WS_SERVER] ERROR: mbedtls_ssl_config_defaults %d\n", ret);
+		return -1;
+	}
+
+	mbedtls_ssl_conf_authmode(conf, MBEDTLS_SSL_VERIFY_NONE);
+	mbedtls_ssl_conf_rng(conf, _random_func, NULL);
+	mbedtls_ssl_conf_ca_chain(conf, wss_certs.next, NULL);
+
+	if(verify) {
+		mbedtls_ssl_conf_authmode(conf, MBEDTLS_SSL_VERIFY_REQUIRED);
+		mbedtls_ssl_conf_verify(conf, _verify_func, NULL);
+	}
+
+	if((ret = mbedtls_ssl_conf_own_cert(conf, &wss_certs, &wss_key)) != 0) {
+		printf("\n[WS_SERVER] ERROR: mbedtls_ssl_conf_own_cert %d\n", ret);
+		return -1;
+	}
+
+#if WS_SERVER_TLS_CACHE_SIZE
+	// a session made without client verification must not resume with verification,
+	// mbedtls does not verify the client again on resumption
+	mbedtls_ssl_conf_session_cache(conf, &wss_cache[verify ? 1 : 0], _cache_get, _cache_set);
+#endif
+#if WS_SERVER_TLS_TICKETS
+	mbedtls_ssl_conf_session_tickets_cb(conf, _ticket_write, _ticket_parse, &wss_ticket[verify ? 1 : 0]);
+#endif
+
+	return 0;
+}
+#endif
+
+void ws_server_tls_setup_free(void);
 
 int ws_server_tls_setup_init(const char *server_cert, const char *server_key, const char *ca_certs)
 {
@@ -129,6 +251,9 @@ exit:
 	return ret;
 #elif (WS_SERVER_USE_TLS == WS_SERVER_TLS_MBEDTLS)
 	int ret = 0;
+#if WS_SERVER_TLS_TICKETS
+	int i;
+#endif
 
 	mbedtls_platform_set_calloc_free(_calloc_func, vPortFree);
 	memset(&wss_certs, 0, sizeof(mbedtls_x509_crt));
@@ -156,12 +281,43 @@ exit:
 		goto exit;
 	}
 
-exit:
-	if(ret) {
-		mbedtls_x509_crt_free(&wss_certs);
-		mbedtls_pk_free(&wss_key);
+	// the configurations are built once and only read by the connections
+#if WS_SERVER_TLS_CACHE_SIZE || WS_SERVER_TLS_TICKETS
+	rtw_mutex_init(&wss_session_mutex);
+#endif
+#if WS_SERVER_TLS_CACHE_SIZE
+	mbedtls_ssl_cache_init(&wss_cache[0]);
+	mbedtls_ssl_cache_init(&wss_cache[1]);
+	mbedtls_ssl_cache_set_max_entries(&wss_cache[0], WS_SERVER_TLS_CACHE_SIZE);
+	mbedtls_ssl_cache_set_max_entries(&wss_cache[1], WS_SERVER_TLS_CACHE_SIZE);
+#endif
+#if WS_SERVER_TLS_TICKETS
+	mbedtls_ssl_ticket_init(&wss_ticket[0]);
+	mbedtls_ssl_ticket_init(&wss_ticket[1]);
+	for(i = 0; i < 2; i ++) {
+#if defined(MBEDTLS_GCM_C)
+		if((ret = mbedtls_ssl_ticket_setup(&wss_ticket[i], _random_func, NULL, MBEDTLS_CIPHER_AES_128_GCM, MBEDTLS_SSL_DEFAULT_TICKET_LIFETIME)) != 0) {
+#else
+		if((ret = mbedtls_ssl_ticket_setup(&wss_ticket[i], _random_func, NULL, MBEDTLS_CIPHER_AES_128_CCM, MBEDTLS_SSL_DEFAULT_TICKET_LIFETIME)) != 0) {
+#endif
+			printf("\n[WS_SERVER] ERROR: mbedtls_ssl_ticket_setup %d\n", ret);
+			ret = -1;
+			goto exit;
+		}
+	}
+#endif
+	mbedtls_ssl_config_init(&wss_conf[0]);
+	mbedtls_ssl_config_init(&wss_conf[1]);
+
+	if((_conf_setup(&wss_conf[0], 0) != 0) || (_conf_setup(&wss_conf[1], 1) != 0)) {
+		ret = -1;
+		goto exit;
 	}
 
+exit:
+	if(ret)
+		ws_server_tls_setup_free();
+
 	return ret;
 #endif
 }
@@ -172,6 +328,19 @@ void ws_server_tls_setup_free(void)
 	x509_crt_free(&wss_certs);
 	pk_free(&wss_key);
 #elif (WS_SERVER_USE_TLS == WS_SERVER_TLS_MBEDTLS)
+	mbedtls_ssl_config_free(&wss_conf[0]);
+	mbedtls_ssl_config_free(&wss_conf[1]);
+#if WS_SERVER_TLS_CACHE_SIZE
+	mbedtls_ssl_cache_free(&wss_cache[0]);
+	mbedtls_ssl_cache_free(&wss_cache[1]);
+#endif
+#if WS_SERVER_TLS_TICKETS
+	mbedtls_ssl_ticket_free(&wss_ticket[0]);
+	mbedtls_ssl_ticket_free(&wss_ticket[1]);
+#endif
+#if WS_SERVER_TLS_CACHE_SIZE || WS_SERVER_TLS_TICKETS
+	rtw_mutex_free(&wss_session_mutex);
+#endif
 	mbedtls_x509_crt_free(&wss_certs);
 	mbedtls_pk_free(&wss_key);
 #endif
@@ -240,40 +409,13 @@ exit:
 	int ret = 0;
 	struct wss_tls *tls = NULL;
 	mbedtls_ssl_context *ssl;
-	mbedtls_ssl_config *conf;
+	mbedtls_ssl_config *conf = &wss_conf[(secure == WS_SERVER_SECURE_TLS_VERIFY) ? 1 : 0];
 
 	if((tls = (struct wss_tls *) malloc(sizeof(struct wss_tls))) != NULL) {
 		memset(tls, 0, sizeof(struct wss_tls));
 		ssl = &tls->ctx;
-		conf = &tls->conf;
 
 		mbedtls_ssl_init(ssl);
-		mbedtls_ssl_config_init(conf);
-
-		if((ret = mbedtls_ssl_config_defaults(conf,
-				MBEDTLS_SSL_IS_SERVER,
-				MBEDTLS_SSL_TRANSPORT_STREAM,
-				MBEDTLS_SSL_PRESET_DEFAULT)) != 0) {
-
-			printf("\n[WS_SERVER] ERROR: mbedtls_ssl_config_defaults %d\n", ret);
-			ret = -1;
-			goto exit;
-		}
-
-		mbedtls_ssl_conf_authmode(conf, MBEDTLS_SSL_VERIFY_NONE);
-		mbedtls_ssl_conf_rng(conf, _random_func, NULL);
-		mbedtls_ssl_conf_ca_chain(conf, wss_certs.next, NULL);
-
-		if(secure == WS_SERVER_SECURE_TLS_VERIFY) {
-			mbedtls_ssl_conf_authmode(conf, MBEDTLS_SSL_VERIFY_REQUIRED);
-			mbedtls_ssl_conf_verify(conf, _verify_func, NULL);
-		}
-
-		if((ret = mbedtls_ssl_conf_own_cert(conf, &wss_certs, &wss_key)) != 0) {
-			printf("\n[WS_SERVER] ERROR: mbedtls_ssl_conf_own_cert %d\n", ret);
-			ret = -1;
-			goto exit;
-		}
 
 		if((ret = mbedtls_ssl_setup(ssl, conf)) != 0) {
 			printf("\n[WS_SERVER] ERROR: mbedtls_ssl_setup %d\n", ret);
@@ -303,7 +445,6 @@ exit:
 	if(ret && tls) {
 		mbedtls_ssl_close_notify(ssl);
 		mbedtls_ssl_free(ssl);
-		mbedtls_ssl_config_free(conf);
 		free(tls);
 		tls = NULL;
 	}
@@ -332,7 +473,6 @@ void ws_server_tls_free(void *tls_in)
 	free(tls);
 #elif (WS_SERVER_USE_TLS == WS_SERVER_TLS_MBEDTLS)
 	mbedtls_ssl_free(&tls->ctx);
-	mbedtls_ssl_config_free(&tls->conf);
 	free(tls);
 #endif
 }
@@ -255,6 +255,8 @@ void cmd_ssl_client(int argc, char **argv)
 #include "mbedtls/error.h"
 #include "mbedtls/debug.h"
 #include "mbedtls/version.h"
+#include "ssl_session_store.h"
+#include <stdlib.h>
 
 #if defined(configENABLE_TRUSTZONE) && (configENABLE_TRUSTZONE == 1) && defined(CONFIG_SSL_CLIENT_PRIVATE_IN_TZ) && (CONFIG_SSL_CLIENT_PRIVATE_IN_TZ == 1)
 #include "device_lock.h"
@@ -403,10 +405,12 @@ static void ssl_client(void *param)
 	printf(" ok\n");
 
 	/*
-	 * 3. Handshake
+	 * 3. Handshake, abbreviated when a session of the server is stored
 	 */
 	printf("\n\r  . Performing the SSL/TLS handshake...");
 
+	ssl_session_store_set(&ssl, server_host, atoi(server_port));
+
 	while((ret = mbedtls_ssl_handshake(&ssl)) != 0) {
 		if((ret != MBEDTLS_ERR_SSL_WANT_READ && ret != MBEDTLS_ERR_SSL_WANT_WRITE
 			&& ret != MBEDTLS_ERR_NET_RECV_FAILED) || retry_count >= 5) {
@@ -421,6 +425,8 @@ static void ssl_client(void *param)
 	printf(" ok\n");
 	printf("\n\r  . Use ciphersuite %s\n", mbedtls_ssl_get_ciphersuite(&ssl));
 
+	ssl_session_store_get(&ssl, server_host, atoi(server_port));
+
 	/*
 	 * 4. Write the GET request
 	 */
@@ -0,0 +1,456 @@
+#include "FreeRTOS.h"
+#include "task.h"
+#include <string.h>
+
+#include "platform_opts.h"
+
+#if CONFIG_USE_MBEDTLS
+#include "mbedtls/platform.h"
+#include "ssl_session_store.h"
+
+#if defined(MBEDTLS_SSL_CLI_C) && (SSL_SESSION_STORE_SIZE > 0)
+
+struct ssl_session_entry {
+	char host[SSL_SESSION_STORE_HOST_LEN + 1];  /*!< empty for a free entry */
+	uint16_t port;
+	uint32_t start;                             /*!< tick of the handshake which made the session or ticket */
+	uint32_t lifetime;                          /*!< seconds */
+	uint32_t last_use;                          /*!< tick, the least recently used entry is replaced */
+	int authmode;                               /*!< of the client which made the session */
+	mbedtls_ssl_session session;                /*!< without peer_cert */
+};
+
+/* ssl_session_store_export() layout: header, then a record and its ticket per entry */
+#define SSL_SESSION_STORE_MAGIC     0x53535332  /* "SSS2" */
+
+struct ssl_session_header {
+	uint32_t magic;
+	uint32_t record_size;
+	uint32_t count;
+};
+
+struct ssl_session_record {
+	char host[SSL_SESSION_STORE_HOST_LEN + 1];
+	uint16_t port;
+	uint32_t age;
+	uint32_t lifetime;
+	int32_t ciphersuite;
+	int32_t compression;
+	uint32_t id_len;
+	uint8_t id[32];
+	uint8_t master[48];
+	uint32_t verify_result;
+	uint32_t ticket_len;
+	uint32_t ticket_lifetime;
+	uint8_t mfl_code;
+	uint8_t trunc_hmac;
+	uint8_t encrypt_then_mac;
+	uint8_t authmode;
+};
+
+static struct ssl_session_entry ssl_session_entries[SSL_SESSION_STORE_SIZE];
+
+/* Entries are only copied and freed under the lock, the scheduler is suspended for a short time */
+#define SSL_SESSION_LOCK()      vTaskSuspendAll()
+#define SSL_SESSION_UNLOCK()    xTaskResumeAll()
+
+static uint32_t _entry_age(struct ssl_session_entry *entry, uint32_t now)
+{
+	return (now - entry->start) / configTICK_RATE_HZ;
+}
+
+static void _entry_free(struct ssl_session_entry *entry)
+{
+	mbedtls_ssl_session_free(&entry->session);
+	memset(entry, 0, sizeof(struct ssl_session_entry));
+}
+
+static struct ssl_session_entry *_entry_find(const char *host, int port, uint32_t now)
+{
+	int i;
+
+	for(i = 0; i < SSL_SESSION_STORE_SIZE; i ++) {
+		struct ssl_session_entry *entry = &ssl_session_entries[i];
+
+		if(entry->host[0] && (entry->port == port) && (strcmp(entry->host, host) == 0)) {
+			if(_entry_age(entry, now) >= entry->lifetime) {
+				_entry_free(entry);
+				return NULL;
+			}
+
+			return entry;
+		}
+	}
+
+	return NULL;
+}
+
+/* Entry for a new host:port, a free one, else an expired one, else the least recently used */
+static struct ssl_session_entry *_entry_new(uint32_t now)
+{
+	struct ssl_session_entry *lru = &ssl_session_entries[0];
+	int i;
+
+	for(i = 0; i < SSL_SESSION_STORE_SIZE; i ++) {
+		struct ssl_session_entry *entry = &ssl_session_entries[i];
+
+		if(entry->host[0] == 0)
+			return entry;
+
+		if(_entry_age(entry, now) >= entry->lifetime) {
+			_entry_free(entry);
+			return entry;
+		}
+
+		if((now - entry->last_use) > (now - lru->last_use))
+			lru = entry;
+	}
+
+	_entry_free(lru);
+	return lru;
+}
+
+static uint32_t _session_lifetime(mbedtls_ssl_session *session)
+{
+	uint32_t lifetime = SSL_SESSION_STORE_LIFETIME;
+
+#if defined(MBEDTLS_SSL_SESSION_TICKETS)
+	if(session->ticket && session->ticket_lifetime && (session->ticket_lifetime < lifetime))
+		lifetime = session->ticket_lifetime;
+#endif
+	return lifetime;
+}
+
+int ssl_session_store_set(mbedtls_ssl_context *ssl, const char *host, int port)
+{
+	struct ssl_session_entry *entry;
+	int ret = -1;
+
+	if((ssl == NULL) || (ssl->conf == NULL) || (host == NULL))
+		return -1;
+
+	SSL_SESSION_LOCK();
+
+	entry = _entry_find(host, port, xTaskGetTickCount());
+
+	/* a session without verification is not used to skip a required verification, a client
+	   with MBEDTLS_SSL_VERIFY_NONE leaves verify_result 0, so the authmode of the handshake counts */
+	if(entry && ((ssl->conf->authmode != MBEDTLS_SSL_VERIFY_REQUIRED) || (entry->authmode == MBEDTLS_SSL_VERIFY_REQUIRED))) {
+		if(mbedtls_ssl_set_session(ssl, &entry->session) == 0) {
+			entry->last_use = xTaskGetTickCount();
+			ret = 0;
+		}
+	}
+
+	SSL_SESSION_UNLOCK();
+
+	return ret;
+}
+
+int ssl_session_store_get(mbedtls_ssl_context *ssl, const char *host, int port)
+{
+	mbedtls_ssl_session *session;
+	struct ssl_session_entry *entry;
+	unsigned char *ticket = NULL;
+	size_t ticket_len = 0;
+	uint32_t now;
+
+	if((ssl == NULL) || (ssl->conf == NULL) || ((session = ssl->session) == NULL) || (host == NULL) ||
+		(strlen(host) > SSL_SESSION_STORE_HOST_LEN) || (port <= 0) || (port > 0xffff))
+		return -1;
+
+#if defined(MBEDTLS_SSL_SESSION_TICKETS)
+	if(session->ticket) {
+		if((ticket = mbedtls_calloc(1, session->ticket_len)) == NULL)
+			return -1;
+
+		memcpy(ticket, session->ticket, session->ticket_len);
+		ticket_len = session->ticket_len;
+	}
+#endif
+
+	/* nothing to resume without a session ID or a ticket */
+	if((session->id_len == 0) && (ticket == NULL))
+		return -1;
+
+	SSL_SESSION_LOCK();
+
+	now = xTaskGetTickCount();
+	entry = _entry_find(host, port, now);
+
+	if(entry && (memcmp(entry->session.master, session->master, sizeof(session->master)) == 0)
+#if defined(MBEDTLS_SSL_SESSION_TICKETS)
+		&& (entry->session.ticket_len == ticket_len)
+		&& ((ticket_len == 0) || (memcmp(entry->session.ticket, ticket, ticket_len) == 0))
+#endif
+		) {
+		/* resumed with the same session ID or ticket */
+		entry->last_use = now;
+	}
+	else {
+		if(entry)
+			_entry_free(entry);
+		else
+			entry = _entry_new(now);
+
+		memcpy(&entry->session, session, sizeof(mbedtls_ssl_session));
+#if defined(MBEDTLS_X509_CRT_PARSE_C)
+		entry->session.peer_cert = NULL;
+#endif
+#if defined(MBEDTLS_SSL_SESSION_TICKETS)
+		entry->session.ticket = ticket;
+		ticket = NULL;
+#endif
+		strcpy(entry->host, host);
+		entry->port = port;
+		entry->authmode = ssl->conf->authmode;
+		entry->start = now;
+		entry->last_use = now;
+		entry->lifetime = _session_lifetime(&entry->session);
+	}
+
+	SSL_SESSION_UNLOCK();
+
+	if(ticket)
+		mbedtls_free(ticket);
+
+	return 0;
+}
+
+void ssl_session_store_remove(const char *host, int port)
+{
+	struct ssl_session_entry *entry;
+
+	if(host == NULL)
+		return;
+
+	SSL_SESSION_LOCK();
+
+	if((entry = _entry_find(host, port, xTaskGetTickCount())) != NULL)
+		_entry_free(entry);
+
+	SSL_SESSION_UNLOCK();
+}
+
+void ssl_session_store_clear(void)
+{
+	int i;
+
+	SSL_SESSION_LOCK();
+
+	for(i = 0; i < SSL_SESSION_STORE_SIZE; i ++)
+		_entry_free(&ssl_session_entries[i]);
+
+	SSL_SESSION_UNLOCK();
+}
+
+int ssl_session_store_export(uint8_t *buf, uint32_t buf_len)
+{
+	struct ssl_session_header header;
+	struct ssl_session_record record;
+	uint32_t len, now;
+	int i;
+
+	SSL_SESSION_LOCK();
+
+	now = xTaskGetTickCount();
+	header.magic = SSL_SESSION_STORE_MAGIC;
+	header.record_size = sizeof(struct ssl_session_record);
+	header.count = 0;
+	len = sizeof(struct ssl_session_header);
+
+	for(i = 0; i < SSL_SESSION_STORE_SIZE; i ++) {
+		struct ssl_session_entry *entry = &ssl_session_entries[i];
+		mbedtls_ssl_session *session = &entry->session;
+		uint32_t ticket_len = 0;
+
+		if((entry->host[0] == 0) || (_entry_age(entry, now) >= entry->lifetime))
+			continue;
+
+#if defined(MBEDTLS_SSL_SESSION_TICKETS)
+		ticket_len = session->ticket_len;
+#endif
+		if(buf) {
+			if((len + sizeof(struct ssl_session_record) + ticket_len) > buf_len) {
+				SSL_SESSION_UNLOCK();
+				memset(&record, 0, sizeof(struct ssl_session_record));
+				return -1;
+			}
+
+			memset(&record, 0, sizeof(struct ssl_session_record));
+			strcpy(record.host, entry->host);
+			record.port = entry->port;
+			record.age = _entry_age(entry, now);
+			record.lifetime = entry->lifetime;
+			record.ciphersuite = session->ciphersuite;
+			record.compression = session->compression;
+			record.id_len = session->id_len;
+			memcpy(record.id, session->id, sizeof(record.id));
+			memcpy(record.master, session->master, sizeof(record.master));
+			record.verify_result = session->verify_result;
+			record.authmode = entry->authmode;
+			record.ticket_len = ticket_len;
+#if defined(MBEDTLS_SSL_SESSION_TICKETS)
+			record.ticket_lifetime = session->ticket_lifetime;
+#endif
+#if defined(MBEDTLS_SSL_MAX_FRAGMENT_LENGTH)
+			record.mfl_code = session->mfl_code;
+#endif
+#if defined(MBEDTLS_SSL_TRUNCATED_HMAC)
+			record.trunc_hmac = session->trunc_hmac;
+#endif
+#if defined(MBEDTLS_SSL_ENCRYPT_THEN_MAC)
+			record.encrypt_then_mac = session->encrypt_then_mac;
+#endif
+			memcpy(buf + len, &record, sizeof(struct ssl_session_record));
+#if defined(MBEDTLS_SSL_SESSION_TICKETS)
+			if(ticket_len)
+				memcpy(buf + len + sizeof(struct ssl_session_record), session->ticket, ticket_len);
+#endif
+		}
+
+		len += sizeof(struct ssl_session_record) + ticket_len;
+		header.count ++;
+	}
+
+	SSL_SESSION_UNLOCK();
+
+	memset(&record, 0, sizeof(struct ssl_session_record));
+
+	if(buf) {
+		if(buf_len < sizeof(struct ssl_session_header))
+			return -1;
+
+		memcpy(buf, &header, sizeof(struct ssl_session_header));
+	}
+
+	return len;
+}
+
+int ssl_session_store_import(const uint8_t *buf, uint32_t buf_len, uint32_t elapsed)
+{
+	struct ssl_session_header header;
+	struct ssl_session_record record;
+	uint32_t pos = sizeof(struct ssl_session_header), i;
+	int count = 0;
+
+	if((buf == NULL) || (buf_len < sizeof(struct ssl_session_header)))
+		return -1;
+
+	memcpy(&header, buf, sizeof(struct ssl_session_header));
+
+	if((header.magic != SSL_SESSION_STORE_MAGIC) || (header.record_size != sizeof(struct ssl_session_record)))
+		return -1;
+
+	for(i = 0; i < header.count; i ++) {
+		struct ssl_session_entry *entry;
+		unsigned char *ticket = NULL;
+		uint32_t now;
+
+		if((buf_len - pos) < sizeof(struct ssl_session_record))
+			break;
+
+		memcpy(&record, buf + pos, sizeof(struct ssl_session_record));
+		pos += sizeof(struct ssl_session_record);
+
+		if((buf_len - pos) < record.ticket_len)
+			break;
+
+		pos += record.ticket_len;
+		record.host[SSL_SESSION_STORE_HOST_LEN] = 0;
+
+		if((record.host[0] == 0) || (record.id_len > sizeof(record.id)) ||
+			(elapsed >= record.lifetime) || (record.age >= (record.lifetime - elapsed)))
+			continue;
+
+#if defined(MBEDTLS_SSL_SESSION_TICKETS)
+		if(record.ticket_len) {
+			if((ticket = mbedtls_calloc(1, record.ticket_len)) == NULL)
+				break;
+
+			memcpy(ticket, buf + pos - record.ticket_len, record.ticket_len);
+		}
+#else
+		if((record.id_len == 0) || record.ticket_len)
+			continue;
+#endif
+
+		SSL_SESSION_LOCK();
+
+		now = xTaskGetTickCount();
+
+		if((entry = _entry_find(record.host, record.port, now)) != NULL)
+			_entry_free(entry);
+		else
+			entry = _entry_new(now);
+
+		strcpy(entry->host, record.host);
+		entry->port = record.port;
+		entry->start = now - (record.age + elapsed) * configTICK_RATE_HZ;
+		entry->last_use = entry->start;
+		entry->lifetime = record.lifetime;
+		entry->session.ciphersuite = record.ciphersuite;
+		entry->session.compression = record.compression;
+		entry->session.id_len = record.id_len;
+		memcpy(entry->session.id, record.id, sizeof(record.id));
+		memcpy(entry->session.master, record.master, sizeof(record.master));
+		entry->session.verify_result = record.verify_result;
+		entry->authmode = record.authmode;
+#if defined(MBEDTLS_SSL_SESSION_TICKETS)
+		entry->session.ticket = ticket;
+		entry->session.ticket_len = record.ticket_len;
+		entry->session.ticket_lifetime = record.ticket_lifetime;
+#endif
+#if defined(MBEDTLS_SSL_MAX_FRAGMENT_LENGTH)
+		entry->session.mfl_code = record.mfl_code;
+#endif
+#if defined(MBEDTLS_SSL_TRUNCATED_HMAC)
+		entry->session.trunc_hmac = record.trunc_hmac;
+#endif
+#if defined(MBEDTLS_SSL_ENCRYPT_THEN_MAC)
+		entry->session.encrypt_then_mac = record.encrypt_then_mac;
+#endif
+
+		SSL_SESSION_UNLOCK();
+
+		count ++;
+	}
+
+	memset(&record, 0, sizeof(struct ssl_session_record));
+
+	return count;
+}
+
+#else /* MBEDTLS_SSL_CLI_C && SSL_SESSION_STORE_SIZE */
+
+int ssl_session_store_set(mbedtls_ssl_context *ssl, const char *host, int port)
+{
+	return -1;
+}
+
+int ssl_session_store_get(mbedtls_ssl_context *ssl, const char *host, int port)
+{
+	return -1;
+}
+
+void ssl_session_store_remove(const char *host, int port)
+{
+}
+
+void ssl_session_store_clear(void)
+{
+}
+
+int ssl_session_store_export(uint8_t *buf, uint32_t buf_len)
+{
+	return -1;
+}
+
+int ssl_session_store_import(const uint8_t *buf, uint32_t buf_len, uint32_t elapsed)
+{
+	return -1;
+}
+
+#endif /* MBEDTLS_SSL_CLI_C && SSL_SESSION_STORE_SIZE */
+
+#endif /* CONFIG_USE_MBEDTLS */
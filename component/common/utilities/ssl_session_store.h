@@ -0,0 +1,87 @@
+#ifndef _SSL_SESSION_STORE_H_
+#define _SSL_SESSION_STORE_H_
+
+#include "platform_opts.h"
+
+#if CONFIG_USE_MBEDTLS
+#include "mbedtls/ssl.h"
+
+/*
+ * TLS client session store. The clients (httpc, websocket client, MQTT, ssl_client)
+ * keep the session of their last handshake per host:port, and offer it to the server
+ * on the next connection, so a reconnect becomes an abbreviated handshake with the
+ * session ID or the session ticket instead of a full RSA/ECDHE handshake.
+ *
+ * Entries hold the master secret and no peer certificate. An entry made by a client
+ * without MBEDTLS_SSL_VERIFY_REQUIRED is not offered by a client which requires
+ * verification, the authmode is kept with the entry and in the exported blob.
+ */
+
+/* Number of host:port entries, 0 to disable the store */
+#ifndef SSL_SESSION_STORE_SIZE
+#define SSL_SESSION_STORE_SIZE      4
+#endif
+
+/* Longest host name kept, longer names are not stored */
+#ifndef SSL_SESSION_STORE_HOST_LEN
+#define SSL_SESSION_STORE_HOST_LEN  64
+#endif
+
+/* Seconds an entry is offered after its full handshake, also bounded by the ticket lifetime hint */
+#ifndef SSL_SESSION_STORE_LIFETIME
+#define SSL_SESSION_STORE_LIFETIME  86400
+#endif
+
+/**
+ * @brief     Offer the stored session of host:port on the next handshake
+ * @param[in] ssl: client context after mbedtls_ssl_setup() and before mbedtls_ssl_handshake()
+ * @param[in] host: server host name or address
+ * @param[in] port: server port
+ * @return    0 : a session is set, -1 : no session stored for host:port
+ */
+int ssl_session_store_set(mbedtls_ssl_context *ssl, const char *host, int port);
+
+/**
+ * @brief     Keep the session of a completed handshake for host:port
+ * @param[in] ssl: client context after a successful mbedtls_ssl_handshake()
+ * @param[in] host: server host name or address
+ * @param[in] port: server port
+ * @return    0 : stored, -1 : not stored (no session ID or ticket from the server, name too long)
+ */
+int ssl_session_store_get(mbedtls_ssl_context *ssl, const char *host, int port);
+
+/**
+ * @brief     Drop the entry of host:port, e.g. after the server certificate changed
+ * @param[in] host: server host name or address
+ * @param[in] port: server port
+ * @return    None
+ */
+void ssl_session_store_remove(const char *host, int port);
+
+/**
+ * @brief  Drop all entries
+ * @return None
+ */
+void ssl_session_store_clear(void);
+
+/**
+ * @brief     Copy the entries to a buffer which the application keeps over deep sleep (e.g. in flash)
+ * @param[out] buf: buffer, or NULL to get the size needed
+ * @param[in] buf_len: size of buf
+ * @return    length written or needed, -1 : buf too small
+ * @note      The buffer holds master secrets, keep it in encrypted or otherwise protected storage.
+ */
+int ssl_session_store_export(uint8_t *buf, uint32_t buf_len);
+
+/**
+ * @brief     Restore the entries written by ssl_session_store_export() after a reboot or deep sleep wakeup
+ * @param[in] buf: exported data
+ * @param[in] buf_len: length of the exported data
+ * @param[in] elapsed: seconds passed since the export (e.g. the deep sleep duration), added to the entry ages
+ * @return    number of entries restored, -1 : data not written by this version of the store
+ */
+int ssl_session_store_import(const uint8_t *buf, uint32_t buf_len, uint32_t elapsed);
+
+#endif /* CONFIG_USE_MBEDTLS */
+
+#endif /* _SSL_SESSION_STORE_H_ */
@@ -90,12 +90,22 @@ char *udp_server_buffer = NULL;
 static void udp_client_handler(void *param);
 static void tcp_client_handler(void *param);
 
+// average time of one send()/recv() call, with a small -l it shows the per-call
+// cost of the socket API (e.g. LWIP_TCPIP_CORE_LOCKING against the TCP_IP thread mbox)
+static uint32_t iperf_us_per_call(uint32_t ticks, uint32_t calls)
+{
+	if(calls == 0)
+		return 0;
+	return (uint32_t)((uint64_t)ticks * 1000000 / configTICK_RATE_HZ / calls);
+}
+
 int tcp_client_func(struct iperf_data_t iperf_data)
 {
 	struct sockaddr_in  ser_addr;
 	int                 i=0;
 	uint32_t            start_time, end_time, bandwidth_time, report_start_time;
 	uint64_t            total_size=0, bandwidth_size=0, report_size=0;
+	uint32_t            send_calls=0;
 	struct iperf_tcp_client_hdr client_hdr;
 
 	// for internal tese
@@ -157,6 +167,7 @@ int tcp_client_func(struct iperf_data_t iperf_data)
 				printf("\n\r[ERROR] %s: TCP client send data error",__func__);
 				goto Exit1;
 			}
+			send_calls++;
 			total_size+=iperf_data.buf_size;
 			bandwidth_size+=iperf_data.buf_size;
 			report_size+=iperf_data.buf_size;
@@ -188,6 +199,7 @@ int tcp_client_func(struct iperf_data_t iperf_data)
 				printf("\n\r[ERROR] %s: TCP client send data error",__func__);
 				goto Exit1;
 			}
+			send_calls++;
 			total_size+=iperf_data.buf_size;
 			bandwidth_size+=iperf_data.buf_size;
 			report_size+=iperf_data.buf_size;
@@ -210,6 +222,7 @@ int tcp_client_func(struct iperf_data_t iperf_data)
 		}
 	}
 	printf("\n\r%s: [END] Totally send %d KBytes in %d ms, %d Kbits/sec",__func__, (uint32_t)(total_size/KB),(uint32_t)(end_time-start_time),((uint32_t)(total_size*8)/(end_time - start_time)));
+	printf("\n\r%s: [END] %d send calls, %d us/call",__func__, send_calls, iperf_us_per_call(end_time-start_time, send_calls));
 
 Exit1:
 	closesocket(iperf_data.client_fd);
@@ -231,6 +244,7 @@ int tcp_server_func(struct iperf_data_t iperf_data)
 	int                  recv_size=0;
 	uint64_t             total_size=0,report_size=0;
 	uint32_t             start_time, report_start_time, end_time;
+	uint32_t             recv_calls=0;
 	struct iperf_tcp_client_hdr client_hdr;
 
 	tcp_server_buffer = pvPortMalloc(iperf_data.buf_size);
@@ -321,6 +335,7 @@ int tcp_server_func(struct iperf_data_t iperf_data)
 			break;
 		}
 		end_time = xTaskGetTickCount();
+		recv_calls++;
 		total_size+=recv_size;
 		report_size+=recv_size;
 		if( (iperf_data.report_interval != DEFAULT_REPORT_INTERVAL) && ((end_time - report_start_time) >= (configTICK_RATE_HZ * iperf_data.report_interval)) && ((end_time - report_start_time) <= (configTICK_RATE_HZ * (iperf_data.report_interval + 1)))) {
@@ -330,6 +345,7 @@ int tcp_server_func(struct iperf_data_t iperf_data)
 		}
 	}
 	printf("\n\r%s: [END] Totally receive %d KBytes in %d ms, %d Kbits/sec",__func__, (uint32_t) (total_size/KB),(uint32_t) (end_time-start_time),(uint32_t) ((uint64_t)(total_size*8)/(end_time - start_time)));
+	printf("\n\r%s: [END] %d recv calls, %d us/call",__func__, recv_calls, iperf_us_per_call(end_time-start_time, recv_calls));
 
 Exit1:
 	// close the connected socket after receiving from connected TCP client
@@ -990,6 +1006,7 @@ Exit:
 	printf("\n\r   Example:\n");
 	printf("  \r     ATWT=-s,-p,5002\n");
 	printf("  \r     ATWT=-c,192.168.1.2,-t,100,-p,5002\n");
+	printf("  \r     ATWT=-c,192.168.1.2,-t,10,-l,64    (cost of one send() call)\n");
 	return;
 }
 
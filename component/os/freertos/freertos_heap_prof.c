@@ -0,0 +1,224 @@
+#include "FreeRTOS.h"
+#include "task.h"
+#include "freertos_heap_prof.h"
+#include <stdio.h>
+#include <string.h>
+
+#if defined(configHEAP_PROFILING) && (configHEAP_PROFILING == 1)
+
+static heap_prof_site_t heap_prof_sites[HEAP_PROF_SITE_NUM];
+static uint32_t heap_prof_fails = 0;
+static uint32_t heap_prof_fail_size = 0;
+static void *heap_prof_fail_caller = NULL;
+
+uint8_t heap_prof_alloc(void *caller, size_t block_size)
+{
+	int i, idx;
+	heap_prof_site_t *site;
+
+	/* open addressing over sites 1..N-1, sites are never removed */
+	idx = ((size_t)caller >> 1) % (HEAP_PROF_SITE_NUM - 1);
+	for (i = 0; i < HEAP_PROF_SITE_NUM - 1; i++) {
+		site = &heap_prof_sites[idx + 1];
+		if (site->caller == caller)
+			break;
+		if (site->caller == NULL) {
+			site->caller = caller;
+			break;
+		}
+		if (++idx == HEAP_PROF_SITE_NUM - 1)
+			idx = 0;
+	}
+	if ((caller == NULL) || (i == HEAP_PROF_SITE_NUM - 1))
+		idx = -1;	// table full, count in site 0
+
+	site = &heap_prof_sites[idx + 1];
+	site->live_bytes += block_size;
+	site->live_blocks++;
+	site->allocs++;
+	if (site->live_bytes > site->peak_bytes)
+		site->peak_bytes = site->live_bytes;
+
+	return (uint8_t)(idx + 1);
+}
+
+void heap_prof_free(uint8_t tag, size_t block_size)
+{
+	heap_prof_site_t *site = &heap_prof_sites[(tag < HEAP_PROF_SITE_NUM) ? tag : 0];
+
+	if (site->live_blocks) {
+		site->live_bytes -= (block_size < site->live_bytes) ? block_size : site->live_bytes;
+		site->live_blocks--;
+	}
+}
+
+void heap_prof_resize(uint8_t tag, size_t old_size, size_t new_size)
+{
+	heap_prof_site_t *site = &heap_prof_sites[(tag < HEAP_PROF_SITE_NUM) ? tag : 0];
+
+	site->live_bytes += new_size;
+	site->live_bytes -= (old_size < site->live_bytes) ? old_size : site->live_bytes;
+	if (site->live_bytes > site->peak_bytes)
+		site->peak_bytes = site->live_bytes;
+}
+
+void heap_prof_fail(void *caller, size_t wanted_size)
+{
+	heap_prof_fails++;
+	heap_prof_fail_size = wanted_size;
+	heap_prof_fail_caller = caller;
+}
+
+void heap_prof_add_free_block(heap_prof_stats_t *stats, size_t block_size)
+{
+	int bucket = 0;
+
+	while ((bucket < HEAP_PROF_HIST_NUM - 1) && (block_size >= ((size_t)32 << bucket)))
+		bucket++;
+
+	stats->hist[bucket]++;
+	stats->free_blocks++;
+	if (block_size > stats->largest_free)
+		stats->largest_free = block_size;
+}
+
+void heap_prof_get_stats(heap_prof_stats_t *stats)
+{
+	memset(stats, 0, sizeof(heap_prof_stats_t));
+
+	vPortHeapProfGetFreeList(stats);
+
+	vTaskSuspendAll();
+	stats->alloc_fails = heap_prof_fails;
+	stats->last_fail_size = heap_prof_fail_size;
+	stats->last_fail_caller = heap_prof_fail_caller;
+	( void ) xTaskResumeAll();
+}
+
+/* Copy out the used sites, largest live bytes first */
+int heap_prof_get_sites(heap_prof_site_t *sites, int num)
+{
+	heap_prof_site_t copy[HEAP_PROF_SITE_NUM], site;
+	int i, j, n = 0;
+
+	vTaskSuspendAll();
+	for (i = 0; i < HEAP_PROF_SITE_NUM; i++) {
+		if (heap_prof_sites[i].allocs)
+			copy[n++] = heap_prof_sites[i];
+	}
+	( void ) xTaskResumeAll();
+
+	for (i = 1; i < n; i++) {
+		site = copy[i];
+		for (j = i; (j > 0) && (copy[j - 1].live_bytes < site.live_bytes); j--)
+			copy[j] = copy[j - 1];
+		copy[j] = site;
+	}
+
+	if (n > num)
+		n = num;
+	memcpy(sites, copy, n * sizeof(heap_prof_site_t));
+
+	return n;
+}
+
+static uint8_t *heap_prof_put32(uint8_t *p, uint32_t val)
+{
+	p[0] = (uint8_t)val;
+	p[1] = (uint8_t)(val >> 8);
+	p[2] = (uint8_t)(val >> 16);
+	p[3] = (uint8_t)(val >> 24);
+	return p + 4;
+}
+
+/*
+ * Little-endian blob for host side tools:
+ * magic, version(16) | site count(16), hist count(16) | 0(16),
+ * total, free, min free, largest free, free blocks, fails, last fail size, last fail caller,
+ * hist[hist count], then per site: caller, live bytes, live blocks, peak bytes, allocs.
+ * Returns the blob length, the needed length when buf is NULL, or -1 when len is too small.
+ * Allocating the buffer may add a call site, so leave room for a few more sites.
+ */
+int heap_prof_get_blob(uint8_t *buf, int len)
+{
+	heap_prof_stats_t stats;
+	heap_prof_site_t sites[HEAP_PROF_SITE_NUM];
+	uint8_t *p = buf;
+	int i, num, need;
+
+	num = heap_prof_get_sites(sites, HEAP_PROF_SITE_NUM);
+	need = 12 + 4 * (8 + HEAP_PROF_HIST_NUM) + 20 * num;
+	if (buf == NULL)
+		return need;
+	if (len < need)
+		return -1;
+
+	heap_prof_get_stats(&stats);
+
+	p = heap_prof_put32(p, HEAP_PROF_BLOB_MAGIC);
+	p = heap_prof_put32(p, HEAP_PROF_BLOB_VERSION | (num << 16));
+	p = heap_prof_put32(p, HEAP_PROF_HIST_NUM);
+	p = heap_prof_put32(p, stats.total_bytes);
+	p = heap_prof_put32(p, stats.free_bytes);
+	p = heap_prof_put32(p, stats.min_free_bytes);
+	p = heap_prof_put32(p, stats.largest_free);
+	p = heap_prof_put32(p, stats.free_blocks);
+	p = heap_prof_put32(p, stats.alloc_fails);
+	p = heap_prof_put32(p, stats.last_fail_size);
+	p = heap_prof_put32(p, (uint32_t)stats.last_fail_caller);
+	for (i = 0; i < HEAP_PROF_HIST_NUM; i++)
+		p = heap_prof_put32(p, stats.hist[i]);
+	for (i = 0; i < num; i++) {
+		p = heap_prof_put32(p, (uint32_t)sites[i].caller);
+		p = heap_prof_put32(p, sites[i].live_bytes);
+		p = heap_prof_put32(p, sites[i].live_blocks);
+		p = heap_prof_put32(p, sites[i].peak_bytes);
+		p = heap_prof_put32(p, sites[i].allocs);
+	}
+
+	return p - buf;
+}
+
+/* Restart peaks and counters from the live values, live bytes are kept */
+void heap_prof_clear(void)
+{
+	int i;
+
+	vTaskSuspendAll();
+	for (i = 0; i < HEAP_PROF_SITE_NUM; i++) {
+		heap_prof_sites[i].peak_bytes = heap_prof_sites[i].live_bytes;
+		heap_prof_sites[i].allocs = heap_prof_sites[i].live_blocks;
+	}
+	heap_prof_fails = 0;
+	heap_prof_fail_size = 0;
+	heap_prof_fail_caller = NULL;
+	( void ) xTaskResumeAll();
+}
+
+void heap_prof_dump(int top)
+{
+	heap_prof_stats_t stats;
+	heap_prof_site_t sites[HEAP_PROF_SITE_NUM];
+	int i, num;
+
+	heap_prof_get_stats(&stats);
+	printf("\n\rheap total %d, free %d, min free %d, largest free %d in %d free blocks\n\r",
+		stats.total_bytes, stats.free_bytes, stats.min_free_bytes, stats.largest_free, stats.free_blocks);
+	printf("alloc fails %d, last %d bytes from %p\n\r", stats.alloc_fails, stats.last_fail_size, stats.last_fail_caller);
+
+	printf("free blocks:");
+	for (i = 0; i < HEAP_PROF_HIST_NUM - 1; i++)
+		printf(" <%d:%d", 32 << i, stats.hist[i]);
+	printf(" >=%d:%d\n\r", 32 << (HEAP_PROF_HIST_NUM - 2), stats.hist[HEAP_PROF_HIST_NUM - 1]);
+
+	if ((top <= 0) || (top > HEAP_PROF_SITE_NUM))
+		top = HEAP_PROF_SITE_NUM;
+	num = heap_prof_get_sites(sites, top);
+	printf("%10s %10s %8s %10s %10s\n\r", "caller", "live", "blocks", "peak", "allocs");
+	for (i = 0; i < num; i++) {
+		printf("%10p %10d %8d %10d %10d\n\r", sites[i].caller, sites[i].live_bytes,
+			sites[i].live_blocks, sites[i].peak_bytes, sites[i].allocs);
+	}
+}
+
+#endif
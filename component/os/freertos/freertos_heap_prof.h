@@ -0,0 +1,72 @@
+#ifndef __FREERTOS_HEAP_PROF_H_
+#define __FREERTOS_HEAP_PROF_H_
+
+#include "FreeRTOS.h"
+
+/*
+ * Heap profiling for pvPortMalloc()/vPortFree().
+ *
+ * Live bytes, live blocks, peak bytes and allocation count are kept per call
+ * site (return address of pvPortMalloc, or the caller handed to
+ * pvPortMallocCaller() by a wrapper such as rtw_malloc). An allocated block keeps the index of
+ * its site in its BlockLink_t next pointer, which is unused while the block is
+ * allocated, so profiling costs no heap memory and a hashed lookup per call.
+ * Largest free block and the free block histogram are computed on request.
+ */
+#ifndef configHEAP_PROFILING
+#define configHEAP_PROFILING		0
+#endif
+
+#define HEAP_PROF_SITE_NUM			32	// call sites tracked, site 0 collects the rest
+#define HEAP_PROF_HIST_NUM			12	// free block histogram, bucket n holds sizes < (32 << n), last one the rest
+
+#define HEAP_PROF_BLOB_MAGIC		0x46525048	// "HPRF"
+#define HEAP_PROF_BLOB_VERSION		1
+
+/* Without a return address intrinsic (IAR) all allocations are counted in site 0 */
+#if defined(__GNUC__)
+#define heapPROF_CALLER()			__builtin_return_address(0)
+#else
+#define heapPROF_CALLER()			NULL
+#endif
+
+typedef struct {
+	void *caller;			// return address, NULL for site 0
+	uint32_t live_bytes;	// block sizes including the heap header
+	uint32_t live_blocks;
+	uint32_t peak_bytes;
+	uint32_t allocs;
+} heap_prof_site_t;
+
+typedef struct {
+	uint32_t total_bytes;
+	uint32_t free_bytes;
+	uint32_t min_free_bytes;	// high-water mark of heap usage
+	uint32_t largest_free;
+	uint32_t free_blocks;
+	uint32_t alloc_fails;
+	uint32_t last_fail_size;
+	void *last_fail_caller;
+	uint32_t hist[HEAP_PROF_HIST_NUM];
+} heap_prof_stats_t;
+
+/* Called by the heap with its lock held */
+uint8_t heap_prof_alloc(void *caller, size_t block_size);
+void heap_prof_free(uint8_t tag, size_t block_size);
+void heap_prof_resize(uint8_t tag, size_t old_size, size_t new_size);
+void heap_prof_fail(void *caller, size_t wanted_size);
+void heap_prof_add_free_block(heap_prof_stats_t *stats, size_t block_size);
+
+/* Provided by the heap: pvPortMalloc() charging the block to pvCaller */
+void *pvPortMallocCaller(size_t xWantedSize, void *pvCaller);
+
+/* Provided by the heap: fill sizes and walk the free list with heap_prof_add_free_block() */
+void vPortHeapProfGetFreeList(heap_prof_stats_t *stats);
+
+void heap_prof_get_stats(heap_prof_stats_t *stats);
+int heap_prof_get_sites(heap_prof_site_t *sites, int num);
+int heap_prof_get_blob(uint8_t *buf, int len);
+void heap_prof_clear(void);
+void heap_prof_dump(int top);
+
+#endif
@@ -76,6 +76,7 @@ task.h is included from an application file. */
 
 #include "FreeRTOS.h"
 #include "task.h"
+#include "freertos_heap_prof.h"
 
 #define RTK_CUSTOMIZATION
 #ifdef RTK_CUSTOMIZATION
@@ -132,9 +133,22 @@ application.  When the bit is free the block is still part of the free heap
 space. */
 static size_t xBlockAllocatedBit = 0;
 
+#if( configHEAP_PROFILING == 1 )
+	static size_t xTotalHeapBytes = 0U;
+#endif
+
 /*-----------------------------------------------------------*/
 
+#if( configHEAP_PROFILING == 1 )
 void *pvPortMalloc( size_t xWantedSize )
+{
+	return pvPortMallocCaller( xWantedSize, heapPROF_CALLER() );
+}
+
+void *pvPortMallocCaller( size_t xWantedSize, void *pvCaller )
+#else
+void *pvPortMalloc( size_t xWantedSize )
+#endif
 {
 BlockLink_t *pxBlock, *pxPreviousBlock, *pxNewBlockLink;
 void *pvReturn = NULL;
@@ -245,6 +259,14 @@ void *pvReturn = NULL;
 					by the application and has no "next" block. */
 					pxBlock->xBlockSize |= xBlockAllocatedBit;
 					pxBlock->pxNextFreeBlock = NULL;
+
+					#if( configHEAP_PROFILING == 1 )
+					{
+						/* The unused next pointer of an allocated block keeps
+						its call site until vPortFree(). */
+						pxBlock->pxNextFreeBlock = ( BlockLink_t * ) ( size_t ) heap_prof_alloc( pvCaller, pxBlock->xBlockSize & ~xBlockAllocatedBit );
+					}
+					#endif
 				}
 				else
 				{
@@ -262,6 +284,15 @@ void *pvReturn = NULL;
 		}
 
 		traceMALLOC( pvReturn, xWantedSize );
+
+		#if( configHEAP_PROFILING == 1 )
+		{
+			if( pvReturn == NULL )
+			{
+				heap_prof_fail( pvCaller, xWantedSize );
+			}
+		}
+		#endif
 	}
 	( void ) xTaskResumeAll();
 
@@ -287,6 +318,9 @@ void vPortFree( void *pv )
 {
 uint8_t *puc = ( uint8_t * ) pv;
 BlockLink_t *pxLink;
+#if( configHEAP_PROFILING == 1 )
+uint8_t ucSite = 0;
+#endif
 
 	if( pv != NULL )
 	{
@@ -297,6 +331,17 @@ BlockLink_t *pxLink;
 		/* This casting is to keep the compiler from issuing warnings. */
 		pxLink = ( void * ) puc;
 
+		#if( configHEAP_PROFILING == 1 )
+		{
+			/* Take back the call site stored by pvPortMalloc(). */
+			if( ( ( pxLink->xBlockSize & xBlockAllocatedBit ) != 0 ) && ( ( size_t ) pxLink->pxNextFreeBlock < HEAP_PROF_SITE_NUM ) )
+			{
+				ucSite = ( uint8_t ) ( size_t ) pxLink->pxNextFreeBlock;
+				pxLink->pxNextFreeBlock = NULL;
+			}
+		}
+		#endif
+
 		/* Check the block is actually allocated. */
 		configASSERT( ( pxLink->xBlockSize & xBlockAllocatedBit ) != 0 );
 		configASSERT( pxLink->pxNextFreeBlock == NULL );
@@ -314,6 +359,11 @@ BlockLink_t *pxLink;
 					/* Add this block to the list of free blocks. */
 					xFreeBytesRemaining += pxLink->xBlockSize;
 					traceFREE( pv, pxLink->xBlockSize );
+					#if( configHEAP_PROFILING == 1 )
+					{
+						heap_prof_free( ucSite, pxLink->xBlockSize );
+					}
+					#endif
 					prvInsertBlockIntoFreeList( ( ( BlockLink_t * ) pxLink ) );
 				}
 				( void ) xTaskResumeAll();
@@ -343,6 +393,31 @@ size_t xPortGetMinimumEverFreeHeapSize( void )
 }
 /*-----------------------------------------------------------*/
 
+#if( configHEAP_PROFILING == 1 )
+void vPortHeapProfGetFreeList( heap_prof_stats_t *pxStats )
+{
+BlockLink_t *pxBlock;
+
+	vTaskSuspendAll();
+	{
+		pxStats->total_bytes = xTotalHeapBytes;
+		pxStats->free_bytes = xFreeBytesRemaining;
+		pxStats->min_free_bytes = xMinimumEverFreeBytesRemaining;
+
+		/* The end markers of all but the last region are zero sized links. */
+		for( pxBlock = xStart.pxNextFreeBlock; pxBlock != NULL; pxBlock = pxBlock->pxNextFreeBlock )
+		{
+			if( pxBlock->xBlockSize != 0 )
+			{
+				heap_prof_add_free_block( pxStats, pxBlock->xBlockSize );
+			}
+		}
+	}
+	( void ) xTaskResumeAll();
+}
+#endif
+/*-----------------------------------------------------------*/
+
 static void prvInsertBlockIntoFreeList( BlockLink_t *pxBlockToInsert )
 {
 BlockLink_t *pxIterator;
@@ -489,6 +564,11 @@ const HeapRegion_t *pxHeapRegion;
 
 	xMinimumEverFreeBytesRemaining = xTotalHeapSize;
 	xFreeBytesRemaining = xTotalHeapSize;
+	#if( configHEAP_PROFILING == 1 )
+	{
+		xTotalHeapBytes = xTotalHeapSize;
+	}
+	#endif
 
 	/* Check something was actually defined before it is accessed. */
 	configASSERT( xTotalHeapSize );
@@ -530,6 +610,11 @@ void* pvPortReAlloc( void *pv,  size_t xWantedSize )
 				/* Add this block to the list of free blocks. */
 				pxLink->xBlockSize &= ~xBlockAllocatedBit;
 				xFreeBytesRemaining += pxLink->xBlockSize;
+				#if( configHEAP_PROFILING == 1 )
+				{
+					heap_prof_free( ( uint8_t ) ( size_t ) pxLink->pxNextFreeBlock, pxLink->xBlockSize );
+				}
+				#endif
 				prvInsertBlockIntoFreeList( ( ( BlockLink_t * ) pxLink ) );
 			}
 			xTaskResumeAll();
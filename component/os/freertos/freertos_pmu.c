@@ -1,6 +1,8 @@
 #include "FreeRTOS.h"
 #include "freertos_pmu.h"
 #include "rtl8710c_freertos_pmu.h"
+#include "lwip/opt.h"
+#include "lwip/timeouts.h"
 
 uint32_t pmu_set_sysactive_time(uint32_t timeout_ms)
 {
@@ -38,3 +40,12 @@ uint32_t pmu_yield_os_check(void)
 #endif
 }
 
+uint32_t pmu_get_lwip_sleep_time(void)
+{
+#if LWIP_TIMERS && LWIP_TIMERS_WHEEL && !NO_SYS
+	return sys_timeouts_sleeptime();
+#else
+	return 0xFFFFFFFF;
+#endif
+}
+
@@ -159,6 +159,13 @@ void pmu_clean_wakelock_stat(void);
   */
 uint32_t pmu_set_sysactive_time(uint32_t timeout_ms);
 
+/**
+  * @brief  get the time until the next lwIP timeout, can be called from any task.
+  * @retval time in ms before the TCP_IP thread needs to run its timers,
+  *         0xFFFFFFFF if no timeout is pending or LWIP_TIMERS_WHEEL is disabled.
+  */
+uint32_t pmu_get_lwip_sleep_time(void);
+
 void pmu_add_wakeup_event(uint32_t event);
 void pmu_del_wakeup_event(uint32_t event);
 
@@ -8,6 +8,9 @@
 #include <stdio.h>
 #include <freertos_pmu.h>
 //#include <tcm_heap.h>
+#if defined(configHEAP_PROFILING) && (configHEAP_PROFILING == 1)
+#include "freertos_heap_prof.h"
+#endif
 
 #if defined(CONFIG_PLATFORM_8710C)
 #include "cmsis.h"
@@ -77,6 +80,33 @@ static unsigned int __div64_32(u64 *n, unsigned int base)
 
 /********************* os depended service ********************/
 
+#if defined(configHEAP_PROFILING) && (configHEAP_PROFILING == 1)
+/* Heap profiling charges the block to caller instead of to this wrapper */
+u8* _freertos_malloc_caller(u32 sz, void *caller)
+{
+	return pvPortMallocCaller(sz, caller);
+}
+
+u8* _freertos_zmalloc_caller(u32 sz, void *caller)
+{
+	u8 *pbuf = pvPortMallocCaller(sz, caller);
+
+	if (pbuf != NULL)
+		memset(pbuf, 0, sz);
+
+	return pbuf;
+}
+
+u8* _freertos_malloc(u32 sz)
+{
+	return _freertos_malloc_caller(sz, heapPROF_CALLER());
+}
+
+u8* _freertos_zmalloc(u32 sz)
+{
+	return _freertos_zmalloc_caller(sz, heapPROF_CALLER());
+}
+#else
 u8* _freertos_malloc(u32 sz)
 {
 	return pvPortMalloc(sz);
@@ -91,6 +121,7 @@ u8* _freertos_zmalloc(u32 sz)
 
 	return pbuf;	
 }
+#endif
 
 void _freertos_mfree(u8 *pbuf, u32 sz)
 {
@@ -43,6 +43,7 @@ task.h is included from an application file. */
 #include "FreeRTOS.h"
 #include "task.h"
 #include "memory.h"
+#include "freertos_heap_prof.h"
 #undef MPU_WRAPPERS_INCLUDED_FROM_API_FILE
 
 #if( configSUPPORT_DYNAMIC_ALLOCATION == 0 )
@@ -236,7 +237,7 @@ int xPortGetHeapIndex( void *pv)
 }
               
 /*-----------------------------------------------------------*/
-void *pvPortMallocExt( size_t xWantedSize, int idx )
+static void *prvPortMallocExt( size_t xWantedSize, int idx, void *pvCaller )
 {
 BlockLink_t *pxBlock, *pxPreviousBlock, *pxNewBlockLink;
 void *pvReturn = NULL;
@@ -348,6 +349,14 @@ void *pvReturn = NULL;
 					by the application and has no "next" block. */
 					pxBlock->xBlockSize |= xHeapInfo[idx].xBlockAllocatedBit;
 					pxBlock->pxNextFreeBlock = NULL;
+
+					#if( configHEAP_PROFILING == 1 )
+					{
+						/* The unused next pointer of an allocated block keeps
+						its call site until vPortFree(). */
+						pxBlock->pxNextFreeBlock = ( BlockLink_t * ) ( size_t ) heap_prof_alloc( pvCaller, pxBlock->xBlockSize & ~xHeapInfo[idx].xBlockAllocatedBit );
+					}
+					#endif
 				}
 				else
 				{
@@ -365,6 +374,15 @@ void *pvReturn = NULL;
 		}
 
 		traceMALLOC( pvReturn, xWantedSize );
+
+		#if( configHEAP_PROFILING == 1 )
+		{
+			if( pvReturn == NULL )
+			{
+				heap_prof_fail( pvCaller, xWantedSize );
+			}
+		}
+		#endif
 	}
 	//( void ) xTaskResumeAll();
 	vPortUnlock();
@@ -386,19 +404,34 @@ void *pvReturn = NULL;
 	configASSERT( ( ( ( size_t ) pvReturn ) & ( size_t ) portBYTE_ALIGNMENT_MASK ) == 0 );
 	return pvReturn;
 }
+
+void *pvPortMallocExt( size_t xWantedSize, int idx )
+{
+	return prvPortMallocExt( xWantedSize, idx, heapPROF_CALLER() );
+}
               
 /*-----------------------------------------------------------*/
 void *pvPortMalloc( size_t xWantedSize )
 {
     // use heap[0]
-    return pvPortMallocExt(xWantedSize, 0);
+    return prvPortMallocExt(xWantedSize, 0, heapPROF_CALLER());
+}
+
+#if( configHEAP_PROFILING == 1 )
+void *pvPortMallocCaller( size_t xWantedSize, void *pvCaller )
+{
+	return prvPortMallocExt( xWantedSize, 0, pvCaller );
 }
+#endif
               
 /*-----------------------------------------------------------*/
 void vPortFree( void *pv )
 {
 uint8_t *puc = ( uint8_t * ) pv;
 BlockLink_t *pxLink;
+#if( configHEAP_PROFILING == 1 )
+uint8_t ucSite = 0;
+#endif
 
     if( pv == NULL) return;
     int idx = xPortGetHeapIndex(pv);
@@ -414,6 +447,17 @@ BlockLink_t *pxLink;
 		/* This casting is to keep the compiler from issuing warnings. */
 		pxLink = ( void * ) puc;
 
+		#if( configHEAP_PROFILING == 1 )
+		{
+			/* Take back the call site stored by pvPortMalloc(). */
+			if( ( ( pxLink->xBlockSize & xHeapInfo[idx].xBlockAllocatedBit ) != 0 ) && ( ( size_t ) pxLink->pxNextFreeBlock < HEAP_PROF_SITE_NUM ) )
+			{
+				ucSite = ( uint8_t ) ( size_t ) pxLink->pxNextFreeBlock;
+				pxLink->pxNextFreeBlock = NULL;
+			}
+		}
+		#endif
+
 		/* Check the block is actually allocated. */
 		configASSERT( ( pxLink->xBlockSize & xHeapInfo[idx].xBlockAllocatedBit ) != 0 );
 		configASSERT( pxLink->pxNextFreeBlock == NULL );
@@ -432,6 +476,11 @@ BlockLink_t *pxLink;
 					/* Add this block to the list of free blocks. */
 					xHeapInfo[idx].xFreeBytesRemaining += pxLink->xBlockSize;
 					traceFREE( pv, pxLink->xBlockSize );
+					#if( configHEAP_PROFILING == 1 )
+					{
+						heap_prof_free( ucSite, pxLink->xBlockSize );
+					}
+					#endif
 					prvInsertBlockIntoFreeList( ( ( BlockLink_t * ) pxLink ) , idx);
 				}
 				//( void ) xTaskResumeAll();
@@ -472,6 +521,31 @@ size_t xPortGetMinimumEverFreeHeapSize( void )
 }
 /*-----------------------------------------------------------*/
 
+#if( configHEAP_PROFILING == 1 )
+void vPortHeapProfGetFreeList( heap_prof_stats_t *pxStats )
+{
+BlockLink_t *pxBlock;
+
+	vPortLock();
+	for( int idx = 0; idx < sizeof(xHeapInfo)/sizeof(xHeapInfo[0]); idx++ )
+	{
+		if( xHeapInfo[idx].pxEnd == NULL )
+			continue;
+
+		pxStats->total_bytes += xHeapInfo[idx].xTotalHeapSize;
+		pxStats->free_bytes += xHeapInfo[idx].xFreeBytesRemaining;
+		pxStats->min_free_bytes += xHeapInfo[idx].xMinimumEverFreeBytesRemaining;
+
+		for( pxBlock = xHeapInfo[idx].xStart.pxNextFreeBlock; pxBlock != xHeapInfo[idx].pxEnd; pxBlock = pxBlock->pxNextFreeBlock )
+		{
+			heap_prof_add_free_block( pxStats, pxBlock->xBlockSize );
+		}
+	}
+	vPortUnlock();
+}
+#endif
+/*-----------------------------------------------------------*/
+
 void vPortInitialiseBlocks( void )
 {
 	/* This just exists to keep the linker quiet. */
@@ -722,6 +796,11 @@ void* pvPortReAlloc( void *pv,  size_t xWantedSize )
 				
 				/* modify current block */
 				pxCurrBlock->xBlockSize = xWantedSize | xHeapInfo[idx].xBlockAllocatedBit;
+				#if( configHEAP_PROFILING == 1 )
+				{
+					heap_prof_resize( ( uint8_t ) ( size_t ) pxCurrBlock->pxNextFreeBlock, oldSize + xHeapStructSize, xWantedSize );
+				}
+				#endif
 				
 				/* create new free space */
 				BlockLink_t *pxNewBlockLink = ( void * ) ( ( ( uint8_t * ) pxCurrBlock ) + xWantedSize );
@@ -783,6 +862,11 @@ void* pvPortReAlloc( void *pv,  size_t xWantedSize )
 					}
 					size_t oldBlockSize = pxCurrBlock->xBlockSize & (~xHeapInfo[idx].xBlockAllocatedBit);
 					pxCurrBlock->xBlockSize = xWantedSize | xHeapInfo[idx].xBlockAllocatedBit;
+					#if( configHEAP_PROFILING == 1 )
+					{
+						heap_prof_resize( ( uint8_t ) ( size_t ) pxCurrBlock->pxNextFreeBlock, oldBlockSize, xWantedSize );
+					}
+					#endif
 					
 					/* create new next block structure */
 					BlockLink_t* pxNewNextBlock =  ( void * ) ( ( ( uint8_t * ) pxCurrBlock ) + xWantedSize );
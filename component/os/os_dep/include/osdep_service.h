@@ -408,6 +408,64 @@ int	rtw_memcmp(void *dst, void *src, u32 sz);
 void	rtw_memset(void *pbuf, int c, u32 sz);
 /*************************** End Memory Management *******************************/
 
+/*************************** Memory Pools *******************************/
+
+typedef struct rtw_mempool {
+	struct rtw_mempool *next;	/* for internal use only, list of all pools */
+	u8 *start;			/* first block */
+	u8 *end;			/* end of the last block */
+	void *free_list;		/* free blocks, linked through their first word */
+	u32 block_size;
+	u32 block_num;
+	u32 free_num;
+	u32 min_free_num;		/* low watermark of free_num */
+	u32 fail_num;			/* rtw_mempool_alloc() calls that found the pool empty */
+} rtw_mempool_t;
+
+/**
+ * @brief  This function creates a pool of fixed size blocks in one allocation from the heap.
+ * @param[in] block_size: The size of each block, rounded up to a multiple of 4 bytes.
+ * @param[in] block_num: The number of blocks.
+ * @return	  The pointer to the pool, NULL if there is no memory.
+ */
+rtw_mempool_t *rtw_mempool_create(u32 block_size, u32 block_num);
+
+/**
+ * @brief  This function deletes a pool. The caller must drain the pool first:
+ *		   a pool with blocks still in use is kept and can be deleted again later.
+ * @param[in] pool: The pool created by rtw_mempool_create().
+ * @return	  _SUCCESS: the pool has been deleted.
+ * @return	  _FAIL: blocks of the pool are still in use.
+ */
+int	rtw_mempool_delete(rtw_mempool_t *pool);
+
+/**
+ * @brief  This function takes a block from a pool in constant time.
+ *		   It can be called from an ISR.
+ * @param[in] pool: The pool created by rtw_mempool_create().
+ * @return	  The pointer to the block, NULL if the pool is empty.
+ */
+void*	rtw_mempool_alloc(rtw_mempool_t *pool);
+
+/**
+ * @brief  This function gives a block back to its pool in constant time.
+ *		   It can be called from an ISR.
+ * @param[in] pool: The pool the block was taken from.
+ * @param[in] pbuf: The block returned by rtw_mempool_alloc().
+ * @return	  None
+ */
+void	rtw_mempool_free(rtw_mempool_t *pool, void *pbuf);
+
+/**
+ * @brief  This function gives a block back to whichever pool it belongs to,
+ *		   for code that frees buffers without knowing where they came from.
+ * @param[in] pbuf: The pointer to the buffer.
+ * @return	  1: pbuf was a pool block and has been freed.
+ * @return	  0: pbuf does not belong to any pool.
+ */
+int	rtw_mempool_release(void *pbuf);
+/*************************** End Memory Pools *******************************/
+
 /*************************** List *******************************/
 
 /**
@@ -40,6 +40,9 @@ void tcm_heap_freemem(void *mem, int size);
 
 int tcm_heap_freeSpace(void);
 
+/// Print the free list, its fragmentation and the size-class usage
+void tcm_heap_dump(void);
+
 #define HNEW(heap, type) \
 	(type*)tcm_heap_allocmem(heap, sizeof(type))
 
@@ -7,6 +7,12 @@
 #if defined(CONFIG_USE_TCM_HEAP) && CONFIG_USE_TCM_HEAP
 #include "tcm_heap.h"
 #endif
+#if defined(PLATFORM_FREERTOS) && defined(configHEAP_PROFILING) && (configHEAP_PROFILING == 1)
+#include "freertos_heap_prof.h"
+#define OSDEP_HEAP_PROF		1
+#else
+#define OSDEP_HEAP_PROF		0
+#endif
 
 #define OSDEP_DBG(x, ...) do {} while(0)
 
@@ -123,6 +129,22 @@ void _rtw_vmfree(u8 *pbuf, u32 sz)
 	}
 }
 
+#if OSDEP_HEAP_PROF
+/* The ops table would charge every block to the _freertos_malloc wrapper,
+ * call the heap directly so the profile shows the rtw_malloc call site */
+u8* _freertos_malloc_caller(u32 sz, void *caller);
+u8* _freertos_zmalloc_caller(u32 sz, void *caller);
+
+u8* _rtw_malloc(u32 sz)
+{
+	return _freertos_malloc_caller(sz, heapPROF_CALLER());
+}
+
+u8* _rtw_zmalloc(u32 sz)
+{
+	return _freertos_zmalloc_caller(sz, heapPROF_CALLER());
+}
+#else
 u8* _rtw_malloc(u32 sz)
 {
 	if(osdep_service.rtw_malloc) {
@@ -144,6 +166,7 @@ u8* _rtw_zmalloc(u32 sz)
 
 	return NULL;
 }
+#endif
 
 void _rtw_mfree(u8 *pbuf, u32 sz)
 {
@@ -435,6 +458,120 @@ void rtw_memset(void *pbuf, int c, u32 sz)
 		OSDEP_DBG("Not implement osdep service: rtw_memset");
 }
 
+static rtw_mempool_t *mempool_list = NULL;
+
+rtw_mempool_t *rtw_mempool_create(u32 block_size, u32 block_num)
+{
+	rtw_mempool_t *pool;
+	_irqL irqL;
+	u32 i;
+
+	if((block_size == 0) || (block_num == 0))
+		return NULL;
+
+	block_size = (block_size + 3) & ~3;
+	pool = (rtw_mempool_t *)rtw_zmalloc(sizeof(rtw_mempool_t) + block_size * block_num);
+	if(pool == NULL)
+		return NULL;
+
+	pool->start = (u8 *)(pool + 1);
+	pool->end = pool->start + block_size * block_num;
+	pool->block_size = block_size;
+	pool->block_num = block_num;
+	pool->free_num = block_num;
+	pool->min_free_num = block_num;
+	for(i = block_num; i > 0; i--) {
+		void **block = (void **)(pool->start + (i - 1) * block_size);
+		*block = pool->free_list;
+		pool->free_list = block;
+	}
+
+	rtw_enter_critical(NULL, &irqL);
+	pool->next = mempool_list;
+	mempool_list = pool;
+	rtw_exit_critical(NULL, &irqL);
+
+	return pool;
+}
+
+int rtw_mempool_delete(rtw_mempool_t *pool)
+{
+	rtw_mempool_t **pprev;
+	_irqL irqL;
+
+	if(pool == NULL)
+		return _SUCCESS;
+
+	rtw_enter_critical(NULL, &irqL);
+	if(pool->free_num != pool->block_num) {
+		// a later rtw_mempool_free() of those blocks would write into freed heap
+		rtw_exit_critical(NULL, &irqL);
+		OSDEP_DBG("rtw_mempool_delete: %d blocks still in use, pool kept", pool->block_num - pool->free_num);
+		return _FAIL;
+	}
+	for(pprev = &mempool_list; *pprev; pprev = &(*pprev)->next) {
+		if(*pprev == pool) {
+			*pprev = pool->next;
+			break;
+		}
+	}
+	rtw_exit_critical(NULL, &irqL);
+
+	rtw_mfree((u8 *)pool, sizeof(rtw_mempool_t) + pool->block_size * pool->block_num);
+	return _SUCCESS;
+}
+
+void *rtw_mempool_alloc(rtw_mempool_t *pool)
+{
+	void **block;
+	_irqL irqL;
+
+	rtw_enter_critical(NULL, &irqL);
+	block = (void **)pool->free_list;
+	if(block) {
+		pool->free_list = *block;
+		if(--pool->free_num < pool->min_free_num)
+			pool->min_free_num = pool->free_num;
+	} else
+		pool->fail_num++;
+	rtw_exit_critical(NULL, &irqL);
+
+	return block;
+}
+
+void rtw_mempool_free(rtw_mempool_t *pool, void *pbuf)
+{
+	_irqL irqL;
+
+	if(pbuf == NULL)
+		return;
+
+	rtw_enter_critical(NULL, &irqL);
+	*(void **)pbuf = pool->free_list;
+	pool->free_list = pbuf;
+	pool->free_num++;
+	rtw_exit_critical(NULL, &irqL);
+}
+
+int rtw_mempool_release(void *pbuf)
+{
+	rtw_mempool_t *pool;
+	_irqL irqL;
+
+	rtw_enter_critical(NULL, &irqL);
+	for(pool = mempool_list; pool; pool = pool->next) {
+		if(((u8 *)pbuf >= pool->start) && ((u8 *)pbuf < pool->end))
+			break;
+	}
+	rtw_exit_critical(NULL, &irqL);
+
+	if(pool == NULL)
+		return 0;
+
+	rtw_mempool_free(pool, pbuf);
+	return 1;
+}
+
 void rtw_init_listhead(_list *list)
 {
 	INIT_LIST_HEAD(list);
@@ -1198,7 +1335,8 @@ static void worker_thread_main( void *arg )
 			message.function(message.buf, message.buf_len, message.flags, message.user_data);
 			if(message.buf){
 				//printf("\n!!!!!Free %p(%d)\n", message.buf, message.buf_len);
-				_rtw_mfree((u8 *)message.buf, message.buf_len);
+				if(!rtw_mempool_release(message.buf))
+					_rtw_mfree((u8 *)message.buf, message.buf_len);
 			}
 		}
 	}
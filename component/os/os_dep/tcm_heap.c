@@ -15,6 +15,16 @@
 
 #define TCM_HEAP_SIZE	(40*1024)
 
+/* Size-class front end for tcm_heap_malloc/tcm_heap_free: small blocks come from
+ * slabs of equal blocks in O(1), so they neither walk nor split the chunk list.
+ * Off by default: the first block of a class reserves its whole slab (2 KB for
+ * the 512 byte class) out of the 40 KB, size the slabs from tcm_heap_dump() peaks
+ * before setting it to 1.
+ */
+#ifndef TCM_HEAP_SLAB
+#define TCM_HEAP_SLAB		0
+#endif
+
 static struct Heap g_tcm_heap;
 
 #if defined (__ICCARM__)
@@ -57,30 +67,10 @@ void tcm_heap_init(void)
 #endif
 }
 
-void tcm_heap_dump(void)
-{
-	MemChunk *chunk, *prev;
-	struct Heap* h = &g_tcm_heap;
-	
-	printf("---Free List--\n\r");
-	for (prev = (MemChunk *)&h->FreeList, chunk = h->FreeList;
-		chunk;
-		prev = chunk, chunk = chunk->next)
-	{
-		printf(" prev %x, chunk %x, size %d \n\r", prev, chunk, chunk->size);
-	}
-	printf("--------------\n\r");
-}
-
-void *tcm_heap_allocmem(int size)
+static void *tcm_heap_allocmem_nolock(int size)
 {
 	MemChunk *chunk, *prev;
 	struct Heap* h = &g_tcm_heap;
-	_irqL 	irqL;
-
-	rtw_enter_critical(&tcm_lock, &irqL);
-	
-	if(!g_heap_inited)	tcm_heap_init();
 
 	/* Round size up to the allocation granularity */
 	size = ROUND_UP2(size, sizeof(MemChunk));
@@ -106,7 +96,6 @@ void *tcm_heap_allocmem(int size)
 					memset(chunk, ALLOC_FILL_CODE, size);
 				#endif
 				
-				rtw_exit_critical(&tcm_lock, &irqL);
 				//printf("----ALLOC1-----\n\r");
 				//tcm_heap_dump();
 				//printf("--------------\n\r");
@@ -119,7 +108,6 @@ void *tcm_heap_allocmem(int size)
 				#ifdef _DEBUG
 					memset((uint8_t *)chunk + chunk->size, ALLOC_FILL_CODE, size);
 				#endif
-				rtw_exit_critical(&tcm_lock, &irqL);
 				//printf("----ALLOC2-----\n\r");
 				//tcm_heap_dump();
 				//printf("--------------\n\r");
@@ -129,25 +117,33 @@ void *tcm_heap_allocmem(int size)
 		}
 	}
 	
-	rtw_exit_critical(&tcm_lock, &irqL);
 	//printf("----ALLOC3-----\n\r");
 	//tcm_heap_dump();
 	//printf("--------------\n\r");
 	return NULL; /* fail */
 }
 
-
-void tcm_heap_freemem(void *mem, int size)
+void *tcm_heap_allocmem(int size)
 {
-	MemChunk *prev;
-	//ASSERT(mem);
-	struct Heap* h = &g_tcm_heap;
+	void *mem;
 	_irqL 	irqL;
 
-	rtw_enter_critical(&tcm_lock, &irqL);	
+	rtw_enter_critical(&tcm_lock, &irqL);
 	
 	if(!g_heap_inited)	tcm_heap_init();
 
+	mem = tcm_heap_allocmem_nolock(size);
+
+	rtw_exit_critical(&tcm_lock, &irqL);
+	return mem;
+}
+
+static void tcm_heap_freemem_nolock(void *mem, int size)
+{
+	MemChunk *prev;
+	//ASSERT(mem);
+	struct Heap* h = &g_tcm_heap;
+
 #ifdef _DEBUG
 	memset(mem, FREE_FILL_CODE, size);
 #endif
@@ -215,13 +211,187 @@ void tcm_heap_freemem(void *mem, int size)
 		//ASSERT((uint8_t*)prev + prev->size != (uint8_t*)prev->next);
 	}
 	
-	rtw_exit_critical(&tcm_lock, &irqL);	
 	//printf("---FREE %x--\n\r", mem);
 	//tcm_heap_dump();
 	//printf("--------------\n\r");
 	
 }
 
+void tcm_heap_freemem(void *mem, int size)
+{
+	_irqL 	irqL;
+
+	rtw_enter_critical(&tcm_lock, &irqL);	
+	
+	if(!g_heap_inited)	tcm_heap_init();
+
+	tcm_heap_freemem_nolock(mem, size);
+
+	rtw_exit_critical(&tcm_lock, &irqL);	
+}
+
+#if TCM_HEAP_SLAB
+/* A slab is one chunk holding equal blocks of a class. Slabs with free blocks are
+ * linked per class, a slab is given back to the chunk list when all its blocks are free.
+ */
+typedef struct _TcmSlab
+{
+	struct _TcmSlab *next;
+	struct _TcmSlab *prev;
+	void *free;			// free blocks, linked through their first word
+	uint16_t used;
+	uint8_t cls;
+	uint8_t full;
+} TcmSlab;
+
+#define TCM_SLAB_CLASS_NUM	5
+#define TCM_SLAB_HDR_SIZE	ROUND_UP2(sizeof(TcmSlab), 8)
+
+static const uint16_t tcm_slab_block_size[TCM_SLAB_CLASS_NUM] = {32, 64, 128, 256, 512};
+static const uint8_t tcm_slab_block_num[TCM_SLAB_CLASS_NUM] = {16, 16, 8, 8, 4};
+
+static struct {
+	TcmSlab *partial;	// slabs with free blocks
+	uint16_t slabs;
+	uint16_t used;
+	uint16_t peak;
+	uint32_t allocs;
+	uint32_t fallbacks;	// class allocations served by the chunk list, no room for a slab
+} tcm_slab_class[TCM_SLAB_CLASS_NUM];
+
+static int tcm_slab_get_class(int size)
+{
+	int cls;
+
+	for (cls = 0; cls < TCM_SLAB_CLASS_NUM; cls++) {
+		if (size <= tcm_slab_block_size[cls])
+			return cls;
+	}
+	return -1;
+}
+
+static void *tcm_slab_alloc(int cls, TcmSlab **owner)
+{
+	TcmSlab *slab = tcm_slab_class[cls].partial;
+	void *block;
+
+	if (slab == NULL) {
+		int i;
+		uint8_t *p;
+
+		slab = (TcmSlab *)tcm_heap_allocmem_nolock(TCM_SLAB_HDR_SIZE +
+			tcm_slab_block_size[cls] * tcm_slab_block_num[cls]);
+		if (slab == NULL) {
+			tcm_slab_class[cls].fallbacks++;
+			return NULL;
+		}
+
+		slab->cls = cls;
+		slab->used = 0;
+		slab->full = 0;
+		slab->prev = NULL;
+		slab->next = NULL;
+		slab->free = NULL;
+		p = (uint8_t *)slab + TCM_SLAB_HDR_SIZE;
+		for (i = tcm_slab_block_num[cls] - 1; i >= 0; i--) {
+			*(void **)(p + i * tcm_slab_block_size[cls]) = slab->free;
+			slab->free = p + i * tcm_slab_block_size[cls];
+		}
+		tcm_slab_class[cls].partial = slab;
+		tcm_slab_class[cls].slabs++;
+	}
+
+	block = slab->free;
+	slab->free = *(void **)block;
+	slab->used++;
+
+	if (slab->free == NULL) {
+		/* full, off the partial list */
+		tcm_slab_class[cls].partial = slab->next;
+		if (slab->next)
+			slab->next->prev = NULL;
+		slab->full = 1;
+	}
+
+	tcm_slab_class[cls].allocs++;
+	if (++tcm_slab_class[cls].used > tcm_slab_class[cls].peak)
+		tcm_slab_class[cls].peak = tcm_slab_class[cls].used;
+
+	*owner = slab;
+	return block;
+}
+
+static void tcm_slab_free(TcmSlab *slab, void *block)
+{
+	int cls = slab->cls;
+
+	*(void **)block = slab->free;
+	slab->free = block;
+	slab->used--;
+	tcm_slab_class[cls].used--;
+
+	if (slab->full) {
+		/* back on the partial list */
+		slab->full = 0;
+		slab->prev = NULL;
+		slab->next = tcm_slab_class[cls].partial;
+		if (slab->next)
+			slab->next->prev = slab;
+		tcm_slab_class[cls].partial = slab;
+	}
+
+	if (slab->used == 0) {
+		if (slab->prev)
+			slab->prev->next = slab->next;
+		else
+			tcm_slab_class[cls].partial = slab->next;
+		if (slab->next)
+			slab->next->prev = slab->prev;
+
+		tcm_slab_class[cls].slabs--;
+		tcm_heap_freemem_nolock(slab, TCM_SLAB_HDR_SIZE +
+			tcm_slab_block_size[cls] * tcm_slab_block_num[cls]);
+	}
+}
+#endif
+
+void tcm_heap_dump(void)
+{
+	MemChunk *chunk, *prev;
+	struct Heap* h = &g_tcm_heap;
+	int free_mem = 0, largest = 0, chunks = 0;
+
+	printf("---Free List--\n\r");
+	for (prev = (MemChunk *)&h->FreeList, chunk = h->FreeList;
+		chunk;
+		prev = chunk, chunk = chunk->next)
+	{
+		printf(" prev %x, chunk %x, size %d \n\r", prev, chunk, chunk->size);
+		free_mem += chunk->size;
+		chunks++;
+		if (chunk->size > largest)
+			largest = chunk->size;
+	}
+	/* fragmentation: share of the free space not in the largest chunk */
+	printf(" free %d in %d chunks, largest %d, fragmentation %d%%\n\r",
+		free_mem, chunks, largest, free_mem ? (100 - largest * 100 / free_mem) : 0);
+
+#if TCM_HEAP_SLAB
+	{
+		int cls;
+
+		printf("---Slab-------\n\r");
+		for (cls = 0; cls < TCM_SLAB_CLASS_NUM; cls++) {
+			printf(" %3d: slabs %d, used %d/%d, peak %d, allocs %d, fallbacks %d\n\r",
+				tcm_slab_block_size[cls], tcm_slab_class[cls].slabs, tcm_slab_class[cls].used,
+				tcm_slab_class[cls].slabs * tcm_slab_block_num[cls], tcm_slab_class[cls].peak,
+				tcm_slab_class[cls].allocs, tcm_slab_class[cls].fallbacks);
+		}
+	}
+#endif
+	printf("--------------\n\r");
+}
+
 int tcm_heap_freeSpace(void)
 {
 	int free_mem = 0;
@@ -236,6 +406,17 @@ int tcm_heap_freeSpace(void)
 	for (chunk = h->FreeList; chunk; chunk = chunk->next)
 		free_mem += chunk->size;
 
+#if TCM_HEAP_SLAB
+	{
+		int cls;
+
+		/* free blocks of the slabs are free space too */
+		for (cls = 0; cls < TCM_SLAB_CLASS_NUM; cls++)
+			free_mem += (tcm_slab_class[cls].slabs * tcm_slab_block_num[cls] -
+				tcm_slab_class[cls].used) * tcm_slab_block_size[cls];
+	}
+#endif
+
 	rtw_exit_critical(&tcm_lock, &irqL);
 	return free_mem;
 }
@@ -251,13 +432,32 @@ void *tcm_heap_malloc(int size)
 	// Make sure that block is 8-byte aligned
 	size = (size + 7U) & ~((uint32_t)7U);
 	size += sizeof(int64_t);
-	mem = (int64_t *)tcm_heap_allocmem(size);
 #else
 	int *mem;
 	size += sizeof(int);
-	mem = (int*)tcm_heap_allocmem(size);
 #endif
 
+#if TCM_HEAP_SLAB
+	int cls = tcm_slab_get_class(size);
+
+	if (cls >= 0) {
+		_irqL 	irqL;
+		TcmSlab *slab;
+
+		rtw_enter_critical(&tcm_lock, &irqL);
+		if(!g_heap_inited)	tcm_heap_init();
+		mem = tcm_slab_alloc(cls, &slab);
+		if (mem) {
+			/* negative header: offset back to the owning slab, sizes are always positive */
+			*mem = -(int)((uint8_t *)mem - (uint8_t *)slab);
+		}
+		rtw_exit_critical(&tcm_lock, &irqL);
+
+		if (mem)
+			return ++mem;
+	}
+#endif
+	mem = tcm_heap_allocmem(size);
 
 	if (mem){
 		*mem++ = size;
@@ -303,6 +503,16 @@ void tcm_heap_free(void *mem)
 	if (_mem)
 	{
 		--_mem;
+#if TCM_HEAP_SLAB
+		if (*_mem < 0) {
+			_irqL 	irqL;
+
+			rtw_enter_critical(&tcm_lock, &irqL);
+			tcm_slab_free((TcmSlab *)((uint8_t *)_mem + *_mem), _mem);
+			rtw_exit_critical(&tcm_lock, &irqL);
+			return;
+		}
+#endif
 		tcm_heap_freemem(_mem, *_mem);
 	}
 }
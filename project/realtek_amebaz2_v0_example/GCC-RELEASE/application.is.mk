@@ -275,6 +275,7 @@ SRC_C += ../../../component/soc/realtek/8710c/misc/platform/ota_8710c.c
 SRC_C += ../../../component/common/api/network/src/ping_test.c
 SRC_C += ../../../component/common/utilities/ssl_client.c
 SRC_C += ../../../component/common/utilities/ssl_client_ext.c
+SRC_C += ../../../component/common/utilities/ssl_session_store.c
 SRC_C += ../../../component/common/utilities/tcptest.c
 SRC_C += ../../../component/common/api/network/src/wlan_network.c
 
@@ -370,6 +371,7 @@ SRC_C += ../../../component/common/network/lwip/lwip_v2.0.2/src/netif/ethernet.c
 SRC_C += ../../../component/common/network/lwip/lwip_v2.0.2/port/realtek/freertos/ethernetif.c
 SRC_C += ../../../component/common/drivers/wlan/realtek/src/osdep/lwip_intf.c
 SRC_C += ../../../component/common/network/lwip/lwip_v2.0.2/port/realtek/freertos/sys_arch.c
+SRC_C += ../../../component/common/network/lwip/lwip_v2.0.2/port/realtek/freertos/chksum.c
 
 #network - mdns
 SRC_C += ../../../component/common/network/mDNS/mDNSPlatform.c
@@ -436,6 +438,7 @@ SRC_C += ../../../component/os/freertos/freertos_cb.c
 SRC_C += ../../../component/os/freertos/freertos_service.c
 SRC_C += ../../../component/os/os_dep/osdep_service.c
 SRC_C += ../../../component/os/freertos/freertos_pmu.c
+SRC_C += ../../../component/os/freertos/freertos_heap_prof.c
 
 #os - freertos
 SRC_C += ../../../component/os/freertos/freertos_v10.0.1/Source/croutine.c
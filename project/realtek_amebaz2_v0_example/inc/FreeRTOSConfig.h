@@ -100,6 +100,7 @@ extern uint32_t SystemCoreClock;
 
 /* Constants provided for debugging and optimisation assistance. */
 #define configCHECK_FOR_STACK_OVERFLOW			2
+#define configHEAP_PROFILING					0	// per call site heap usage, see freertos_heap_prof.h and ATSH
 
 /* Software timer definitions. */
 #define configUSE_TIMERS							1